@@ -33,7 +33,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <time.h>
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <loc_nmea.h>
@@ -50,44 +55,101 @@ namespace loc_core
 ******************************************************************************/
 class SystemStatusNmeaBase
 {
+public:
+    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
+    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    // PQWP7 has the most fields, 3 per SV
+    static const uint32_t NMEA_MAX_FIELDS = 2 + SV_ALL_NUM*3;
+
+    // sentence type and number following "$PQW", e.g. 'P' '7', as one value
+    // to switch on
+    static constexpr uint32_t getNmeaId(const char* nmea) {
+        return ((uint32_t)(uint8_t)nmea[4] << 8) | (uint8_t)nmea[5];
+    }
+
 protected:
-    std::vector<std::string> mField;
+    // fields point into the caller's buffer, where each separator has been
+    // replaced by a '\0'
+    const char* mField[NMEA_MAX_FIELDS];
+    uint32_t mNumFields;
 
-    SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
+    // str_in is tokenized in place, it must stay valid as long as this object
+    SystemStatusNmeaBase(char *str_in, uint32_t len_in) : mNumFields(0)
     {
         // check size and talker
         if (!loc_nmea_is_debug(str_in, len_in)) {
             return;
         }
 
-        std::string parser(str_in);
-        std::string::size_type index = 0;
-
-        // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
+        // fields are the ',' separated values up to the checksum field
+        char* end = (char*)memchr(str_in, '*', strnlen(str_in, len_in));
+        if (nullptr == end) {
             return;
         }
-        parser[index] = ',';
+        *end = ',';
 
         // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
-            }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
+        char* field = str_in;
+        while (field <= end && mNumFields < NMEA_MAX_FIELDS) {
+            char* sep = (char*)memchr(field, ',', end - field + 1);
+            *sep = '\0';
+            mField[mNumFields++] = field;
+            field = sep + 1;
         }
     }
 
     virtual ~SystemStatusNmeaBase() { }
 
-public:
-    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
-    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    // field conversions, with the same results as atoi / strtol / atof on
+    // well formed fields
+    inline int32_t getInt(uint32_t i) const
+    {
+        return (int32_t)getInt64(i);
+    }
+
+    int64_t getInt64(uint32_t i) const
+    {
+        const char* p = mField[i];
+        while (' ' == *p) {
+            p++;
+        }
+        bool negative = ('-' == *p);
+        if (negative || '+' == *p) {
+            p++;
+        }
+        uint64_t value = 0;
+        for (; *p >= '0' && *p <= '9'; p++) {
+            value = value*10 + (*p - '0');
+        }
+        return negative ? -(int64_t)value : (int64_t)value;
+    }
+
+    uint64_t getHex(uint32_t i) const
+    {
+        const char* p = mField[i];
+        while (' ' == *p) {
+            p++;
+        }
+        if ('0' == p[0] && ('x' == p[1] || 'X' == p[1])) {
+            p += 2;
+        }
+        uint64_t value = 0;
+        for (;; p++) {
+            if (*p >= '0' && *p <= '9') {
+                value = (value << 4) | (*p - '0');
+            } else if ((*p | 0x20) >= 'a' && (*p | 0x20) <= 'f') {
+                value = (value << 4) | ((*p | 0x20) - 'a' + 10);
+            } else {
+                break;
+            }
+        }
+        return value;
+    }
+
+    inline double getDouble(uint32_t i) const
+    {
+        return strtod(mField[i], nullptr);
+    }
 };
 
 /******************************************************************************
@@ -205,51 +267,51 @@ public:
     inline uint32_t   getGalBpAmpQ()  { return mM1.mGalBpAmpQ; }
     inline uint64_t   getTimeUncNs()  { return mM1.mTimeUncNs; }
 
-    SystemStatusPQWM1parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWM1parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
         memset(&mM1, 0, sizeof(mM1));
-        if (mField.size() <= eMax0) {
-            LOC_LOGE("PQWM1parser - invalid size=%zu", mField.size());
+        if (mNumFields <= eMax0) {
+            LOC_LOGE("PQWM1parser - invalid size=%u", mNumFields);
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
-        if (mField.size() > eLeapSecUnc) {
-            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
+        mM1.mGpsWeek = getInt(eGpsWeek);
+        mM1.mGpsTowMs = getInt(eGpsTowMs);
+        mM1.mTimeValid = getInt(eTimeValid);
+        mM1.mTimeSource = getInt(eTimeSource);
+        mM1.mTimeUnc = getInt(eTimeUnc);
+        mM1.mClockFreqBias = getInt(eClockFreqBias);
+        mM1.mClockFreqBiasUnc = getInt(eClockFreqBiasUnc);
+        mM1.mXoState = getInt(eXoState);
+        mM1.mPgaGain = getInt(ePgaGain);
+        mM1.mGpsBpAmpI = getInt(eGpsBpAmpI);
+        mM1.mGpsBpAmpQ = getInt(eGpsBpAmpQ);
+        mM1.mAdcI = getInt(eAdcI);
+        mM1.mAdcQ = getInt(eAdcQ);
+        mM1.mJammerGps = getInt(eJammerGps);
+        mM1.mJammerGlo = getInt(eJammerGlo);
+        mM1.mJammerBds = getInt(eJammerBds);
+        mM1.mJammerGal = getInt(eJammerGal);
+        mM1.mRecErrorRecovery = getInt(eRecErrorRecovery);
+        mM1.mAgcGps = getDouble(eAgcGps);
+        mM1.mAgcGlo = getDouble(eAgcGlo);
+        mM1.mAgcBds = getDouble(eAgcBds);
+        mM1.mAgcGal = getDouble(eAgcGal);
+        if (mNumFields > eLeapSecUnc) {
+            mM1.mLeapSeconds = getInt(eLeapSeconds);
+            mM1.mLeapSecUnc = getInt(eLeapSecUnc);
         }
-        if (mField.size() > eGalBpAmpQ) {
-            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].c_str());
-            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].c_str());
-            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].c_str());
-            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].c_str());
-            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].c_str());
-            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].c_str());
+        if (mNumFields > eGalBpAmpQ) {
+            mM1.mGloBpAmpI = getInt(eGloBpAmpI);
+            mM1.mGloBpAmpQ = getInt(eGloBpAmpQ);
+            mM1.mBdsBpAmpI = getInt(eBdsBpAmpI);
+            mM1.mBdsBpAmpQ = getInt(eBdsBpAmpQ);
+            mM1.mGalBpAmpI = getInt(eGalBpAmpI);
+            mM1.mGalBpAmpQ = getInt(eGalBpAmpQ);
         }
-        if (mField.size() > eTimeUncNs) {
-            mM1.mTimeUncNs = strtoull(mField[eTimeUncNs].c_str(), nullptr, 10);
+        if (mNumFields > eTimeUncNs) {
+            mM1.mTimeUncNs = (uint64_t)getInt64(eTimeUncNs);
         }
     }
 
@@ -298,20 +360,20 @@ public:
     inline float      getEpiAltUnc() { return mP1.mEpiAltUnc;        }
     inline uint8_t    getEpiSrc() { return mP1.mEpiSrc;           }
 
-    SystemStatusPQWP1parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP1parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mNumFields < eMax) {
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        mP1.mEpiValidity = getHex(eEpiValidity);
+        mP1.mEpiLat = getDouble(eEpiLat);
+        mP1.mEpiLon = getDouble(eEpiLon);
+        mP1.mEpiAlt = getDouble(eEpiAlt);
+        mP1.mEpiHepe = getInt(eEpiHepe);
+        mP1.mEpiAltUnc = getDouble(eEpiAltUnc);
+        mP1.mEpiSrc = getInt(eEpiSrc);
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -353,18 +415,18 @@ public:
     inline float      getBestHepe() { return mP2.mBestHepe;         }
     inline float      getBestAltUnc() { return mP2.mBestAltUnc;       }
 
-    SystemStatusPQWP2parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP2parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mNumFields < eMax) {
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        mP2.mBestLat = getDouble(eBestLat);
+        mP2.mBestLon = getDouble(eBestLon);
+        mP2.mBestAlt = getDouble(eBestAlt);
+        mP2.mBestHepe = getDouble(eBestHepe);
+        mP2.mBestAltUnc = getDouble(eBestAltUnc);
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -429,25 +491,25 @@ public:
     inline uint8_t    getQzssXtraValid() { return mP3.mQzssXtraValid;    }
     inline uint32_t   getNavicXtraValid() { return mP3.mNavicXtraValid;     }
 
-    SystemStatusPQWP3parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP3parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mNumFields < eMax) {
             return;
         }
         memset(&mP3, 0, sizeof(mP3));
         // todo: update for navic once available
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        mP3.mXtraValidMask = getHex(eXtraValidMask);
+        mP3.mGpsXtraAge = getInt(eGpsXtraAge);
+        mP3.mGloXtraAge = getInt(eGloXtraAge);
+        mP3.mBdsXtraAge = getInt(eBdsXtraAge);
+        mP3.mGalXtraAge = getInt(eGalXtraAge);
+        mP3.mQzssXtraAge = getInt(eQzssXtraAge);
+        mP3.mGpsXtraValid = getHex(eGpsXtraValid);
+        mP3.mGloXtraValid = getHex(eGloXtraValid);
+        mP3.mBdsXtraValid = getHex(eBdsXtraValid);
+        mP3.mGalXtraValid = getHex(eGalXtraValid);
+        mP3.mQzssXtraValid = getHex(eQzssXtraValid);
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -489,18 +551,18 @@ public:
     inline uint64_t   getGalEpheValid() { return mP4.mGalEpheValid;     }
     inline uint8_t    getQzssEpheValid() { return mP4.mQzssEpheValid;    }
 
-    SystemStatusPQWP4parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP4parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mNumFields < eMax) {
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        mP4.mGpsEpheValid = getHex(eGpsEpheValid);
+        mP4.mGloEpheValid = getHex(eGloEpheValid);
+        mP4.mBdsEpheValid = getHex(eBdsEpheValid);
+        mP4.mGalEpheValid = getHex(eGalEpheValid);
+        mP4.mQzssEpheValid = getHex(eQzssEpheValid);
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -579,29 +641,29 @@ public:
     inline uint8_t    getQzssBadMask() { return mP5.mQzssBadMask;      }
     inline uint32_t   getNavicBadMask() { return mP5.mNavicBadMask;       }
 
-    SystemStatusPQWP5parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP5parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mNumFields < eMax) {
             return;
         }
         memset(&mP5, 0, sizeof(mP5));
         // todo: update for navic once available
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        mP5.mGpsUnknownMask = getHex(eGpsUnknownMask);
+        mP5.mGloUnknownMask = getHex(eGloUnknownMask);
+        mP5.mBdsUnknownMask = getHex(eBdsUnknownMask);
+        mP5.mGalUnknownMask = getHex(eGalUnknownMask);
+        mP5.mQzssUnknownMask = getHex(eQzssUnknownMask);
+        mP5.mGpsGoodMask = getHex(eGpsGoodMask);
+        mP5.mGloGoodMask = getHex(eGloGoodMask);
+        mP5.mBdsGoodMask = getHex(eBdsGoodMask);
+        mP5.mGalGoodMask = getHex(eGalGoodMask);
+        mP5.mQzssGoodMask = getHex(eQzssGoodMask);
+        mP5.mGpsBadMask = getHex(eGpsBadMask);
+        mP5.mGloBadMask = getHex(eGloBadMask);
+        mP5.mBdsBadMask = getHex(eBdsBadMask);
+        mP5.mGalBadMask = getHex(eGalBadMask);
+        mP5.mQzssBadMask = getHex(eQzssBadMask);
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -631,14 +693,14 @@ private:
 public:
     inline uint32_t   getFixInfoMask() { return mP6.mFixInfoMask;      }
 
-    SystemStatusPQWP6parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP6parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mNumFields < eMax) {
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        mP6.mFixInfoMask = getHex(eFixInfoMask);
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -666,24 +728,24 @@ private:
     SystemStatusPQWP7 mP7;
 
 public:
-    SystemStatusPQWP7parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWP7parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
         uint32_t svLimit = SV_ALL_NUM;
-        if (mField.size() < eMin) {
-            LOC_LOGE("PQWP7parser - invalid size=%zu", mField.size());
+        if (mNumFields < eMin) {
+            LOC_LOGE("PQWP7parser - invalid size=%u", mNumFields);
             return;
         }
-        if (mField.size() < eMax) {
+        if (mNumFields < eMax) {
             // Try reducing limit, accounting for possibly missing NAVIC support
             svLimit = SV_ALL_NUM_MIN;
         }
 
         memset(mP7.mNav, 0, sizeof(mP7.mNav));
         for (uint32_t i=0; i<svLimit; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(getInt(i*3+2));
+            mP7.mNav[i].mSource = GnssEphemerisSource(getInt(i*3+3));
+            mP7.mNav[i].mAgeSec = getInt(i*3+4);
         }
     }
 
@@ -717,15 +779,15 @@ public:
     inline uint16_t   getFixInfoMask() { return mS1.mFixInfoMask;      }
     inline uint32_t   getHepeLimit()   { return mS1.mHepeLimit;      }
 
-    SystemStatusPQWS1parser(const char *str_in, uint32_t len_in)
+    SystemStatusPQWS1parser(char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mNumFields < eMax) {
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        mS1.mFixInfoMask = getInt(eFixInfoMask);
+        mS1.mHepeLimit = getInt(eHepeLimit);
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -1288,10 +1350,17 @@ void SystemStatus::destroyInstance()
 }
 
 void SystemStatus::resetNetworkInfo() {
-    for (int i=0; i<mCache.mNetworkInfo.size(); ++i) {
+    // copied out first, as updating the cache while reading it would wait
+    // for this very reader
+    std::vector<SystemStatusNetworkInfo> networkInfo;
+    uint32_t version = beginRead();
+    mCache[version].mNetworkInfo.copyTo(networkInfo);
+    endRead(version);
+    for (int i=0; i<networkInfo.size(); ++i) {
         // Reset all the cached NetworkInfo Items as disconnected
-        eventConnectionStatus(false, mCache.mNetworkInfo[i].mType, mCache.mNetworkInfo[i].mRoaming,
-                mCache.mNetworkInfo[i].mNetworkHandle, mCache.mNetworkInfo[i].mApn);
+        string apn = networkInfo[i].mApn;
+        eventConnectionStatus(false, networkInfo[i].mType,
+                networkInfo[i].mRoaming, networkInfo[i].mNetworkHandle, apn);
     }
 }
 
@@ -1301,53 +1370,55 @@ IOsObserver* SystemStatus::getOsObserver()
 }
 
 SystemStatus::SystemStatus(const MsgTask* msgTask) :
-    mSysStatusObsvr(this, msgTask)
+    mSysStatusObsvr(this, msgTask),
+    mLatest(0)
 {
     int result = 0;
     ENTRY_LOG ();
-    mCache.mLocation.clear();
-
-    mCache.mTimeAndClock.clear();
-    mCache.mXoState.clear();
-    mCache.mRfAndParams.clear();
-    mCache.mErrRecovery.clear();
-
-    mCache.mInjectedPosition.clear();
-    mCache.mBestPosition.clear();
-    mCache.mXtra.clear();
-    mCache.mEphemeris.clear();
-    mCache.mSvHealth.clear();
-    mCache.mPdr.clear();
-    mCache.mNavData.clear();
-
-    mCache.mPositionFailure.clear();
-
-    mCache.mAirplaneMode.clear();
-    mCache.mENH.clear();
-    mCache.mGPSState.clear();
-    mCache.mNLPStatus.clear();
-    mCache.mWifiHardwareState.clear();
-    mCache.mNetworkInfo.clear();
-    mCache.mRilServiceInfo.clear();
-    mCache.mRilCellInfo.clear();
-    mCache.mServiceStatus.clear();
-    mCache.mModel.clear();
-    mCache.mManufacturer.clear();
-    mCache.mAssistedGps.clear();
-    mCache.mScreenState.clear();
-    mCache.mPowerConnectState.clear();
-    mCache.mTimeZoneChange.clear();
-    mCache.mTimeChange.clear();
-    mCache.mWifiSupplicantStatus.clear();
-    mCache.mShutdownState.clear();
-    mCache.mTac.clear();
-    mCache.mMccMnc.clear();
-    mCache.mBtDeviceScanDetail.clear();
-    mCache.mBtLeDeviceScanDetail.clear();
+    mReaders[0] = 0;
+    mReaders[1] = 0;
 
     EXIT_LOG_WITH_ERROR ("%d",result);
 }
 
+/******************************************************************************
+ SystemStatus - versioning the cache
+******************************************************************************/
+// Returns the version of the cache to update, the one not published,
+// brought up to date with the published one. Only the rings changed by the
+// last update are copied.
+SystemStatusCache& SystemStatus::beginUpdate()
+{
+    uint32_t next = 1 - mLatest.load(std::memory_order_relaxed);
+    // wait for the readers that took it before the last update replaced it;
+    // later ones find it is not the latest and move on
+    while (0 != mReaders[next].load(std::memory_order_seq_cst)) {
+        sched_yield();
+    }
+    mCache[next] = mCache[1 - next];
+    return mCache[next];
+}
+
+// publishes the version returned by beginUpdate() as the latest
+void SystemStatus::commitUpdate()
+{
+    mLatest.store(1 - mLatest.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+}
+
+uint32_t SystemStatus::beginRead() const
+{
+    while (true) {
+        uint32_t version = mLatest.load(std::memory_order_seq_cst);
+        mReaders[version].fetch_add(1, std::memory_order_seq_cst);
+        // a writer that checked for readers before they were counted
+        // updates it only once it is no longer the latest
+        if (version == mLatest.load(std::memory_order_seq_cst)) {
+            return version;
+        }
+        endRead(version);
+    }
+}
+
 /******************************************************************************
  SystemStatus - storing dataitems
 ******************************************************************************/
@@ -1363,11 +1434,8 @@ bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
         return false;
     }
 
-    // first event or updated
+    // first event or updated, the ring drops the oldest item once full
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
     return true;
 }
 
@@ -1375,14 +1443,16 @@ template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
 {
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
-void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const
+void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c,
+                                   bool isLatestOnly) const
 {
+    if (!isLatestOnly) {
+        c.copyTo(reportout);
+        return;
+    }
     reportout.clear();
     if (c.size() >= 1) {
         reportout.push_back(c.back());
@@ -1408,51 +1478,56 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
     strlcpy(buf, data, sizeof(buf));
 
     pthread_mutex_lock(&mMutexSystemStatus);
+    SystemStatusCache& cache = beginUpdate();
 
-    // parse the received nmea strings here
-    if (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+    // parse the received nmea strings here, "$PQW" is checked already
+    switch (SystemStatusNmeaBase::getNmeaId(data)) {
+    case SystemStatusNmeaBase::getNmeaId("$PQWM1"): {
         SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
-        setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
-        setIteminReport(mCache.mXoState, SystemStatusXoState(s));
-        setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
-        setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
+        setIteminReport(cache.mTimeAndClock, SystemStatusTimeAndClock(s));
+        setIteminReport(cache.mXoState, SystemStatusXoState(s));
+        setIteminReport(cache.mRfAndParams, SystemStatusRfAndParams(s));
+        setIteminReport(cache.mErrRecovery, SystemStatusErrRecovery(s));
+        break;
     }
-    else if (0 == strncmp(data, "$PQWP1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mInjectedPosition,
+    case SystemStatusNmeaBase::getNmeaId("$PQWP1"):
+        setIteminReport(cache.mInjectedPosition,
                 SystemStatusInjectedPosition(SystemStatusPQWP1parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP2", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mBestPosition,
+        break;
+    case SystemStatusNmeaBase::getNmeaId("$PQWP2"):
+        setIteminReport(cache.mBestPosition,
                 SystemStatusBestPosition(SystemStatusPQWP2parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP3", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mXtra,
+        break;
+    case SystemStatusNmeaBase::getNmeaId("$PQWP3"):
+        setIteminReport(cache.mXtra,
                 SystemStatusXtra(SystemStatusPQWP3parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP4", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mEphemeris,
+        break;
+    case SystemStatusNmeaBase::getNmeaId("$PQWP4"):
+        setIteminReport(cache.mEphemeris,
                 SystemStatusEphemeris(SystemStatusPQWP4parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP5", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mSvHealth,
+        break;
+    case SystemStatusNmeaBase::getNmeaId("$PQWP5"):
+        setIteminReport(cache.mSvHealth,
                 SystemStatusSvHealth(SystemStatusPQWP5parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP6", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPdr,
+        break;
+    case SystemStatusNmeaBase::getNmeaId("$PQWP6"):
+        setIteminReport(cache.mPdr,
                 SystemStatusPdr(SystemStatusPQWP6parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP7", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mNavData,
+        break;
+    case SystemStatusNmeaBase::getNmeaId("$PQWP7"):
+        setIteminReport(cache.mNavData,
                 SystemStatusNavData(SystemStatusPQWP7parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWS1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPositionFailure,
+        break;
+    case SystemStatusNmeaBase::getNmeaId("$PQWS1"):
+        setIteminReport(cache.mPositionFailure,
                 SystemStatusPositionFailure(SystemStatusPQWS1parser(buf, len).get()));
-    }
-    else {
+        break;
+    default:
         // do nothing
+        break;
     }
 
+    commitUpdate();
     pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
 }
@@ -1469,14 +1544,16 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
 {
     bool ret = false;
     pthread_mutex_lock(&mMutexSystemStatus);
+    SystemStatusCache& cache = beginUpdate();
 
-    ret = setIteminReport(mCache.mLocation, SystemStatusLocation(location, locationEx));
+    ret = setIteminReport(cache.mLocation, SystemStatusLocation(location, locationEx));
     LOC_LOGV("eventPosition - lat=%f lon=%f alt=%f speed=%f",
              location.gpsLocation.latitude,
              location.gpsLocation.longitude,
              location.gpsLocation.altitude,
              location.gpsLocation.speed);
 
+    commitUpdate();
     pthread_mutex_unlock(&mMutexSystemStatus);
     return ret;
 }
@@ -1492,99 +1569,101 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 {
     bool ret = false;
     pthread_mutex_lock(&mMutexSystemStatus);
+    SystemStatusCache& cache = beginUpdate();
     switch(dataitem->getId())
     {
         case AIRPLANEMODE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mAirplaneMode,
+            ret = setIteminReport(cache.mAirplaneMode,
                     SystemStatusAirplaneMode(*(static_cast<AirplaneModeDataItemBase*>(dataitem))));
             break;
         case ENH_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mENH,
+            ret = setIteminReport(cache.mENH,
                     SystemStatusENH(*(static_cast<ENHDataItemBase*>(dataitem))));
             break;
         case GPSSTATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mGPSState,
+            ret = setIteminReport(cache.mGPSState,
                     SystemStatusGpsState(*(static_cast<GPSStateDataItemBase*>(dataitem))));
             break;
         case NLPSTATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mNLPStatus,
+            ret = setIteminReport(cache.mNLPStatus,
                     SystemStatusNLPStatus(*(static_cast<NLPStatusDataItemBase*>(dataitem))));
             break;
         case WIFIHARDWARESTATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mWifiHardwareState,
+            ret = setIteminReport(cache.mWifiHardwareState,
                     SystemStatusWifiHardwareState(*(static_cast<WifiHardwareStateDataItemBase*>(dataitem))));
             break;
         case NETWORKINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mNetworkInfo,
+            ret = setIteminReport(cache.mNetworkInfo,
                     SystemStatusNetworkInfo(*(static_cast<NetworkInfoDataItemBase*>(dataitem))));
             break;
         case RILSERVICEINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mRilServiceInfo,
+            ret = setIteminReport(cache.mRilServiceInfo,
                     SystemStatusServiceInfo(*(static_cast<RilServiceInfoDataItemBase*>(dataitem))));
             break;
         case RILCELLINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mRilCellInfo,
+            ret = setIteminReport(cache.mRilCellInfo,
                     SystemStatusRilCellInfo(*(static_cast<RilCellInfoDataItemBase*>(dataitem))));
             break;
         case SERVICESTATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mServiceStatus,
+            ret = setIteminReport(cache.mServiceStatus,
                     SystemStatusServiceStatus(*(static_cast<ServiceStatusDataItemBase*>(dataitem))));
             break;
         case MODEL_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mModel,
+            ret = setIteminReport(cache.mModel,
                     SystemStatusModel(*(static_cast<ModelDataItemBase*>(dataitem))));
             break;
         case MANUFACTURER_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mManufacturer,
+            ret = setIteminReport(cache.mManufacturer,
                     SystemStatusManufacturer(*(static_cast<ManufacturerDataItemBase*>(dataitem))));
             break;
         case ASSISTED_GPS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mAssistedGps,
+            ret = setIteminReport(cache.mAssistedGps,
                     SystemStatusAssistedGps(*(static_cast<AssistedGpsDataItemBase*>(dataitem))));
             break;
         case SCREEN_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mScreenState,
+            ret = setIteminReport(cache.mScreenState,
                     SystemStatusScreenState(*(static_cast<ScreenStateDataItemBase*>(dataitem))));
             break;
         case POWER_CONNECTED_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mPowerConnectState,
+            ret = setIteminReport(cache.mPowerConnectState,
                     SystemStatusPowerConnectState(*(static_cast<PowerConnectStateDataItemBase*>(dataitem))));
             break;
         case TIMEZONE_CHANGE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTimeZoneChange,
+            ret = setIteminReport(cache.mTimeZoneChange,
                     SystemStatusTimeZoneChange(*(static_cast<TimeZoneChangeDataItemBase*>(dataitem))));
             break;
         case TIME_CHANGE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTimeChange,
+            ret = setIteminReport(cache.mTimeChange,
                     SystemStatusTimeChange(*(static_cast<TimeChangeDataItemBase*>(dataitem))));
             break;
         case WIFI_SUPPLICANT_STATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mWifiSupplicantStatus,
+            ret = setIteminReport(cache.mWifiSupplicantStatus,
                     SystemStatusWifiSupplicantStatus(*(static_cast<WifiSupplicantStatusDataItemBase*>(dataitem))));
             break;
         case SHUTDOWN_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mShutdownState,
+            ret = setIteminReport(cache.mShutdownState,
                     SystemStatusShutdownState(*(static_cast<ShutdownStateDataItemBase*>(dataitem))));
             break;
         case TAC_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTac,
+            ret = setIteminReport(cache.mTac,
                     SystemStatusTac(*(static_cast<TacDataItemBase*>(dataitem))));
             break;
         case MCCMNC_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mMccMnc,
+            ret = setIteminReport(cache.mMccMnc,
                     SystemStatusMccMnc(*(static_cast<MccmncDataItemBase*>(dataitem))));
             break;
         case BTLE_SCAN_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mBtDeviceScanDetail,
+            ret = setIteminReport(cache.mBtDeviceScanDetail,
                     SystemStatusBtDeviceScanDetail(*(static_cast<BtDeviceScanDetailsDataItemBase*>(dataitem))));
             break;
         case BT_SCAN_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mBtLeDeviceScanDetail,
+            ret = setIteminReport(cache.mBtLeDeviceScanDetail,
                     SystemStatusBtleDeviceScanDetail(*(static_cast<BtLeDeviceScanDetailsDataItemBase*>(dataitem))));
             break;
         default:
             break;
     }
+    commitUpdate();
     pthread_mutex_unlock(&mMutexSystemStatus);
     LOC_LOGv("DataItemId: %d, whether to record dateitem in cache: %d", dataitem->getId(), ret);
     return ret;
@@ -1600,96 +1679,68 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 ******************************************************************************/
 bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) const
 {
-    pthread_mutex_lock(&mMutexSystemStatus);
+    uint32_t version = beginRead();
+    const SystemStatusCache* cache = &mCache[version];
+
+    // copy either the latest item of each report or the entire reports
+    getIteminReport(report.mLocation, cache->mLocation, isLatestOnly);
+
+    getIteminReport(report.mTimeAndClock, cache->mTimeAndClock, isLatestOnly);
+    getIteminReport(report.mXoState, cache->mXoState, isLatestOnly);
+    getIteminReport(report.mRfAndParams, cache->mRfAndParams, isLatestOnly);
+    getIteminReport(report.mErrRecovery, cache->mErrRecovery, isLatestOnly);
+
+    getIteminReport(report.mInjectedPosition, cache->mInjectedPosition, isLatestOnly);
+    getIteminReport(report.mBestPosition, cache->mBestPosition, isLatestOnly);
+    getIteminReport(report.mXtra, cache->mXtra, isLatestOnly);
+    getIteminReport(report.mEphemeris, cache->mEphemeris, isLatestOnly);
+    getIteminReport(report.mSvHealth, cache->mSvHealth, isLatestOnly);
+    getIteminReport(report.mPdr, cache->mPdr, isLatestOnly);
+    getIteminReport(report.mNavData, cache->mNavData, isLatestOnly);
+
+    getIteminReport(report.mPositionFailure, cache->mPositionFailure, isLatestOnly);
+
+    getIteminReport(report.mAirplaneMode, cache->mAirplaneMode, isLatestOnly);
+    getIteminReport(report.mENH, cache->mENH, isLatestOnly);
+    getIteminReport(report.mGPSState, cache->mGPSState, isLatestOnly);
+    getIteminReport(report.mNLPStatus, cache->mNLPStatus, isLatestOnly);
+    getIteminReport(report.mWifiHardwareState, cache->mWifiHardwareState, isLatestOnly);
+    getIteminReport(report.mNetworkInfo, cache->mNetworkInfo, isLatestOnly);
+    getIteminReport(report.mRilServiceInfo, cache->mRilServiceInfo, isLatestOnly);
+    getIteminReport(report.mRilCellInfo, cache->mRilCellInfo, isLatestOnly);
+    getIteminReport(report.mServiceStatus, cache->mServiceStatus, isLatestOnly);
+    getIteminReport(report.mModel, cache->mModel, isLatestOnly);
+    getIteminReport(report.mManufacturer, cache->mManufacturer, isLatestOnly);
+    getIteminReport(report.mAssistedGps, cache->mAssistedGps, isLatestOnly);
+    getIteminReport(report.mScreenState, cache->mScreenState, isLatestOnly);
+    getIteminReport(report.mPowerConnectState, cache->mPowerConnectState, isLatestOnly);
+    getIteminReport(report.mTimeZoneChange, cache->mTimeZoneChange, isLatestOnly);
+    getIteminReport(report.mTimeChange, cache->mTimeChange, isLatestOnly);
+    getIteminReport(report.mWifiSupplicantStatus, cache->mWifiSupplicantStatus, isLatestOnly);
+    getIteminReport(report.mShutdownState, cache->mShutdownState, isLatestOnly);
+    getIteminReport(report.mTac, cache->mTac, isLatestOnly);
+    getIteminReport(report.mMccMnc, cache->mMccMnc, isLatestOnly);
+    getIteminReport(report.mBtDeviceScanDetail, cache->mBtDeviceScanDetail, isLatestOnly);
+    getIteminReport(report.mBtLeDeviceScanDetail, cache->mBtLeDeviceScanDetail, isLatestOnly);
+    endRead(version);
+    return true;
+}
 
-    if (isLatestOnly) {
-        // push back only the latest report and return it
-        getIteminReport(report.mLocation, mCache.mLocation);
-
-        getIteminReport(report.mTimeAndClock, mCache.mTimeAndClock);
-        getIteminReport(report.mXoState, mCache.mXoState);
-        getIteminReport(report.mRfAndParams, mCache.mRfAndParams);
-        getIteminReport(report.mErrRecovery, mCache.mErrRecovery);
-
-        getIteminReport(report.mInjectedPosition, mCache.mInjectedPosition);
-        getIteminReport(report.mBestPosition, mCache.mBestPosition);
-        getIteminReport(report.mXtra, mCache.mXtra);
-        getIteminReport(report.mEphemeris, mCache.mEphemeris);
-        getIteminReport(report.mSvHealth, mCache.mSvHealth);
-        getIteminReport(report.mPdr, mCache.mPdr);
-        getIteminReport(report.mNavData, mCache.mNavData);
-
-        getIteminReport(report.mPositionFailure, mCache.mPositionFailure);
-
-        getIteminReport(report.mAirplaneMode, mCache.mAirplaneMode);
-        getIteminReport(report.mENH, mCache.mENH);
-        getIteminReport(report.mGPSState, mCache.mGPSState);
-        getIteminReport(report.mNLPStatus, mCache.mNLPStatus);
-        getIteminReport(report.mWifiHardwareState, mCache.mWifiHardwareState);
-        getIteminReport(report.mNetworkInfo, mCache.mNetworkInfo);
-        getIteminReport(report.mRilServiceInfo, mCache.mRilServiceInfo);
-        getIteminReport(report.mRilCellInfo, mCache.mRilCellInfo);
-        getIteminReport(report.mServiceStatus, mCache.mServiceStatus);
-        getIteminReport(report.mModel, mCache.mModel);
-        getIteminReport(report.mManufacturer, mCache.mManufacturer);
-        getIteminReport(report.mAssistedGps, mCache.mAssistedGps);
-        getIteminReport(report.mScreenState, mCache.mScreenState);
-        getIteminReport(report.mPowerConnectState, mCache.mPowerConnectState);
-        getIteminReport(report.mTimeZoneChange, mCache.mTimeZoneChange);
-        getIteminReport(report.mTimeChange, mCache.mTimeChange);
-        getIteminReport(report.mWifiSupplicantStatus, mCache.mWifiSupplicantStatus);
-        getIteminReport(report.mShutdownState, mCache.mShutdownState);
-        getIteminReport(report.mTac, mCache.mTac);
-        getIteminReport(report.mMccMnc, mCache.mMccMnc);
-        getIteminReport(report.mBtDeviceScanDetail, mCache.mBtDeviceScanDetail);
-        getIteminReport(report.mBtLeDeviceScanDetail, mCache.mBtLeDeviceScanDetail);
-    }
-    else {
-        // copy entire reports and return them
-        report.mLocation.clear();
-
-        report.mTimeAndClock.clear();
-        report.mXoState.clear();
-        report.mRfAndParams.clear();
-        report.mErrRecovery.clear();
-
-        report.mInjectedPosition.clear();
-        report.mBestPosition.clear();
-        report.mXtra.clear();
-        report.mEphemeris.clear();
-        report.mSvHealth.clear();
-        report.mPdr.clear();
-        report.mNavData.clear();
-
-        report.mPositionFailure.clear();
-
-        report.mAirplaneMode.clear();
-        report.mENH.clear();
-        report.mGPSState.clear();
-        report.mNLPStatus.clear();
-        report.mWifiHardwareState.clear();
-        report.mNetworkInfo.clear();
-        report.mRilServiceInfo.clear();
-        report.mRilCellInfo.clear();
-        report.mServiceStatus.clear();
-        report.mModel.clear();
-        report.mManufacturer.clear();
-        report.mAssistedGps.clear();
-        report.mScreenState.clear();
-        report.mPowerConnectState.clear();
-        report.mTimeZoneChange.clear();
-        report.mTimeChange.clear();
-        report.mWifiSupplicantStatus.clear();
-        report.mShutdownState.clear();
-        report.mTac.clear();
-        report.mMccMnc.clear();
-        report.mBtDeviceScanDetail.clear();
-        report.mBtLeDeviceScanDetail.clear();
-
-        report = mCache;
-    }
+/******************************************************************************
+@brief      API to read the cached reports in place, without copying them
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
+@param[In]  visitor called with the latest version of the cache, which
+            stays unchanged until the visitor returns. It must not update
+            SystemStatus, the update would wait for it to return.
+
+@return     true when successfully done
+******************************************************************************/
+bool SystemStatus::visitReport(
+        const std::function<void(const SystemStatusCache& reports)>& visitor) const
+{
+    uint32_t version = beginRead();
+    visitor(mCache[version]);
+    endRead(version);
     return true;
 }
 
@@ -1703,24 +1754,26 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
 bool SystemStatus::setDefaultGnssEngineStates(void)
 {
     pthread_mutex_lock(&mMutexSystemStatus);
+    SystemStatusCache& cache = beginUpdate();
 
-    setDefaultIteminReport(mCache.mLocation, SystemStatusLocation());
+    setDefaultIteminReport(cache.mLocation, SystemStatusLocation());
 
-    setDefaultIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock());
-    setDefaultIteminReport(mCache.mXoState, SystemStatusXoState());
-    setDefaultIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams());
-    setDefaultIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery());
+    setDefaultIteminReport(cache.mTimeAndClock, SystemStatusTimeAndClock());
+    setDefaultIteminReport(cache.mXoState, SystemStatusXoState());
+    setDefaultIteminReport(cache.mRfAndParams, SystemStatusRfAndParams());
+    setDefaultIteminReport(cache.mErrRecovery, SystemStatusErrRecovery());
 
-    setDefaultIteminReport(mCache.mInjectedPosition, SystemStatusInjectedPosition());
-    setDefaultIteminReport(mCache.mBestPosition, SystemStatusBestPosition());
-    setDefaultIteminReport(mCache.mXtra, SystemStatusXtra());
-    setDefaultIteminReport(mCache.mEphemeris, SystemStatusEphemeris());
-    setDefaultIteminReport(mCache.mSvHealth, SystemStatusSvHealth());
-    setDefaultIteminReport(mCache.mPdr, SystemStatusPdr());
-    setDefaultIteminReport(mCache.mNavData, SystemStatusNavData());
+    setDefaultIteminReport(cache.mInjectedPosition, SystemStatusInjectedPosition());
+    setDefaultIteminReport(cache.mBestPosition, SystemStatusBestPosition());
+    setDefaultIteminReport(cache.mXtra, SystemStatusXtra());
+    setDefaultIteminReport(cache.mEphemeris, SystemStatusEphemeris());
+    setDefaultIteminReport(cache.mSvHealth, SystemStatusSvHealth());
+    setDefaultIteminReport(cache.mPdr, SystemStatusPdr());
+    setDefaultIteminReport(cache.mNavData, SystemStatusNavData());
 
-    setDefaultIteminReport(mCache.mPositionFailure, SystemStatusPositionFailure());
+    setDefaultIteminReport(cache.mPositionFailure, SystemStatusPositionFailure());
 
+    commitUpdate();
     pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
 }
@@ -1757,5 +1810,313 @@ bool SystemStatus::updatePowerConnectState(bool charging)
     mSysStatusObsvr.notify({&s});
     return true;
 }
+
+#ifdef __LOC_UNIT_TEST__
+/******************************************************************************
+ SystemStatusItemRing check
+******************************************************************************/
+// an item owning heap memory, so that a slot copied over raw or destroyed
+// twice shows under ASan, which also counts the items alive
+struct SystemStatusCheckItem
+{
+    static const uint32_t maxItem = 5;
+    static int32_t sAlive;
+    std::string mValue;
+    inline SystemStatusCheckItem(uint32_t value) :
+            mValue(std::to_string(value) + std::string(32, 'x')) {
+        sAlive++;
+    }
+    inline SystemStatusCheckItem(const SystemStatusCheckItem& other) : mValue(other.mValue) {
+        sAlive++;
+    }
+    SystemStatusCheckItem& operator=(const SystemStatusCheckItem&) = default;
+    inline ~SystemStatusCheckItem() { sAlive--; }
+    inline bool is(uint32_t value) const {
+        return mValue == SystemStatusCheckItem(value).mValue;
+    }
+};
+int32_t SystemStatusCheckItem::sAlive = 0;
+
+// ring holds the items first to last - 1, the latest maxItem of them
+static uint32_t checkRingItems(const SystemStatusItemRing<SystemStatusCheckItem>& ring,
+                               uint32_t first, uint32_t last)
+{
+    first = std::max(first, (last > SystemStatusCheckItem::maxItem) ?
+                            last - SystemStatusCheckItem::maxItem : 0);
+    uint32_t mismatches = (ring.size() == last - first) ? 0 : 1;
+    std::vector<SystemStatusCheckItem> items;
+    ring.copyTo(items);
+    if (items.size() != ring.size()) {
+        mismatches++;
+    }
+    for (uint32_t i = 0; i < ring.size() && i < items.size(); i++) {
+        if (!ring[i].is(first + i) || !items[i].is(first + i)) {
+            mismatches++;
+        }
+    }
+    if (!ring.empty() && !ring.back().is(last - 1)) {
+        mismatches++;
+    }
+    return mismatches;
+}
+
+uint32_t SystemStatus::checkItemRing()
+{
+    const uint32_t N = SystemStatusCheckItem::maxItem;
+    uint32_t mismatches = 0;
+    {
+        SystemStatusItemRing<SystemStatusCheckItem> ring;
+        mismatches += checkRingItems(ring, 0, 0);
+        // fill, then wrap more than once
+        for (uint32_t i = 0; i < 3 * N + 2; i++) {
+            ring.push_back(SystemStatusCheckItem(i));
+            mismatches += checkRingItems(ring, 0, i + 1);
+        }
+
+        // copies of a part filled ring over a wrapped one and back
+        SystemStatusItemRing<SystemStatusCheckItem> part;
+        part.push_back(SystemStatusCheckItem(100));
+        part.push_back(SystemStatusCheckItem(101));
+        SystemStatusItemRing<SystemStatusCheckItem> copy(ring);
+        mismatches += checkRingItems(copy, 0, 3 * N + 2);
+        copy = part;
+        mismatches += checkRingItems(copy, 100, 102);
+        copy = ring;
+        mismatches += checkRingItems(copy, 0, 3 * N + 2);
+        copy.push_back(SystemStatusCheckItem(3 * N + 2));
+        mismatches += checkRingItems(copy, 0, 3 * N + 3);
+        mismatches += checkRingItems(ring, 0, 3 * N + 2);
+
+        // and filled again after clear
+        ring.clear();
+        mismatches += checkRingItems(ring, 0, 0);
+        if (SystemStatusCheckItem::sAlive != (int32_t)(copy.size() + part.size())) {
+            mismatches++;
+        }
+        for (uint32_t i = 200; i < 200 + N + 1; i++) {
+            ring.push_back(SystemStatusCheckItem(i));
+        }
+        mismatches += checkRingItems(ring, 200, 200 + N + 1);
+    }
+    if (0 != SystemStatusCheckItem::sAlive) {
+        LOC_LOGe("%d ring items not destroyed", SystemStatusCheckItem::sAlive);
+        mismatches++;
+    }
+    return mismatches;
+}
+
+/******************************************************************************
+ debug NMEA parse check and benchmark
+******************************************************************************/
+static const char* const sDebugNmeaCorpus[] = {
+    "$PQWM1,2110,345612000,3,1,12,-2345,120,2,36,1024,1012,-3,5,120,98,0,45,0"
+    ",32.5,30.25,28.0,31.75,18,0,1000,998,1020,1015,1011,1009,15000*37\r\n",
+    "$PQWP1,123519.00,0x3,37.422001,-122.084101,12.5,45,8.5,2*76\r\n",
+    "$PQWP2,123519.00,37.422005,-122.084099,11.8,4.2,6.1*15\r\n",
+    "$PQWP3,123519.00,0x1f,12,14,10,18,9,0xffffffff,0x00ffffff,0x1fffffff,0x0fffffff,0x1f*20\r\n",
+    "$PQWP4,123519.00,0xfffffffe,0x00ffffff,0x1fffffffff,0x0fffffffff,0x1f*0C\r\n",
+    "$PQWP5,123519.00,0x0,0x0,0x0,0x0,0x0,0xffffffff,0x00ffffff,0x1fffffffff,"
+    "0x0fffffffff,0x1f,0x0,0x0,0x0,0x0,0x0*0E\r\n",
+    "$PQWP6,123519.00,0x41*5E\r\n",
+    "$PQWS1,123519.00,5,100*3F\r\n",
+};
+
+static std::vector<std::string> debugNmeaCorpus()
+{
+    std::vector<std::string> corpus(std::begin(sDebugNmeaCorpus), std::end(sDebugNmeaCorpus));
+    // PQWP7 is by far the longest, 3 fields per SV
+    std::string p7 = "PQWP7,123519.00";
+    for (uint32_t i = 0; i < SV_ALL_NUM; i++) {
+        p7 += (i % 4) ? ",1,2,3600" : ",0,0,0";
+    }
+    uint8_t checksum = 0;
+    for (char c : p7) {
+        checksum ^= c;
+    }
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+    corpus.push_back("$" + p7 + tail);
+    return corpus;
+}
+
+uint32_t SystemStatus::checkNmeaParse()
+{
+    std::vector<std::string> corpus = debugNmeaCorpus();
+    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1];
+    uint32_t numBad = 0;
+    for (const std::string& nmea : corpus) {
+        uint32_t len = nmea.size();
+        strlcpy(buf, nmea.c_str(), sizeof(buf));
+        // a field late in each sentence, so all fields before it are split right
+        bool ok = false;
+        switch (SystemStatusNmeaBase::getNmeaId(buf)) {
+        case SystemStatusNmeaBase::getNmeaId("$PQWM1"):
+            ok = (15000 == SystemStatusPQWM1parser(buf, len).get().mTimeUncNs);
+            break;
+        case SystemStatusNmeaBase::getNmeaId("$PQWP1"):
+            ok = (2 == SystemStatusPQWP1parser(buf, len).get().mEpiSrc);
+            break;
+        case SystemStatusNmeaBase::getNmeaId("$PQWP2"):
+            ok = (6.1f == SystemStatusPQWP2parser(buf, len).get().mBestAltUnc);
+            break;
+        case SystemStatusNmeaBase::getNmeaId("$PQWP3"):
+            ok = (0x1f == SystemStatusPQWP3parser(buf, len).get().mQzssXtraValid);
+            break;
+        case SystemStatusNmeaBase::getNmeaId("$PQWP4"):
+            ok = (0x1f == SystemStatusPQWP4parser(buf, len).get().mQzssEpheValid);
+            break;
+        case SystemStatusNmeaBase::getNmeaId("$PQWP5"):
+            ok = (0x0fffffffffULL == SystemStatusPQWP5parser(buf, len).get().mGalGoodMask);
+            break;
+        case SystemStatusNmeaBase::getNmeaId("$PQWP6"):
+            ok = (0x41 == SystemStatusPQWP6parser(buf, len).get().mFixInfoMask);
+            break;
+        case SystemStatusNmeaBase::getNmeaId("$PQWP7"):
+            ok = (3600 == SystemStatusPQWP7parser(buf, len).get().mNav[SV_ALL_NUM - 1].mAgeSec);
+            break;
+        case SystemStatusNmeaBase::getNmeaId("$PQWS1"):
+            ok = (100 == SystemStatusPQWS1parser(buf, len).get().mHepeLimit);
+            break;
+        default:
+            break;
+        }
+        if (!ok) {
+            LOC_LOGe("mis-parsed %s", nmea.c_str());
+            numBad++;
+        }
+    }
+    return numBad;
+}
+
+uint64_t SystemStatus::benchmarkNmeaParse(uint32_t rounds)
+{
+    std::vector<std::string> corpus = debugNmeaCorpus();
+    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1];
+    uint64_t sum = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (const std::string& nmea : corpus) {
+            uint32_t len = nmea.size();
+            strlcpy(buf, nmea.c_str(), sizeof(buf));
+            switch (SystemStatusNmeaBase::getNmeaId(buf)) {
+            case SystemStatusNmeaBase::getNmeaId("$PQWM1"):
+                sum += SystemStatusPQWM1parser(buf, len).get().mTimeUncNs;
+                break;
+            case SystemStatusNmeaBase::getNmeaId("$PQWP1"):
+                sum += SystemStatusPQWP1parser(buf, len).get().mEpiSrc;
+                break;
+            case SystemStatusNmeaBase::getNmeaId("$PQWP2"):
+                sum += SystemStatusPQWP2parser(buf, len).get().mBestHepe;
+                break;
+            case SystemStatusNmeaBase::getNmeaId("$PQWP3"):
+                sum += SystemStatusPQWP3parser(buf, len).get().mQzssXtraValid;
+                break;
+            case SystemStatusNmeaBase::getNmeaId("$PQWP4"):
+                sum += SystemStatusPQWP4parser(buf, len).get().mGalEpheValid;
+                break;
+            case SystemStatusNmeaBase::getNmeaId("$PQWP5"):
+                sum += SystemStatusPQWP5parser(buf, len).get().mQzssBadMask;
+                break;
+            case SystemStatusNmeaBase::getNmeaId("$PQWP6"):
+                sum += SystemStatusPQWP6parser(buf, len).get().mFixInfoMask;
+                break;
+            case SystemStatusNmeaBase::getNmeaId("$PQWP7"):
+                sum += SystemStatusPQWP7parser(buf, len).get().mNav[SV_ALL_NUM - 1].mAgeSec;
+                break;
+            case SystemStatusNmeaBase::getNmeaId("$PQWS1"):
+                sum += SystemStatusPQWS1parser(buf, len).get().mHepeLimit;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    LOC_LOGd("parsed %zu sentences %u times, checksum of fields %" PRIu64,
+             corpus.size(), rounds, sum);
+
+    uint64_t totalNs = (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+    return (0 == rounds) ? 0 : totalNs / ((uint64_t)rounds * corpus.size());
+}
+
+/******************************************************************************
+ concurrent getReport stress test
+******************************************************************************/
+static inline uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// every PQWM1 carries the tick it was sent at both as GPS TOW and as GPS
+// jammer, so TimeAndClock and RfAndParams from one version always pair up
+static bool isReportConsistent(const SystemStatusReports& report)
+{
+    if (report.mTimeAndClock.size() != report.mRfAndParams.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < report.mTimeAndClock.size(); i++) {
+        if (report.mTimeAndClock[i].mGpsTowMs != report.mRfAndParams[i].mJammerGps ||
+            (i > 0 && report.mTimeAndClock[i].mGpsTowMs <=
+                      report.mTimeAndClock[i - 1].mGpsTowMs)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t SystemStatus::stressReport(uint32_t durationMs, uint32_t numReaders,
+                                    uint64_t& maxSetNs)
+{
+    SystemStatus* systemStatus = new SystemStatus(nullptr);
+    std::atomic<bool> stop(false);
+    std::atomic<uint32_t> numBad(0);
+    std::atomic<uint64_t> numReports(0);
+
+    std::vector<std::thread> readers;
+    for (uint32_t r = 0; r < numReaders; r++) {
+        readers.emplace_back([&]() {
+            SystemStatusReports report;
+            while (!stop.load(std::memory_order_relaxed)) {
+                systemStatus->getReport(report, false);
+                if (!isReportConsistent(report)) {
+                    numBad++;
+                }
+                numReports++;
+            }
+        });
+    }
+
+    maxSetNs = 0;
+    uint64_t endNs = monotonicNs() + durationMs * 1000000ULL;
+    char nmea[SystemStatusNmeaBase::NMEA_MAXSIZE];
+    for (uint32_t tick = 1; monotonicNs() < endNs; tick++) {
+        int len = snprintf(nmea, sizeof(nmea),
+                "$PQWM1,2110,%u,3,1,12,-2345,120,2,36,1024,1012,-3,5,%u,98,0,45,0"
+                ",32.5,30.25,28.0,31.75,18,0,1000,998,1020,1015,1011,1009,15000*00\r\n",
+                tick, tick);
+        uint64_t startNs = monotonicNs();
+        systemStatus->setNmeaString(nmea, len);
+        uint64_t setNs = monotonicNs() - startNs;
+        if (setNs > maxSetNs) {
+            maxSetNs = setNs;
+        }
+        // 20 Hz, the fastest rate the modem sends debug NMEA at
+        usleep(50000);
+    }
+
+    stop = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    LOC_LOGd("%" PRIu64 " reports read, %u inconsistent, longest setNmeaString %" PRIu64 " ns",
+             numReports.load(), numBad.load(), maxSetNs);
+    delete systemStatus;
+    return numBad;
+}
+#endif
+
 } // namespace loc_core
 
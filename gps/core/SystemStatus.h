@@ -34,6 +34,10 @@
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <functional>
+#include <atomic>
+#include <new>
+#include <type_traits>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <MsgTask.h>
@@ -826,55 +830,190 @@ public:
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
-class SystemStatusReports
+/******************************************************************************
+ SystemStatusItemRing - history of the latest items of one type
+******************************************************************************/
+// Fixed capacity ring of the latest TYPE_ITEM::maxItem items, oldest first.
+// Slots are constructed on first use and then overwritten in place, so adding
+// an item is O(1) and does not allocate once the ring is full.
+template <typename TYPE_ITEM>
+class SystemStatusItemRing
+{
+    static const uint32_t N = TYPE_ITEM::maxItem;
+    typename std::aligned_storage<sizeof(TYPE_ITEM), alignof(TYPE_ITEM)>::type mItems[N];
+    uint32_t mFirst;
+    uint32_t mSize;
+
+    inline TYPE_ITEM* slot(uint32_t i) {
+        return reinterpret_cast<TYPE_ITEM*>(&mItems[(mFirst + i) % N]);
+    }
+    inline const TYPE_ITEM* slot(uint32_t i) const {
+        return reinterpret_cast<const TYPE_ITEM*>(&mItems[(mFirst + i) % N]);
+    }
+
+public:
+    inline SystemStatusItemRing() : mFirst(0), mSize(0) {}
+    inline SystemStatusItemRing(const SystemStatusItemRing& other) : mFirst(0), mSize(0) {
+        *this = other;
+    }
+    inline ~SystemStatusItemRing() { clear(); }
+
+    // slots are filled from 0 and mFirst only moves once the ring is full,
+    // so the constructed slots are always [0, mSize)
+    SystemStatusItemRing& operator=(const SystemStatusItemRing& other) {
+        if (this != &other) {
+            TYPE_ITEM* items = reinterpret_cast<TYPE_ITEM*>(mItems);
+            const TYPE_ITEM* otherItems = reinterpret_cast<const TYPE_ITEM*>(other.mItems);
+            uint32_t i = 0;
+            for (; i < mSize && i < other.mSize; i++) {
+                items[i] = otherItems[i];
+            }
+            for (; i < other.mSize; i++) {
+                new (&items[i]) TYPE_ITEM(otherItems[i]);
+            }
+            for (; i < mSize; i++) {
+                items[i].~TYPE_ITEM();
+            }
+            mFirst = other.mFirst;
+            mSize = other.mSize;
+        }
+        return *this;
+    }
+
+    inline bool empty() const { return 0 == mSize; }
+    inline uint32_t size() const { return mSize; }
+    // 0 is the oldest item
+    inline TYPE_ITEM& operator[](uint32_t i) { return *slot(i); }
+    inline const TYPE_ITEM& operator[](uint32_t i) const { return *slot(i); }
+    inline TYPE_ITEM& back() { return *slot(mSize - 1); }
+    inline const TYPE_ITEM& back() const { return *slot(mSize - 1); }
+
+    // adds item as the latest, replacing the oldest one if full
+    void push_back(const TYPE_ITEM& item) {
+        if (mSize < N) {
+            new (slot(mSize)) TYPE_ITEM(item);
+            mSize++;
+        } else {
+            *slot(0) = item;
+            mFirst = (mFirst + 1) % N;
+        }
+    }
+
+    void clear() {
+        for (uint32_t i = 0; i < mSize; i++) {
+            slot(i)->~TYPE_ITEM();
+        }
+        mFirst = 0;
+        mSize = 0;
+    }
+
+    void copyTo(std::vector<TYPE_ITEM>& out) const {
+        out.clear();
+        out.reserve(mSize);
+        for (uint32_t i = 0; i < mSize; i++) {
+            out.push_back(*slot(i));
+        }
+    }
+};
+
+// SystemStatusItemRing in one version of the cache. Every change stamps it
+// with a new version number, so that bringing the same ring of another
+// version of the cache up to date copies it only if it changed since.
+template <typename TYPE_ITEM>
+class SystemStatusVersionedRing
+{
+    SystemStatusItemRing<TYPE_ITEM> mRing;
+    uint64_t mVersion;
+
+    inline SystemStatusItemRing<TYPE_ITEM>& mutate() {
+        mVersion++;
+        return mRing;
+    }
+
+public:
+    inline SystemStatusVersionedRing() : mVersion(0) {}
+    SystemStatusVersionedRing(const SystemStatusVersionedRing& other) = default;
+    inline SystemStatusVersionedRing& operator=(const SystemStatusVersionedRing& other) {
+        if (mVersion != other.mVersion) {
+            mRing = other.mRing;
+            mVersion = other.mVersion;
+        }
+        return *this;
+    }
+
+    inline bool empty() const { return mRing.empty(); }
+    inline uint32_t size() const { return mRing.size(); }
+    inline const TYPE_ITEM& operator[](uint32_t i) const { return mRing[i]; }
+    inline const TYPE_ITEM& back() const { return mRing.back(); }
+    inline TYPE_ITEM& back() { return mutate().back(); }
+    inline void push_back(const TYPE_ITEM& item) { mutate().push_back(item); }
+    inline void clear() { mutate().clear(); }
+    inline void copyTo(std::vector<TYPE_ITEM>& out) const { mRing.copyTo(out); }
+};
+
+template <typename TYPE_ITEM>
+using SystemStatusItemVector = std::vector<TYPE_ITEM>;
+
+/******************************************************************************
+ SystemStatusReports
+******************************************************************************/
+// the reports of every item type, each kept in a C<item type> container
+template <template <typename> class C>
+class SystemStatusReportsBase
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    C<SystemStatusLocation>                   mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    C<SystemStatusTimeAndClock>               mTimeAndClock;
+    C<SystemStatusXoState>                    mXoState;
+    C<SystemStatusRfAndParams>                mRfAndParams;
+    C<SystemStatusErrRecovery>                mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    C<SystemStatusInjectedPosition>           mInjectedPosition;
+    C<SystemStatusBestPosition>               mBestPosition;
+    C<SystemStatusXtra>                       mXtra;
+    C<SystemStatusEphemeris>                  mEphemeris;
+    C<SystemStatusSvHealth>                   mSvHealth;
+    C<SystemStatusPdr>                        mPdr;
+    C<SystemStatusNavData>                    mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    C<SystemStatusPositionFailure>            mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusAirplaneMode>     mAirplaneMode;
-    std::vector<SystemStatusENH>              mENH;
-    std::vector<SystemStatusGpsState>         mGPSState;
-    std::vector<SystemStatusNLPStatus>        mNLPStatus;
-    std::vector<SystemStatusWifiHardwareState> mWifiHardwareState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusServiceInfo>      mRilServiceInfo;
-    std::vector<SystemStatusRilCellInfo>      mRilCellInfo;
-    std::vector<SystemStatusServiceStatus>    mServiceStatus;
-    std::vector<SystemStatusModel>            mModel;
-    std::vector<SystemStatusManufacturer>     mManufacturer;
-    std::vector<SystemStatusAssistedGps>      mAssistedGps;
-    std::vector<SystemStatusScreenState>      mScreenState;
-    std::vector<SystemStatusPowerConnectState> mPowerConnectState;
-    std::vector<SystemStatusTimeZoneChange>   mTimeZoneChange;
-    std::vector<SystemStatusTimeChange>       mTimeChange;
-    std::vector<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
-    std::vector<SystemStatusShutdownState>    mShutdownState;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
-    std::vector<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
-    std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+    C<SystemStatusAirplaneMode>               mAirplaneMode;
+    C<SystemStatusENH>                        mENH;
+    C<SystemStatusGpsState>                   mGPSState;
+    C<SystemStatusNLPStatus>                  mNLPStatus;
+    C<SystemStatusWifiHardwareState>          mWifiHardwareState;
+    C<SystemStatusNetworkInfo>                mNetworkInfo;
+    C<SystemStatusServiceInfo>                mRilServiceInfo;
+    C<SystemStatusRilCellInfo>                mRilCellInfo;
+    C<SystemStatusServiceStatus>              mServiceStatus;
+    C<SystemStatusModel>                      mModel;
+    C<SystemStatusManufacturer>               mManufacturer;
+    C<SystemStatusAssistedGps>                mAssistedGps;
+    C<SystemStatusScreenState>                mScreenState;
+    C<SystemStatusPowerConnectState>          mPowerConnectState;
+    C<SystemStatusTimeZoneChange>             mTimeZoneChange;
+    C<SystemStatusTimeChange>                 mTimeChange;
+    C<SystemStatusWifiSupplicantStatus>       mWifiSupplicantStatus;
+    C<SystemStatusShutdownState>              mShutdownState;
+    C<SystemStatusTac>                        mTac;
+    C<SystemStatusMccMnc>                     mMccMnc;
+    C<SystemStatusBtDeviceScanDetail>         mBtDeviceScanDetail;
+    C<SystemStatusBtleDeviceScanDetail>       mBtLeDeviceScanDetail;
 };
 
+// copy of the reports handed out by SystemStatus::getReport
+typedef SystemStatusReportsBase<SystemStatusItemVector> SystemStatusReports;
+// one version of the reports cached by SystemStatus, read in place with
+// visitReport
+typedef SystemStatusReportsBase<SystemStatusVersionedRing> SystemStatusCache;
+
 /******************************************************************************
  SystemStatus
 ******************************************************************************/
@@ -889,8 +1028,26 @@ private:
     inline ~SystemStatus() {}
 
     // Data members
+    // Writers serialize on mMutexSystemStatus, readers take no lock. There
+    // are two versions of the cache. Readers read the latest one, and a
+    // writer updates the other one, once the readers still on it from
+    // before it was replaced are done, then publishes it as the latest.
+    // Each reader counts itself in mReaders of the version it reads, so
+    // writers only wait for readers of the version they replaced last.
     static pthread_mutex_t                    mMutexSystemStatus;
-    SystemStatusReports mCache;
+    SystemStatusCache                         mCache[2];
+    std::atomic<uint32_t>                     mLatest;
+    mutable std::atomic<uint32_t>             mReaders[2];
+
+    // mMutexSystemStatus must be held from beginUpdate() to commitUpdate()
+    SystemStatusCache& beginUpdate();
+    void commitUpdate();
+    // returns the latest version, left as it is until endRead(); the
+    // reader must not update SystemStatus before endRead()
+    uint32_t beginRead() const;
+    inline void endRead(uint32_t version) const {
+        mReaders[version].fetch_sub(1, std::memory_order_release);
+    }
 
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     bool setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s);
@@ -900,7 +1057,8 @@ private:
     void setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s);
 
     template <typename TYPE_REPORT, typename TYPE_ITEM>
-    void getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const;
+    void getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c,
+                         bool isLatestOnly) const;
 
 public:
     // Static methods
@@ -913,11 +1071,34 @@ public:
     bool eventDataItemNotify(IDataItemCore* dataitem);
     bool setNmeaString(const char *data, uint32_t len);
     bool getReport(SystemStatusReports& reports, bool isLatestonly = false) const;
+    bool visitReport(const std::function<void(const SystemStatusCache& reports)>& visitor) const;
     bool setDefaultGnssEngineStates(void);
     bool eventConnectionStatus(bool connected, int8_t type,
                                bool roaming, NetworkHandle networkHandle, string& apn);
     bool updatePowerConnectState(bool charging);
     void resetNetworkInfo();
+
+#ifdef __LOC_UNIT_TEST__
+    // fills SystemStatusItemRings of an item that owns heap memory past
+    // wrapping, copies them over each other, to vectors and clears them.
+    // Returns the number of items not where they should be, or not
+    // destroyed exactly once; 0 on success.
+    static uint32_t checkItemRing();
+
+    // parses a debug NMEA corpus with one sentence of each type and
+    // returns the number of sentences mis-parsed, 0 on success
+    static uint32_t checkNmeaParse();
+    // parses the same corpus rounds times, without storing the results,
+    // and returns ns per sentence
+    static uint64_t benchmarkNmeaParse(uint32_t rounds);
+
+    // feeds PQWM1 at 20 Hz for durationMs while numReaders threads call
+    // getReport(isLatestOnly=false) back to back. Returns the number of
+    // reports that mixed two versions of the cache, 0 on success, and the
+    // longest setNmeaString call in maxSetNs.
+    static uint32_t stressReport(uint32_t durationMs, uint32_t numReaders,
+                                 uint64_t& maxSetNs);
+#endif
 };
 
 } // namespace loc_core
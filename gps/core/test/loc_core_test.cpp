@@ -0,0 +1,56 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_CoreTest"
+
+// Runs the __LOC_UNIT_TEST__ self checks of libloc_core. Exits non-zero
+// if any of them fails.
+
+#include <LocUnitTest.h>
+#include <SystemStatus.h>
+
+using namespace loc_util;
+using namespace loc_core;
+
+int main(int argc, char** argv) {
+    LocUnitTest test(argc, argv);
+    test.report("SystemStatus item ring", SystemStatus::checkItemRing());
+    test.report("SystemStatus debug NMEA parse", SystemStatus::checkNmeaParse());
+    uint64_t maxSetNs = 0;
+    test.report("SystemStatus concurrent getReport",
+                SystemStatus::stressReport(2000, 4, maxSetNs));
+    printf("longest setNmeaString %" PRIu64 " ns\n", maxSetNs);
+
+    if (test.runBenchmarks()) {
+        printf("debug NMEA parse %" PRIu64 " ns per sentence\n",
+               SystemStatus::benchmarkNmeaParse(100000));
+    }
+
+    return test.finish();
+}
@@ -47,6 +47,7 @@
 #include <SystemStatus.h>
 #include <vector>
 #include <loc_misc_utils.h>
+#include <LocMsgPool.h>
 #include <gps_extended_c.h>
 
 #define RAD2DEG    (180.0 / M_PI)
@@ -2987,7 +2988,11 @@ GnssAdapter::startTrackingCommand(LocationAPI* client, TrackingOptions& options)
             mApi(api),
             mClient(client),
             mSessionId(sessionId),
-            mOptions(options) {}
+            mOptions(options) {
+            // after the client updates it depends on, and ahead of the
+            // positions that follow it
+            setInOrder();
+        }
         inline virtual void proc() const {
             // distance based tracking will need to know engine capabilities before it can start
             if (!mAdapter.isEngineCapabilitiesKnown() && mOptions.minDistance > 0) {
@@ -3192,7 +3197,11 @@ GnssAdapter::updateTrackingOptionsCommand(LocationAPI* client, uint32_t id,
             mApi(api),
             mClient(client),
             mSessionId(sessionId),
-            mOptions(options) {}
+            mOptions(options) {
+            // after the client updates it depends on, and ahead of the
+            // positions that follow it
+            setInOrder();
+        }
         inline virtual void proc() const {
             // distance based tracking will need to know engine capabilities before it can start
             if (!mAdapter.isEngineCapabilitiesKnown() && mOptions.minDistance > 0) {
@@ -3372,7 +3381,11 @@ GnssAdapter::stopTrackingCommand(LocationAPI* client, uint32_t id)
             mAdapter(adapter),
             mApi(api),
             mClient(client),
-            mSessionId(sessionId) {}
+            mSessionId(sessionId) {
+            // after the client updates it depends on, and ahead of the
+            // positions that follow it
+            setInOrder();
+        }
         inline virtual void proc() const {
             bool isTimeBased = mAdapter.isTimeBasedTrackingSession(mClient, mSessionId);
             bool isDistanceBased = mAdapter.isDistanceBasedTrackingSession(mClient, mSessionId);
@@ -3759,7 +3772,7 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
              locationExtended.locOutputEngType,
              ulpLocation.unpropagatedPosition, status, msInWeek);
 
-    struct MsgReportSPEPosition : public LocMsg {
+    struct MsgReportSPEPosition : public LocPooledMsg<MsgReportSPEPosition> {
         GnssAdapter& mAdapter;
         mutable UlpLocation mUlpLocation;
         mutable GpsLocationExtended mLocationExtended;
@@ -3773,16 +3786,24 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
                                     const GpsLocationExtended& locationExtended,
                                     enum loc_sess_status status,
                                     LocPosTechMask techMask,
-                                    GnssDataNotification dataNotify,
+                                    const GnssDataNotification* pDataNotify,
                                     int msInWeek) :
-            LocMsg(),
+            LocPooledMsg(),
             mAdapter(adapter),
             mUlpLocation(ulpLocation),
             mLocationExtended(locationExtended),
             mStatus(status),
             mTechMask(techMask),
-            mDataNotify(dataNotify),
-            mMsInWeek(msInWeek) {}
+            mMsInWeek(msInWeek) {
+            if (nullptr != pDataNotify) {
+                mDataNotify = *pDataNotify;
+                mDataNotify.size = sizeof(mDataNotify);
+            } else {
+                memset(&mDataNotify, 0, sizeof(mDataNotify));
+            }
+            setPriority(LOC_MSG_PRIORITY_REALTIME);
+            setDeadline(POSITION_REPORT_DELIVERY_DEADLINE_MS);
+        }
         inline virtual void proc() const {
             if (mAdapter.mTimeBasedTrackingSessions.empty() &&
                 mAdapter.mDistanceBasedTrackingSessions.empty()) {
@@ -3835,13 +3856,8 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
     };
 
     if (mContext != NULL) {
-        GnssDataNotification dataNotifyCopy = {};
-        if (pDataNotify) {
-            dataNotifyCopy = *pDataNotify;
-            dataNotifyCopy.size = sizeof(dataNotifyCopy);
-        }
         sendMsg(new MsgReportSPEPosition(*this, ulpLocation, locationExtended,
-                                          status, techMask, dataNotifyCopy, msInWeek));
+                                          status, techMask, pDataNotify, msInWeek));
     }
 }
 
@@ -3849,14 +3865,14 @@ void
 GnssAdapter::reportEnginePositionsEvent(unsigned int count,
                                         EngineLocationInfo* locationArr)
 {
-    struct MsgReportEnginePositions : public LocMsg {
+    struct MsgReportEnginePositions : public LocPooledMsg<MsgReportEnginePositions> {
         GnssAdapter& mAdapter;
         unsigned int mCount;
         EngineLocationInfo mEngLocInfo[LOC_OUTPUT_ENGINE_COUNT];
         inline MsgReportEnginePositions(GnssAdapter& adapter,
                                         unsigned int count,
                                         EngineLocationInfo* locationArr) :
-            LocMsg(),
+            LocPooledMsg(),
             mAdapter(adapter),
             mCount(count) {
             if (mCount > LOC_OUTPUT_ENGINE_COUNT) {
@@ -3865,6 +3881,8 @@ GnssAdapter::reportEnginePositionsEvent(unsigned int count,
             if (mCount > 0) {
                 memcpy(mEngLocInfo, locationArr, sizeof(EngineLocationInfo)*mCount);
             }
+            setPriority(LOC_MSG_PRIORITY_REALTIME);
+            setDeadline(POSITION_REPORT_DELIVERY_DEADLINE_MS);
         }
         inline virtual void proc() const {
             mAdapter.reportEnginePositions(mCount, mEngLocInfo);
@@ -4078,21 +4096,18 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
         bool custom_nmea_gga = (1 == ContextBase::mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED);
         bool isTagBlockGroupingEnabled =
                 (1 == ContextBase::mGps_conf.NMEA_TAG_BLOCK_GROUPING_ENABLED);
-        std::vector<std::string> nmeaArraystr;
-        int indexOfGGA = -1;
+        char nmea[LOC_NMEA_OUTPUT_SIZE];
+        LocNmeaOutput nmeaOutput(nmea, sizeof(nmea));
         loc_nmea_generate_pos(ulpLocation, locationExtended, mLocSystemInfo, generate_nmea,
-                custom_nmea_gga, nmeaArraystr, indexOfGGA, isTagBlockGroupingEnabled);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
-        }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
+                custom_nmea_gga, nmeaOutput, isTagBlockGroupingEnabled);
+        reportNmea(nmeaOutput.getNmea(), nmeaOutput.getLength());
 
         /* DgnssNtrip */
+        int indexOfGGA = nmeaOutput.getIndexOfGGA();
         if (-1 != indexOfGGA && isDgnssNmeaRequired()) {
             mDgnssState |= DGNSS_STATE_NO_NMEA_PENDING;
-            mStartDgnssNtripParams.nmea = std::move(nmeaArraystr[indexOfGGA]);
+            mStartDgnssNtripParams.nmea.assign(nmeaOutput.getSentence(indexOfGGA),
+                                               nmeaOutput.getSentenceLength(indexOfGGA));
             bool isLocationValid = (0 != ulpLocation.gpsLocation.latitude) ||
                     (0 != ulpLocation.gpsLocation.longitude);
             checkUpdateDgnssNtrip(isLocationValid);
@@ -4103,13 +4118,18 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
 void
 GnssAdapter::reportLatencyInfoEvent(const GnssLatencyInfo& gnssLatencyInfo)
 {
-    struct MsgReportLatencyInfo : public LocMsg {
+    struct MsgReportLatencyInfo : public LocPooledMsg<MsgReportLatencyInfo> {
         GnssAdapter& mAdapter;
         GnssLatencyInfo mGnssLatencyInfo;
         inline MsgReportLatencyInfo(GnssAdapter& adapter,
             const GnssLatencyInfo& gnssLatencyInfo) :
             mGnssLatencyInfo(gnssLatencyInfo),
-            mAdapter(adapter) {}
+            mAdapter(adapter) {
+            // logLatencyInfo() pairs each position with the front of the
+            // queue, so every entry must be queued ahead of its position,
+            // in the lane of positions and never coalesced
+            setPriority(LOC_MSG_PRIORITY_REALTIME);
+        }
         inline virtual void proc() const {
             mAdapter.mGnssLatencyInfoQueue.push(mGnssLatencyInfo);
             LOC_LOGv("mGnssLatencyInfoQueue.size after push=%zu",
@@ -4188,14 +4208,17 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
         }
     }
 
-    struct MsgReportSv : public LocMsg {
+    struct MsgReportSv : public LocPooledMsg<MsgReportSv> {
         GnssAdapter& mAdapter;
         const GnssSvNotification mSvNotify;
         inline MsgReportSv(GnssAdapter& adapter,
                            const GnssSvNotification& svNotify) :
-            LocMsg(),
+            LocPooledMsg(),
             mAdapter(adapter),
-            mSvNotify(svNotify) {}
+            mSvNotify(svNotify) {
+            setPriority(LOC_MSG_PRIORITY_BULK);
+            coalesceByType();
+        }
         inline virtual void proc() const {
             mAdapter.reportSv((GnssSvNotification&)mSvNotify);
         }
@@ -4351,14 +4374,10 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
         !mTimeBasedTrackingSessions.empty()) {
-        std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_sv(svNotify, nmeaArraystr);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
-        }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
+        char nmea[LOC_NMEA_OUTPUT_SIZE];
+        LocNmeaOutput nmeaOutput(nmea, sizeof(nmea));
+        loc_nmea_generate_sv(svNotify, nmeaOutput);
+        reportNmea(nmeaOutput.getNmea(), nmeaOutput.getLength());
     }
 
     mGnssSvIdUsedInPosAvail = false;
@@ -4373,17 +4392,21 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
         return;
     }
 
-    struct MsgReportNmea : public LocMsg {
+    struct MsgReportNmea : public LocPooledMsg<MsgReportNmea> {
         GnssAdapter& mAdapter;
+        // sentences of up to NMEA_SENTENCE_MAX_LENGTH are kept in place,
+        // only expanded ones need a heap buffer
+        char mNmeaBuf[NMEA_SENTENCE_MAX_LENGTH + 1];
         const char* mNmea;
         size_t mLength;
         inline MsgReportNmea(GnssAdapter& adapter,
                              const char* nmea,
                              size_t length) :
-            LocMsg(),
+            LocPooledMsg(),
             mAdapter(adapter),
-            mNmea(new char[length+1]),
+            mNmea(length < sizeof(mNmeaBuf) ? mNmeaBuf : new char[length+1]),
             mLength(length) {
+                setPriority(LOC_MSG_PRIORITY_BULK);
                 if (mNmea == nullptr) {
                     LOC_LOGE("%s] new allocation failed, fatal error.", __func__);
                     return;
@@ -4392,7 +4415,9 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
             }
         inline virtual ~MsgReportNmea()
         {
-            delete[] mNmea;
+            if (mNmea != mNmeaBuf) {
+                delete[] mNmea;
+            }
         }
         inline virtual void proc() const {
             // extract bug report info - this returns true if consumed by systemstatus
@@ -4441,17 +4466,19 @@ void
 GnssAdapter::reportDataEvent(const GnssDataNotification& dataNotify,
                              int msInWeek)
 {
-    struct MsgReportData : public LocMsg {
+    struct MsgReportData : public LocPooledMsg<MsgReportData> {
         GnssAdapter& mAdapter;
         GnssDataNotification mDataNotify;
         int mMsInWeek;
         inline MsgReportData(GnssAdapter& adapter,
                              const GnssDataNotification& dataNotify,
                              int msInWeek) :
-            LocMsg(),
+            LocPooledMsg(),
             mAdapter(adapter),
             mDataNotify(dataNotify),
             mMsInWeek(msInWeek) {
+            setPriority(LOC_MSG_PRIORITY_BULK);
+            coalesceByType();
         }
         inline virtual void proc() const {
             if (mMsInWeek >= 0) {
@@ -4771,16 +4798,17 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
     LOC_LOGD("%s]: msInWeek=%d", __func__, msInWeek);
 
     if (0 != gnssMeasurements.gnssMeasNotification.count) {
-        struct MsgReportGnssMeasurementData : public LocMsg {
+        struct MsgReportGnssMeasurementData :
+                public LocPooledMsg<MsgReportGnssMeasurementData> {
             GnssAdapter& mAdapter;
-            GnssMeasurements mGnssMeasurements;
             GnssMeasurementsNotification mMeasurementsNotify;
             inline MsgReportGnssMeasurementData(GnssAdapter& adapter,
                                                 const GnssMeasurements& gnssMeasurements,
                                                 int msInWeek) :
-                    LocMsg(),
+                    LocPooledMsg(),
                     mAdapter(adapter),
                     mMeasurementsNotify(gnssMeasurements.gnssMeasNotification) {
+                setPriority(LOC_MSG_PRIORITY_BULK);
                 if (-1 != msInWeek) {
                     mAdapter.getAgcInformation(mMeasurementsNotify, msInWeek);
                 }
@@ -5418,7 +5446,7 @@ void GnssAdapter::dataConnFailedCommand(AGpsExtType agpsType){
 
 void GnssAdapter::convertSatelliteInfo(std::vector<GnssDebugSatelliteInfo>& out,
                                        const GnssSvType& in_constellation,
-                                       const SystemStatusReports& in)
+                                       const SystemStatusCache& in)
 {
     uint64_t sv_mask = 0ULL;
     uint32_t svid_min = 0;
@@ -5573,9 +5601,16 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
         return false;
     }
 
-    SystemStatusReports reports = {};
-    systemstatus->getReport(reports, true);
+    // read the latest reports in place instead of copying them
+    systemstatus->visitReport([&r](const SystemStatusCache& reports) {
+        fillDebugReport(r, reports);
+    });
+
+    return true;
+}
 
+void GnssAdapter::fillDebugReport(GnssDebugReport& r, const SystemStatusCache& reports)
+{
     r.size = sizeof(r);
 
     // location block
@@ -5669,8 +5704,6 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
     convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_GALILEO, reports);
     convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_NAVIC, reports);
     LOC_LOGV("getDebugReport - satellite=%zu", r.mSatelliteInfo.size());
-
-    return true;
 }
 
 /* get AGC information from system status and fill it */
@@ -5680,48 +5713,54 @@ GnssAdapter::getAgcInformation(GnssMeasurementsNotification& measurements, int m
     SystemStatus* systemstatus = getSystemStatus();
 
     if (nullptr != systemstatus) {
-        SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
-
-        if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
-            (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
-
-            for (size_t i = 0; i < measurements.count; i++) {
-                switch (measurements.measurements[i].svType) {
-                case GNSS_SV_TYPE_GPS:
-                case GNSS_SV_TYPE_QZSS:
-                    measurements.measurements[i].agcLevelDb =
-                            reports.mRfAndParams.back().mAgcGps;
-                    measurements.measurements[i].flags |=
-                            GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
-                    break;
+        systemstatus->visitReport([&](const SystemStatusCache& reports) {
+            fillAgcInformation(measurements, msInWeek, reports);
+        });
+    }
+}
 
-                case GNSS_SV_TYPE_GALILEO:
-                    measurements.measurements[i].agcLevelDb =
-                            reports.mRfAndParams.back().mAgcGal;
-                    measurements.measurements[i].flags |=
-                            GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
-                    break;
+void
+GnssAdapter::fillAgcInformation(GnssMeasurementsNotification& measurements, int msInWeek,
+                                const SystemStatusCache& reports)
+{
+    if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
+        (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
 
-                case GNSS_SV_TYPE_GLONASS:
-                    measurements.measurements[i].agcLevelDb =
-                            reports.mRfAndParams.back().mAgcGlo;
-                    measurements.measurements[i].flags |=
-                            GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
-                    break;
+        for (size_t i = 0; i < measurements.count; i++) {
+            switch (measurements.measurements[i].svType) {
+            case GNSS_SV_TYPE_GPS:
+            case GNSS_SV_TYPE_QZSS:
+                measurements.measurements[i].agcLevelDb =
+                        reports.mRfAndParams.back().mAgcGps;
+                measurements.measurements[i].flags |=
+                        GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
+                break;
 
-                case GNSS_SV_TYPE_BEIDOU:
-                    measurements.measurements[i].agcLevelDb =
-                            reports.mRfAndParams.back().mAgcBds;
-                    measurements.measurements[i].flags |=
-                            GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
-                    break;
+            case GNSS_SV_TYPE_GALILEO:
+                measurements.measurements[i].agcLevelDb =
+                        reports.mRfAndParams.back().mAgcGal;
+                measurements.measurements[i].flags |=
+                        GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
+                break;
 
-                case GNSS_SV_TYPE_SBAS:
-                case GNSS_SV_TYPE_UNKNOWN:
-                default:
-                    break;
-                }
+            case GNSS_SV_TYPE_GLONASS:
+                measurements.measurements[i].agcLevelDb =
+                        reports.mRfAndParams.back().mAgcGlo;
+                measurements.measurements[i].flags |=
+                        GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
+                break;
+
+            case GNSS_SV_TYPE_BEIDOU:
+                measurements.measurements[i].agcLevelDb =
+                        reports.mRfAndParams.back().mAgcBds;
+                measurements.measurements[i].flags |=
+                        GNSS_MEASUREMENTS_DATA_AUTOMATIC_GAIN_CONTROL_BIT;
+                break;
+
+            case GNSS_SV_TYPE_SBAS:
+            case GNSS_SV_TYPE_UNKNOWN:
+            default:
+                break;
             }
         }
     }
@@ -5735,82 +5774,88 @@ GnssAdapter::getDataInformation(GnssDataNotification& data, int msInWeek)
 
     LOC_LOGV("%s]: msInWeek=%d", __func__, msInWeek);
     if (nullptr != systemstatus) {
-        SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
-
-        if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
-            (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
-
-            for (int sig = GNSS_LOC_SIGNAL_TYPE_GPS_L1CA;
-                 sig < GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES; sig++) {
-                data.gnssDataMask[sig] = 0;
-                data.jammerInd[sig] = 0.0;
-                data.agc[sig] = 0.0;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGps) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] =
-                        reports.mRfAndParams.back().mAgcGps;
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] =
-                        reports.mRfAndParams.back().mAgcGps;
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] =
+        systemstatus->visitReport([&](const SystemStatusCache& reports) {
+            fillDataInformation(data, msInWeek, reports);
+        });
+    }
+}
+
+void
+GnssAdapter::fillDataInformation(GnssDataNotification& data, int msInWeek,
+                                 const SystemStatusCache& reports)
+{
+    if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
+        (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
+
+        for (int sig = GNSS_LOC_SIGNAL_TYPE_GPS_L1CA;
+             sig < GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES; sig++) {
+            data.gnssDataMask[sig] = 0;
+            data.jammerInd[sig] = 0.0;
+            data.agc[sig] = 0.0;
+        }
+        if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGps) {
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] |=
+                    GNSS_LOC_DATA_AGC_BIT;
+            data.agc[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] =
                     reports.mRfAndParams.back().mAgcGps;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGps) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] =
-                        (double)reports.mRfAndParams.back().mJammerGps;
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] =
-                        (double)reports.mRfAndParams.back().mJammerGps;
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] =
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] |=
+                    GNSS_LOC_DATA_AGC_BIT;
+            data.agc[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] =
+                    reports.mRfAndParams.back().mAgcGps;
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] |=
+                    GNSS_LOC_DATA_AGC_BIT;
+            data.agc[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] =
+                reports.mRfAndParams.back().mAgcGps;
+        }
+        if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGps) {
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] |=
+                    GNSS_LOC_DATA_JAMMER_IND_BIT;
+            data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GPS_L1CA] =
                     (double)reports.mRfAndParams.back().mJammerGps;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGlo) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] =
-                        reports.mRfAndParams.back().mAgcGlo;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGlo) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] =
-                        (double)reports.mRfAndParams.back().mJammerGlo;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcBds) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] =
-                        reports.mRfAndParams.back().mAgcBds;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerBds) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] =
-                        (double)reports.mRfAndParams.back().mJammerBds;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGal) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] |=
-                        GNSS_LOC_DATA_AGC_BIT;
-                data.agc[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] =
-                        reports.mRfAndParams.back().mAgcGal;
-            }
-            if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGal) {
-                data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] |=
-                        GNSS_LOC_DATA_JAMMER_IND_BIT;
-                data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] =
-                        (double)reports.mRfAndParams.back().mJammerGal;
-            }
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] |=
+                    GNSS_LOC_DATA_JAMMER_IND_BIT;
+            data.jammerInd[GNSS_LOC_SIGNAL_TYPE_QZSS_L1CA] =
+                    (double)reports.mRfAndParams.back().mJammerGps;
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] |=
+                    GNSS_LOC_DATA_JAMMER_IND_BIT;
+            data.jammerInd[GNSS_LOC_SIGNAL_TYPE_SBAS_L1_CA] =
+                (double)reports.mRfAndParams.back().mJammerGps;
+        }
+        if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGlo) {
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] |=
+                    GNSS_LOC_DATA_AGC_BIT;
+            data.agc[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] =
+                    reports.mRfAndParams.back().mAgcGlo;
+        }
+        if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGlo) {
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] |=
+                    GNSS_LOC_DATA_JAMMER_IND_BIT;
+            data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GLONASS_G1] =
+                    (double)reports.mRfAndParams.back().mJammerGlo;
+        }
+        if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcBds) {
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] |=
+                    GNSS_LOC_DATA_AGC_BIT;
+            data.agc[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] =
+                    reports.mRfAndParams.back().mAgcBds;
+        }
+        if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerBds) {
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] |=
+                    GNSS_LOC_DATA_JAMMER_IND_BIT;
+            data.jammerInd[GNSS_LOC_SIGNAL_TYPE_BEIDOU_B1_I] =
+                    (double)reports.mRfAndParams.back().mJammerBds;
+        }
+        if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mAgcGal) {
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] |=
+                    GNSS_LOC_DATA_AGC_BIT;
+            data.agc[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] =
+                    reports.mRfAndParams.back().mAgcGal;
+        }
+        if (GNSS_INVALID_JAMMER_IND != reports.mRfAndParams.back().mJammerGal) {
+            data.gnssDataMask[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] |=
+                    GNSS_LOC_DATA_JAMMER_IND_BIT;
+            data.jammerInd[GNSS_LOC_SIGNAL_TYPE_GALILEO_E1_C] =
+                    (double)reports.mRfAndParams.back().mJammerGal;
         }
     }
 }
@@ -88,6 +88,9 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define LOC_GPS_NI_RESPONSE_IGNORE 4
 #define ODCPI_EXPECTED_INJECTION_TIME_MS 10000
 #define DELETE_AIDING_DATA_EXPECTED_TIME_MS 5000
+// expected time from a position report reaching the adapter to its delivery,
+// exceeding it is counted as late by the MsgTask
+#define POSITION_REPORT_DELIVERY_DEADLINE_MS 100
 
 class GnssAdapter;
 
@@ -310,6 +313,12 @@ class GnssAdapter : public LocAdapterBase {
     LocationSystemInfo mLocSystemInfo;
     std::vector<GnssSvIdSource> mBlacklistedSvIds;
     PowerStateType mSystemPowerState;
+    /* fill in from the latest reports, read in place by visitReport */
+    static void fillDebugReport(GnssDebugReport& r, const SystemStatusCache& reports);
+    static void fillAgcInformation(GnssMeasurementsNotification& measurements, int msInWeek,
+                                   const SystemStatusCache& reports);
+    static void fillDataInformation(GnssDataNotification& data, int msInWeek,
+                                    const SystemStatusCache& reports);
 
     /* === Misc ===================================================================== */
     BlockCPIInfo mBlockCPIInfo;
@@ -634,7 +643,7 @@ public:
     static uint32_t convertSuplMode(const GnssConfigSuplModeMask suplModeMask);
     static void convertSatelliteInfo(std::vector<GnssDebugSatelliteInfo>& out,
                                      const GnssSvType& in_constellation,
-                                     const SystemStatusReports& in);
+                                     const SystemStatusCache& in);
     static bool convertToGnssSvIdConfig(
             const std::vector<GnssSvIdSource>& blacklistedSvIds, GnssSvIdConfig& config);
     static void convertFromGnssSvIdConfig(
@@ -0,0 +1,137 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef LOC_LEVEL_RING_H
+#define LOC_LEVEL_RING_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace loc_util {
+
+// Contiguous replacement for SkipList: one fixed capacity ring per level,
+// allocated up front. Appending to a full level drops its oldest entry,
+// so there is no allocation per entry. Dumps visit the entries in place
+// instead of copying them out.
+template <typename T>
+class LevelRing {
+    struct Ring {
+        std::vector<T> mItems;
+        // index of the oldest entry
+        uint32_t mFront;
+        uint32_t mSize;
+        inline Ring(uint32_t capacity) : mItems(capacity), mFront(0), mSize(0) {}
+        inline const T& at(uint32_t i) const {
+            return mItems[(mFront + i) % mItems.size()];
+        }
+    };
+    std::vector<Ring> mRings;
+    uint32_t mSize;
+
+public:
+    // capacities has the capacity of each level
+    inline LevelRing(const std::vector<uint32_t>& capacities) : mSize(0) {
+        mRings.reserve(capacities.size());
+        for (uint32_t capacity : capacities) {
+            mRings.emplace_back(capacity);
+        }
+    }
+
+    // appends data to level, dropping the oldest entry of the level if it
+    // is full. Returns false if level is out of range or has no capacity.
+    bool append(const T& data, int level) {
+        if (level < 0 || level >= (int)mRings.size() || mRings[level].mItems.empty()) {
+            return false;
+        }
+        Ring& ring = mRings[level];
+        if (ring.mSize == ring.mItems.size()) {
+            pop(level);
+        }
+        ring.mItems[(ring.mFront + ring.mSize) % ring.mItems.size()] = data;
+        ring.mSize++;
+        mSize++;
+        return true;
+    }
+
+    // drops the oldest entry of level, if any
+    inline void pop(int level) {
+        Ring& ring = mRings[level];
+        if (ring.mSize > 0) {
+            ring.mFront = (ring.mFront + 1) % ring.mItems.size();
+            ring.mSize--;
+            mSize--;
+        }
+    }
+
+    // the oldest entry of level, which must not be empty
+    inline const T& front(int level) const { return mRings[level].at(0); }
+
+    inline uint32_t size(int level) const { return mRings[level].mSize; }
+    inline uint32_t size() const { return mSize; }
+
+    inline void flush() {
+        for (Ring& ring : mRings) {
+            ring.mFront = ring.mSize = 0;
+        }
+        mSize = 0;
+    }
+
+    // calls visit(data, level) on the entries of level, oldest first
+    template <typename Visitor>
+    void dump(int level, Visitor visit) const {
+        const Ring& ring = mRings[level];
+        for (uint32_t i = 0; i < ring.mSize; i++) {
+            visit(ring.at(i), level);
+        }
+    }
+
+    // calls visit(data, level) on the entries of all levels, merged in the
+    // order of less(a, b), e.g. by timestamp. Each level must already be
+    // in that order, as it is when entries are appended in that order.
+    template <typename Less, typename Visitor>
+    void dumpMerged(Less less, Visitor visit) const {
+        std::vector<uint32_t> next(mRings.size(), 0);
+        while (true) {
+            int level = -1;
+            for (int l = 0; l < (int)mRings.size(); l++) {
+                if (next[l] < mRings[l].mSize &&
+                    (-1 == level || less(mRings[l].at(next[l]), mRings[level].at(next[level])))) {
+                    level = l;
+                }
+            }
+            if (-1 == level) {
+                break;
+            }
+            visit(mRings[level].at(next[level]++), level);
+        }
+    }
+};
+
+} // namespace loc_util
+
+#endif //LOC_LEVEL_RING_H
@@ -30,7 +30,9 @@
 #define __LOC_HEAP__
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
+#include <vector>
 
 namespace loc_util {
 
@@ -50,51 +52,168 @@ public:
     inline bool outRanks(LocRankable& rankable) { return ranks(rankable) > 0; }
 };
 
-// opaque class to provide service implementation.
-class LocHeapNode;
+// LocHeap Compare for LocRankable types
+template <typename T>
+struct LocRankableCompare {
+    inline bool operator()(T& a, T& b) const { return a.outRanks(b); }
+};
+
+#define LOC_HEAP_INVALID_INDEX UINT32_MAX
+
+// intrusive handle an obj must derive from to be kept in a LocHeap. It
+// holds the position of the obj in the heap array, so the obj can be
+// removed or have its rank updated without searching for it.
+class LocHeapHandle {
+    template <typename T, typename Compare> friend class LocHeap;
+    uint32_t mHeapIndex;
+public:
+    inline LocHeapHandle() : mHeapIndex(LOC_HEAP_INVALID_INDEX) {}
+    inline bool inHeap() const { return LOC_HEAP_INVALID_INDEX != mHeapIndex; }
+};
 
-// a heap whose left and right children are not sorted. It is sorted only vertically,
-// i.e. parent always ranks higher than children, if they exist. Ranking algorithm is
-// implemented in Rankable. The reason that there is no sort between children is to
-// help beter balance the tree with lower cost. When a node is pushed to the tree,
-// it is guaranteed that the subtree that is smaller gets to have the new node.
+// a 4-ary heap kept in an array of pointers to T, which must derive from
+// LocHeapHandle. Compare(a, b) is true if a ranks higher than b, i.e. is
+// to be closer to the top. The array only grows, so once it reaches its
+// high water mark push / pop / remove / update do not allocate.
+// objs are managed by the client, which creates and destroys them. The
+// destroy should happen after the obj is popped or removed from the heap.
+template <typename T, typename Compare = LocRankableCompare<T>>
 class LocHeap {
-protected:
-    LocHeapNode* mTree;
+    std::vector<T*> mNodes;
+    Compare mCompare;
+
+    static inline uint32_t& indexOf(T& node) {
+        return static_cast<LocHeapHandle&>(node).mHeapIndex;
+    }
+    inline void place(T* node, uint32_t index) {
+        mNodes[index] = node;
+        indexOf(*node) = index;
+    }
+    // moves the node at index up until its parent outranks it
+    void siftUp(uint32_t index) {
+        T* node = mNodes[index];
+        while (index > 0) {
+            uint32_t parent = (index - 1) / 4;
+            if (!mCompare(*node, *mNodes[parent])) {
+                break;
+            }
+            place(mNodes[parent], index);
+            index = parent;
+        }
+        place(node, index);
+    }
+    // moves the node at index down until it outranks all its children
+    void siftDown(uint32_t index) {
+        T* node = mNodes[index];
+        uint32_t size = mNodes.size();
+        while (true) {
+            uint32_t first = index * 4 + 1;
+            if (first >= size) {
+                break;
+            }
+            uint32_t last = (first + 4 < size) ? first + 4 : size;
+            uint32_t best = first;
+            for (uint32_t child = first + 1; child < last; child++) {
+                if (mCompare(*mNodes[child], *mNodes[best])) {
+                    best = child;
+                }
+            }
+            if (!mCompare(*mNodes[best], *node)) {
+                break;
+            }
+            place(mNodes[best], index);
+            index = best;
+        }
+        place(node, index);
+    }
+
 public:
-    inline LocHeap() : mTree(NULL) {}
-    ~LocHeap();
-
-    // push keeps the tree sorted by rank, it also tries to balance the
-    // tree by adding the new node to the smaller of the subtrees.
-    // node is reference to an obj that is managed by client, that client
-    //      creates and destroyes. The destroy should happen after the
-    //      node is popped out from the heap.
-    void push(LocRankable& node);
-
-    // Peeks the node data on tree top, which has currently the highest ranking
-    // There is no change the tree structure with this operation
-    // Returns NULL if the tree is empty, otherwise pointer to the node data of
-    //         the tree top.
-    LocRankable* peek();
-
-    // pop keeps the tree sorted by rank, but it does not try to balance
-    // the tree.
-    // Return - pointer to the node popped out, or NULL if heap is already empty
-    LocRankable* pop();
-
-    // navigating through the tree and find the node that ranks the same
-    // as the input data, then remove it from the tree. Rank is implemented
-    // by rankable obj.
-    // returns the pointer to the node removed; or NULL (if failed).
-    LocRankable* remove(LocRankable& rankable);
+    inline LocHeap() {}
+    inline LocHeap(const Compare& compare) : mCompare(compare) {}
+    inline ~LocHeap() {
+        for (T* node : mNodes) {
+            indexOf(*node) = LOC_HEAP_INVALID_INDEX;
+        }
+    }
+
+    inline uint32_t size() const { return mNodes.size(); }
+    inline bool empty() const { return mNodes.empty(); }
+    inline void reserve(uint32_t capacity) { mNodes.reserve(capacity); }
+
+    // node must not be in a heap already
+    inline void push(T& node) {
+        mNodes.push_back(&node);
+        siftUp(mNodes.size() - 1);
+    }
+
+    // the node ranking highest, NULL if the heap is empty
+    inline T* peek() const {
+        return mNodes.empty() ? NULL : mNodes[0];
+    }
+
+    // removes and returns the node ranking highest, NULL if the heap is empty
+    inline T* pop() {
+        T* top = peek();
+        if (NULL != top) {
+            remove(*top);
+        }
+        return top;
+    }
+
+    // removes the node, O(log n). Returns false if it is not in this heap.
+    bool remove(T& node) {
+        uint32_t index = indexOf(node);
+        if (index >= mNodes.size() || mNodes[index] != &node) {
+            return false;
+        }
+        T* last = mNodes.back();
+        mNodes.pop_back();
+        indexOf(node) = LOC_HEAP_INVALID_INDEX;
+        if (last != &node) {
+            place(last, index);
+            update(*last);
+        }
+        return true;
+    }
+
+    // restores the order after the rank of node has changed, up or down,
+    // O(log n). Returns false if it is not in this heap.
+    bool update(T& node) {
+        uint32_t index = indexOf(node);
+        if (index >= mNodes.size() || mNodes[index] != &node) {
+            return false;
+        }
+        if (index > 0 && mCompare(node, *mNodes[(index - 1) / 4])) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+        return true;
+    }
 
 #ifdef __LOC_UNIT_TEST__
-    bool checkTree();
-    uint32_t getTreeSize();
+    // checks that no node is outranked by a child, and that the handle of
+    // every node has its index in the array
+    bool checkTree() {
+        for (uint32_t index = 0; index < mNodes.size(); index++) {
+            if (indexOf(*mNodes[index]) != index ||
+                (index > 0 && mCompare(*mNodes[index], *mNodes[(index - 1) / 4]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    inline uint32_t getTreeSize() { return size(); }
 #endif
 };
 
+#ifdef __LOC_UNIT_TEST__
+// runs numOps random push / pop / remove / update ops on a LocHeap and on
+// a sorted reference container, checking the tree and the top after each.
+// Returns the number of mismatches, 0 on success.
+uint32_t locHeapRandomTest(uint32_t numOps, uint32_t seed);
+#endif
+
 } // namespace loc_util
 
 #endif //__LOC_HEAP__
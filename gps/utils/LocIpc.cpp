@@ -32,10 +32,21 @@
 #include <errno.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
 #include <loc_misc_utils.h>
+#include <loc_cfg.h>
 #include <log_util.h>
 #include <LocIpc.h>
 #include <algorithm>
+#include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <unordered_map>
 
 using namespace std;
 
@@ -58,6 +69,11 @@ namespace loc_util {
         } \
     }
 
+// true if a failed non-blocking receive just found nothing to receive
+static inline bool isNothingToRecv(int err) {
+    return EAGAIN == err || EWOULDBLOCK == err || EINTR == err;
+}
+
 const char Sock::MSG_ABORT[] = "LocIpc::Sock::ABORT";
 const char Sock::LOC_IPC_HEAD[] = "$MSGLEN$";
 ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
@@ -96,29 +112,38 @@ ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockad
 }
 ssize_t Sock::recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const  {
-    std::string msg(mMaxTxSize, 0);
-    ssize_t nBytes = ::recvfrom(sid, (void*)msg.data(), msg.size(), flags, srcAddr, addrlen);
+    // one spare byte so that the data handed to dataCb is always NUL terminated
+    if (mRxBuf.size() < mMaxTxSize + 1) {
+        mRxBuf.resize(mMaxTxSize + 1);
+    }
+    char* msg = &mRxBuf[0];
+    ssize_t nBytes = ::recvfrom(sid, msg, mMaxTxSize, flags, srcAddr, addrlen);
     if (nBytes > 0) {
-        if (strncmp(msg.data(), MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
-            LOC_LOGi("recvd abort msg.data %s", msg.data());
+        msg[nBytes] = 0;
+        if (strncmp(msg, MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
+            LOC_LOGi("recvd abort msg.data %s", msg);
             nBytes = 0;
-        } else if (strncmp(msg.data(), LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
+        } else if (strncmp(msg, LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
             // short message
-            msg.resize(nBytes);
-            dataCb->onReceive(msg.data(), nBytes, &recver);
+            dataCb->onReceive(msg, nBytes, &recver);
         } else {
             // long message
-            size_t msgLen = 0;
-            sscanf(msg.data() + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
-            msg.resize(msgLen);
+            size_t msgLen = strtoul(msg + sizeof(LOC_IPC_HEAD) - 1, nullptr, 10);
+            if (mRxBuf.size() < msgLen + 1) {
+                mRxBuf.resize(msgLen + 1);
+                msg = &mRxBuf[0];
+            }
+            // the rest follows right away, wait for it even if the head
+            // was picked up without waiting
             for (size_t msgLenReceived = 0; (msgLenReceived < msgLen) && (nBytes > 0);
                  msgLenReceived += nBytes) {
-                nBytes = ::recvfrom(sid, &(msg[msgLenReceived]), msg.size() - msgLenReceived,
-                                    flags, srcAddr, addrlen);
+                nBytes = ::recvfrom(sid, msg + msgLenReceived, msgLen - msgLenReceived,
+                                    flags & ~MSG_DONTWAIT, srcAddr, addrlen);
             }
             if (nBytes > 0) {
+                msg[msgLen] = 0;
                 nBytes = msgLen;
-                dataCb->onReceive(msg.data(), nBytes, &recver);
+                dataCb->onReceive(msg, nBytes, &recver);
             }
         }
     }
@@ -129,16 +154,794 @@ ssize_t Sock::sendAbort(int flags, const struct sockaddr *destAddr, socklen_t ad
     return send(MSG_ABORT, sizeof(MSG_ABORT), flags, destAddr, addrlen);
 }
 
+// header of a binary frame, in host byte order as both ends are local
+struct LocIpcFrameHead {
+    uint32_t mMagic;
+    uint32_t mLength;
+};
+#define LOC_IPC_FRAME_MAGIC 0x46434f4c  // "LOCF"
+// a msg over LOC_IPC_MAX_FRAME_SIZE goes as a head frame with no payload and
+// mLength of the whole msg, then as chunk frames of its consecutive pieces
+#define LOC_IPC_LONG_MAGIC 0x4c434f4c   // "LOCL"
+#define LOC_IPC_CHUNK_MAGIC 0x43434f4c  // "LOCC"
+// how long the rest of a long msg is waited for once its head is received
+#define LOC_IPC_LONG_RECV_TIMEOUT_MSEC 2000
+
+// max number of fds passed with one frame
+#define LOC_IPC_MAX_FDS 3
+// max number of msgs per sendmmsg() / recvmmsg()
+#define LOC_IPC_SEND_BATCH 16
+#define LOC_IPC_RECV_BATCH 8
+// payload of the frame offering a shared memory ring, see LocIpcShmSender
+static const char LOC_IPC_SHM_OFFER[] = "LocIpc::Sock::SHM";
+
+ssize_t Sock::sendFrame(const void *buf, uint32_t len, int flags,
+                        const int fds[], uint32_t numFds) const {
+    return sendFrame(LOC_IPC_FRAME_MAGIC, buf, len, flags, fds, numFds);
+}
+ssize_t Sock::sendLongFrame(const void *buf, uint32_t len, int flags) const {
+    ssize_t rtv = -1;
+    LocIpcFrameHead head = {LOC_IPC_LONG_MAGIC, len};
+    SOCK_OP_AND_LOG(buf, len, isValid(), rtv,
+                    ::send(mSid, &head, sizeof(head), flags | MSG_NOSIGNAL));
+    for (uint32_t offset = 0; offset < len && rtv > 0; offset += LOC_IPC_MAX_FRAME_SIZE) {
+        rtv = sendFrame(LOC_IPC_CHUNK_MAGIC, (const char*)buf + offset,
+                        min(len - offset, (uint32_t)LOC_IPC_MAX_FRAME_SIZE), flags, nullptr, 0);
+    }
+    return (rtv > 0) ? len : -1;
+}
+ssize_t Sock::sendFrame(uint32_t magic, const void *buf, uint32_t len, int flags,
+                        const int fds[], uint32_t numFds) const {
+    ssize_t rtv = -1;
+    LocIpcFrameHead head = {magic, len};
+    struct iovec iov[2] = {{&head, sizeof(head)}, {(void*)buf, len}};
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    union {
+        struct cmsghdr mAlign;
+        char mBuf[CMSG_SPACE(sizeof(int) * LOC_IPC_MAX_FDS)];
+    } control = {};
+    if (nullptr != fds && numFds > 0 && numFds <= LOC_IPC_MAX_FDS) {
+        msg.msg_control = control.mBuf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * numFds);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * numFds);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * numFds);
+    }
+    SOCK_OP_AND_LOG(buf, len, isValid(), rtv, ::sendmsg(mSid, &msg, flags | MSG_NOSIGNAL));
+    return (rtv > 0) ? len : rtv;
+}
+ssize_t Sock::sendBatch(const LocIpcMsg msgs[], uint32_t numMsgs, int flags, bool framed,
+                        const struct sockaddr *destAddr, socklen_t addrlen) const {
+    ssize_t sent = 0;
+    while (sent < numMsgs) {
+        LocIpcFrameHead heads[LOC_IPC_SEND_BATCH];
+        struct iovec iovs[LOC_IPC_SEND_BATCH][2];
+        struct mmsghdr mmsgs[LOC_IPC_SEND_BATCH];
+        uint32_t n = 0;
+        for (; n < LOC_IPC_SEND_BATCH && sent + n < numMsgs; n++) {
+            const LocIpcMsg& m = msgs[sent + n];
+            if (nullptr == m.mData || 0 == m.mLength ||
+                m.mLength > (framed ? LOC_IPC_MAX_FRAME_SIZE : mMaxTxSize)) {
+                break;
+            }
+            memset(&mmsgs[n], 0, sizeof(mmsgs[n]));
+            struct msghdr& msg = mmsgs[n].msg_hdr;
+            if (framed) {
+                heads[n] = {LOC_IPC_FRAME_MAGIC, m.mLength};
+                iovs[n][0] = {&heads[n], sizeof(heads[n])};
+                iovs[n][1] = {(void*)m.mData, m.mLength};
+                msg.msg_iovlen = 2;
+            } else {
+                iovs[n][0] = {(void*)m.mData, m.mLength};
+                msg.msg_iovlen = 1;
+                msg.msg_name = (void*)destAddr;
+                msg.msg_namelen = addrlen;
+            }
+            msg.msg_iov = iovs[n];
+        }
+        if (0 == n) {
+            break;
+        }
+        int rtv = ::sendmmsg(mSid, mmsgs, n, flags | MSG_NOSIGNAL);
+        if (rtv <= 0) {
+            LOC_LOGw("failed reason: %s", strerror(errno));
+            break;
+        }
+        sent += rtv;
+        if ((uint32_t)rtv < n) {
+            break;
+        }
+    }
+    return (0 == sent && numMsgs > 0) ? -1 : sent;
+}
+
+// a msg over LOC_IPC_MAX_FRAME_SIZE being put back together from its chunks
+struct LocIpcLongRx {
+    string& mBuf;
+    uint32_t mLength;
+    uint32_t mReceived;
+};
+
+// passes the payload of a received frame to dataCb, or the fds of a shared
+// memory ring offer to shmFds, or adds a chunk to longRx and passes the long
+// msg on once complete. Closes any fds it does not pass on.
+static ssize_t handleFrame(const LocIpcRecver& recver,
+                           const shared_ptr<ILocIpcListener>& dataCb,
+                           char* frame, ssize_t nBytes, struct msghdr& msg,
+                           vector<int>* shmFds, LocIpcLongRx& longRx) {
+    int fds[LOC_IPC_MAX_FDS];
+    uint32_t numFds = 0;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); nullptr != cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type) {
+            uint32_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (uint32_t i = 0; i < n && numFds < LOC_IPC_MAX_FDS; i++) {
+                memcpy(&fds[numFds++], CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            }
+        }
+    }
+
+    LocIpcFrameHead head = {};
+    if ((size_t)nBytes >= sizeof(head)) {
+        memcpy(&head, frame, sizeof(head));
+    }
+    if (LOC_IPC_LONG_MAGIC == head.mMagic && sizeof(head) == (size_t)nBytes &&
+        head.mLength > LOC_IPC_MAX_FRAME_SIZE) {
+        if (longRx.mLength > 0) {
+            LOC_LOGe("dropping long msg cut off at %u of %u bytes",
+                     longRx.mReceived, longRx.mLength);
+        }
+        if (longRx.mBuf.size() < head.mLength + 1) {
+            longRx.mBuf.resize(head.mLength + 1);
+        }
+        longRx.mLength = head.mLength;
+        longRx.mReceived = 0;
+        nBytes = 0;
+    } else if (LOC_IPC_CHUNK_MAGIC == head.mMagic && !(msg.msg_flags & MSG_TRUNC) &&
+               head.mLength == nBytes - sizeof(head) && 0 != head.mLength &&
+               head.mLength <= longRx.mLength - longRx.mReceived) {
+        memcpy(&longRx.mBuf[longRx.mReceived], frame + sizeof(head), head.mLength);
+        longRx.mReceived += head.mLength;
+        nBytes = 0;
+        if (longRx.mReceived == longRx.mLength) {
+            nBytes = longRx.mLength;
+            longRx.mLength = 0;
+            longRx.mBuf[nBytes] = 0;
+            dataCb->onReceive(&longRx.mBuf[0], nBytes, &recver);
+        }
+    } else if (LOC_IPC_FRAME_MAGIC != head.mMagic || (msg.msg_flags & MSG_TRUNC) ||
+        head.mLength != nBytes - sizeof(head) || 0 == head.mLength) {
+        // keep the connection, a bad frame only loses itself
+        LOC_LOGe("dropping bad frame of %zd bytes, flags 0x%x", nBytes, msg.msg_flags);
+        nBytes = 0;
+    } else {
+        frame[nBytes] = 0;
+        nBytes = head.mLength;
+        if (sizeof(LOC_IPC_SHM_OFFER) == head.mLength &&
+            0 == memcmp(frame + sizeof(head), LOC_IPC_SHM_OFFER, head.mLength)) {
+            if (nullptr != shmFds) {
+                shmFds->assign(fds, fds + numFds);
+                numFds = 0;
+            }
+        } else {
+            dataCb->onReceive(frame + sizeof(head), head.mLength, &recver);
+        }
+    }
+    for (uint32_t i = 0; i < numFds; i++) {
+        ::close(fds[i]);
+    }
+    return nBytes;
+}
+
+ssize_t Sock::recvFrames(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                         int sid, int flags, vector<int>* shmFds) const {
+    // one spare byte per frame so that payloads are passed NUL terminated
+    const size_t frameSize = sizeof(LocIpcFrameHead) + LOC_IPC_MAX_FRAME_SIZE;
+    if (nullptr == mRxFrames) {
+        mRxFrames.reset(new char[LOC_IPC_RECV_BATCH * (frameSize + 1)]);
+    }
+    struct iovec iovs[LOC_IPC_RECV_BATCH];
+    struct mmsghdr mmsgs[LOC_IPC_RECV_BATCH];
+    union {
+        struct cmsghdr mAlign;
+        char mBuf[CMSG_SPACE(sizeof(int) * LOC_IPC_MAX_FDS)];
+    } controls[LOC_IPC_RECV_BATCH];
+    for (uint32_t i = 0; i < LOC_IPC_RECV_BATCH; i++) {
+        iovs[i] = {mRxFrames.get() + i * (frameSize + 1), frameSize};
+        memset(&mmsgs[i], 0, sizeof(mmsgs[i]));
+        mmsgs[i].msg_hdr.msg_iov = &iovs[i];
+        mmsgs[i].msg_hdr.msg_iovlen = 1;
+        mmsgs[i].msg_hdr.msg_control = controls[i].mBuf;
+        mmsgs[i].msg_hdr.msg_controllen = sizeof(controls[i].mBuf);
+    }
+    // only the first frame is waited for
+    int n = ::recvmmsg(sid, mmsgs, LOC_IPC_RECV_BATCH,
+                       flags | MSG_WAITFORONE | MSG_CMSG_CLOEXEC, nullptr);
+    if (n < 0) {
+        if (!isNothingToRecv(errno)) {
+            LOC_LOGw("failed reason: %s", strerror(errno));
+        }
+        return -1;
+    }
+    LocIpcLongRx longRx = {mRxBuf, 0, 0};
+    ssize_t nBytes = 0;
+    for (int i = 0; i < n; i++) {
+        if (0 == mmsgs[i].msg_len) {
+            // the peer has closed the connection
+            return (nBytes > 0) ? nBytes : 0;
+        }
+        ssize_t len = handleFrame(recver, dataCb, (char*)iovs[i].iov_base,
+                                  mmsgs[i].msg_len, mmsgs[i].msg_hdr, shmFds, longRx);
+        // a bad frame still counts, as the connection is still good
+        nBytes += (len > 0) ? len : 1;
+    }
+    // the rest of a long msg follows right away, wait for it even if the
+    // connection is non-blocking
+    while (longRx.mLength > 0) {
+        struct pollfd pfd = {sid, POLLIN, 0};
+        int rtv = ::poll(&pfd, 1, LOC_IPC_LONG_RECV_TIMEOUT_MSEC);
+        if (rtv < 0 && EINTR == errno) {
+            continue;
+        }
+        ssize_t len = -1;
+        if (rtv > 0) {
+            mmsgs[0].msg_hdr.msg_controllen = sizeof(controls[0].mBuf);
+            len = ::recvmsg(sid, &mmsgs[0].msg_hdr, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        }
+        if (0 == len) {
+            return (nBytes > 0) ? nBytes : 0;
+        } else if (len < 0) {
+            if (0 == rtv || !isNothingToRecv(errno)) {
+                LOC_LOGe("dropping long msg cut off at %u of %u bytes",
+                         longRx.mReceived, longRx.mLength);
+                break;
+            }
+        } else {
+            len = handleFrame(recver, dataCb, (char*)iovs[0].iov_base, len,
+                              mmsgs[0].msg_hdr, shmFds, longRx);
+            nBytes += (len > 0) ? len : 1;
+        }
+    }
+    return nBytes;
+}
+
+// Local senders first try to connect to the recver's SOCK_SEQPACKET socket,
+// named after its datagram socket plus LOC_IPC_SEQPACKET_SUFFIX, and send
+// binary frames on the connection. Recvers built before it only bind the
+// datagram socket, so a failed connect means datagrams are used instead,
+// until a connect retried after LOC_IPC_SEQ_RETRY_MSEC succeeds. A recver
+// binds its SOCK_SEQPACKET socket before its datagram socket, and takes what
+// is on the datagram socket before any frame of a newly accepted connection,
+// so that a sender moving from datagrams to a connection keeps its order.
+// A connected sender goes back to datagrams only once the recver has closed
+// the connection, i.e. for a new recver.
+#define LOC_IPC_SEQ_RETRY_MSEC 1000
+
+static bool getSeqPacketAddr(const char* name, struct sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    int len = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s%s",
+                       name, LOC_IPC_SEQPACKET_SUFFIX);
+    return '\0' != name[0] && len > 0 && (size_t)len < sizeof(addr.sun_path);
+}
+
+// Shared memory ring, in a memfd mapped by both processes, which a
+// LocIpcShmSender writes msgs to and a LocIpcShmRecver reads them from.
+// Each msg is a uint32_t length followed by the payload and a NUL, padded to
+// 8 bytes; a length of LOC_IPC_SHM_WRAP marks the rest of the ring as unused.
+// An eventfd doorbell in each direction wakes whichever side is waiting.
+struct LocIpcShmRingHead {
+    uint32_t mMagic;
+    uint32_t mSize;
+    // set while the recver has the ring mapped. Until it is, msgs go over
+    // the control socket, so nothing is lost if the recver can't map it.
+    atomic<uint32_t> mRecverAttached;
+    alignas(64) atomic<uint32_t> mWritePos;
+    atomic<uint32_t> mRecverWaiting;
+    alignas(64) atomic<uint32_t> mReadPos;
+    atomic<uint32_t> mSenderWaiting;
+};
+#define LOC_IPC_SHM_MAGIC 0x4d48534c  // "LSHM"
+#define LOC_IPC_SHM_WRAP 0xffffffff
+#define LOC_IPC_SHM_MIN_RING_SIZE 4096
+#define LOC_IPC_SHM_REC_SIZE(len) ((sizeof(uint32_t) + (len) + 1 + 7) & ~(size_t)7)
+// same as SO_SNDTIMEO on local sockets
+#define LOC_IPC_SHM_SEND_TIMEOUT_MSEC 2000
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+class LocIpcShmSender : public LocIpcSender {
+    // socket to the recver the ring was offered over, taking msgs that
+    // don't go into the ring
+    const shared_ptr<LocIpcSender> mCtrlSender;
+    size_t mMapSize;
+    mutable mutex mSendMutex;
+
+    inline bool map() {
+        void* addr = MAP_FAILED;
+        if (mMemFd >= 0 && mMapSize > sizeof(LocIpcShmRingHead)) {
+            addr = mmap(nullptr, mMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, mMemFd, 0);
+        }
+        if (MAP_FAILED == addr) {
+            LOC_LOGe("shm map error. reason: %s", strerror(errno));
+            return false;
+        }
+        mHead = (LocIpcShmRingHead*)addr;
+        mData = (char*)addr + sizeof(LocIpcShmRingHead);
+        return true;
+    }
+    // waits for need bytes to be free in front of write position w
+    inline bool waitForSpace(uint32_t w, uint32_t need) const {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (;;) {
+            uint32_t used = w - mHead->mReadPos.load(std::memory_order_acquire);
+            if (used > mRingSize) {
+                LOC_LOGe("shm ring corrupted, used %u", used);
+                return false;
+            }
+            if (mRingSize - used >= need) {
+                return true;
+            }
+            // the recver checks mSenderWaiting after each read position update
+            mHead->mSenderWaiting.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (mRingSize - (w - mHead->mReadPos.load(std::memory_order_acquire)) >= need) {
+                return true;
+            }
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            int64_t waitedMs = (now.tv_sec - start.tv_sec) * 1000 +
+                    (now.tv_nsec - start.tv_nsec) / 1000000;
+            if (waitedMs >= LOC_IPC_SHM_SEND_TIMEOUT_MSEC ||
+                !mHead->mRecverAttached.load(std::memory_order_acquire)) {
+                LOC_LOGw("shm ring full, need %u bytes", need);
+                return false;
+            }
+            // msgs of a batch so far may not have been notified yet
+            notify();
+            struct pollfd pfd = {mSpaceEvt, POLLIN, 0};
+            if (::poll(&pfd, 1, LOC_IPC_SHM_SEND_TIMEOUT_MSEC - waitedMs) > 0) {
+                uint64_t count;
+                (void)!::read(mSpaceEvt, &count, sizeof(count));
+            }
+        }
+    }
+    // writes a msg to the ring and publishes it, without waking the recver
+    // up; called with mSendMutex held
+    inline bool put(const uint8_t data[], uint32_t length) const {
+        uint32_t w = mHead->mWritePos.load(std::memory_order_relaxed);
+        uint32_t offset = w & (mRingSize - 1);
+        uint32_t recSize = LOC_IPC_SHM_REC_SIZE(length);
+        // a msg never wraps around, so that the recver can use it in place
+        uint32_t pad = (mRingSize - offset < recSize) ? (mRingSize - offset) : 0;
+        if (!waitForSpace(w, pad + recSize)) {
+            return false;
+        }
+        if (pad > 0) {
+            uint32_t wrap = LOC_IPC_SHM_WRAP;
+            memcpy(mData + offset, &wrap, sizeof(wrap));
+            w += pad;
+            offset = 0;
+        }
+        memcpy(mData + offset, &length, sizeof(length));
+        memcpy(mData + offset + sizeof(length), data, length);
+        mData[offset + sizeof(length) + length] = 0;
+        mHead->mWritePos.store(w + recSize, std::memory_order_release);
+        return true;
+    }
+    // sends a msg too big for the ring over the control socket, once the
+    // recver has taken all msgs before it out of the ring, so that it does
+    // not overtake them; called with mSendMutex held
+    inline bool putCtrl(const uint8_t data[], uint32_t length, int32_t msgId) const {
+        notify();
+        return nullptr != mCtrlSender &&
+                waitForSpace(mHead->mWritePos.load(std::memory_order_relaxed), mRingSize) &&
+                mCtrlSender->sendData(data, length, msgId);
+    }
+    // wakes the recver up if it waits for msgs
+    inline void notify() const {
+        // pairs with the fence in LocIpcShmRecver::prepareWait()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mHead->mRecverWaiting.load(std::memory_order_relaxed)) {
+            uint64_t one = 1;
+            (void)!::write(mDataEvt, &one, sizeof(one));
+        }
+    }
+protected:
+    int mMemFd;
+    // written by the sender to wake the recver, and by the recver on free space
+    int mDataEvt;
+    int mSpaceEvt;
+    LocIpcShmRingHead* mHead;
+    char* mData;
+    // copy of mHead->mSize, which the peer could change under us
+    uint32_t mRingSize;
+
+    inline virtual bool isOperable() const override { return nullptr != mHead; }
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const {
+        if (!isAttached()) {
+            return (nullptr != mCtrlSender && mCtrlSender->sendData(data, length, msgId)) ?
+                    length : -1;
+        }
+        lock_guard<mutex> lock(mSendMutex);
+        bool ok = (length > mRingSize / 4) ? putCtrl(data, length, msgId) : put(data, length);
+        notify();
+        return ok ? length : -1;
+    }
+    // writes all msgs and wakes the recver up once for all of them
+    inline virtual uint32_t sendBatch(const LocIpcMsg msgs[], uint32_t numMsgs) const override {
+        if (!isAttached()) {
+            return (nullptr != mCtrlSender) ? mCtrlSender->sendDataBatch(msgs, numMsgs) : 0;
+        }
+        lock_guard<mutex> lock(mSendMutex);
+        uint32_t sent = 0;
+        for (; sent < numMsgs; sent++) {
+            const LocIpcMsg& m = msgs[sent];
+            bool ok = (m.mLength > mRingSize / 4) ?
+                    putCtrl(m.mData, m.mLength, -1) : put(m.mData, m.mLength);
+            if (!ok) {
+                break;
+            }
+        }
+        notify();
+        return sent;
+    }
+public:
+    // creates a ring of ringSize bytes, rounded up to a power of 2
+    inline LocIpcShmSender(const shared_ptr<LocIpcSender>& ctrlSender, uint32_t ringSize) :
+            LocIpcSender(), mCtrlSender(ctrlSender), mMapSize(0),
+            mMemFd(-1), mDataEvt(-1), mSpaceEvt(-1), mHead(nullptr), mData(nullptr),
+            mRingSize(LOC_IPC_SHM_MIN_RING_SIZE) {
+        while (mRingSize < ringSize && mRingSize < 0x40000000) {
+            mRingSize <<= 1;
+        }
+        mMapSize = sizeof(LocIpcShmRingHead) + mRingSize;
+#ifdef SYS_memfd_create
+        mMemFd = syscall(SYS_memfd_create, "LocIpcShm", MFD_CLOEXEC);
+#endif
+        mDataEvt = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        mSpaceEvt = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (mMemFd < 0 || mDataEvt < 0 || mSpaceEvt < 0 ||
+            ftruncate(mMemFd, mMapSize) < 0 || !map()) {
+            LOC_LOGe("shm ring error. reason: %s", strerror(errno));
+            return;
+        }
+        mHead->mMagic = LOC_IPC_SHM_MAGIC;
+        mHead->mSize = mRingSize;
+        mHead->mRecverAttached.store(0);
+        mHead->mWritePos.store(0);
+        mHead->mRecverWaiting.store(0);
+        mHead->mReadPos.store(0);
+        mHead->mSenderWaiting.store(0);
+    }
+    // maps a ring offered by the peer. Takes ownership of the fds.
+    inline LocIpcShmSender(int memFd, int dataEvt, int spaceEvt) :
+            LocIpcSender(), mCtrlSender(nullptr), mMapSize(0),
+            mMemFd(memFd), mDataEvt(dataEvt), mSpaceEvt(spaceEvt), mHead(nullptr),
+            mData(nullptr), mRingSize(0) {
+        struct stat sbuf = {};
+        if (fstat(mMemFd, &sbuf) < 0 || sbuf.st_size <= (off_t)sizeof(LocIpcShmRingHead)) {
+            LOC_LOGe("shm ring of bad size");
+            return;
+        }
+        mMapSize = sbuf.st_size;
+        if (map()) {
+            mRingSize = mHead->mSize;
+            if (LOC_IPC_SHM_MAGIC != mHead->mMagic || mRingSize < LOC_IPC_SHM_MIN_RING_SIZE ||
+                0 != (mRingSize & (mRingSize - 1)) ||
+                mMapSize < sizeof(LocIpcShmRingHead) + mRingSize) {
+                LOC_LOGe("bad shm ring, magic 0x%x size %u", mHead->mMagic, mRingSize);
+                munmap(mHead, mMapSize);
+                mHead = nullptr;
+            }
+        }
+    }
+    inline virtual ~LocIpcShmSender() {
+        if (nullptr != mHead) {
+            munmap(mHead, mMapSize);
+        }
+        for (int fd : {mMemFd, mDataEvt, mSpaceEvt}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+    inline bool isAttached() const {
+        return isOperable() && mHead->mRecverAttached.load(std::memory_order_acquire);
+    }
+    // passes the ring to the recver at the other end of mCtrlSender
+    inline bool offer() const {
+        int fds[] = {mMemFd, mDataEvt, mSpaceEvt};
+        return isOperable() && nullptr != mCtrlSender &&
+                mCtrlSender->sendFds((const uint8_t*)LOC_IPC_SHM_OFFER,
+                                     sizeof(LOC_IPC_SHM_OFFER), fds, 3);
+    }
+};
+
+class LocIpcShmRecver : public LocIpcShmSender, public LocIpcRecver {
+    // read position, kept here as the copy in the ring is writable by the peer
+    mutable uint32_t mReadPos;
+    mutable atomic<bool> mAborted;
+protected:
+    inline virtual ssize_t recv() const override {
+        ssize_t nBytes = 0;
+        while (0 == nBytes && !mAborted) {
+            if (prepareWait()) {
+                struct pollfd pfd = {mDataEvt, POLLIN, 0};
+                if (::poll(&pfd, 1, -1) < 0 && EINTR != errno) {
+                    return -1;
+                }
+            }
+            endWait();
+            nBytes = drain(*this);
+        }
+        return mAborted ? 0 : nBytes;
+    }
+public:
+    inline LocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                           int memFd, int dataEvt, int spaceEvt) :
+            LocIpcShmSender(memFd, dataEvt, spaceEvt), LocIpcRecver(listener, *this),
+            mReadPos(0), mAborted(false) {
+        if (isOperable()) {
+            mReadPos = mHead->mReadPos.load(std::memory_order_acquire);
+            mHead->mRecverAttached.store(1, std::memory_order_release);
+        }
+    }
+    inline virtual ~LocIpcShmRecver() {
+        if (isOperable()) {
+            mHead->mRecverAttached.store(0, std::memory_order_release);
+        }
+    }
+    inline int getWaitFd() const { return mDataEvt; }
+    // asks the sender to ring the doorbell on new msgs. Returns false if
+    // msgs are pending already, so there is nothing to wait for.
+    inline bool prepareWait() const {
+        mHead->mRecverWaiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return mHead->mWritePos.load(std::memory_order_acquire) == mReadPos;
+    }
+    inline void endWait() const {
+        mHead->mRecverWaiting.store(0, std::memory_order_relaxed);
+        uint64_t count;
+        (void)!::read(mDataEvt, &count, sizeof(count));
+    }
+    // passes all pending msgs, in place, to the listener as coming from
+    // recver, and returns the number of payload bytes passed
+    inline ssize_t drain(const LocIpcRecver& recver) const {
+        ssize_t nBytes = 0;
+        uint32_t r = mReadPos;
+        uint32_t w = mHead->mWritePos.load(std::memory_order_acquire);
+        while (r != w) {
+            uint32_t offset = r & (mRingSize - 1);
+            uint32_t length = 0;
+            memcpy(&length, mData + offset, sizeof(length));
+            if (LOC_IPC_SHM_WRAP == length && w - r <= mRingSize) {
+                r += mRingSize - offset;
+                continue;
+            }
+            if (w - r > mRingSize || 0 == length || length > mRingSize / 4 ||
+                offset + LOC_IPC_SHM_REC_SIZE(length) > mRingSize ||
+                LOC_IPC_SHM_REC_SIZE(length) > w - r) {
+                LOC_LOGe("shm ring corrupted, skipping %u bytes", w - r);
+                r = w;
+                break;
+            }
+            char* msg = mData + offset + sizeof(length);
+            msg[length] = 0;
+            mDataCb->onReceive(msg, length, &recver);
+            nBytes += length;
+            r += LOC_IPC_SHM_REC_SIZE(length);
+            mHead->mReadPos.store(r, std::memory_order_release);
+            // pairs with the fence in LocIpcShmSender::waitForSpace()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (mHead->mSenderWaiting.exchange(0, std::memory_order_relaxed)) {
+                uint64_t one = 1;
+                (void)!::write(mSpaceEvt, &one, sizeof(one));
+            }
+        }
+        mReadPos = r;
+        mHead->mReadPos.store(r, std::memory_order_release);
+        return nBytes;
+    }
+    inline virtual const char* getName() const override { return "LocIpcShmRecver"; };
+    inline virtual void abort() const override {
+        mAborted = true;
+        uint64_t one = 1;
+        (void)!::write(mDataEvt, &one, sizeof(one));
+    }
+};
+
+// Watches a LocIpcLocalSender's connection for its recver closing it. The
+// recver never sends on the connection, so it only turns readable then.
+class LocIpcPeerCloseRecver : public LocIpcSender, public LocIpcRecver {
+    const shared_ptr<Sock> mConn;
+    const string mName;
+    mutable bool mClosed;
+    mutable bool mAborted;
+
+    // true once the peer has closed the connection; anything it did send
+    // is discarded
+    inline bool checkClosed(int flags) const {
+        char buf[64];
+        ssize_t nBytes = ::recv(mConn->mSid, buf, sizeof(buf), flags);
+        if (nBytes > 0 || (nBytes < 0 && isNothingToRecv(errno)) || mClosed) {
+            return mClosed;
+        }
+        mClosed = true;
+        if (!mAborted) {
+            LOC_LOGd("%s: peer closed the connection", mName.c_str());
+            mDataCb->onPeerClosed(this);
+        }
+        return true;
+    }
+protected:
+    inline virtual bool isOperable() const override { return mConn->isValid(); }
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length,
+                                int32_t msgId) const override {
+        return -1;
+    }
+    inline virtual ssize_t recv() const override {
+        struct pollfd pfd = {mConn->mSid, POLLIN | POLLRDHUP, 0};
+        while (!mAborted) {
+            if (::poll(&pfd, 1, -1) < 0 && EINTR != errno) {
+                return -1;
+            }
+            if (0 != pfd.revents && checkClosed(MSG_DONTWAIT)) {
+                return 0;
+            }
+        }
+        return 0;
+    }
+public:
+    inline LocIpcPeerCloseRecver(const shared_ptr<ILocIpcListener>& listener,
+                                 const shared_ptr<Sock>& conn, const char* name) :
+            LocIpcSender(), LocIpcRecver(listener, *this),
+            mConn(conn), mName(name), mClosed(false), mAborted(false) {}
+    inline virtual bool watchFds(LocIpcFdWatcher& watcher) const override {
+        watcher.watchFd(mConn->mSid);
+        return true;
+    }
+    inline virtual bool recvReady(int fd) const override {
+        return !checkClosed(MSG_DONTWAIT);
+    }
+    inline virtual const char* getName() const override { return mName.c_str(); }
+    inline virtual void abort() const override {
+        mAborted = true;
+        // wakes up recv(), the sender still has the connection to send on
+        ::shutdown(mConn->mSid, SHUT_RD);
+    }
+};
+
 class LocIpcLocalSender : public LocIpcSender {
+    // connection to the recver's SOCK_SEQPACKET socket, once made
+    mutable shared_ptr<Sock> mSeqSock;
+    // no SOCK_SEQPACKET sockets here, stop trying to connect
+    mutable bool mSeqUnsupported;
+    // CLOCK_MONOTONIC ns before which a failed connect is not retried
+    mutable uint64_t mSeqRetryNs;
+    mutable mutex mSeqMutex;
+    // held while the chunks of a msg over LOC_IPC_MAX_FRAME_SIZE are sent
+    mutable mutex mLongFrameMutex;
+
+    static inline uint64_t getNowNs() {
+        struct timespec now = {};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    }
+    inline shared_ptr<Sock> getSeqSock() const {
+        lock_guard<mutex> lock(mSeqMutex);
+        if (nullptr == mSeqSock && !mSeqUnsupported && getNowNs() >= mSeqRetryNs) {
+            struct sockaddr_un addr;
+            int fd = -1;
+            if (!getSeqPacketAddr(mAddr.sun_path, addr)) {
+                mSeqUnsupported = true;
+            } else if ((fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0) {
+                mSeqUnsupported = (EPROTONOSUPPORT == errno || EINVAL == errno ||
+                                   EAFNOSUPPORT == errno || ESOCKTNOSUPPORT == errno);
+            } else {
+                timeval timeout;
+                timeout.tv_sec = 2;
+                timeout.tv_usec = 0;
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+                    mSeqSock = make_shared<Sock>(fd);
+                } else {
+                    // not a SOCK_SEQPACKET socket at that name
+                    mSeqUnsupported = (EPROTOTYPE == errno);
+                    ::close(fd);
+                }
+            }
+            if (nullptr == mSeqSock) {
+                mSeqRetryNs = getNowNs() + LOC_IPC_SEQ_RETRY_MSEC * 1000000ULL;
+            }
+            if (mSeqUnsupported) {
+                LOC_LOGd("%s takes datagrams only", mAddr.sun_path);
+            }
+        }
+        return mSeqSock;
+    }
+    inline void dropSeqSock(const shared_ptr<Sock>& seqSock) const {
+        lock_guard<mutex> lock(mSeqMutex);
+        if (mSeqSock == seqSock) {
+            mSeqSock = nullptr;
+            mSeqRetryNs = 0;
+        }
+    }
+    inline ssize_t sendFrames(const Sock& seqSock, const uint8_t data[], uint32_t length) const {
+        if (length <= LOC_IPC_MAX_FRAME_SIZE) {
+            return seqSock.sendFrame(data, length, 0);
+        }
+        lock_guard<mutex> lock(mLongFrameMutex);
+        return seqSock.sendLongFrame(data, length, 0);
+    }
+    static inline bool isPeerGone(int err) {
+        return EPIPE == err || ECONNRESET == err || ENOTCONN == err || ECONNREFUSED == err;
+    }
 protected:
     shared_ptr<Sock> mSock;
     struct sockaddr_un mAddr;
     inline virtual bool isOperable() const override { return mSock != nullptr && mSock->isValid(); }
     inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
+        shared_ptr<Sock> seqSock = getSeqSock();
+        if (nullptr != seqSock) {
+            ssize_t rtv = sendFrames(*seqSock, data, length);
+            if (rtv >= 0 || !isPeerGone(errno)) {
+                return rtv;
+            }
+            // the recver has gone. A new one starts a new stream, with this msg.
+            dropSeqSock(seqSock);
+            seqSock = getSeqSock();
+            if (nullptr != seqSock) {
+                return sendFrames(*seqSock, data, length);
+            }
+        }
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
+    inline virtual uint32_t sendBatch(const LocIpcMsg msgs[], uint32_t numMsgs) const override {
+        uint32_t sent = 0;
+        while (sent < numMsgs) {
+            shared_ptr<Sock> seqSock = getSeqSock();
+            ssize_t rtv = (nullptr != seqSock) ?
+                    seqSock->sendBatch(msgs + sent, numMsgs - sent, 0, true) :
+                    mSock->sendBatch(msgs + sent, numMsgs - sent, 0, false,
+                                     (struct sockaddr*)&mAddr, sizeof(mAddr));
+            if (rtv > 0) {
+                sent += rtv;
+            } else if (send(msgs[sent].mData, msgs[sent].mLength, -1) > 0) {
+                // one that did not fit in a batch, or failed it and got
+                // the reconnect of send()
+                sent++;
+            } else {
+                break;
+            }
+        }
+        return sent;
+    }
 public:
+    inline virtual bool sendFds(const uint8_t data[], uint32_t length,
+                                const int fds[], uint32_t numFds) const override {
+        shared_ptr<Sock> seqSock = getSeqSock();
+        return nullptr != seqSock && seqSock->sendFrame(data, length, 0, fds, numFds) > 0;
+    }
+    inline virtual unique_ptr<LocIpcRecver> getPeerCloseRecver(
+            const shared_ptr<ILocIpcListener>& listener) const override {
+        shared_ptr<Sock> seqSock = getSeqSock();
+        if (nullptr == seqSock || nullptr == listener) {
+            return nullptr;
+        }
+        return unique_ptr<LocIpcRecver>(
+                new LocIpcPeerCloseRecver(listener, seqSock, mAddr.sun_path));
+    }
     inline LocIpcLocalSender(const char* name) : LocIpcSender(),
+            mSeqSock(nullptr),
+            mSeqUnsupported(false),
+            mSeqRetryNs(0),
             mSock(nullptr),
             mAddr({.sun_family = AF_UNIX, {}}) {
 
@@ -160,28 +963,250 @@ public:
 };
 
 class LocIpcLocalRecver : public LocIpcLocalSender, public LocIpcRecver {
+    // SOCK_SEQPACKET socket senders connect to for binary frames, and the
+    // connections accepted on it. The datagram socket at mAddr stays bound
+    // for older senders, senders that could not connect, and abort.
+    Sock mSeqListenSock;
+    struct sockaddr_un mSeqAddr;
+    mutable vector<int> mSeqConns;
+    // shared memory ring the sender offered over one of the connections
+    mutable unique_ptr<LocIpcShmRecver> mShmRecver;
+    mutable vector<int> mShmFds;
+    mutable vector<struct pollfd> mPollFds;
+    // set while on a LocIpcReactor
+    mutable LocIpcFdWatcher* mWatcher;
+
+    inline void attachShm() const {
+        if (3 == mShmFds.size()) {
+            unique_ptr<LocIpcShmRecver> shmRecver(
+                    new LocIpcShmRecver(mDataCb, mShmFds[0], mShmFds[1], mShmFds[2]));
+            if (shmRecver->isRecvable()) {
+                // a new offer replaces the ring, after what is left in it
+                if (nullptr != mShmRecver) {
+                    mShmRecver->drain(*this);
+                    if (nullptr != mWatcher) {
+                        mWatcher->unwatchFd(mShmRecver->getWaitFd());
+                    }
+                }
+                mShmRecver = std::move(shmRecver);
+                if (nullptr != mWatcher) {
+                    watchShm();
+                }
+                LOC_LOGd("%s: shm ring attached", mAddr.sun_path);
+            }
+        } else {
+            for (int fd : mShmFds) {
+                ::close(fd);
+            }
+        }
+        mShmFds.clear();
+    }
+    inline void watchShm() const {
+        mWatcher->watchFd(mShmRecver->getWaitFd());
+        // the doorbell is only rung for a waiting recver, ring it ourselves
+        // for what was sent before
+        if (!mShmRecver->prepareWait()) {
+            uint64_t one = 1;
+            (void)!::write(mShmRecver->getWaitFd(), &one, sizeof(one));
+        }
+    }
+
+    // handlers of one readable fd each, returning the payload bytes passed on
+    inline ssize_t recvDgram(int flags) const {
+        socklen_t size = sizeof(mAddr);
+        return mSock->recv(*this, mDataCb, flags, (struct sockaddr*)&mAddr, &size);
+    }
+    // returns false on abort
+    inline bool acceptConn() const {
+        int connFd = ::accept4(mSeqListenSock.mSid, nullptr, nullptr,
+                               SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (connFd >= 0) {
+            // the sender may have sent datagrams before connecting, they go first
+            ssize_t nBytes = 0;
+            while ((nBytes = recvDgram(MSG_DONTWAIT)) > 0) {}
+            if (0 == nBytes) {
+                ::close(connFd);
+                return false;
+            }
+            mSeqConns.push_back(connFd);
+            if (nullptr != mWatcher) {
+                mWatcher->watchFd(connFd);
+            }
+        } else if (!isNothingToRecv(errno)) {
+            LOC_LOGw("accept error. reason: %s", strerror(errno));
+        }
+        return true;
+    }
+    // closes connection i once its sender has gone
+    inline ssize_t recvConn(size_t i) const {
+        ssize_t nBytes = mSock->recvFrames(*this, mDataCb, mSeqConns[i], 0, &mShmFds);
+        if (!mShmFds.empty()) {
+            attachShm();
+            nBytes = 0;
+        } else if (nBytes == 0 || (nBytes < 0 && !isNothingToRecv(errno))) {
+            if (nullptr != mWatcher) {
+                mWatcher->unwatchFd(mSeqConns[i]);
+            }
+            ::close(mSeqConns[i]);
+            mSeqConns.erase(mSeqConns.begin() + i);
+            nBytes = 0;
+        }
+        return (nBytes > 0) ? nBytes : 0;
+    }
+    // the ring's sender puts a msg on its connection only once the ring is
+    // empty, so what is on the connections goes before what is in the ring
+    inline ssize_t recvShm() const {
+        ssize_t nBytes = 0;
+        for (size_t i = mSeqConns.size(); i > 0; i--) {
+            for (ssize_t n = 0; i <= mSeqConns.size() && (n = recvConn(i - 1)) > 0; ) {
+                nBytes += n;
+            }
+        }
+        mShmRecver->endWait();
+        return nBytes + mShmRecver->drain(*this);
+    }
+
+    // waits on the datagram socket, all frame connections and the shared
+    // memory ring until at least one msg has been delivered. Returns 0 on
+    // abort, -1 on error.
+    inline ssize_t pollRecv() const {
+        ssize_t rtv = 0;
+        while (0 == rtv) {
+            // with msgs in the ring only peek at the sockets, so that what was
+            // sent on them before the ring was attached still comes first
+            bool shmPending = (nullptr != mShmRecver) && !mShmRecver->prepareWait();
+            mPollFds.resize(3 + mSeqConns.size());
+            mPollFds[0] = {mSock->mSid, POLLIN, 0};
+            mPollFds[1] = {mSeqListenSock.mSid, POLLIN, 0};
+            mPollFds[2] = {(nullptr != mShmRecver) ? mShmRecver->getWaitFd() : -1, POLLIN, 0};
+            for (size_t i = 0; i < mSeqConns.size(); i++) {
+                mPollFds[3 + i] = {mSeqConns[i], POLLIN, 0};
+            }
+            if (::poll(mPollFds.data(), mPollFds.size(), shmPending ? 0 : -1) < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                LOC_LOGe("poll error. reason: %s", strerror(errno));
+                return -1;
+            }
+            // connections first; a new one is only added after this loop
+            for (size_t i = mSeqConns.size(); i > 0; i--) {
+                if (0 != mPollFds[2 + i].revents) {
+                    rtv += recvConn(i - 1);
+                }
+            }
+            if (nullptr != mShmRecver) {
+                rtv += recvShm();
+            }
+            if (0 != mPollFds[1].revents && !acceptConn()) {
+                return 0;
+            }
+            if (0 != mPollFds[0].revents) {
+                ssize_t nBytes = recvDgram(0);
+                if (nBytes <= 0) {
+                    return nBytes;
+                }
+                rtv += nBytes;
+            }
+        }
+        return rtv;
+    }
 protected:
     inline virtual ssize_t recv() const override {
-        socklen_t size = sizeof(mAddr);
-        return mSock->recv(*this, mDataCb, 0, (struct sockaddr*)&mAddr, &size);
+        if (!mSeqListenSock.isValid()) {
+            return recvDgram(0);
+        }
+        return pollRecv();
     }
 public:
+    inline virtual bool watchFds(LocIpcFdWatcher& watcher) const override {
+        mWatcher = &watcher;
+        watcher.watchFd(mSock->mSid);
+        if (mSeqListenSock.isValid()) {
+            watcher.watchFd(mSeqListenSock.mSid);
+        }
+        for (int connFd : mSeqConns) {
+            watcher.watchFd(connFd);
+        }
+        if (nullptr != mShmRecver) {
+            watchShm();
+        }
+        return true;
+    }
+    inline virtual bool recvReady(int fd) const override {
+        if (fd == mSock->mSid) {
+            ssize_t nBytes = recvDgram(MSG_DONTWAIT);
+            return nBytes > 0 || (nBytes < 0 && isNothingToRecv(errno));
+        } else if (fd == mSeqListenSock.mSid) {
+            return acceptConn();
+        } else if (nullptr != mShmRecver && fd == mShmRecver->getWaitFd()) {
+            do {
+                recvShm();
+            } while (!mShmRecver->prepareWait());
+        } else {
+            auto it = find(mSeqConns.begin(), mSeqConns.end(), fd);
+            if (it != mSeqConns.end()) {
+                recvConn(it - mSeqConns.begin());
+            }
+        }
+        return true;
+    }
     inline LocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener, const char* name) :
-            LocIpcLocalSender(name), LocIpcRecver(listener, *this) {
+            LocIpcLocalSender(name), LocIpcRecver(listener, *this),
+            mSeqListenSock(-1), mWatcher(nullptr) {
 
         if ((unlink(mAddr.sun_path) < 0) && (errno != ENOENT)) {
             LOC_LOGw("unlink socket error. reason:%s", strerror(errno));
         }
 
         umask(0157);
+        // without the SOCK_SEQPACKET socket, senders simply fall back to
+        // datagrams. It is bound first, so that a sender finding the datagram
+        // socket also finds it.
+        if (mSock->isValid() && getSeqPacketAddr(mAddr.sun_path, mSeqAddr)) {
+            unlink(mSeqAddr.sun_path);
+            mSeqListenSock.mSid = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                                           0);
+            if (mSeqListenSock.isValid() &&
+                (::bind(mSeqListenSock.mSid, (struct sockaddr*)&mSeqAddr, sizeof(mSeqAddr)) < 0 ||
+                 ::listen(mSeqListenSock.mSid, 8) < 0)) {
+                LOC_LOGw("seqpacket socket error. %s, reason: %s", mSeqAddr.sun_path,
+                         strerror(errno));
+                mSeqListenSock.close();
+                unlink(mSeqAddr.sun_path);
+            }
+        }
+
         if (mSock->isValid() && ::bind(mSock->mSid, (struct sockaddr*)&mAddr, sizeof(mAddr)) < 0) {
             LOC_LOGe("bind socket error. sock fd: %d: %s, reason: %s", mSock->mSid,
                     mAddr.sun_path, strerror(errno));
             mSock->close();
+            if (mSeqListenSock.isValid()) {
+                mSeqListenSock.close();
+                unlink(mSeqAddr.sun_path);
+            }
         }
     }
-    inline virtual ~LocIpcLocalRecver() { unlink(mAddr.sun_path); }
+    inline virtual ~LocIpcLocalRecver() {
+        for (int connFd : mSeqConns) {
+            ::close(connFd);
+        }
+        if (mSeqListenSock.isValid()) {
+            unlink(mSeqAddr.sun_path);
+        }
+        unlink(mAddr.sun_path);
+    }
     inline virtual const char* getName() const override { return mAddr.sun_path; };
+    inline virtual void onListenerReady() override {
+        LocIpcRecver::onListenerReady();
+        // the listener may have changed the owner of the datagram socket to
+        // let its peers in, give the same to the SOCK_SEQPACKET socket
+        struct stat sbuf = {};
+        if (mSeqListenSock.isValid() && 0 == stat(mAddr.sun_path, &sbuf) &&
+            0 != chown(mSeqAddr.sun_path, sbuf.st_uid, sbuf.st_gid)) {
+            LOC_LOGw("chown %s failed. reason: %s", mSeqAddr.sun_path, strerror(errno));
+        }
+    }
     inline virtual void abort() const override {
         if (isSendable()) {
             mSock->sendAbort(0, (struct sockaddr*)&mAddr, sizeof(mAddr));
@@ -270,24 +1295,124 @@ public:
 };
 
 class LocIpcInetTcpRecver : public LocIpcInetRecver {
-    mutable int32_t mConnFd;
+    // connections accepted so far, each read on its own
+    mutable vector<int> mConns;
+    mutable bool mListening;
+    // written by abort() to wake up recv()
+    int mAbortEvt;
+    mutable vector<struct pollfd> mPollFds;
+    // set while on a LocIpcReactor
+    mutable LocIpcFdWatcher* mWatcher;
+
+    inline bool startListening() const {
+        if (!mListening && mSock->isValid()) {
+            if (::listen(mSock->mSid, 3) < 0) {
+                LOC_LOGe("listen error. reason: %s", strerror(errno));
+                mSock->close();
+            } else {
+                mListening = true;
+            }
+        }
+        return mListening;
+    }
+    inline void acceptConn() const {
+        socklen_t size = sizeof(mAddr);
+        int connFd = ::accept4(mSock->mSid, (struct sockaddr*)&mAddr, &size,
+                               SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (connFd >= 0) {
+            mConns.push_back(connFd);
+            if (nullptr != mWatcher) {
+                mWatcher->watchFd(connFd);
+            }
+        } else if (!isNothingToRecv(errno)) {
+            LOC_LOGw("accept error. reason: %s", strerror(errno));
+        }
+    }
+    // closes connection i once its peer has closed it
+    inline ssize_t recvConn(size_t i, int flags) const {
+        ssize_t nBytes = mSock->recv(*this, mDataCb, flags, nullptr, nullptr, mConns[i]);
+        if (nBytes == 0 || (nBytes < 0 && !isNothingToRecv(errno))) {
+            if (nullptr != mWatcher) {
+                mWatcher->unwatchFd(mConns[i]);
+            }
+            ::close(mConns[i]);
+            mConns.erase(mConns.begin() + i);
+        }
+        return (nBytes > 0) ? nBytes : 0;
+    }
 protected:
     inline virtual ssize_t recv() const override {
-        socklen_t size = sizeof(mAddr);
-        if (-1 == mConnFd && mSock->isValid()) {
-            if (::listen(mSock->mSid, 3) < 0 ||
-                (mConnFd = accept(mSock->mSid, (struct sockaddr*)&mAddr, &size)) < 0) {
-                mSock->close();
-                mConnFd = -1;
+        if (!startListening()) {
+            return -1;
+        }
+        ssize_t rtv = 0;
+        while (0 == rtv) {
+            mPollFds.resize(2 + mConns.size());
+            mPollFds[0] = {mSock->mSid, POLLIN, 0};
+            mPollFds[1] = {mAbortEvt, POLLIN, 0};
+            for (size_t i = 0; i < mConns.size(); i++) {
+                mPollFds[2 + i] = {mConns[i], POLLIN, 0};
+            }
+            if (::poll(mPollFds.data(), mPollFds.size(), -1) < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                LOC_LOGe("poll error. reason: %s", strerror(errno));
+                return -1;
+            }
+            if (0 != mPollFds[1].revents) {
+                return 0;
+            }
+            for (size_t i = mConns.size(); i > 0; i--) {
+                if (0 != mPollFds[1 + i].revents) {
+                    rtv += recvConn(i - 1, 0);
+                }
+            }
+            if (0 != mPollFds[0].revents) {
+                acceptConn();
             }
         }
-        return mSock->recv(*this, mDataCb, 0, (struct sockaddr*)&mAddr, &size, mConnFd);
+        return rtv;
     }
 public:
     inline LocIpcInetTcpRecver(const shared_ptr<ILocIpcListener>& listener, const char* name,
                                int32_t port) :
-            LocIpcInetRecver(listener, name, port, SOCK_STREAM), mConnFd(-1) {}
-    inline virtual ~LocIpcInetTcpRecver() { if (-1 != mConnFd) ::close(mConnFd);}
+            LocIpcInetRecver(listener, name, port, SOCK_STREAM), mListening(false),
+            mAbortEvt(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), mWatcher(nullptr) {}
+    inline virtual ~LocIpcInetTcpRecver() {
+        for (int connFd : mConns) {
+            ::close(connFd);
+        }
+        if (mAbortEvt >= 0) {
+            ::close(mAbortEvt);
+        }
+    }
+    inline virtual void abort() const override {
+        uint64_t one = 1;
+        (void)!::write(mAbortEvt, &one, sizeof(one));
+    }
+    inline virtual bool watchFds(LocIpcFdWatcher& watcher) const override {
+        if (!startListening()) {
+            return false;
+        }
+        mWatcher = &watcher;
+        watcher.watchFd(mSock->mSid);
+        for (int connFd : mConns) {
+            watcher.watchFd(connFd);
+        }
+        return true;
+    }
+    inline virtual bool recvReady(int fd) const override {
+        if (fd == mSock->mSid) {
+            acceptConn();
+        } else {
+            auto it = find(mConns.begin(), mConns.end(), fd);
+            if (it != mConns.end()) {
+                recvConn(it - mConns.begin(), MSG_DONTWAIT);
+            }
+        }
+        return true;
+    }
 };
 
 class LocIpcInetUdpRecver : public LocIpcInetRecver {
@@ -302,8 +1427,279 @@ public:
             LocIpcInetRecver(listener, name, port, SOCK_DGRAM) {}
 
     inline virtual ~LocIpcInetUdpRecver() {}
+    inline virtual bool watchFds(LocIpcFdWatcher& watcher) const override {
+        watcher.watchFd(mSock->mSid);
+        return true;
+    }
+    inline virtual bool recvReady(int fd) const override {
+        socklen_t size = sizeof(mAddr);
+        ssize_t nBytes = mSock->recv(*this, mDataCb, MSG_DONTWAIT, (struct sockaddr*)&mAddr, &size);
+        return nBytes > 0 || (nBytes < 0 && isNothingToRecv(errno));
+    }
+};
+
+#define LOC_IPC_REACTOR_MAX_EVENTS 8
+// epoll key of the stop eventfd; others are (entry id << 32) | fd
+#define LOC_IPC_REACTOR_STOP_KEY   UINT64_MAX
+
+/*
+LocIpcReactorState - what the reactor threads share. It outlives the
+                     LocIpcReactor as long as any of its threads is running.
+                     Every fd is armed EPOLLONESHOT, so only one thread
+                     ever handles it at a time, and is re-armed once done.
+*/
+class LocIpcReactorState {
+public:
+    struct Entry : public LocIpcFdWatcher {
+        LocIpcReactorState& mState;
+        const uint32_t mId;
+        // held while the recver is in use
+        mutex mLock;
+        unique_ptr<LocIpcRecver> mRecver;
+        unordered_set<int> mFds;
+        // set by remove() from a listener, which leaves detaching to the
+        // reactor thread once the listener has returned
+        atomic<bool> mRemoved;
+
+        inline Entry(LocIpcReactorState& state, uint32_t id) :
+                mState(state), mId(id), mRemoved(false) {}
+        inline virtual ~Entry() {}
+        inline virtual void watchFd(int fd) override {
+            if (mFds.insert(fd).second) {
+                mState.ctl(EPOLL_CTL_ADD, mId, fd);
+            }
+        }
+        inline virtual void unwatchFd(int fd) override {
+            if (mFds.erase(fd) > 0) {
+                mState.ctl(EPOLL_CTL_DEL, mId, fd);
+            }
+        }
+        // called with mLock held
+        inline void detach() {
+            for (int fd : mFds) {
+                mState.ctl(EPOLL_CTL_DEL, mId, fd);
+            }
+            mFds.clear();
+            mRecver.reset();
+        }
+    };
+
+    int mEpollFd;
+    int mStopEvt;
+    mutex mLock;
+    unordered_map<uint32_t, shared_ptr<Entry>> mEntries;
+    uint32_t mNextId;
+    // entry whose recver the calling thread is in
+    static thread_local Entry* sCurrent;
+    // other entries the listener of sCurrent removed, detached by handle()
+    // after it has let go of sCurrent, so that no thread ever waits for an
+    // entry lock while holding another
+    static thread_local vector<shared_ptr<Entry>> sRemoved;
+
+    inline LocIpcReactorState() :
+            mEpollFd(epoll_create1(EPOLL_CLOEXEC)),
+            mStopEvt(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), mNextId(0) {
+        if (mEpollFd < 0 || mStopEvt < 0) {
+            LOC_LOGe("epoll / eventfd error. reason: %s", strerror(errno));
+        } else {
+            // level triggered, so that every thread sees it
+            struct epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.u64 = LOC_IPC_REACTOR_STOP_KEY;
+            epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mStopEvt, &ev);
+        }
+    }
+    inline ~LocIpcReactorState() {
+        if (mEpollFd >= 0) {
+            ::close(mEpollFd);
+        }
+        if (mStopEvt >= 0) {
+            ::close(mStopEvt);
+        }
+    }
+    inline bool isValid() const { return mEpollFd >= 0 && mStopEvt >= 0; }
+
+    inline void ctl(int op, uint32_t id, int fd) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLONESHOT;
+        ev.data.u64 = ((uint64_t)id << 32) | (uint32_t)fd;
+        if (epoll_ctl(mEpollFd, op, fd, &ev) < 0 && EPOLL_CTL_DEL != op) {
+            LOC_LOGe("epoll_ctl(%d) fd %d error. reason: %s", op, fd, strerror(errno));
+        }
+    }
+
+    inline shared_ptr<Entry> find(uint32_t id) {
+        lock_guard<mutex> lock(mLock);
+        auto it = mEntries.find(id);
+        return (it != mEntries.end()) ? it->second : nullptr;
+    }
+    inline shared_ptr<Entry> take(const LocIpcRecver* ipcRecver) {
+        lock_guard<mutex> lock(mLock);
+        for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+            if (it->second->mRecver.get() == ipcRecver) {
+                shared_ptr<Entry> entry = it->second;
+                mEntries.erase(it);
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    inline void handle(uint64_t key) {
+        int fd = (int)(uint32_t)key;
+        shared_ptr<Entry> entry = find((uint32_t)(key >> 32));
+        if (nullptr == entry) {
+            return;
+        }
+        {
+            lock_guard<mutex> lock(entry->mLock);
+            if (nullptr == entry->mRecver || entry->mRemoved || entry->mFds.count(fd) == 0) {
+                return;
+            }
+            sCurrent = entry.get();
+            bool keep = entry->mRecver->recvReady(fd);
+            sCurrent = nullptr;
+            if (!keep && !entry->mRemoved) {
+                lock_guard<mutex> lock(mLock);
+                mEntries.erase(entry->mId);
+            }
+            if (!keep || entry->mRemoved) {
+                entry->detach();
+            } else if (entry->mFds.count(fd) > 0) {
+                ctl(EPOLL_CTL_MOD, entry->mId, fd);
+            }
+        }
+        while (!sRemoved.empty()) {
+            shared_ptr<Entry> removed = std::move(sRemoved.back());
+            sRemoved.pop_back();
+            lock_guard<mutex> lock(removed->mLock);
+            removed->detach();
+        }
+    }
+
+    // waits for and handles ready fds. Returns false once stopped.
+    inline bool poll() {
+        struct epoll_event events[LOC_IPC_REACTOR_MAX_EVENTS];
+        int n = epoll_wait(mEpollFd, events, LOC_IPC_REACTOR_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (EINTR == errno) {
+                return true;
+            }
+            LOC_LOGe("epoll_wait error. reason: %s", strerror(errno));
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            if (LOC_IPC_REACTOR_STOP_KEY == events[i].data.u64) {
+                return false;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            handle(events[i].data.u64);
+        }
+        return true;
+    }
+
+    inline void stop() {
+        uint64_t one = 1;
+        (void)!::write(mStopEvt, &one, sizeof(one));
+    }
+};
+
+thread_local LocIpcReactorState::Entry* LocIpcReactorState::sCurrent = nullptr;
+thread_local vector<shared_ptr<LocIpcReactorState::Entry>> LocIpcReactorState::sRemoved;
+
+class LocIpcReactorRunnable : public LocRunnable {
+    shared_ptr<LocIpcReactorState> mState;
+public:
+    inline LocIpcReactorRunnable(const shared_ptr<LocIpcReactorState>& state) :
+            mState(state) {}
+    inline virtual bool run() override { return mState->poll(); }
+    inline virtual void interrupt() override { mState->stop(); }
 };
 
+LocIpcReactor::LocIpcReactor(uint32_t numThreads) :
+        mState(make_shared<LocIpcReactorState>()),
+        mThreads(new LocThread[numThreads]) {
+    if (mState->isValid()) {
+        for (uint32_t i = 0; i < numThreads; i++) {
+            std::string threadName("LocIpcReactor-");
+            threadName.append(std::to_string(i));
+            mThreads[i].start(threadName.c_str(), make_shared<LocIpcReactorRunnable>(mState));
+        }
+    }
+}
+
+LocIpcReactor::~LocIpcReactor() {
+    mState->stop();
+    unordered_map<uint32_t, shared_ptr<LocIpcReactorState::Entry>> entries;
+    {
+        lock_guard<mutex> lock(mState->mLock);
+        entries.swap(mState->mEntries);
+    }
+    for (auto& it : entries) {
+        lock_guard<mutex> lock(it.second->mLock);
+        it.second->detach();
+    }
+}
+
+bool LocIpcReactor::add(unique_ptr<LocIpcRecver>& ipcRecver) {
+    if (!mState->isValid() || nullptr == ipcRecver || !ipcRecver->isRecvable()) {
+        return false;
+    }
+    shared_ptr<LocIpcReactorState::Entry> entry;
+    {
+        lock_guard<mutex> lock(mState->mLock);
+        entry = make_shared<LocIpcReactorState::Entry>(*mState, mState->mNextId++);
+        mState->mEntries[entry->mId] = entry;
+    }
+    // threads wait on the entry lock for events that come in meanwhile
+    lock_guard<mutex> lock(entry->mLock);
+    if (!ipcRecver->watchFds(*entry)) {
+        {
+            lock_guard<mutex> lock(mState->mLock);
+            mState->mEntries.erase(entry->mId);
+        }
+        entry->detach();
+        return false;
+    }
+    entry->mRecver = std::move(ipcRecver);
+    // inform that the socket is ready to receive message
+    entry->mRecver->onListenerReady();
+    return true;
+}
+
+void LocIpcReactor::remove(const LocIpcRecver* ipcRecver) {
+    shared_ptr<LocIpcReactorState::Entry> entry = mState->take(ipcRecver);
+    if (nullptr == entry) {
+        return;
+    }
+    if (LocIpcReactorState::sCurrent == entry.get()) {
+        // from its own listener; handle() detaches it once that returns
+        entry->mRemoved = true;
+    } else if (nullptr != LocIpcReactorState::sCurrent) {
+        // from another one's listener, which holds its own entry lock
+        entry->mRemoved = true;
+        LocIpcReactorState::sRemoved.push_back(entry);
+    } else {
+        lock_guard<mutex> lock(entry->mLock);
+        entry->detach();
+    }
+}
+
+LocIpcReactor* LocIpcReactor::getShared() {
+    static LocIpcReactor* sReactor = []() -> LocIpcReactor* {
+        uint32_t numThreads = 0;
+        loc_param_s_type reactorConfigTable[] = {
+            {"IPC_REACTOR_THREADS", &numThreads, NULL, 'n'},
+        };
+        UTIL_READ_CONF(LOC_PATH_GPS_CONF, reactorConfigTable);
+        LOC_LOGd("IPC_REACTOR_THREADS %u", numThreads);
+        // never destroyed, recvers may still be removed during static destruction
+        return (numThreads > 0) ? new LocIpcReactor(numThreads) : nullptr;
+    }();
+    return sReactor;
+}
+
 class LocIpcRunnable : public LocRunnable {
     bool mAbortCalled;
     LocIpc& mLocIpc;
@@ -333,6 +1729,12 @@ public:
 
 bool LocIpc::startNonBlockingListening(unique_ptr<LocIpcRecver>& ipcRecver) {
     if (ipcRecver != nullptr && ipcRecver->isRecvable()) {
+        LocIpcReactor* reactor = LocIpcReactor::getShared();
+        const LocIpcRecver* recver = ipcRecver.get();
+        if (nullptr != reactor && reactor->add(ipcRecver)) {
+            mReactorRecver = recver;
+            return true;
+        }
         std::string threadName("LocIpc-");
         threadName.append(ipcRecver->getName());
         return mThread.start(threadName.c_str(), make_shared<LocIpcRunnable>(*this, ipcRecver));
@@ -355,6 +1757,10 @@ bool LocIpc::startBlockingListening(LocIpcRecver& ipcRecver) {
 }
 
 void LocIpc::stopNonBlockingListening() {
+    if (nullptr != mReactorRecver) {
+        LocIpcReactor::getShared()->remove(mReactorRecver);
+        mReactorRecver = nullptr;
+    }
     mThread.stop();
 }
 
@@ -368,6 +1774,10 @@ bool LocIpc::send(LocIpcSender& sender, const uint8_t data[], uint32_t length, i
     return sender.sendData(data, length, msgId);
 }
 
+uint32_t LocIpc::send(LocIpcSender& sender, const LocIpcMsg msgs[], uint32_t numMsgs) {
+    return sender.sendDataBatch(msgs, numMsgs);
+}
+
 shared_ptr<LocIpcSender> LocIpc::getLocIpcLocalSender(const char* localSockName) {
     return make_shared<LocIpcLocalSender>(localSockName);
 }
@@ -375,6 +1785,12 @@ unique_ptr<LocIpcRecver> LocIpc::getLocIpcLocalRecver(const shared_ptr<ILocIpcLi
                                                       const char* localSockName) {
     return make_unique<LocIpcLocalRecver>(listener, localSockName);
 }
+shared_ptr<LocIpcSender> LocIpc::getLocIpcShmSender(const shared_ptr<LocIpcSender>& ctrlSender,
+                                                    uint32_t ringSize) {
+    shared_ptr<LocIpcShmSender> sender = (nullptr == ctrlSender) ? nullptr :
+            make_shared<LocIpcShmSender>(ctrlSender, ringSize);
+    return (nullptr != sender && sender->offer()) ? sender : nullptr;
+}
 static void* sLibQrtrHandle = nullptr;
 static const char* sLibQrtrName = "libloc_socket.so";
 shared_ptr<LocIpcSender> LocIpc::getLocIpcQrtrSender(int service, int instance) {
@@ -427,4 +1843,172 @@ pair<shared_ptr<LocIpcSender>, unique_ptr<LocIpcRecver>>
             creator(listener, instance);
 }
 
+#ifdef __LOC_UNIT_TEST__
+// msg seq, numbered from 0, with a pattern of its seq filling the rest
+static string checkMsg(uint32_t seq, uint32_t size) {
+    string msg(max(size, (uint32_t)sizeof(seq)), 0);
+    memcpy(&msg[0], &seq, sizeof(seq));
+    for (uint32_t i = sizeof(seq); i < msg.size(); i++) {
+        msg[i] = (char)(seq + i);
+    }
+    return msg;
+}
+
+uint32_t LocIpc::checkLocal(const char* sockName, bool useShm, uint32_t numRounds) {
+    struct CheckingListener : public ILocIpcListener {
+        mutex mLock;
+        condition_variable mCond;
+        bool mReady = false;
+        uint32_t mCount = 0;
+        uint32_t mMismatches = 0;
+        inline void onListenerReady() override {
+            lock_guard<mutex> lock(mLock);
+            mReady = true;
+            mCond.notify_all();
+        }
+        inline void onReceive(const char* data, uint32_t length, const LocIpcRecver*) override {
+            lock_guard<mutex> lock(mLock);
+            uint32_t seq = UINT32_MAX;
+            if (length >= sizeof(seq)) {
+                memcpy(&seq, data, sizeof(seq));
+            }
+            if (seq != mCount || 0 != checkMsg(seq, length).compare(0, length, data, length)) {
+                mMismatches++;
+            }
+            mCount++;
+            mCond.notify_all();
+        }
+    };
+    auto listener = make_shared<CheckingListener>();
+    LocIpc ipc;
+    unique_ptr<LocIpcRecver> recver = getLocIpcLocalRecver(listener, sockName);
+    ipc.startNonBlockingListening(recver);
+    {
+        unique_lock<mutex> lock(listener->mLock);
+        listener->mCond.wait(lock, [&listener] { return listener->mReady; });
+    }
+
+    uint32_t seq = 0;
+    uint32_t mismatches = 0;
+    shared_ptr<LocIpcSender> sender = getLocIpcLocalSender(sockName);
+    if (useShm) {
+        shared_ptr<LocIpcSender> shmSender = getLocIpcShmSender(sender);
+        if (nullptr == shmSender) {
+            LOC_LOGe("no shm ring");
+            mismatches++;
+        } else {
+            // msgs sent before the recver thread takes up the offer go over
+            // the socket, and must still come in order with the rest
+            sender = shmSender;
+        }
+    }
+
+    // sizes the socket and the ring take at once, and some that neither
+    // does and that the sender has to split or divert
+    const uint32_t sizes[] = {10, 70000, 20, 300000, 8, 65536, 65537, 5000, 200000, 12};
+    const uint32_t numSizes = sizeof(sizes) / sizeof(sizes[0]);
+    for (uint32_t round = 0; round < numRounds; round++) {
+        for (uint32_t size : sizes) {
+            string msg = checkMsg(seq++, size);
+            if (!send(*sender, (const uint8_t*)msg.data(), msg.size())) {
+                mismatches++;
+            }
+        }
+        // and the same sizes as one batch
+        string batch[numSizes];
+        LocIpcMsg msgs[numSizes];
+        for (uint32_t i = 0; i < numSizes; i++) {
+            batch[i] = checkMsg(seq++, sizes[i]);
+            msgs[i] = {(const uint8_t*)batch[i].data(), (uint32_t)batch[i].size()};
+        }
+        mismatches += numSizes - send(*sender, msgs, numSizes);
+    }
+    {
+        unique_lock<mutex> lock(listener->mLock);
+        listener->mCond.wait_for(lock, chrono::seconds(10), [&listener, seq] {
+            return listener->mCount >= seq;
+        });
+        mismatches += listener->mMismatches + (seq - min(seq, listener->mCount));
+    }
+    ipc.stopNonBlockingListening();
+    return mismatches;
+}
+
+void LocIpc::benchmarkLocal(const char* sockName, bool useShm, uint32_t msgSize,
+                            uint32_t numMsgs, uint64_t& cpuNs, uint64_t& wallNs) {
+    struct CountingListener : public ILocIpcListener {
+        mutex mLock;
+        condition_variable mCond;
+        bool mReady = false;
+        uint32_t mCount = 0;
+        inline void onListenerReady() override {
+            lock_guard<mutex> lock(mLock);
+            mReady = true;
+            mCond.notify_all();
+        }
+        inline void onReceive(const char*, uint32_t, const LocIpcRecver*) override {
+            lock_guard<mutex> lock(mLock);
+            mCount++;
+            mCond.notify_all();
+        }
+    };
+    auto listener = make_shared<CountingListener>();
+    LocIpc ipc;
+    unique_ptr<LocIpcRecver> recver = getLocIpcLocalRecver(listener, sockName);
+    ipc.startNonBlockingListening(recver);
+    {
+        unique_lock<mutex> lock(listener->mLock);
+        listener->mCond.wait(lock, [&listener] { return listener->mReady; });
+    }
+
+    shared_ptr<LocIpcSender> sender = getLocIpcLocalSender(sockName);
+    if (useShm) {
+        shared_ptr<LocIpcSender> shmSender = getLocIpcShmSender(sender);
+        if (nullptr == shmSender) {
+            LOC_LOGe("no shm ring, measuring the socket");
+        } else {
+            // the offer is taken up by the recver thread, wait for it so that
+            // all msgs measured go through the ring
+            string hello("hello");
+            for (uint32_t sent = 1; ; sent++) {
+                shmSender->sendData((const uint8_t*)hello.data(), hello.size(), -1);
+                unique_lock<mutex> lock(listener->mLock);
+                listener->mCond.wait(lock, [&listener, sent] {
+                    return listener->mCount >= sent;
+                });
+                if (static_cast<LocIpcShmSender&>(*shmSender).isAttached()) {
+                    break;
+                }
+            }
+            sender = shmSender;
+        }
+    }
+    uint32_t numWarmUp = 0;
+    {
+        lock_guard<mutex> lock(listener->mLock);
+        numWarmUp = listener->mCount;
+    }
+
+    string msg(msgSize, 'x');
+    struct timespec cpuStart, wallStart, cpuEnd, wallEnd;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuStart);
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+    for (uint32_t i = 0; i < numMsgs; i++) {
+        sender->sendData((const uint8_t*)msg.data(), msgSize, -1);
+    }
+    {
+        unique_lock<mutex> lock(listener->mLock);
+        listener->mCond.wait_for(lock, chrono::seconds(10), [&listener, numWarmUp, numMsgs] {
+            return listener->mCount >= numWarmUp + numMsgs;
+        });
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuEnd);
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    cpuNs = (cpuEnd.tv_sec - cpuStart.tv_sec) * 1000000000ULL + cpuEnd.tv_nsec - cpuStart.tv_nsec;
+    wallNs = (wallEnd.tv_sec - wallStart.tv_sec) * 1000000000ULL +
+            wallEnd.tv_nsec - wallStart.tv_nsec;
+    ipc.stopNonBlockingListening();
+}
+#endif
+
 }
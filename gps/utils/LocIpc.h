@@ -36,6 +36,7 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unordered_set>
+#include <vector>
 #include <mutex>
 #include <LocThread.h>
 
@@ -43,8 +44,24 @@ using namespace std;
 
 namespace loc_util {
 
+// largest payload sent as a single binary frame over a connected local
+// SOCK_SEQPACKET socket. Bigger payloads go over the same connection as a
+// head frame and chunk frames of up to this size.
+#define LOC_IPC_MAX_FRAME_SIZE (64 * 1024)
+// a local recver named "x" also listens on a SOCK_SEQPACKET socket "x.sp"
+#define LOC_IPC_SEQPACKET_SUFFIX ".sp"
+// default data size of a shared memory ring from getLocIpcShmSender()
+#define LOC_IPC_SHM_RING_SIZE (256 * 1024)
+
 class LocIpcRecver;
 class LocIpcSender;
+class LocIpcReactorState;
+
+// one msg of a batch sent with LocIpc::send()
+struct LocIpcMsg {
+    const uint8_t* mData;
+    uint32_t mLength;
+};
 
 class ILocIpcListener {
 protected:
@@ -54,6 +71,9 @@ public:
     // when the socket for LocIpc is ready to receive messages.
     inline virtual void onListenerReady() {}
     virtual void onReceive(const char* data, uint32_t len, const LocIpcRecver* recver) = 0;
+    // for a recver from LocIpcSender::getPeerCloseRecver(), once the peer
+    // has closed the connection
+    inline virtual void onPeerClosed(const LocIpcRecver* recver) {}
 };
 
 class LocIpcQrtrWatcher {
@@ -101,6 +121,15 @@ public:
             getLocIpcInetTcpSender(const char* serverName, int32_t port);
     static shared_ptr<LocIpcSender>
             getLocIpcQrtrSender(int service, int instance);
+    // Offers the peer of local sender ctrlSender a shared memory ring of
+    // ringSize bytes, passed over ctrlSender, and returns a sender that
+    // writes to the ring once the peer has mapped it. Until then, and for
+    // msgs too big for the ring, msgs go over ctrlSender. Returns nullptr if
+    // the ring can't be offered, e.g. ctrlSender is not connected over
+    // SOCK_SEQPACKET; ctrlSender should be used as is then.
+    static shared_ptr<LocIpcSender>
+            getLocIpcShmSender(const shared_ptr<LocIpcSender>& ctrlSender,
+                               uint32_t ringSize = LOC_IPC_SHM_RING_SIZE);
 
     static unique_ptr<LocIpcRecver>
             getLocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener,
@@ -147,9 +176,62 @@ public:
     // The function will return true on success, and false on failure.
     static bool send(LocIpcSender& sender, const uint8_t data[],
                      uint32_t length, int32_t msgId = -1);
+    // Sends numMsgs msgs in order, with as few syscalls as the sender can
+    // manage, e.g. one sendmmsg() for all of them. Returns the number of
+    // msgs sent, which stops short of numMsgs at the first failure.
+    static uint32_t send(LocIpcSender& sender, const LocIpcMsg msgs[], uint32_t numMsgs);
+
+#ifdef __LOC_UNIT_TEST__
+    // sends numRounds rounds of msgs, small ones and ones too big for a
+    // datagram or the ring, to a local recver at sockName in this process,
+    // over the socket or over a shared memory ring. Returns the number of
+    // msgs lost, corrupted or out of order; 0 on success.
+    static uint32_t checkLocal(const char* sockName, bool useShm, uint32_t numRounds);
+    // sends numMsgs msgs of msgSize bytes to a local recver at sockName in
+    // this process, over the socket or over a shared memory ring, and
+    // measures the CPU time both ends took and the wall time, in ns.
+    static void benchmarkLocal(const char* sockName, bool useShm, uint32_t msgSize,
+                               uint32_t numMsgs, uint64_t& cpuNs, uint64_t& wallNs);
+#endif
 
 private:
     LocThread mThread;
+    // recver handed to the shared LocIpcReactor instead of to mThread
+    const LocIpcRecver* mReactorRecver = nullptr;
+};
+
+// Lets a recver tell LocIpcReactor which fds to wait on for it, as they come
+// and go, e.g. with connections being accepted and closed.
+class LocIpcFdWatcher {
+protected:
+    inline virtual ~LocIpcFdWatcher() {}
+public:
+    virtual void watchFd(int fd) = 0;
+    virtual void unwatchFd(int fd) = 0;
+};
+
+// Listens to many recvers on one epoll loop, run by a pool of numThreads
+// threads, instead of one thread per recver. A recver is only ever used by
+// one of the threads at a time. Recvers that can't be multiplexed, such as
+// QRTR ones, are refused by add() and need their own thread.
+class LocIpcReactor {
+    shared_ptr<LocIpcReactorState> mState;
+    unique_ptr<LocThread[]> mThreads;
+public:
+    LocIpcReactor(uint32_t numThreads = 1);
+    ~LocIpcReactor();
+
+    // takes ipcRecver over and calls its listener from the reactor threads.
+    // Returns false, with ipcRecver left as is, if it can't be multiplexed.
+    bool add(unique_ptr<LocIpcRecver>& ipcRecver);
+    // stops listening to ipcRecver and destroys it. When called from outside
+    // the listeners on this reactor, no call to its listener is in progress
+    // once this returns. From within one, that is so once that one returns.
+    void remove(const LocIpcRecver* ipcRecver);
+
+    // reactor used by LocIpc::startNonBlockingListening(), run by
+    // IPC_REACTOR_THREADS threads from gps.conf; nullptr if that is 0.
+    static LocIpcReactor* getShared();
 };
 
 /* this is only when client needs to implement Sender / Recver that are not already provided by
@@ -160,16 +242,42 @@ protected:
     LocIpcSender() = default;
     virtual bool isOperable() const = 0;
     virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const = 0;
+    // returns the number of msgs sent, in order
+    inline virtual uint32_t sendBatch(const LocIpcMsg msgs[], uint32_t numMsgs) const {
+        uint32_t sent = 0;
+        while (sent < numMsgs && send(msgs[sent].mData, msgs[sent].mLength, -1) > 0) {
+            sent++;
+        }
+        return sent;
+    }
 public:
     virtual ~LocIpcSender() = default;
     inline bool isSendable() const { return isOperable(); }
     inline bool sendData(const uint8_t data[], uint32_t length, int32_t msgId) const {
         return isSendable() && (send(data, length, msgId) > 0);
     }
+    inline uint32_t sendDataBatch(const LocIpcMsg msgs[], uint32_t numMsgs) const {
+        return isSendable() ? sendBatch(msgs, numMsgs) : 0;
+    }
     virtual unique_ptr<LocIpcRecver> getRecver(const shared_ptr<ILocIpcListener>& listener) {
         return nullptr;
     }
     inline virtual void copyDestAddrFrom(const LocIpcSender& otherSender) {}
+    // sends data together with numFds open fds the peer receives copies of.
+    // Only local senders connected over SOCK_SEQPACKET can do this.
+    inline virtual bool sendFds(const uint8_t data[], uint32_t length,
+                                const int fds[], uint32_t numFds) const {
+        return false;
+    }
+    // recver that receives nothing but calls listener's onPeerClosed() once
+    // the recver at the other end closes the connection this sender sends
+    // on, e.g. as its process died. Connects first if need be. nullptr if
+    // the sender has no connection, as with datagram only recvers. It is
+    // meant for a LocIpcReactor, where it costs nothing until then.
+    inline virtual unique_ptr<LocIpcRecver> getPeerCloseRecver(
+            const shared_ptr<ILocIpcListener>& listener) const {
+        return nullptr;
+    }
 };
 
 class LocIpcRecver {
@@ -191,14 +299,28 @@ public:
     }
     virtual void abort() const = 0;
     virtual const char* getName() const = 0;
+    // For LocIpcReactor. A recver that can be multiplexed has watcher watch
+    // its fds, keeps it up to date as they change, and returns true.
+    inline virtual bool watchFds(LocIpcFdWatcher& watcher) const { return false; }
+    // receives what is ready on watched fd, without blocking. Returns false
+    // once the recver is done, as recvData() would.
+    inline virtual bool recvReady(int fd) const { return false; }
 };
 
 class Sock {
     static const char MSG_ABORT[];
     static const char LOC_IPC_HEAD[];
     const uint32_t mMaxTxSize;
+    // receive buffer reused across recv() / recvFrames() calls. Only the
+    // listening thread receives, so it needs no locking.
+    mutable string mRxBuf;
+    // LOC_IPC_RECV_BATCH frame buffers for recvFrames(), left uninitialized
+    // so that only the pages frames actually land in get used
+    mutable unique_ptr<char[]> mRxFrames;
     ssize_t sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
                    socklen_t addrlen) const;
+    ssize_t sendFrame(uint32_t magic, const void *buf, uint32_t len, int flags,
+                      const int fds[], uint32_t numFds) const;
     ssize_t recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                      int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
 public:
@@ -211,6 +333,28 @@ public:
     ssize_t recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                  struct sockaddr *srcAddr, socklen_t *addrlen, int sid = -1) const;
     ssize_t sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen);
+    // sends len bytes as one binary frame, header and payload gathered into a
+    // single sendmsg(), along with numFds fds if any. mSid must be connected
+    // and keep msg boundaries.
+    ssize_t sendFrame(const void *buf, uint32_t len, int flags,
+                      const int fds[] = nullptr, uint32_t numFds = 0) const;
+    // sends len bytes over LOC_IPC_MAX_FRAME_SIZE as a head frame followed
+    // by chunk frames, which recvFrames() puts back together. The caller
+    // keeps other long msgs off the connection until it returns.
+    ssize_t sendLongFrame(const void *buf, uint32_t len, int flags) const;
+    // sends msgs with sendmmsg(), each as a binary frame if framed, else as
+    // a plain datagram to destAddr. Stops at the first msg that does not fit
+    // in one frame / datagram. Returns the number of msgs sent, or -1 if
+    // not even the first one could be.
+    ssize_t sendBatch(const LocIpcMsg msgs[], uint32_t numMsgs, int flags, bool framed,
+                      const struct sockaddr *destAddr = nullptr, socklen_t addrlen = 0) const;
+    // receives the binary frames pending on connection sid, up to
+    // LOC_IPC_RECV_BATCH of them with one recvmmsg(), and passes their
+    // payloads, in place, to dataCb. A shared memory ring offer is not
+    // passed on, its fds are put in shmFds instead, or closed if shmFds is
+    // nullptr. Returns 0 once the peer has closed the connection.
+    ssize_t recvFrames(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                       int sid, int flags, vector<int>* shmFds = nullptr) const;
     inline void close() {
         if (isValid()) {
             ::close(mSid);
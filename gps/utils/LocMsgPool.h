@@ -0,0 +1,141 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_MSG_POOL__
+#define __LOC_MSG_POOL__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <MsgTask.h>
+
+namespace loc_util {
+
+// max number of freed blocks a LocMsgPool keeps for reuse, beyond which
+// blocks are returned to the heap
+#define LOC_MSG_POOL_MAX_FREE 16
+
+// Free list of storage blocks sized for one msg type T. Blocks are taken
+// from the heap only when the free list is empty, so once a steady state
+// rate of T msgs is reached there are no more heap allocations for them.
+// One pool exists per type and is shared by all MsgTasks, since a msg is
+// allocated on the sender thread before its MsgTask is known.
+template <typename T>
+class LocMsgPool {
+    union Block {
+        Block* mNext;
+        alignas(T) char mStorage[sizeof(T)];
+    };
+    std::mutex mLock;
+    Block* mFree;
+    uint32_t mNumFree;
+    std::atomic<uint64_t> mHeapAllocs;
+
+    inline LocMsgPool() : mFree(nullptr), mNumFree(0), mHeapAllocs(0) {}
+    ~LocMsgPool() = delete;
+public:
+    // never destroyed, msgs may still be freed during static destruction
+    static inline LocMsgPool& getInstance() {
+        static LocMsgPool* sPool = new LocMsgPool();
+        return *sPool;
+    }
+
+    inline void* alloc(size_t size) {
+        // a type derived from T is bigger than the blocks
+        if (size > sizeof(Block)) {
+            return ::operator new(size);
+        }
+        {
+            std::lock_guard<std::mutex> guard(mLock);
+            if (nullptr != mFree) {
+                Block* block = mFree;
+                mFree = block->mNext;
+                mNumFree--;
+                return block;
+            }
+        }
+        mHeapAllocs.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(sizeof(Block));
+    }
+
+    inline void free(void* p, size_t size) {
+        if (nullptr == p) {
+            return;
+        }
+        if (size <= sizeof(Block)) {
+            std::lock_guard<std::mutex> guard(mLock);
+            if (mNumFree < LOC_MSG_POOL_MAX_FREE) {
+                Block* block = (Block*)p;
+                block->mNext = mFree;
+                mFree = block;
+                mNumFree++;
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    // number of blocks this pool has taken from the heap so far
+    inline uint64_t getHeapAllocs() const {
+        return mHeapAllocs.load(std::memory_order_relaxed);
+    }
+};
+
+// Base of a LocMsg type T whose instances live in LocMsgPool<T>. new T(...)
+// constructs in place in a recycled block, and the delete MsgTask does
+// once proc() has run hands the block back to the pool.
+template <typename T>
+struct LocPooledMsg : public LocMsg {
+    inline LocPooledMsg() : LocMsg() {}
+    inline virtual ~LocPooledMsg() {}
+
+    inline static void* operator new(size_t size) {
+        return LocMsgPool<T>::getInstance().alloc(size);
+    }
+    inline static void operator delete(void* p, size_t size) {
+        LocMsgPool<T>::getInstance().free(p, size);
+    }
+
+    // have a pending T replaced by this one instead of both being run
+    inline void coalesceByType() { setCoalesceKey(locMsgTypeKey<T>()); }
+};
+
+#ifdef __LOC_UNIT_TEST__
+// sends numFixes synthetic position msgs through a MsgTask on the default
+// queue backend, once warmed up, and returns the number of heap
+// allocations made meanwhile; 0 on success. allocCount returns the number
+// of allocations the process made so far, counting those of the queue as
+// well as the pool's; if null only the pool's are counted.
+uint64_t locMsgPoolCountSteadyStateAllocs(uint32_t numFixes, uint64_t (*allocCount)());
+#endif
+
+} // namespace loc_util
+
+#endif //__LOC_MSG_POOL__
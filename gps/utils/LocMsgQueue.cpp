@@ -0,0 +1,456 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_MsgQueue"
+
+#include <unistd.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <MsgTask.h>
+#include <LocMsgQueue.h>
+#include <msg_q.h>
+#include <loc_cfg.h>
+#include <log_util.h>
+#include <loc_log.h>
+#include <loc_pla.h>
+#ifdef __LOC_UNIT_TEST__
+#include <time.h>
+#include <thread>
+#include <vector>
+#endif
+
+#define LOC_MSG_QUEUE_RING_DEFAULT_CAPACITY (1024)
+#define LOC_MSG_QUEUE_RING_MAX_CAPACITY     (1 << 16)
+#define LOC_CACHE_LINE_SIZE                 (64)
+
+namespace loc_util {
+
+static void LocMsgDestroy(void* msg) {
+    delete (LocMsg*)msg;
+}
+
+/*
+LocMsgQueueLegacy - the original msg_q based backend. msg_q is kept as is,
+                    both for this backend and for any other user of the C API.
+*/
+class LocMsgQueueLegacy : public LocMsgQueue {
+    void* mQ;
+public:
+    inline LocMsgQueueLegacy() : mQ((void*)msg_q_init2()) {}
+    inline virtual ~LocMsgQueueLegacy() {
+        if (NULL != mQ) {
+            msg_q_flush(mQ);
+            msg_q_destroy(&mQ);
+        }
+    }
+    inline bool isValid() const { return NULL != mQ; }
+
+    inline virtual bool send(LocMsg* msg) override {
+        return eMSG_Q_SUCCESS == msg_q_snd(mQ, (void*)msg, LocMsgDestroy);
+    }
+    virtual LocMsg* receive() override {
+        LocMsg* msg = NULL;
+        msq_q_err_type result = msg_q_rcv(mQ, (void**)&msg);
+        if (eMSG_Q_SUCCESS != result) {
+            LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
+                     loc_get_msg_q_status(result));
+            msg = NULL;
+        }
+        return msg;
+    }
+    inline virtual LocMsg* tryReceive() override {
+        LocMsg* msg = NULL;
+        if (eMSG_Q_SUCCESS != msg_q_rmv(mQ, (void**)&msg)) {
+            msg = NULL;
+        }
+        return msg;
+    }
+    inline virtual void unblock() override { msg_q_unblock(mQ); }
+    inline virtual void flush() override { msg_q_flush(mQ); }
+};
+
+/*
+LocMsgQueueRing - bounded multi-producer / single-consumer ring of LocMsg
+                  pointers. Producers claim a cell with a CAS on mEnqPos and
+                  publish it by advancing the cell's sequence number; the
+                  consumer never takes a lock in the steady state. Cells are
+                  allocated once and recycled, so there is no per-msg node
+                  allocation. The consumer parks on a futex when the ring is
+                  empty, and producers only issue a wake syscall if it is
+                  parked.
+
+                  When the ring is full, producers spill into a locked
+                  overflow list instead of blocking, since the MsgTask thread
+                  itself routinely sends to its own queue. While the overflow
+                  list is non empty new msgs also go there, and the consumer
+                  only takes from it once the ring is drained, which keeps
+                  msgs from any single sender in FIFO order.
+*/
+class LocMsgQueueRing : public LocMsgQueue {
+    struct Cell {
+        std::atomic<uint32_t> mSeq;
+        LocMsg* mMsg;
+    };
+    const uint32_t mMask;
+    Cell* const mCells;
+    char mPad0[LOC_CACHE_LINE_SIZE];
+    // written by producers
+    std::atomic<uint32_t> mEnqPos;
+    char mPad1[LOC_CACHE_LINE_SIZE];
+    // written by consumer only
+    uint32_t mDeqPos;
+    // futex word, 1 while the consumer is parked or about to be
+    std::atomic<int> mSleeping;
+    char mPad2[LOC_CACHE_LINE_SIZE];
+    std::atomic<bool> mUnblocked;
+    std::atomic<uint32_t> mOverflowSize;
+    std::mutex mOverflowLock;
+    std::deque<LocMsg*> mOverflow;
+
+    static inline uint32_t roundUpCapacity(uint32_t capacity) {
+        uint32_t size = 2;
+        while (size < capacity && size < LOC_MSG_QUEUE_RING_MAX_CAPACITY) {
+            size <<= 1;
+        }
+        return size;
+    }
+    static inline void futexWait(std::atomic<int>* addr, int val) {
+        syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAIT_PRIVATE, val,
+                NULL, NULL, 0);
+    }
+    static inline void futexWake(std::atomic<int>* addr, int count) {
+        syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAKE_PRIVATE, count,
+                NULL, NULL, 0);
+    }
+
+    bool tryPush(LocMsg* msg);
+    LocMsg* tryPop();
+    LocMsg* popOverflow();
+    void wakeConsumer();
+
+public:
+    LocMsgQueueRing(uint32_t capacity);
+    virtual ~LocMsgQueueRing();
+
+    virtual bool send(LocMsg* msg) override;
+    virtual LocMsg* receive() override;
+    virtual LocMsg* tryReceive() override;
+    virtual void unblock() override;
+    virtual void flush() override;
+};
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex word must be an int");
+
+LocMsgQueueRing::LocMsgQueueRing(uint32_t capacity) :
+        mMask(roundUpCapacity(capacity) - 1), mCells(new Cell[mMask + 1]),
+        mEnqPos(0), mDeqPos(0), mSleeping(0), mUnblocked(false), mOverflowSize(0) {
+    for (uint32_t i = 0; i <= mMask; i++) {
+        mCells[i].mSeq.store(i, std::memory_order_relaxed);
+        mCells[i].mMsg = NULL;
+    }
+}
+
+LocMsgQueueRing::~LocMsgQueueRing() {
+    flush();
+    delete[] mCells;
+}
+
+inline bool LocMsgQueueRing::tryPush(LocMsg* msg) {
+    uint32_t pos = mEnqPos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = mCells[pos & mMask];
+        int32_t diff = (int32_t)(cell.mSeq.load(std::memory_order_acquire) - pos);
+        if (0 == diff) {
+            if (mEnqPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.mMsg = msg;
+                cell.mSeq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // consumer has not freed this cell yet, ring is full
+            return false;
+        } else {
+            pos = mEnqPos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+inline LocMsg* LocMsgQueueRing::tryPop() {
+    Cell& cell = mCells[mDeqPos & mMask];
+    if (cell.mSeq.load(std::memory_order_acquire) != mDeqPos + 1) {
+        return NULL;
+    }
+    LocMsg* msg = cell.mMsg;
+    cell.mMsg = NULL;
+    // recycle the cell for the producer one lap ahead
+    cell.mSeq.store(mDeqPos + mMask + 1, std::memory_order_release);
+    mDeqPos++;
+    return msg;
+}
+
+LocMsg* LocMsgQueueRing::popOverflow() {
+    LocMsg* msg = NULL;
+    std::lock_guard<std::mutex> guard(mOverflowLock);
+    if (!mOverflow.empty()) {
+        msg = mOverflow.front();
+        mOverflow.pop_front();
+        mOverflowSize.fetch_sub(1, std::memory_order_release);
+    }
+    return msg;
+}
+
+inline void LocMsgQueueRing::wakeConsumer() {
+    // pairs with the fence in receive(), either we see the consumer parked
+    // or the consumer sees what we just queued
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (1 == mSleeping.load(std::memory_order_relaxed) &&
+            1 == mSleeping.exchange(0, std::memory_order_relaxed)) {
+        futexWake(&mSleeping, 1);
+    }
+}
+
+bool LocMsgQueueRing::send(LocMsg* msg) {
+    if (mUnblocked.load(std::memory_order_acquire)) {
+        LOC_LOGE("%s: Message queue has been unblocked.", __func__);
+        return false;
+    }
+
+    if (0 != mOverflowSize.load(std::memory_order_acquire) || !tryPush(msg)) {
+        std::lock_guard<std::mutex> guard(mOverflowLock);
+        mOverflow.push_back(msg);
+        mOverflowSize.fetch_add(1, std::memory_order_release);
+    }
+
+    wakeConsumer();
+    return true;
+}
+
+LocMsg* LocMsgQueueRing::receive() {
+    for (;;) {
+        if (mUnblocked.load(std::memory_order_acquire)) {
+            LOC_LOGE("%s: Message queue has been unblocked.", __func__);
+            return NULL;
+        }
+
+        LocMsg* msg = tryPop();
+        if (NULL != msg) {
+            return msg;
+        }
+
+        if (mEnqPos.load(std::memory_order_acquire) != mDeqPos) {
+            // a producer claimed the next cell but has not published it yet.
+            // Must not look at overflow before it lands, or its sender's
+            // later msgs could jump ahead of it.
+            sched_yield();
+            continue;
+        }
+
+        if (0 != mOverflowSize.load(std::memory_order_acquire)) {
+            msg = popOverflow();
+            if (NULL != msg) {
+                return msg;
+            }
+            continue;
+        }
+
+        mSleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!mUnblocked.load(std::memory_order_relaxed) &&
+                mEnqPos.load(std::memory_order_relaxed) == mDeqPos &&
+                0 == mOverflowSize.load(std::memory_order_relaxed)) {
+            futexWait(&mSleeping, 1);
+        }
+        mSleeping.store(0, std::memory_order_relaxed);
+    }
+}
+
+LocMsg* LocMsgQueueRing::tryReceive() {
+    LocMsg* msg = NULL;
+    if (!mUnblocked.load(std::memory_order_acquire)) {
+        msg = tryPop();
+        // as in receive(), overflow only once nothing is in flight in the ring
+        if (NULL == msg && mEnqPos.load(std::memory_order_acquire) == mDeqPos &&
+                0 != mOverflowSize.load(std::memory_order_acquire)) {
+            msg = popOverflow();
+        }
+    }
+    return msg;
+}
+
+void LocMsgQueueRing::unblock() {
+    LOC_LOGD("%s: Unblocking Message Queue", __func__);
+    mUnblocked.store(true, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    mSleeping.store(0, std::memory_order_relaxed);
+    futexWake(&mSleeping, INT_MAX);
+}
+
+void LocMsgQueueRing::flush() {
+    LocMsg* msg;
+    while (NULL != (msg = tryPop()) || NULL != (msg = popOverflow())) {
+        delete msg;
+    }
+}
+
+static uint32_t sMsgTaskQueueType = LOC_MSG_QUEUE_RING;
+static uint32_t sMsgTaskRingCapacity = LOC_MSG_QUEUE_RING_DEFAULT_CAPACITY;
+
+LocMsgQueue* LocMsgQueue::create() {
+    static const bool sConfigRead = []() {
+        loc_param_s_type msgQueueConfigTable[] = {
+            {"MSG_TASK_QUEUE_TYPE",    &sMsgTaskQueueType,    NULL, 'n'},
+            {"MSG_TASK_RING_CAPACITY", &sMsgTaskRingCapacity, NULL, 'n'},
+        };
+        UTIL_READ_CONF(LOC_PATH_GPS_CONF, msgQueueConfigTable);
+        LOC_LOGd("MSG_TASK_QUEUE_TYPE %u MSG_TASK_RING_CAPACITY %u",
+                 sMsgTaskQueueType, sMsgTaskRingCapacity);
+        return true;
+    }();
+    (void)sConfigRead;
+    return create((LocMsgQueueType)sMsgTaskQueueType, sMsgTaskRingCapacity);
+}
+
+LocMsgQueue* LocMsgQueue::create(LocMsgQueueType type, uint32_t ringCapacity) {
+    LocMsgQueue* q = NULL;
+    if (LOC_MSG_QUEUE_RING == type) {
+        q = new LocMsgQueueRing(ringCapacity);
+    } else {
+        LocMsgQueueLegacy* legacyQ = new LocMsgQueueLegacy();
+        if (legacyQ->isValid()) {
+            q = legacyQ;
+        } else {
+            LOC_LOGE("%s: msg_q_init2 failed", __func__);
+            delete legacyQ;
+        }
+    }
+    return q;
+}
+
+#ifdef __LOC_UNIT_TEST__
+struct LocCheckMsg : public LocMsg {
+    const uint32_t mProducer;
+    const uint32_t mSeq;
+    inline LocCheckMsg(uint32_t producer, uint32_t seq) : mProducer(producer), mSeq(seq) {}
+    inline virtual void proc() const override {}
+};
+
+uint32_t LocMsgQueue::checkOrder(LocMsgQueueType type, uint32_t numProducers,
+                                 uint32_t msgsPerProducer) {
+    // a small ring so that producers also spill into the overflow list
+    LocMsgQueue* q = create(type, 64);
+    std::vector<std::thread> producers;
+
+    for (uint32_t i = 0; i < numProducers; i++) {
+        producers.emplace_back([q, i, msgsPerProducer] {
+            for (uint32_t j = 0; j < msgsPerProducer; j++) {
+                q->send(new LocCheckMsg(i, j));
+            }
+        });
+    }
+
+    uint32_t mismatches = 0;
+    std::vector<uint32_t> nextSeq(numProducers, 0);
+    uint64_t total = (uint64_t)numProducers * msgsPerProducer;
+    for (uint64_t n = 0; n < total; n++) {
+        LocCheckMsg* msg = (LocCheckMsg*)q->receive();
+        if (msg->mProducer >= numProducers || msg->mSeq != nextSeq[msg->mProducer]) {
+            mismatches++;
+        } else {
+            nextSeq[msg->mProducer]++;
+        }
+        delete msg;
+    }
+    if (nullptr != q->tryReceive()) {
+        mismatches++;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    delete q;
+    return mismatches;
+}
+
+static inline uint64_t benchmarkNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct LocBenchmarkMsg : public LocMsg {
+    uint64_t mSentNs;
+    inline LocBenchmarkMsg() : mSentNs(0) {}
+    inline virtual void proc() const override {}
+};
+
+void LocMsgQueue::benchmark(LocMsgQueueType type, uint32_t numProducers,
+                            uint32_t msgsPerProducer,
+                            uint64_t& sendNs, uint64_t& latencyNs) {
+    LocMsgQueue* q = create(type, LOC_MSG_QUEUE_RING_DEFAULT_CAPACITY);
+    std::atomic<uint64_t> totalSendNs(0);
+    std::vector<std::thread> producers;
+
+    for (uint32_t i = 0; i < numProducers; i++) {
+        producers.emplace_back([q, msgsPerProducer, &totalSendNs] {
+            uint64_t spentNs = 0;
+            for (uint32_t j = 0; j < msgsPerProducer; j++) {
+                LocBenchmarkMsg* msg = new LocBenchmarkMsg();
+                uint64_t start = benchmarkNowNs();
+                msg->mSentNs = start;
+                q->send(msg);
+                spentNs += benchmarkNowNs() - start;
+            }
+            totalSendNs += spentNs;
+        });
+    }
+
+    uint64_t total = (uint64_t)numProducers * msgsPerProducer;
+    uint64_t totalLatencyNs = 0;
+    for (uint64_t n = 0; n < total; n++) {
+        LocBenchmarkMsg* msg = (LocBenchmarkMsg*)q->receive();
+        totalLatencyNs += benchmarkNowNs() - msg->mSentNs;
+        delete msg;
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    delete q;
+
+    sendNs = total ? totalSendNs / total : 0;
+    latencyNs = total ? totalLatencyNs / total : 0;
+}
+#endif
+
+} // namespace loc_util
@@ -0,0 +1,94 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_MSG_QUEUE__
+#define __LOC_MSG_QUEUE__
+
+#include <stdint.h>
+
+namespace loc_util {
+
+struct LocMsg;
+
+// Queue backends MsgTask can run on, selected by MSG_TASK_QUEUE_TYPE
+// in gps.conf.
+typedef enum {
+    // msg_q over linked_list, mutex + condvar, one malloc per msg
+    LOC_MSG_QUEUE_LEGACY = 0,
+    // bounded lock-free multi-producer / single-consumer ring with
+    // futex wakeup; spills into a locked overflow list when full. The
+    // default, no allocation per msg short of spilling.
+    LOC_MSG_QUEUE_RING = 1,
+} LocMsgQueueType;
+
+// abstract msg queue used by MsgTask. Any number of threads may send;
+// only the MsgTask thread receives.
+class LocMsgQueue {
+public:
+    inline LocMsgQueue() {}
+    inline virtual ~LocMsgQueue() {}
+
+    // queues the msg. Ownership passes to the queue on success.
+    // Returns false if the queue has been unblocked; msg is untouched.
+    virtual bool send(LocMsg* msg) = 0;
+
+    // blocks until a msg is available and returns it, caller owns it.
+    // Returns NULL once the queue has been unblocked.
+    virtual LocMsg* receive() = 0;
+
+    // returns the next msg if one is available without blocking, caller
+    // owns it. Returns NULL if the queue is empty or unblocked.
+    virtual LocMsg* tryReceive() = 0;
+
+    // wakes up the receiver and makes all subsequent send / receive fail
+    virtual void unblock() = 0;
+
+    // deletes all pending msgs
+    virtual void flush() = 0;
+
+    // creates a queue of the backend type configured in gps.conf
+    static LocMsgQueue* create();
+    static LocMsgQueue* create(LocMsgQueueType type, uint32_t ringCapacity);
+
+#ifdef __LOC_UNIT_TEST__
+    // numProducers threads each send msgsPerProducer msgs while this one
+    // receives them. Returns the number of msgs lost, duplicated or out
+    // of their producer's order; 0 on success.
+    static uint32_t checkOrder(LocMsgQueueType type, uint32_t numProducers,
+                               uint32_t msgsPerProducer);
+    // measures average send() latency and send-to-receive latency, in ns,
+    // with numProducers threads each sending msgsPerProducer msgs.
+    static void benchmark(LocMsgQueueType type, uint32_t numProducers,
+                          uint32_t msgsPerProducer,
+                          uint64_t& sendNs, uint64_t& latencyNs);
+#endif
+};
+
+} // namespace loc_util
+
+#endif //__LOC_MSG_QUEUE__
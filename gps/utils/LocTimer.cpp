@@ -37,7 +37,7 @@
 #include <log_util.h>
 #include <loc_timer.h>
 #include <LocTimer.h>
-#include <LocHeap.h>
+#include <LocTimerQueue.h>
 #include <LocThread.h>
 #include <LocSharedLock.h>
 #include <MsgTask.h>
@@ -56,22 +56,21 @@ LocTimer, LocTimerDelegate, LocTimerContainer, LocTimerPollTask, LocTimerWrapper
 
 LocTimer - client front end, interface for client to start / stop timers, also
            to provide a callback.
-LocTimerDelegate - an internal timer entity, which also is a LocRankable obj.
+LocTimerDelegate - an internal timer entity, which also is a LocTimerQueueNode obj.
                    Its life cycle is different than that of LocTimer. It gets
                    created when LocTimer::start() is called, and gets deleted
                    when it expires or clients calls the hosting LocTimer obj's
                    stop() method. When a LocTimerDelegate obj is ticking, it
-                   stays in the corresponding LocTimerContainer. When expired
-                   or stopped, the obj is removed from the container. Since it
-                   is also a LocRankable obj, and LocTimerContainer also is a
-                   heap, its ranks() implementation decides where it is placed
-                   in the heap.
-LocTimerContainer - core of the timer service. It is a container (derived from
-                    LocHeap) for LocTimerDelegate (implements LocRankable) objs.
+                   stays in the LocTimerQueue of the corresponding
+                   LocTimerContainer. When expired or stopped, the obj is
+                   removed from the container.
+LocTimerContainer - core of the timer service. It is a container, on top of a
+                    LocTimerQueue (a heap or a timing wheel, per gps.conf), for
+                    LocTimerDelegate objs.
                     There are 2 of such containers, one for sw timers (or Linux
                     timers) one for hw timers (or Linux alarms). It adds one of
                     each (those that expire the soonest) to kernel via services
-                    provided by LocTimerPollTask. All the heap management on the
+                    provided by LocTimerPollTask. All the queue management on the
                     LocTimerDelegate objs are done in the MsgTask context, such
                     that synchronization is ensured.
 LocTimerPollTask - is a class that wraps timerfd and epoll POXIS APIs. It also
@@ -86,14 +85,14 @@ LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
 class LocTimerPollTask;
 
 // This is a multi-functaional class that:
-// * extends the LocHeap class for the detection of head update upon add / remove
-//   events. When that happens, soonest time out changes, so timerfd needs update.
-// * contains the timers, and add / remove them into the heap
+// * keeps the timers in a LocTimerQueue, and detects changes of the soonest time
+//   out upon add / remove / expire events. Only then timerfd needs update.
+// * contains the timers, and add / remove them into the queue
 // * provides and maps 2 of such containers, one for timers (or  mSwTimers), one
 //   for alarms (or mHwTimers);
 // * provides a polling thread;
 // * provides a MsgTask thread for synchronized add / remove / timer client callback.
-class LocTimerContainer : public LocHeap {
+class LocTimerContainer {
     // mutex to synchronize getters of static members
     static pthread_mutex_t mMutex;
     // Container of timers
@@ -106,22 +105,23 @@ class LocTimerContainer : public LocHeap {
     static LocTimerPollTask* mPollTask;
     // timer / alarm fd
     int mDevFd;
+    // ticking timers, only accessed in the MsgTask context
+    LocTimerQueue* mQueue;
+    // absolute time mDevFd is armed for, 0 if disarmed
+    uint64_t mArmedNs;
     // ctor
     LocTimerContainer(bool wakeOnExpire);
     // dtor
     ~LocTimerContainer();
     static MsgTask* getMsgTaskLocked();
     static LocTimerPollTask* getPollTaskLocked();
-    // extend LocHeap and pop if the top outRanks input
-    LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
-    // update the timer POSIX calls with updated soonest timer spec
-    void updateSoonestTime(LocTimerDelegate* priorTop);
+    // update the timer POSIX calls if the soonest time out has changed
+    void updateSoonestTime();
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
     static LocTimerContainer* get(bool wakeOnExpire);
 
-    LocTimerDelegate* getSoonestTimer();
     int getTimerFd();
     // add a timer / alarm obj into the container
     void add(LocTimerDelegate& timer);
@@ -169,9 +169,9 @@ public:
     // dtor
     ~LocTimerPollTask() = default;
     // add a container of timers. Each contain has a unique device fd, i.e.
-    // either timer or alarm fd, and a heap of timers / alarms. It is expected
+    // either timer or alarm fd, and a queue of timers / alarms. It is expected
     // that container would have written to the device fd with the soonest
-    // time out value in the heap at the time of calling this method. So all
+    // time out value in the queue at the time of calling this method. So all
     // this method does is to add the fd of the input container to the poll
     // and also add the pointer of the container to the event data ptr, such
     // when poll_wait wakes up on events, we know who is the owner of the fd.
@@ -183,28 +183,26 @@ public:
 
 // Internal class of timer obj. It gets born when client calls LocTimer::start();
 // and gets deleted when client calls LocTimer::stop() or when the it expire()'s.
-// This class implements LocRankable::ranks() so that when an obj is added into
-// the container (of LocHeap), it gets placed in sorted order.
-class LocTimerDelegate : public LocRankable {
+// As a LocTimerQueueNode, it is kept by the container's queue in expiry order.
+class LocTimerDelegate : public LocTimerQueueNode {
     friend class LocTimerContainer;
     friend class LocTimer;
     LocTimer* mClient;
     LocSharedLock* mLock;
-    struct timespec mFutureTime;
     LocTimerContainer* mContainer;
-    // not a complete obj, just ctor for LocRankable comparisons
-    inline LocTimerDelegate(struct timespec& delay)
-        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL) {}
     inline ~LocTimerDelegate() { if (mLock) { mLock->drop(); mLock = NULL; } }
 public:
-    LocTimerDelegate(LocTimer& client, struct timespec& futureTime, LocTimerContainer* container);
+    LocTimerDelegate(LocTimer& client, uint64_t expiryNs, LocTimerContainer* container);
     void destroyLocked();
-    // LocRankable virtual method
-    virtual int ranks(LocRankable& rankable);
     void expire();
-    inline struct timespec getFutureTime() { return mFutureTime; }
 };
 
+static inline uint64_t getBootTimeNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
 /***************************LocTimerContainer methods***************************/
 
 // Most of these static recources are created on demand. They however are never
@@ -218,11 +216,12 @@ LocTimerContainer* LocTimerContainer::mHwTimers = NULL;
 MsgTask* LocTimerContainer::mMsgTask = NULL;
 LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
 
-// ctor - initialize timer heaps
+// ctor - initialize timer queues
 // A container for swTimer (timer) is created, when wakeOnExpire is true; or
 // HwTimer (alarm), when wakeOnExpire is false.
 LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)),
+    mQueue(LocTimerQueue::create()), mArmedNs(0) {
 
     if ((-1 == mDevFd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
@@ -244,6 +243,7 @@ LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
 inline
 LocTimerContainer::~LocTimerContainer() {
     close(mDevFd);
+    delete mQueue;
 }
 
 LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
@@ -282,45 +282,38 @@ LocTimerPollTask* LocTimerContainer::getPollTaskLocked() {
     return mPollTask;
 }
 
-inline
-LocTimerDelegate* LocTimerContainer::getSoonestTimer() {
-    return (LocTimerDelegate*)(peek());
-}
-
 inline
 int LocTimerContainer::getTimerFd() {
     return mDevFd;
 }
 
-void LocTimerContainer::updateSoonestTime(LocTimerDelegate* priorTop) {
-    LocTimerDelegate* curTop = getSoonestTimer();
+// mArmedNs tracks what the timerfd is set to, so starting or stopping a
+// timer that is not the soonest costs no system call.
+void LocTimerContainer::updateSoonestTime() {
+    uint64_t soonestNs = 0;
+    mQueue->getNextExpiry(soonestNs);
 
-    // check if top has changed
-    if (curTop != priorTop) {
+    if (soonestNs != mArmedNs) {
         struct itimerspec delay;
         memset(&delay, 0, sizeof(struct itimerspec));
-        bool toSetTime = false;
-        // if tree is empty now, we remove poll and disarm timer
-        if (!curTop) {
+        // if queue is empty now, we remove poll and disarm timer
+        if (0 == soonestNs) {
             mPollTask->removePoll(*this);
-            // setting the values to disarm timer
-            delay.it_value.tv_sec = 0;
-            delay.it_value.tv_nsec = 0;
-            toSetTime = true;
-        } else if (!priorTop || curTop->outRanks(*priorTop)) {
-            // do this first to avoid race condition, in case settime is called
-            // with too small an interval
-            mPollTask->addPoll(*this);
-            delay.it_value = curTop->getFutureTime();
-            toSetTime = true;
-        }
-        if (toSetTime) {
-            timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+        } else {
+            if (0 == mArmedNs) {
+                // do this first to avoid race condition, in case settime is called
+                // with too small an interval
+                mPollTask->addPoll(*this);
+            }
+            delay.it_value.tv_sec = soonestNs / 1000000000ULL;
+            delay.it_value.tv_nsec = soonestNs % 1000000000ULL;
         }
+        timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+        mArmedNs = soonestNs;
     }
 }
 
-// all the heap management is done in the MsgTask context.
+// all the queue management is done in the MsgTask context.
 inline
 void LocTimerContainer::add(LocTimerDelegate& timer) {
     struct MsgTimerPush : public LocMsg {
@@ -329,16 +322,15 @@ void LocTimerContainer::add(LocTimerDelegate& timer) {
         inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
-            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-            mTimerContainer->push((LocRankable&)(*mTimer));
-            mTimerContainer->updateSoonestTime(priorTop);
+            mTimerContainer->mQueue->add(*mTimer, getBootTimeNs());
+            mTimerContainer->updateSoonestTime();
         }
     };
 
     mMsgTask->sendMsg(new MsgTimerPush(*this, timer));
 }
 
-// all the heap management is done in the MsgTask context.
+// all the queue management is done in the MsgTask context.
 void LocTimerContainer::remove(LocTimerDelegate& timer) {
     struct MsgTimerRemove : public LocMsg {
         LocTimerContainer* mTimerContainer;
@@ -346,14 +338,9 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
         inline MsgTimerRemove(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
-            LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
-
-            // update soonest timer only if mTimer is actually removed from
-            // mTimerContainer AND mTimer is not priorTop.
-            if (priorTop == ((LocHeap*)mTimerContainer)->remove((LocRankable&)*mTimer)) {
-                // if passing in NULL, we tell updateSoonestTime to update
-                // kernel with the current top timer interval.
-                mTimerContainer->updateSoonestTime(NULL);
+            // mTimer is not in the queue any more if it has expired
+            if (mTimerContainer->mQueue->remove(*mTimer)) {
+                mTimerContainer->updateSoonestTime();
             }
             // all timers are deleted here, and only here.
             delete mTimer;
@@ -363,28 +350,26 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
     mMsgTask->sendMsg(new MsgTimerRemove(*this, timer));
 }
 
-// all the heap management is done in the MsgTask context.
-// Upon expire, we check and continuously pop the heap until
-// the top node's timeout is in the future.
+// all the queue management is done in the MsgTask context.
+// Upon expire, we pop all the timers that are due.
 void LocTimerContainer::expire() {
     struct MsgTimerExpire : public LocMsg {
         LocTimerContainer* mTimerContainer;
         inline MsgTimerExpire(LocTimerContainer& container) :
             LocMsg(), mTimerContainer(&container) {}
         inline virtual void proc() const {
-            struct timespec now;
-            // get time spec of now
-            clock_gettime(CLOCK_BOOTTIME, &now);
-            LocTimerDelegate timerOfNow(now);
-            // pop everything in the heap that outRanks now, i.e. has time older than now
+            uint64_t nowNs = getBootTimeNs();
+            // timerfd has been disarmed and removed from poll in expire()
+            mTimerContainer->mArmedNs = 0;
+            // pop everything in the queue that has time older than now
             // and then call expire() on that timer.
-            for (LocTimerDelegate* timer = (LocTimerDelegate*)mTimerContainer->pop();
-                 NULL != timer;
-                 timer = mTimerContainer->popIfOutRanks(timerOfNow)) {
-                // the timer delegate obj will be deleted before the return of this call
-                timer->expire();
+            LocTimerQueueNode* timer;
+            while (NULL != (timer = mTimerContainer->mQueue->popExpired(nowNs))) {
+                // the timer delegate obj will be deleted after this call, by
+                // the MsgTimerRemove its stop() sends
+                static_cast<LocTimerDelegate*>(timer)->expire();
             }
-            mTimerContainer->updateSoonestTime(NULL);
+            mTimerContainer->updateSoonestTime();
         }
     };
 
@@ -395,15 +380,6 @@ void LocTimerContainer::expire() {
     mMsgTask->sendMsg(new MsgTimerExpire(*this));
 }
 
-LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
-    LocTimerDelegate* poppedNode = NULL;
-    if (mTree && !timer.outRanks(*peek())) {
-        poppedNode = (LocTimerDelegate*)(pop());
-    }
-
-    return poppedNode;
-}
-
 
 /***************************LocTimerPollTask methods***************************/
 
@@ -468,11 +444,11 @@ bool TimerRunnable::run() {
 
 inline
 LocTimerDelegate::LocTimerDelegate(LocTimer& client,
-                                   struct timespec& futureTime,
+                                   uint64_t expiryNs,
                                    LocTimerContainer* container)
-    : mClient(&client),
+    : LocTimerQueueNode(expiryNs),
+      mClient(&client),
       mLock(mClient->mLock->share()),
-      mFutureTime(futureTime),
       mContainer(container) {
     // adding the timer into the container
     mContainer->add(*this);
@@ -497,22 +473,6 @@ void LocTimerDelegate::destroyLocked() {
       // once, and we want it reach there only once.
 }
 
-int LocTimerDelegate::ranks(LocRankable& rankable) {
-    int rank = -1;
-    LocTimerDelegate* timer = (LocTimerDelegate*)(&rankable);
-    if (timer) {
-        // larger time ranks lower!!!
-        // IOW, if input obj has bigger tv_sec/tv_nsec, this obj outRanks higher
-        rank = timer->mFutureTime.tv_sec - mFutureTime.tv_sec;
-        if(0 == rank)
-        {
-            //rank against tv_nsec for msec accuracy
-            rank = (int)(timer->mFutureTime.tv_nsec - mFutureTime.tv_nsec);
-        }
-    }
-    return rank;
-}
-
 inline
 void LocTimerDelegate::expire() {
     // keeping a copy of client pointer to be safe
@@ -545,19 +505,12 @@ bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire) {
     bool success = false;
     mLock->lock();
     if (!mTimer) {
-        struct timespec futureTime;
-        clock_gettime(CLOCK_BOOTTIME, &futureTime);
-        futureTime.tv_sec += timeOutInMs / 1000;
-        futureTime.tv_nsec += (timeOutInMs % 1000) * 1000000;
-        if (futureTime.tv_nsec >= 1000000000) {
-            futureTime.tv_sec += futureTime.tv_nsec / 1000000000;
-            futureTime.tv_nsec %= 1000000000;
-        }
+        uint64_t expiryNs = getBootTimeNs() + (uint64_t)timeOutInMs * 1000000ULL;
 
         LocTimerContainer* container;
         container = LocTimerContainer::get(wakeOnExpire);
         if (NULL != container) {
-            mTimer = new LocTimerDelegate(*this, futureTime, container);
+            mTimer = new LocTimerDelegate(*this, expiryNs, container);
             // if mTimer is non 0, success should be 0; or vice versa
         }
         success = (NULL != mTimer);
@@ -0,0 +1,492 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <LocTimerQueue.h>
+#include <loc_cfg.h>
+#include <log_util.h>
+#include <loc_pla.h>
+#ifdef __LOC_UNIT_TEST__
+#include <algorithm>
+#include <vector>
+#endif
+
+namespace loc_util {
+
+// the sooner expiry ranks higher
+struct LocTimerQueueNodeCompare {
+    inline bool operator()(LocTimerQueueNode& a, LocTimerQueueNode& b) const {
+        return a.mExpiryNs < b.mExpiryNs;
+    }
+};
+
+class LocTimerHeap : public LocTimerQueue {
+    LocHeap<LocTimerQueueNode, LocTimerQueueNodeCompare> mHeap;
+public:
+    inline virtual void add(LocTimerQueueNode& timer, uint64_t) override {
+        mHeap.push(timer);
+    }
+    inline virtual bool remove(LocTimerQueueNode& timer) override {
+        return mHeap.remove(timer);
+    }
+    inline virtual bool getNextExpiry(uint64_t& expiryNs) override {
+        LocTimerQueueNode* top = mHeap.peek();
+        if (NULL != top) {
+            expiryNs = top->mExpiryNs;
+        }
+        return NULL != top;
+    }
+    inline virtual LocTimerQueueNode* popExpired(uint64_t nowNs) override {
+        LocTimerQueueNode* top = mHeap.peek();
+        return (NULL != top && top->mExpiryNs <= nowNs) ? mHeap.pop() : NULL;
+    }
+};
+
+#define LOC_TIMER_WHEEL_BITS   6
+#define LOC_TIMER_WHEEL_SLOTS  (1U << LOC_TIMER_WHEEL_BITS)
+#define LOC_TIMER_WHEEL_MASK   (LOC_TIMER_WHEEL_SLOTS - 1)
+#define LOC_TIMER_WHEEL_LEVELS 4
+// ticks covered by the wheel, 2^24 ticks or 46 hours at 10 ms slack
+#define LOC_TIMER_WHEEL_SPAN   (1ULL << (LOC_TIMER_WHEEL_BITS * LOC_TIMER_WHEEL_LEVELS))
+// ticks per slot of the top level
+#define LOC_TIMER_WHEEL_TOP_SLOT_TICKS \
+        (1ULL << (LOC_TIMER_WHEEL_BITS * (LOC_TIMER_WHEEL_LEVELS - 1)))
+
+// Hierarchical timing wheel. Expiry is rounded up to a tick of slackMs.
+// Level 0 has a slot per tick for the next 64 ticks, level n a slot per
+// 64^n ticks. A slot of level n > 0 is cascaded, i.e. its timers placed
+// again one or more levels down, when time reaches the start of its span.
+// Timers are kept in intrusive doubly linked lists, so add and remove are
+// O(1); a bitmap of non empty slots per level lets time skip idle ticks.
+// Timers beyond the span of the wheel wait in a far list, which is placed
+// again each time a top level slot cascades.
+class LocTimerWheel : public LocTimerQueue {
+    const uint64_t mTickNs;
+    // all ticks before mCurTick have been moved to mDue
+    uint64_t mCurTick;
+    // number of timers in the slots and mFar, mDue not included
+    uint32_t mCount;
+    uint64_t mOccupied[LOC_TIMER_WHEEL_LEVELS];
+    LocTimerQueueNode* mSlots[LOC_TIMER_WHEEL_LEVELS][LOC_TIMER_WHEEL_SLOTS];
+    // expired timers not popped yet
+    LocTimerQueueNode* mDue;
+    // timers beyond the span, with mLevel of LOC_TIMER_WHEEL_LEVELS
+    LocTimerQueueNode* mFar;
+    // cached result of getNextExpiry(), in ticks, UINT64_MAX if empty
+    bool mSoonestValid;
+    uint64_t mSoonestTick;
+
+    static inline void link(LocTimerQueueNode*& head, LocTimerQueueNode& timer) {
+        timer.mPrev = NULL;
+        timer.mNext = head;
+        if (NULL != head) {
+            head->mPrev = &timer;
+        }
+        head = &timer;
+    }
+    static inline void unlink(LocTimerQueueNode*& head, LocTimerQueueNode& timer) {
+        if (NULL != timer.mPrev) {
+            timer.mPrev->mNext = timer.mNext;
+        } else {
+            head = timer.mNext;
+        }
+        if (NULL != timer.mNext) {
+            timer.mNext->mPrev = timer.mPrev;
+        }
+        timer.mPrev = timer.mNext = NULL;
+    }
+    // distance from slot from to the first non empty slot, wrapping around
+    static inline uint32_t distanceToFirst(uint64_t occupied, uint32_t from) {
+        return __builtin_ctzll((0 == from) ? occupied :
+                               (occupied >> from) | (occupied << (64 - from)));
+    }
+
+    // slot of the level holding its soonest timers, and the tick its
+    // span starts at. The level must not be empty. done tells whether
+    // mCurTick has been processed by advance() already.
+    inline uint32_t firstSlot(int level, bool done, uint64_t& startTick) {
+        uint32_t shift = LOC_TIMER_WHEEL_BITS * level;
+        uint32_t cur = (mCurTick >> shift) & LOC_TIMER_WHEEL_MASK;
+        // slot cur of level 0 is due at mCurTick. That of the levels above
+        // is a full turn ahead, unless mCurTick starts its span and it has
+        // not been cascaded yet.
+        bool pending = !done && 0 == (mCurTick & ((1ULL << shift) - 1));
+        uint32_t from = (0 == level || pending) ? 0 : 1;
+        uint32_t offset = from + distanceToFirst(mOccupied[level],
+                                                 (cur + from) & LOC_TIMER_WHEEL_MASK);
+        startTick = (0 == level) ? mCurTick + offset : ((mCurTick >> shift) + offset) << shift;
+        return (cur + offset) & LOC_TIMER_WHEEL_MASK;
+    }
+
+    // timer.mTick must not be before mCurTick
+    void place(LocTimerQueueNode& timer) {
+        uint64_t delta = timer.mTick - mCurTick;
+        mCount++;
+        if (delta >= LOC_TIMER_WHEEL_SPAN) {
+            timer.mLevel = LOC_TIMER_WHEEL_LEVELS;
+            link(mFar, timer);
+            return;
+        }
+        int level = 0;
+        while (level < LOC_TIMER_WHEEL_LEVELS - 1 &&
+               delta >= (1ULL << (LOC_TIMER_WHEEL_BITS * (level + 1)))) {
+            level++;
+        }
+        uint32_t slot = (timer.mTick >> (LOC_TIMER_WHEEL_BITS * level)) & LOC_TIMER_WHEEL_MASK;
+        timer.mLevel = level;
+        timer.mSlot = slot;
+        link(mSlots[level][slot], timer);
+        mOccupied[level] |= (1ULL << slot);
+    }
+
+    // places again the timers of the list, which is emptied
+    void cascade(LocTimerQueueNode*& head) {
+        LocTimerQueueNode* timer = head;
+        head = NULL;
+        while (NULL != timer) {
+            LocTimerQueueNode* next = timer->mNext;
+            mCount--;
+            place(*timer);
+            timer = next;
+        }
+    }
+
+    // moves the timers of all ticks up to nowTick to mDue
+    void advance(uint64_t nowTick) {
+        while (mCount > 0 && mCurTick <= nowTick) {
+            if (0 == (mCurTick & LOC_TIMER_WHEEL_MASK)) {
+                for (int level = 1; level < LOC_TIMER_WHEEL_LEVELS; level++) {
+                    uint32_t slot = (mCurTick >> (LOC_TIMER_WHEEL_BITS * level)) &
+                            LOC_TIMER_WHEEL_MASK;
+                    mOccupied[level] &= ~(1ULL << slot);
+                    cascade(mSlots[level][slot]);
+                    if (0 != slot) {
+                        break;
+                    }
+                }
+                if (0 == (mCurTick & (LOC_TIMER_WHEEL_TOP_SLOT_TICKS - 1))) {
+                    cascade(mFar);
+                }
+            }
+            uint32_t slot = mCurTick & LOC_TIMER_WHEEL_MASK;
+            LocTimerQueueNode* timer;
+            while (NULL != (timer = mSlots[0][slot])) {
+                unlink(mSlots[0][slot], *timer);
+                timer->mLevel = -1;
+                link(mDue, *timer);
+                mCount--;
+            }
+            mOccupied[0] &= ~(1ULL << slot);
+
+            // skip to the next tick that has timers due or a slot to cascade
+            uint64_t nextTick = nowTick + 1;
+            if (NULL != mFar) {
+                nextTick = ((mCurTick / LOC_TIMER_WHEEL_TOP_SLOT_TICKS) + 1) *
+                        LOC_TIMER_WHEEL_TOP_SLOT_TICKS;
+                nextTick = (nextTick < nowTick + 1) ? nextTick : nowTick + 1;
+            }
+            for (int level = 0; level < LOC_TIMER_WHEEL_LEVELS; level++) {
+                if (0 != mOccupied[level]) {
+                    uint64_t startTick;
+                    firstSlot(level, true, startTick);
+                    nextTick = (startTick < nextTick) ? startTick : nextTick;
+                }
+            }
+            mCurTick = (nextTick > mCurTick) ? nextTick : mCurTick + 1;
+        }
+        if (mCurTick <= nowTick) {
+            mCurTick = nowTick + 1;
+        }
+    }
+
+public:
+    inline LocTimerWheel(uint32_t slackMs) :
+        mTickNs((uint64_t)slackMs * 1000000ULL), mCurTick(0), mCount(0), mDue(NULL), mFar(NULL),
+        mSoonestValid(true), mSoonestTick(UINT64_MAX) {
+        memset(mOccupied, 0, sizeof(mOccupied));
+        memset(mSlots, 0, sizeof(mSlots));
+    }
+
+    virtual void add(LocTimerQueueNode& timer, uint64_t nowNs) override {
+        // an idle wheel catches up with time at once
+        if (0 == mCount && mCurTick < nowNs / mTickNs) {
+            mCurTick = nowNs / mTickNs;
+        }
+        timer.mTick = (timer.mExpiryNs + mTickNs - 1) / mTickNs;
+        if (timer.mTick < mSoonestTick) {
+            mSoonestTick = timer.mTick;
+        }
+        if (timer.mTick < mCurTick) {
+            // its tick has passed already
+            timer.mLevel = -1;
+            link(mDue, timer);
+        } else {
+            place(timer);
+        }
+    }
+
+    virtual bool remove(LocTimerQueueNode& timer) override {
+        if (-1 == timer.mLevel) {
+            unlink(mDue, timer);
+        } else if (LOC_TIMER_WHEEL_LEVELS == timer.mLevel) {
+            unlink(mFar, timer);
+            mCount--;
+        } else if (timer.mLevel >= 0) {
+            LocTimerQueueNode*& head = mSlots[timer.mLevel][timer.mSlot];
+            unlink(head, timer);
+            if (NULL == head) {
+                mOccupied[timer.mLevel] &= ~(1ULL << timer.mSlot);
+            }
+            mCount--;
+        } else {
+            return false;
+        }
+        timer.mLevel = -2;
+        if (timer.mTick == mSoonestTick) {
+            mSoonestValid = false;
+        }
+        return true;
+    }
+
+    // the soonest timer of the wheel is the soonest in the first non empty
+    // slot of one of the levels, or in mDue / mFar. Arming the timerfd for
+    // it, instead of for the next cascade, means no wakeups other than for
+    // expiries. It is only looked up again once the cached one is gone.
+    virtual bool getNextExpiry(uint64_t& expiryNs) override {
+        if (!mSoonestValid) {
+            uint64_t soonest = UINT64_MAX;
+            for (LocTimerQueueNode* timer = mDue; NULL != timer; timer = timer->mNext) {
+                soonest = (timer->mTick < soonest) ? timer->mTick : soonest;
+            }
+            for (LocTimerQueueNode* timer = mFar; NULL != timer; timer = timer->mNext) {
+                soonest = (timer->mTick < soonest) ? timer->mTick : soonest;
+            }
+            for (int level = 0; level < LOC_TIMER_WHEEL_LEVELS; level++) {
+                uint64_t startTick;
+                // no timer in a slot is due before the slot's span starts
+                if (0 != mOccupied[level]) {
+                    uint32_t slot = firstSlot(level, false, startTick);
+                    for (LocTimerQueueNode* timer = mSlots[level][slot];
+                         NULL != timer && startTick < soonest; timer = timer->mNext) {
+                        soonest = (timer->mTick < soonest) ? timer->mTick : soonest;
+                    }
+                }
+            }
+            mSoonestTick = soonest;
+            mSoonestValid = true;
+        }
+        if (UINT64_MAX != mSoonestTick) {
+            expiryNs = mSoonestTick * mTickNs;
+        }
+        return UINT64_MAX != mSoonestTick;
+    }
+
+    virtual LocTimerQueueNode* popExpired(uint64_t nowNs) override {
+        if (NULL == mDue) {
+            advance(nowNs / mTickNs);
+        }
+        LocTimerQueueNode* timer = mDue;
+        if (NULL != timer) {
+            unlink(mDue, *timer);
+            timer->mLevel = -2;
+            mSoonestValid = false;
+        }
+        return timer;
+    }
+};
+
+static uint32_t sTimerQueueType = LOC_TIMER_QUEUE_HEAP;
+static uint32_t sTimerWheelSlackMs = LOC_TIMER_WHEEL_DEFAULT_SLACK_MSEC;
+
+LocTimerQueue* LocTimerQueue::create() {
+    static const bool sConfigRead = []() {
+        loc_param_s_type timerQueueConfigTable[] = {
+            {"TIMER_QUEUE_TYPE",       &sTimerQueueType,    NULL, 'n'},
+            {"TIMER_WHEEL_SLACK_MSEC", &sTimerWheelSlackMs, NULL, 'n'},
+        };
+        UTIL_READ_CONF(LOC_PATH_GPS_CONF, timerQueueConfigTable);
+        LOC_LOGd("TIMER_QUEUE_TYPE %u TIMER_WHEEL_SLACK_MSEC %u",
+                 sTimerQueueType, sTimerWheelSlackMs);
+        return true;
+    }();
+    (void)sConfigRead;
+    return create((LocTimerQueueType)sTimerQueueType, sTimerWheelSlackMs);
+}
+
+LocTimerQueue* LocTimerQueue::create(LocTimerQueueType type, uint32_t slackMs) {
+    if (LOC_TIMER_QUEUE_WHEEL == type) {
+        return new LocTimerWheel((0 == slackMs) ? 1 : slackMs);
+    }
+    return new LocTimerHeap();
+}
+
+#ifdef __LOC_UNIT_TEST__
+struct LocCheckTimer : public LocTimerQueueNode {
+    const uint32_t mIndex;
+    inline LocCheckTimer(uint64_t expiryNs, uint32_t index) :
+        LocTimerQueueNode(expiryNs), mIndex(index) {}
+};
+
+uint32_t LocTimerQueue::checkExpiry(LocTimerQueueType type, uint32_t numTimers,
+                                    uint32_t numOps) {
+    LocTimerQueue* q = create(type, LOC_TIMER_WHEEL_DEFAULT_SLACK_MSEC);
+    const uint64_t slackNs = (LOC_TIMER_QUEUE_WHEEL == type) ?
+            LOC_TIMER_WHEEL_DEFAULT_SLACK_MSEC * 1000000ULL : 0;
+    std::vector<LocCheckTimer*> timers(numTimers, nullptr);
+    // simulated CLOCK_BOOTTIME, timeouts of 10 ms to 6 s
+    uint64_t nowNs = 1000000000ULL;
+    uint32_t seed = 1;
+    auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+    auto restart = [&](uint32_t index) {
+        timers[index] = new LocCheckTimer(nowNs + (10 + random() % 6000) * 1000000ULL, index);
+        q->add(*timers[index], nowNs);
+    };
+
+    for (uint32_t i = 0; i < numTimers; i++) {
+        restart(i);
+    }
+
+    uint32_t mismatches = 0;
+    for (uint32_t n = 0; n < numOps; n++) {
+        uint32_t index = random() % numTimers;
+        if (!q->remove(*timers[index])) {
+            mismatches++;
+        }
+        delete timers[index];
+        restart(index);
+        if (99 == n % 100) {
+            nowNs += 1000000ULL;
+            LocTimerQueueNode* timer;
+            while (NULL != (timer = q->popExpired(nowNs))) {
+                // never early
+                if (timer->mExpiryNs > nowNs) {
+                    mismatches++;
+                }
+                uint32_t expired = ((LocCheckTimer*)timer)->mIndex;
+                delete timer;
+                restart(expired);
+            }
+            // never later than the slack, nor armed for later
+            uint64_t firstNs = UINT64_MAX;
+            for (auto timer : timers) {
+                firstNs = std::min(firstNs, timer->mExpiryNs);
+            }
+            uint64_t expiryNs = 0;
+            if (firstNs + slackNs <= nowNs ||
+                !q->getNextExpiry(expiryNs) || expiryNs > firstNs + slackNs) {
+                mismatches++;
+            }
+        }
+    }
+
+    for (auto timer : timers) {
+        q->remove(*timer);
+        delete timer;
+    }
+    delete q;
+    return mismatches;
+}
+
+static inline uint64_t benchmarkNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct LocBenchmarkTimer : public LocTimerQueueNode {
+    const uint32_t mIndex;
+    inline LocBenchmarkTimer(uint64_t expiryNs, uint32_t index) :
+        LocTimerQueueNode(expiryNs), mIndex(index) {}
+};
+
+void LocTimerQueue::benchmark(LocTimerQueueType type, uint32_t numTimers, uint32_t numOps,
+                              uint64_t& opNs, uint64_t& rearms) {
+    LocTimerQueue* q = create(type, LOC_TIMER_WHEEL_DEFAULT_SLACK_MSEC);
+    std::vector<LocBenchmarkTimer*> timers(numTimers, nullptr);
+    // simulated CLOCK_BOOTTIME, timeouts of 10 ms to 60 s
+    uint64_t nowNs = 1000000000ULL;
+    uint32_t seed = 1;
+    auto random = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 8;
+    };
+    auto restart = [&](uint32_t index) {
+        timers[index] = new LocBenchmarkTimer(
+                nowNs + (10 + random() % 60000) * 1000000ULL, index);
+        q->add(*timers[index], nowNs);
+    };
+    uint64_t armedNs = 0;
+    auto rearm = [&]() {
+        uint64_t expiryNs = 0;
+        q->getNextExpiry(expiryNs);
+        if (expiryNs != armedNs) {
+            armedNs = expiryNs;
+            rearms++;
+        }
+    };
+
+    for (uint32_t i = 0; i < numTimers; i++) {
+        restart(i);
+    }
+    rearms = 0;
+    rearm();
+
+    uint64_t start = benchmarkNowNs();
+    for (uint32_t n = 0; n < numOps; n++) {
+        uint32_t index = random() % numTimers;
+        q->remove(*timers[index]);
+        delete timers[index];
+        restart(index);
+        rearm();
+        if (99 == n % 100) {
+            nowNs += 1000000ULL;
+            LocTimerQueueNode* timer;
+            while (NULL != (timer = q->popExpired(nowNs))) {
+                uint32_t expired = ((LocBenchmarkTimer*)timer)->mIndex;
+                delete timer;
+                restart(expired);
+            }
+            rearm();
+        }
+    }
+    opNs = numOps ? (benchmarkNowNs() - start) / numOps : 0;
+
+    for (auto timer : timers) {
+        q->remove(*timer);
+        delete timer;
+    }
+    delete q;
+}
+#endif
+
+} // namespace loc_util
@@ -0,0 +1,108 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_TIMER_QUEUE__
+#define __LOC_TIMER_QUEUE__
+
+#include <stdint.h>
+#include <LocHeap.h>
+
+namespace loc_util {
+
+// default TIMER_WHEEL_SLACK_MSEC, i.e. tick of the timing wheel
+#define LOC_TIMER_WHEEL_DEFAULT_SLACK_MSEC 10
+
+// Backends LocTimer keeps its ticking timers in, selected by
+// TIMER_QUEUE_TYPE in gps.conf.
+typedef enum {
+    // LocHeap of timers, exact expiry, O(log n) start and stop
+    LOC_TIMER_QUEUE_HEAP = 0,
+    // hierarchical timing wheel, O(1) start / stop. Expiry is rounded up
+    // to TIMER_WHEEL_SLACK_MSEC so timers close together share a wakeup.
+    LOC_TIMER_QUEUE_WHEEL = 1,
+} LocTimerQueueType;
+
+// a timer as kept in a LocTimerQueue. mExpiryNs is absolute, in
+// CLOCK_BOOTTIME. The heap handle is only used by the heap, the links by
+// the wheel.
+class LocTimerQueueNode : public LocHeapHandle {
+    friend class LocTimerWheel;
+    LocTimerQueueNode* mPrev;
+    LocTimerQueueNode* mNext;
+    uint64_t mTick;
+    // wheel level, -1 if in the due list, -2 if not in the wheel
+    int8_t mLevel;
+    uint8_t mSlot;
+public:
+    const uint64_t mExpiryNs;
+    inline LocTimerQueueNode(uint64_t expiryNs) :
+        mPrev(NULL), mNext(NULL), mTick(0), mLevel(-2), mSlot(0),
+        mExpiryNs(expiryNs) {}
+    inline virtual ~LocTimerQueueNode() {}
+};
+
+// ticking timers of a LocTimerContainer, ordered by expiry. Only used from
+// the LocTimer MsgTask thread, so no locking.
+class LocTimerQueue {
+public:
+    inline LocTimerQueue() {}
+    inline virtual ~LocTimerQueue() {}
+
+    // adds a timer, nowNs is the current CLOCK_BOOTTIME
+    virtual void add(LocTimerQueueNode& timer, uint64_t nowNs) = 0;
+
+    // returns false if timer is not in the queue, e.g. already popped
+    virtual bool remove(LocTimerQueueNode& timer) = 0;
+
+    // time the timerfd should be armed for, false if the queue is empty
+    virtual bool getNextExpiry(uint64_t& expiryNs) = 0;
+
+    // removes and returns a timer that is due by nowNs, NULL if none is
+    virtual LocTimerQueueNode* popExpired(uint64_t nowNs) = 0;
+
+    // creates a queue of the backend type configured in gps.conf
+    static LocTimerQueue* create();
+    static LocTimerQueue* create(LocTimerQueueType type, uint32_t slackMs);
+
+#ifdef __LOC_UNIT_TEST__
+    // churns numTimers running timers numOps times, each op stopping one
+    // and restarting it with a new timeout, while time moves on by 1 ms
+    // every 100 ops and due timers are restarted. Returns the number of
+    // timers popped early, left due past the slack, or armed for too late;
+    // 0 on success.
+    static uint32_t checkExpiry(LocTimerQueueType type, uint32_t numTimers, uint32_t numOps);
+    // the same churn, with timeouts of up to 60 s. Returns average ns per
+    // op and the number of times the timerfd would have been reprogrammed.
+    static void benchmark(LocTimerQueueType type, uint32_t numTimers, uint32_t numOps,
+                          uint64_t& opNs, uint64_t& rearms);
+#endif
+};
+
+} // namespace loc_util
+
+#endif //__LOC_TIMER_QUEUE__
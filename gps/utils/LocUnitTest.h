@@ -0,0 +1,109 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_UNIT_TEST_H__
+#define __LOC_UNIT_TEST_H__
+
+// Scaffolding of the __LOC_UNIT_TEST__ test programs. Include it from the
+// file with main() only: defining LOC_UNIT_TEST_COUNT_ALLOCS before it also
+// replaces operator new with one that counts the allocations of the process.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <atomic>
+#include <new>
+
+namespace loc_util {
+
+// Runs the checks of a test program, and its benchmarks if it is started
+// with --benchmark. Checks pass or fail, benchmarks only print numbers, so
+// make check and ctest runs stay quick and deterministic.
+class LocUnitTest {
+    uint32_t mFailures;
+    bool mBenchmarks;
+public:
+    inline LocUnitTest(int argc, char** argv) : mFailures(0), mBenchmarks(false) {
+        for (int i = 1; i < argc; i++) {
+            if (0 == strcmp(argv[i], "--benchmark")) {
+                mBenchmarks = true;
+            }
+        }
+    }
+
+    inline bool runBenchmarks() const { return mBenchmarks; }
+
+    // mismatches is what the check returns, 0 on success
+    inline void report(const char* name, uint64_t mismatches) {
+        printf("%s %s", (0 == mismatches) ? "PASS" : "FAIL", name);
+        if (0 != mismatches) {
+            printf(", %" PRIu64 " mismatches", mismatches);
+            mFailures++;
+        }
+        printf("\n");
+    }
+
+    // prints the number of checks failed, returns the exit code for main()
+    inline int finish() {
+        printf("%u checks failed\n", mFailures);
+        return (0 == mFailures) ? 0 : 1;
+    }
+};
+
+#ifdef LOC_UNIT_TEST_COUNT_ALLOCS
+static std::atomic<uint64_t> sLocUnitTestAllocs(0);
+
+// number of allocations the process made so far
+static uint64_t locUnitTestAllocCount() {
+    return sLocUnitTestAllocs.load(std::memory_order_relaxed);
+}
+#endif
+
+} // namespace loc_util
+
+#ifdef LOC_UNIT_TEST_COUNT_ALLOCS
+void* operator new(size_t size) {
+    loc_util::sLocUnitTestAllocs.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc((0 == size) ? 1 : size);
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+#endif
+
+#endif //__LOC_UNIT_TEST_H__
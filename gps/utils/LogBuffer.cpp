@@ -28,6 +28,10 @@
  */
 
 #include "LogBuffer.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <wchar.h>
+#include <algorithm>
 #ifdef USE_GLIB
 #include <execinfo.h>
 #endif
@@ -44,6 +48,291 @@ struct sigaction LogBuffer::mOriSigAction[NSIG];
 struct sigaction LogBuffer::mNewSigAction;
 mutex LogBuffer::sLock;
 
+class LogBufferRing {
+public:
+    // number of records written; the last LOG_BUFFER_RING_SIZE are kept
+    atomic<uint64_t> mHead;
+    // number of records whose writing has begun, at most mHead + 1
+    atomic<uint64_t> mBegun;
+    // records before this one have been flushed
+    atomic<uint64_t> mStart;
+    // false once the thread writing to the ring has exited, so that
+    // another thread can take it over
+    atomic<bool> mOwned;
+    LogBufferRing* mNext;
+    int32_t mTid;
+    LogBufferRecord mRecords[LOG_BUFFER_RING_SIZE];
+
+    inline LogBufferRing() :
+        mHead(0), mBegun(0), mStart(0), mOwned(true), mNext(nullptr), mTid(0) {}
+
+    // the slot for the next record; commit() makes it visible to dump()
+    inline LogBufferRecord& begin() {
+        uint64_t head = mHead.load(memory_order_relaxed);
+        // seqlock style, dump() drops a record it may have copied while
+        // it was being overwritten
+        mBegun.store(head + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        LogBufferRecord& record = mRecords[head % LOG_BUFFER_RING_SIZE];
+        record.mTid = mTid;
+        record.mNumArgs = 0;
+        record.mStringsLen = 0;
+        return record;
+    }
+    inline void commit() {
+        mHead.store(mHead.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+};
+
+// hands the ring of a thread back when the thread exits
+struct LogBufferRingOwner {
+    LogBufferRing* mRing;
+    inline LogBufferRingOwner() : mRing(nullptr) {}
+    inline ~LogBufferRingOwner() {
+        if (nullptr != mRing) {
+            mRing->mOwned.store(false, memory_order_release);
+        }
+    }
+};
+static thread_local LogBufferRingOwner sRingOwner;
+
+static inline uint64_t getClockNs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// one conversion of a printf format, from its '%' up to mEnd
+struct LogBufferConversion {
+    const char* mEnd;
+    char mConv;
+    // 0, or 'h', 'H' for hh, 'l', 'q' for ll, 'j', 'z', 't', 'L'
+    char mLength;
+    bool mStarWidth;
+    bool mStarPrecision;
+    // -1 if none or given by an arg
+    int mPrecision;
+
+    inline uint32_t numArgs() const {
+        return (mStarWidth ? 1 : 0) + (mStarPrecision ? 1 : 0) + 1;
+    }
+};
+
+// p points at a '%' that is not part of "%%". Returns false on formats
+// not supported, which stop the recording / formatting of the args.
+static bool parseConversion(const char* p, LogBufferConversion& c) {
+    c.mStarWidth = c.mStarPrecision = false;
+    c.mPrecision = -1;
+    c.mLength = 0;
+    p++;
+    while ('-' == *p || '+' == *p || ' ' == *p || '#' == *p || '0' == *p || '\'' == *p) {
+        p++;
+    }
+    if ('*' == *p) {
+        c.mStarWidth = true;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    if ('.' == *p) {
+        p++;
+        if ('*' == *p) {
+            c.mStarPrecision = true;
+            p++;
+        } else {
+            c.mPrecision = 0;
+            while (*p >= '0' && *p <= '9') {
+                c.mPrecision = c.mPrecision * 10 + (*p++ - '0');
+            }
+        }
+    }
+    switch (*p) {
+    case 'h':
+        c.mLength = ('h' == p[1]) ? (p++, 'H') : 'h';
+        p++;
+        break;
+    case 'l':
+        c.mLength = ('l' == p[1]) ? (p++, 'q') : 'l';
+        p++;
+        break;
+    case 'q': case 'j': case 'z': case 't': case 'L':
+        c.mLength = *p++;
+        break;
+    }
+    c.mConv = *p;
+    c.mEnd = p + 1;
+    switch (c.mConv) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'p': case 'n':
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        return true;
+    case 'c': case 's':
+        // wide chars / strings are not kept
+        return 'l' != c.mLength;
+    default:
+        return false;
+    }
+}
+
+// stores the args format consumes in record, until the first that is not
+// supported or does not fit
+static void recordArgs(LogBufferRecord& record, const char* format, va_list args) {
+    for (const char* p = strchr(format, '%'); nullptr != p; p = strchr(p, '%')) {
+        if ('%' == p[1]) {
+            p += 2;
+            continue;
+        }
+        LogBufferConversion c;
+        if (!parseConversion(p, c) ||
+            record.mNumArgs + c.numArgs() > LOG_BUFFER_MAX_ARGS) {
+            break;
+        }
+        p = c.mEnd;
+        uint64_t* arg = &record.mArgs[record.mNumArgs];
+        int precision = c.mPrecision;
+        if (c.mStarWidth) {
+            *arg++ = (uint64_t)(int64_t)va_arg(args, int);
+        }
+        if (c.mStarPrecision) {
+            precision = va_arg(args, int);
+            *arg++ = (uint64_t)(int64_t)precision;
+        }
+        switch (c.mConv) {
+        case 'd': case 'i':
+            switch (c.mLength) {
+            case 'l': *arg = (int64_t)va_arg(args, long); break;
+            case 'q': *arg = (int64_t)va_arg(args, long long); break;
+            case 'j': *arg = (int64_t)va_arg(args, intmax_t); break;
+            case 'z': *arg = (int64_t)va_arg(args, ssize_t); break;
+            case 't': *arg = (int64_t)va_arg(args, ptrdiff_t); break;
+            default:  *arg = (int64_t)va_arg(args, int); break;
+            }
+            break;
+        case 'o': case 'u': case 'x': case 'X':
+            switch (c.mLength) {
+            case 'l': *arg = va_arg(args, unsigned long); break;
+            case 'q': *arg = va_arg(args, unsigned long long); break;
+            case 'j': *arg = va_arg(args, uintmax_t); break;
+            case 'z': *arg = va_arg(args, size_t); break;
+            case 't': *arg = va_arg(args, ptrdiff_t); break;
+            default:  *arg = va_arg(args, unsigned int); break;
+            }
+            break;
+        case 'c':
+            *arg = va_arg(args, int);
+            break;
+        case 'p': case 'n':
+            *arg = (uintptr_t)va_arg(args, void*);
+            break;
+        case 's': {
+            const char* str = va_arg(args, const char*);
+            if (nullptr == str) {
+                *arg = UINT64_MAX;
+                break;
+            }
+            size_t space = LOG_BUFFER_MAX_STRINGS_LEN - record.mStringsLen;
+            if (0 == space) {
+                // point to the NUL of the last string
+                *arg = record.mStringsLen - 1;
+                break;
+            }
+            size_t len = strnlen(str, (precision >= 0 && (size_t)precision < space - 1) ?
+                                 precision : space - 1);
+            memcpy(&record.mStrings[record.mStringsLen], str, len);
+            record.mStrings[record.mStringsLen + len] = '\0';
+            *arg = record.mStringsLen;
+            record.mStringsLen += len + 1;
+            break;
+        }
+        default: {
+            double d = ('L' == c.mLength) ? (double)va_arg(args, long double) :
+                    va_arg(args, double);
+            memcpy(arg, &d, sizeof(d));
+            break;
+        }
+        }
+        record.mNumArgs += c.numArgs();
+    }
+}
+
+// the inverse of recordArgs(), formats the record's msg into out
+static void formatArgs(const LogBufferRecord& record, string& out) {
+    uint32_t arg = 0;
+    const char* p = record.mFormat;
+    while ('\0' != *p) {
+        const char* percent = strchr(p, '%');
+        if (nullptr == percent) {
+            out.append(p);
+            break;
+        }
+        out.append(p, percent - p);
+        if ('%' == percent[1]) {
+            out.push_back('%');
+            p = percent + 2;
+            continue;
+        }
+        LogBufferConversion c;
+        char spec[32];
+        size_t specLen = 0;
+        if (!parseConversion(percent, c) || arg + c.numArgs() > record.mNumArgs) {
+            // args that were not kept
+            out.append(percent);
+            break;
+        }
+        // the conversion, with each '*' replaced by its arg
+        for (const char* q = percent; q < c.mEnd && specLen < sizeof(spec) - 12; q++) {
+            if ('*' == *q) {
+                specLen += snprintf(&spec[specLen], sizeof(spec) - specLen, "%d",
+                                    (int)(int64_t)record.mArgs[arg++]);
+            } else {
+                spec[specLen++] = *q;
+            }
+        }
+        spec[specLen] = '\0';
+        p = c.mEnd;
+
+        uint64_t value = record.mArgs[arg++];
+        char text[LOG_BUFFER_MAX_STRINGS_LEN + 64];
+        text[0] = '\0';
+        switch (c.mConv) {
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            switch (c.mLength) {
+            case 'l': snprintf(text, sizeof(text), spec, (long)value); break;
+            case 'q': snprintf(text, sizeof(text), spec, (long long)value); break;
+            case 'j': snprintf(text, sizeof(text), spec, (intmax_t)value); break;
+            case 'z': snprintf(text, sizeof(text), spec, (size_t)value); break;
+            case 't': snprintf(text, sizeof(text), spec, (ptrdiff_t)value); break;
+            default:  snprintf(text, sizeof(text), spec, (int)value); break;
+            }
+            break;
+        case 'c':
+            snprintf(text, sizeof(text), spec, (int)value);
+            break;
+        case 'p':
+            snprintf(text, sizeof(text), spec, (void*)(uintptr_t)value);
+            break;
+        case 'n':
+            break;
+        case 's':
+            snprintf(text, sizeof(text), spec,
+                     (UINT64_MAX == value) ? "(null)" : &record.mStrings[value]);
+            break;
+        default: {
+            double d;
+            memcpy(&d, &value, sizeof(d));
+            if ('L' == c.mLength) {
+                snprintf(text, sizeof(text), spec, (long double)d);
+            } else {
+                snprintf(text, sizeof(text), spec, d);
+            }
+            break;
+        }
+        }
+        out.append(text);
+    }
+}
+
 LogBuffer* LogBuffer::getInstance() {
     if (mInstance == nullptr) {
         lock_guard<mutex> guard(sLock);
@@ -54,9 +343,9 @@ LogBuffer* LogBuffer::getInstance() {
     return mInstance;
 }
 
-LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
+LogBuffer::LogBuffer(): mRings(nullptr),
         mConfigVec(TOTAL_LOG_LEVELS, ConfigsInLevel(TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC,
-                    MAXIMUM_NUM_IN_LIST, 0)) {
+                    MAXIMUM_NUM_IN_LIST)) {
     loc_param_s_type log_buff_config_table[] =
     {
         {"E_LEVEL_TIME_DEPTH",      &mConfigVec[0].mTimeDepthThres,  NULL, 'n'},
@@ -75,41 +364,151 @@ LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
     registerSignalHandler();
 }
 
-void LogBuffer::append(string& data, int level, uint64_t timestamp) {
-    lock_guard<mutex> guard(mLock);
-    pair<uint64_t, string> item(timestamp, data);
-    mLogList.append(item, level);
-    mConfigVec[level].mCurrentSize++;
+LogBufferRing& LogBuffer::getThreadRing() {
+    LogBufferRing* ring = sRingOwner.mRing;
+    if (nullptr == ring) {
+        // take over the ring of a thread that has exited, if any
+        for (ring = mRings.load(memory_order_acquire); nullptr != ring; ring = ring->mNext) {
+            bool owned = false;
+            if (!ring->mOwned.load(memory_order_relaxed) &&
+                ring->mOwned.compare_exchange_strong(owned, true)) {
+                break;
+            }
+        }
+        if (nullptr == ring) {
+            ring = new LogBufferRing();
+            ring->mNext = mRings.load(memory_order_relaxed);
+            while (!mRings.compare_exchange_weak(ring->mNext, ring, memory_order_release,
+                                                 memory_order_relaxed)) {}
+        }
+        ring->mTid = (int32_t)syscall(SYS_gettid);
+        sRingOwner.mRing = ring;
+    }
+    return *ring;
+}
 
-    while ((timestamp - mLogList.front(level).first) > mConfigVec[level].mTimeDepthThres ||
-            mConfigVec[level].mCurrentSize > mConfigVec[level].mMaxNumThres) {
-        mLogList.pop(level);
-        mConfigVec[level].mCurrentSize--;
+void LogBuffer::append(int level, const char* tag, const char* format, va_list args) {
+    if (level < 0 || level >= TOTAL_LOG_LEVELS) {
+        return;
     }
+    LogBufferRing& ring = getThreadRing();
+    LogBufferRecord& record = ring.begin();
+    record.mTimestampNs = getClockNs(CLOCK_BOOTTIME);
+    record.mTag = tag;
+    record.mFormat = format;
+    record.mLevel = level;
+    recordArgs(record, format, args);
+    ring.commit();
+}
+
+void LogBuffer::append(string& data, int level, uint64_t timestamp) {
+    if (level < 0 || level >= TOTAL_LOG_LEVELS) {
+        return;
+    }
+    LogBufferRing& ring = getThreadRing();
+    LogBufferRecord& record = ring.begin();
+    size_t len = min(data.size(), (size_t)LOG_BUFFER_MAX_STRINGS_LEN - 1);
+    record.mTimestampNs = timestamp;
+    record.mTag = nullptr;
+    record.mFormat = "%s";
+    record.mLevel = level;
+    memcpy(record.mStrings, data.c_str(), len);
+    record.mStrings[len] = '\0';
+    record.mStringsLen = len + 1;
+    record.mArgs[0] = 0;
+    record.mNumArgs = 1;
+    ring.commit();
+}
+
+string LogBuffer::format(const LogBufferRecord& record, int64_t realtimeOffsetNs) {
+    // same prefix as log lines used to be stored with
+    uint64_t realtimeUs = (record.mTimestampNs + realtimeOffsetNs) / 1000;
+    uint64_t sec = realtimeUs / 1000000;
+    char prefix[96];
+    snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%06d %d %d %s :",
+             (int)(sec / 3600 % 24), (int)(sec % 3600 / 60), (int)(sec % 60),
+             (int)(realtimeUs % 1000000), getpid(), record.mTid,
+             (nullptr == record.mTag) ? "" : record.mTag);
+    string text(prefix);
+    formatArgs(record, text);
+    return text;
 }
 
 //Dump the log buffer of specific level, level = -1 to dump all the levels in log buffer.
+//Records are only formatted here, after the per level time depth and capacity are
+//applied to those of all the thread rings, in time order.
 void LogBuffer::dump(std::function<void(stringstream&)> log, int level) {
     lock_guard<mutex> guard(mLock);
-    list<pair<pair<uint64_t, string>, int>> li;
-    if (-1 == level) {
-        li = mLogList.dump();
-    } else {
-        li = mLogList.dump(level);
+    vector<LogBufferRecord> records;
+    for (LogBufferRing* ring = mRings.load(memory_order_acquire); nullptr != ring;
+         ring = ring->mNext) {
+        uint64_t head = ring->mHead.load(memory_order_acquire);
+        uint64_t first = max(ring->mStart.load(memory_order_relaxed),
+                             (head > LOG_BUFFER_RING_SIZE) ? head - LOG_BUFFER_RING_SIZE : 0);
+        size_t copied = records.size();
+        records.resize(copied + (head - first));
+        for (uint64_t i = first; i < head; i++) {
+            memcpy(&records[copied + (i - first)], &ring->mRecords[i % LOG_BUFFER_RING_SIZE],
+                   sizeof(LogBufferRecord));
+        }
+        // drop those the thread has started overwriting meanwhile
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t begun = ring->mBegun.load(memory_order_relaxed);
+        if (begun > first + LOG_BUFFER_RING_SIZE) {
+            uint64_t overwritten = min(begun - LOG_BUFFER_RING_SIZE, head) - first;
+            records.erase(records.begin() + copied, records.begin() + copied + overwritten);
+        }
+    }
+
+    vector<uint32_t> order(records.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&records](uint32_t a, uint32_t b) {
+        return records[a].mTimestampNs < records[b].mTimestampNs;
+    });
+
+    // entries are the timestamp in seconds and the index of the record
+    vector<uint32_t> capacities;
+    for (auto& config : mConfigVec) {
+        capacities.push_back(config.mMaxNumThres);
     }
-    ALOGE("Begining of dump, buffer size: %d", (int)li.size());
+    LevelRing<pair<uint64_t, uint32_t>> logRing(capacities);
+    for (uint32_t index : order) {
+        int recordLevel = records[index].mLevel;
+        uint64_t timestamp = records[index].mTimestampNs / 1000000000ULL;
+        if (logRing.append(make_pair(timestamp, index), recordLevel)) {
+            while ((timestamp - logRing.front(recordLevel).first) >
+                   mConfigVec[recordLevel].mTimeDepthThres) {
+                logRing.pop(recordLevel);
+            }
+        }
+    }
+
+    uint32_t size = (-1 == level) ? logRing.size() : logRing.size(level);
+    int64_t realtimeOffsetNs = getClockNs(CLOCK_REALTIME) - getClockNs(CLOCK_BOOTTIME);
+    ALOGE("Begining of dump, buffer size: %d", (int)size);
     stringstream ln;
-    ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << li.size() << endl;
+    ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << size << endl;
     log(ln);
-    for_each (li.begin(), li.end(), [&, this](const pair<pair<uint64_t, string>, int> &item){
+    auto visit = [&, this](const pair<uint64_t, uint32_t>& item, int itemLevel) {
         stringstream line;
-        line << "["<<item.first.first << "] ";
-        line << "Level " << mLevelMap[item.second] << ": ";
-        line << item.first.second << endl;
+        line << "["<<item.first << "] ";
+        line << "Level " << mLevelMap[itemLevel] << ": ";
+        line << format(records[item.second], realtimeOffsetNs) << endl;
         if (log != nullptr) {
             log(line);
         }
-    });
+    };
+    if (-1 == level) {
+        // in the order the records were sorted in
+        logRing.dumpMerged([&records](const pair<uint64_t, uint32_t>& a,
+                                      const pair<uint64_t, uint32_t>& b) {
+            return records[a.second].mTimestampNs < records[b.second].mTimestampNs;
+        }, visit);
+    } else if (level >= 0 && level < TOTAL_LOG_LEVELS) {
+        logRing.dump(level, visit);
+    }
     ALOGE("End of dump");
 }
 
@@ -130,7 +529,11 @@ void LogBuffer::dumpToLogFile(string filePath) {
 }
 
 void LogBuffer::flush() {
-    mLogList.flush();
+    lock_guard<mutex> guard(mLock);
+    for (LogBufferRing* ring = mRings.load(memory_order_acquire); nullptr != ring;
+         ring = ring->mNext) {
+        ring->mStart.store(ring->mHead.load(memory_order_acquire), memory_order_relaxed);
+    }
 }
 
 void LogBuffer::registerSignalHandler() {
@@ -158,9 +561,7 @@ void LogBuffer::signalHandler(const int code, siginfo_t *const si, void *const s
     nptrs = backtrace(buffer, sizeof(buffer)/sizeof(*buffer));
     strings = backtrace_symbols(buffer, nptrs);
     if (strings != NULL) {
-        timespec tv;
-        clock_gettime(CLOCK_BOOTTIME, &tv);
-        uint64_t elapsedTime = (uint64_t)tv.tv_sec + (uint64_t)tv.tv_nsec/1000000000;
+        uint64_t elapsedTime = getClockNs(CLOCK_BOOTTIME);
         for (int i = 0; i < nptrs; i++) {
             string s(strings[i]);
             mInstance->append(s, 0, elapsedTime);
@@ -30,7 +30,7 @@
 #ifndef LOG_BUFFER_H
 #define LOG_BUFFER_H
 
-#include "SkipList.h"
+#include "LevelRing.h"
 #include "log_util.h"
 #include <loc_cfg.h>
 #include <loc_pla.h>
@@ -39,17 +39,27 @@
 #include <ostream>
 #include <fstream>
 #include <time.h>
+#include <stdarg.h>
 #include <mutex>
+#include <atomic>
 #include <signal.h>
 #include <thread>
 #include <functional>
 
+using namespace std;
+
 //default error level time depth threshold,
 #define TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC 60
 //default maximum log buffer size
 #define MAXIMUM_NUM_IN_LIST 50
 //file path of dumped log buffer
 #define LOG_BUFFER_FILE_PATH "/data/vendor/location/"
+//number of records in the ring of each logging thread
+#define LOG_BUFFER_RING_SIZE 512
+//maximum number of args kept per record, the rest are dropped
+#define LOG_BUFFER_MAX_ARGS 12
+//bytes per record for copies of the strings passed as %s args
+#define LOG_BUFFER_MAX_STRINGS_LEN 128
 
 namespace loc_util {
 
@@ -57,12 +67,35 @@ class ConfigsInLevel{
 public:
     uint32_t mTimeDepthThres;
     uint32_t mMaxNumThres;
-    int mCurrentSize;
 
-    ConfigsInLevel(uint32_t time, int num, int size):
-        mTimeDepthThres(time), mMaxNumThres(num), mCurrentSize(size) {}
+    ConfigsInLevel(uint32_t time, int num):
+        mTimeDepthThres(time), mMaxNumThres(num) {}
+};
+
+// One LOC_LOG* call, kept in binary form: the format and tag pointers,
+// which must be string literals, and the raw args. It is only turned
+// into text when the buffer is dumped.
+struct LogBufferRecord {
+    uint64_t mArgs[LOG_BUFFER_MAX_ARGS];
+    // CLOCK_BOOTTIME
+    uint64_t mTimestampNs;
+    const char* mTag;
+    const char* mFormat;
+    int32_t mTid;
+    uint8_t mLevel;
+    // args in mArgs; a conversion of mFormat beyond them prints as is
+    uint8_t mNumArgs;
+    uint16_t mStringsLen;
+    // %s args, NUL terminated, mArgs has their offsets
+    char mStrings[LOG_BUFFER_MAX_STRINGS_LEN];
 };
 
+class LogBufferRing;
+
+// Each thread logs into a ring of its own, lock free and without heap
+// allocation. Only dump() and flush() take mLock. The per level time
+// depth and capacity are applied to the records of all the rings when
+// they are dumped.
 class LogBuffer {
 private:
     static LogBuffer* mInstance;
@@ -70,14 +103,22 @@ private:
     static struct sigaction mNewSigAction;
     static mutex sLock;
 
-    SkipList<pair<uint64_t, string>> mLogList;
+    // rings of all threads that have logged, never freed
+    atomic<LogBufferRing*> mRings;
     vector<ConfigsInLevel> mConfigVec;
     mutex mLock;
 
     const vector<string> mLevelMap {"E", "W", "I", "D", "V"};
 
+    LogBufferRing& getThreadRing();
+    string format(const LogBufferRecord& record, int64_t realtimeOffsetNs);
+
 public:
     static LogBuffer* getInstance();
+    // format must be a string literal, args are formatted at dump time
+    void append(int level, const char* tag, const char* format, va_list args);
+    // data is copied, up to LOG_BUFFER_MAX_STRINGS_LEN bytes. timestamp is
+    // in ns of CLOCK_BOOTTIME.
     void append(string& data, int level, uint64_t timestamp);
     void dump(std::function<void(stringstream&)> log, int level = -1);
     void dumpToAdbLogcat();
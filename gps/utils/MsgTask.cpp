@@ -30,18 +30,96 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <time.h>
+#include <atomic>
 #include <MsgTask.h>
-#include <msg_q.h>
+#include <LocMsgQueue.h>
 #include <log_util.h>
 #include <loc_log.h>
 #include <loc_pla.h>
+#include <LocMsgPool.h>
+#ifdef __LOC_UNIT_TEST__
+#include <sched.h>
+#include <gps_extended_c.h>
+#endif
+
+// max number of msgs moved from the queue into the priority lanes
+// per dispatch
+#define LOC_MSG_INTAKE_BATCH 32
 
 namespace loc_util {
 
+static inline uint64_t getMonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void LocMsg::setDeadline(uint32_t deadlineMs, bool dropIfLate) {
+    mDeadlineNs = getMonotonicNs() + (uint64_t)deadlineMs * 1000000ULL;
+    mDropIfLate = dropIfLate;
+}
+
+// MTRunnable takes msgs off the queue in arrival order and stages them in
+// per LocMsgPriority lanes, which are intrusive lists only ever touched by
+// the MsgTask thread. Each run() dispatches one msg from the highest lane
+// that is not empty, unless a lower lane has been passed over
+// LOC_MSG_STARVATION_LIMIT times, in which case that lane goes first.
+// While an in-order msg is staged, msgs are instead dispatched in the
+// order they were staged, i.e. by arrival, until it has been run.
+//
+// A msg with a coalesce key is not queued itself. It is parked in the slot
+// for its key, and a small trigger msg is queued only if the slot was
+// empty. A msg arriving while the slot is still occupied replaces the one
+// parked there, so the queue holds at most one trigger per key, and the
+// trigger runs whichever msg is in the slot when it gets its turn.
 class MTRunnable : public LocRunnable {
-    const void* mQ;
+    struct Lane {
+        LocMsg* mHead;
+        LocMsg* mTail;
+        // number of dispatches from other lanes while this one waited
+        uint32_t mSkipped;
+    };
+    struct CoalesceSlot {
+        std::atomic<const void*> mKey;
+        std::atomic<LocMsg*> mPending;
+    };
+    struct CoalesceTrigger : public LocPooledMsg<CoalesceTrigger> {
+        CoalesceSlot& mSlot;
+        inline CoalesceTrigger(CoalesceSlot& slot, LocMsgPriority priority) :
+                LocPooledMsg(), mSlot(slot) {
+            setPriority(priority);
+        }
+        inline virtual void proc() const override {
+            LocMsg* msg = mSlot.mPending.exchange(nullptr, std::memory_order_acq_rel);
+            if (nullptr != msg) {
+                msg->log();
+                msg->proc();
+                delete msg;
+            }
+        }
+    };
+    LocMsgQueue* mQ;
+    Lane mLanes[LOC_MSG_PRIORITY_MAX];
+    uint32_t mNumStaged;
+    // number of staged in-order msgs
+    uint32_t mNumInOrder;
+    // arrival sequence of the next msg staged
+    uint64_t mNextSeq;
+    CoalesceSlot mCoalesceSlots[LOC_MSG_MAX_COALESCE_KEYS];
+    std::atomic<uint64_t> mDispatched[LOC_MSG_PRIORITY_MAX];
+    std::atomic<uint64_t> mLate[LOC_MSG_PRIORITY_MAX];
+    std::atomic<uint64_t> mDropped[LOC_MSG_PRIORITY_MAX];
+    std::atomic<uint64_t> mCoalesced[LOC_MSG_PRIORITY_MAX];
+    // run once nothing is left to dispatch, only touched by the MsgTask thread
+    std::vector<std::function<void()>> mIdleFuncs;
+
+    void stage(LocMsg* msg);
+    void runIdleFuncs();
+    LocMsg* unstage();
+    CoalesceSlot* getCoalesceSlot(const void* key);
 public:
-    inline MTRunnable(const void* q) : mQ(q) {}
+    MTRunnable(LocMsgQueue* q);
     virtual ~MTRunnable();
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
@@ -54,20 +132,33 @@ public:
 
     // to interrupt the run() method and come out of that
     virtual void interrupt() override;
+
+    void getCounters(LocMsgTaskCounters& counters) const;
+
+    // returns false if msg could not be coalesced and needs queueing as usual
+    bool sendCoalesced(LocMsg* msg);
+
+    inline void addIdleFunc(const std::function<void()>& func) { mIdleFuncs.push_back(func); }
+    // MTRunnable of the MsgTask thread the caller is on, if any
+    static thread_local MTRunnable* sCurrent;
 };
 
-static void LocMsgDestroy(void* msg) {
-    delete (LocMsg*)msg;
-}
+thread_local MTRunnable* MTRunnable::sCurrent = nullptr;
 
 MsgTask::MsgTask(const char* threadName) :
-    mQ(msg_q_init2()), mThread() {
-    mThread.start(threadName, std::make_shared<MTRunnable>(mQ));
+    mQ(LocMsgQueue::create()), mRunnable(std::make_shared<MTRunnable>(mQ)),
+    mThread() {
+    mThread.start(threadName, mRunnable);
 }
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
-    if (msg && this) {
-        msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+    if (msg && this && mQ) {
+        if (nullptr != msg->mCoalesceKey && mRunnable->sendCoalesced((LocMsg*)msg)) {
+            return;
+        }
+        if (!mQ->send((LocMsg*)msg)) {
+            delete msg;
+        }
     } else {
         LOC_LOGE("%s: msg is %p and this is %p",
                  __func__, msg, this);
@@ -85,36 +176,332 @@ void MsgTask::sendMsg(const std::function<void()> runnable) const {
     sendMsg(new RunMsg(runnable));
 }
 
+bool MsgTask::runWhenIdle(const std::function<void()>& func) {
+    MTRunnable* runnable = MTRunnable::sCurrent;
+    if (nullptr == runnable) {
+        return false;
+    }
+    runnable->addIdleFunc(func);
+    return true;
+}
+
+void MsgTask::getCounters(LocMsgTaskCounters& counters) const {
+    memset(&counters, 0, sizeof(counters));
+    if (nullptr != mRunnable) {
+        mRunnable->getCounters(counters);
+    }
+}
+
+MTRunnable::MTRunnable(LocMsgQueue* q) : mQ(q), mNumStaged(0), mNumInOrder(0), mNextSeq(0) {
+    for (int i = 0; i < LOC_MSG_PRIORITY_MAX; i++) {
+        mLanes[i] = {nullptr, nullptr, 0};
+        mDispatched[i].store(0, std::memory_order_relaxed);
+        mLate[i].store(0, std::memory_order_relaxed);
+        mDropped[i].store(0, std::memory_order_relaxed);
+        mCoalesced[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < LOC_MSG_MAX_COALESCE_KEYS; i++) {
+        mCoalesceSlots[i].mKey.store(nullptr, std::memory_order_relaxed);
+        mCoalesceSlots[i].mPending.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+MTRunnable::CoalesceSlot* MTRunnable::getCoalesceSlot(const void* key) {
+    for (int i = 0; i < LOC_MSG_MAX_COALESCE_KEYS; i++) {
+        CoalesceSlot& slot = mCoalesceSlots[i];
+        const void* slotKey = slot.mKey.load(std::memory_order_acquire);
+        // claim a free slot, if another sender got there first slotKey is
+        // updated to its key
+        if (nullptr == slotKey &&
+                slot.mKey.compare_exchange_strong(slotKey, key, std::memory_order_acq_rel)) {
+            return &slot;
+        }
+        if (slotKey == key) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+bool MTRunnable::sendCoalesced(LocMsg* msg) {
+    CoalesceSlot* slot = getCoalesceSlot(msg->mCoalesceKey);
+    if (nullptr == slot) {
+        LOC_LOGw("out of coalesce slots, queueing msg %p as is", msg);
+        return false;
+    }
+
+    LocMsgPriority priority = msg->mPriority;
+    LocMsg* replaced = slot->mPending.exchange(msg, std::memory_order_acq_rel);
+    if (nullptr != replaced) {
+        // the trigger queued for replaced will run msg instead
+        mCoalesced[priority].fetch_add(1, std::memory_order_relaxed);
+        delete replaced;
+    } else {
+        CoalesceTrigger* trigger = new CoalesceTrigger(*slot, priority);
+        if (!mQ->send(trigger)) {
+            delete trigger;
+            delete slot->mPending.exchange(nullptr, std::memory_order_acq_rel);
+        }
+    }
+    return true;
+}
+
+void MTRunnable::stage(LocMsg* msg) {
+    if (msg->mPriority < LOC_MSG_PRIORITY_REALTIME || msg->mPriority >= LOC_MSG_PRIORITY_MAX) {
+        msg->mPriority = LOC_MSG_PRIORITY_CONTROL;
+    }
+    Lane& lane = mLanes[msg->mPriority];
+    msg->mNextInLane = nullptr;
+    if (nullptr == lane.mTail) {
+        lane.mHead = msg;
+    } else {
+        lane.mTail->mNextInLane = msg;
+    }
+    lane.mTail = msg;
+    msg->mSeq = mNextSeq++;
+    if (msg->mInOrder) {
+        mNumInOrder++;
+    }
+    mNumStaged++;
+}
+
+LocMsg* MTRunnable::unstage() {
+    int pick = -1;
+    for (int i = 0; i < LOC_MSG_PRIORITY_MAX; i++) {
+        if (nullptr == mLanes[i].mHead) {
+            continue;
+        }
+        if (mNumInOrder > 0) {
+            // oldest head first, nothing overtakes the in-order msg
+            if (pick < 0 || mLanes[i].mHead->mSeq < mLanes[pick].mHead->mSeq) {
+                pick = i;
+            }
+        } else if (pick < 0 || mLanes[i].mSkipped >= LOC_MSG_STARVATION_LIMIT) {
+            pick = i;
+        }
+    }
+    if (pick < 0) {
+        return nullptr;
+    }
+    for (int i = 0; i < LOC_MSG_PRIORITY_MAX; i++) {
+        if (i == pick) {
+            mLanes[i].mSkipped = 0;
+        } else if (nullptr != mLanes[i].mHead) {
+            mLanes[i].mSkipped++;
+        }
+    }
+
+    Lane& lane = mLanes[pick];
+    LocMsg* msg = lane.mHead;
+    lane.mHead = msg->mNextInLane;
+    if (nullptr == lane.mHead) {
+        lane.mTail = nullptr;
+    }
+    msg->mNextInLane = nullptr;
+    if (msg->mInOrder) {
+        mNumInOrder--;
+    }
+    mNumStaged--;
+    return msg;
+}
+
+void MTRunnable::getCounters(LocMsgTaskCounters& counters) const {
+    for (int i = 0; i < LOC_MSG_PRIORITY_MAX; i++) {
+        counters.mDispatched[i] = mDispatched[i].load(std::memory_order_relaxed);
+        counters.mLate[i] = mLate[i].load(std::memory_order_relaxed);
+        counters.mDropped[i] = mDropped[i].load(std::memory_order_relaxed);
+        counters.mCoalesced[i] = mCoalesced[i].load(std::memory_order_relaxed);
+    }
+}
+
 void MTRunnable::interrupt() {
-    msg_q_unblock((void*)mQ);
+    if (mQ) {
+        mQ->unblock();
+    }
 }
 
 void MTRunnable::prerun() {
+    sCurrent = this;
     // make sure we do not run in background scheduling group
      set_sched_policy(gettid(), SP_FOREGROUND);
 }
 
+void MTRunnable::runIdleFuncs() {
+    // funcs may add more funcs, which wait for the next idle point
+    std::vector<std::function<void()>> funcs;
+    funcs.swap(mIdleFuncs);
+    for (auto& func : funcs) {
+        func();
+    }
+}
+
 bool MTRunnable::run() {
     LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
-    if (eMSG_Q_SUCCESS != result) {
-        LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
-                 loc_get_msg_q_status(result));
-        return false;
+    if (0 == mNumStaged) {
+        msg = mQ ? mQ->receive() : NULL;
+        if (NULL == msg) {
+            return false;
+        }
+        stage(msg);
+    }
+    // pull in whatever else is already queued, so that a msg of a higher
+    // priority can overtake those ahead of it
+    for (int i = 0; i < LOC_MSG_INTAKE_BATCH && NULL != (msg = mQ->tryReceive()); i++) {
+        stage(msg);
     }
 
-    msg->log();
-    // there is where each individual msg handling is invoked
-    msg->proc();
+    msg = unstage();
+    LocMsgPriority priority = msg->mPriority;
+    bool late = (0 != msg->mDeadlineNs && getMonotonicNs() > msg->mDeadlineNs);
+    if (late && msg->mDropIfLate) {
+        mDropped[priority].fetch_add(1, std::memory_order_relaxed);
+        LOC_LOGv("drop late msg %p, priority %d", msg, priority);
+    } else {
+        if (late) {
+            mLate[priority].fetch_add(1, std::memory_order_relaxed);
+        }
+        msg->log();
+        // there is where each individual msg handling is invoked
+        msg->proc();
+        mDispatched[priority].fetch_add(1, std::memory_order_relaxed);
+    }
 
     delete msg;
 
+    if (!mIdleFuncs.empty() && 0 == mNumStaged) {
+        if (NULL != (msg = mQ->tryReceive())) {
+            stage(msg);
+        } else {
+            runIdleFuncs();
+        }
+    }
+
     return true;
 }
 
 MTRunnable::~MTRunnable() {
-    msg_q_flush((void*)mQ);
-    msg_q_destroy((void**)&mQ);
+    LocMsg* msg;
+    while (NULL != (msg = unstage())) {
+        delete msg;
+    }
+    delete mQ;
+    for (int i = 0; i < LOC_MSG_MAX_COALESCE_KEYS; i++) {
+        delete mCoalesceSlots[i].mPending.exchange(nullptr, std::memory_order_relaxed);
+    }
+}
+
+#ifdef __LOC_UNIT_TEST__
+uint64_t locMsgPoolCountSteadyStateAllocs(uint32_t numFixes, uint64_t (*allocCount)()) {
+    struct MsgSyntheticFix : public LocPooledMsg<MsgSyntheticFix> {
+        UlpLocation mUlpLocation;
+        GpsLocationExtended mLocationExtended;
+        std::atomic<uint32_t>& mProcessed;
+        inline MsgSyntheticFix(uint32_t fixNum, std::atomic<uint32_t>& processed) :
+                LocPooledMsg(), mProcessed(processed) {
+            memset(&mUlpLocation, 0, sizeof(mUlpLocation));
+            memset(&mLocationExtended, 0, sizeof(mLocationExtended));
+            mUlpLocation.gpsLocation.timestamp = fixNum;
+            setPriority(LOC_MSG_PRIORITY_REALTIME);
+        }
+        inline virtual void proc() const override {
+            mProcessed.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    LocMsgPool<MsgSyntheticFix>& pool = LocMsgPool<MsgSyntheticFix>::getInstance();
+    std::atomic<uint32_t> processed(0);
+    // on the queue backend gps.conf selects, as every MsgTask
+    MsgTask msgTask("LocMsgPoolTest");
+    // fill the free list up to LOC_MSG_POOL_MAX_FREE blocks, as many as
+    // are ever live below, so that every fix is served from recycled
+    // blocks however far the MsgTask thread lags. Warming up only by
+    // sending would leave the free list as deep as the longest lag seen.
+    MsgSyntheticFix* prefill[LOC_MSG_POOL_MAX_FREE];
+    for (MsgSyntheticFix*& fix : prefill) {
+        fix = new MsgSyntheticFix(0, processed);
+    }
+    for (MsgSyntheticFix* fix : prefill) {
+        delete fix;
+    }
+    // then warm up the queue
+    const uint32_t numWarmUp = 2 * LOC_MSG_POOL_MAX_FREE;
+    uint64_t startAllocs = 0;
+
+    for (uint32_t i = 0; i < numWarmUp + numFixes; i++) {
+        // like a fix source at a fixed rate, keep the number of msgs in
+        // flight (queued, or run but not yet freed) within what the pool
+        // keeps for reuse
+        while (i - processed.load(std::memory_order_acquire) > LOC_MSG_POOL_MAX_FREE - 2) {
+            sched_yield();
+        }
+        if (numWarmUp == i) {
+            startAllocs = (nullptr != allocCount) ? allocCount() : pool.getHeapAllocs();
+        }
+        msgTask.sendMsg(new MsgSyntheticFix(i, processed));
+    }
+    while (processed.load(std::memory_order_acquire) < numWarmUp + numFixes) {
+        sched_yield();
+    }
+    return ((nullptr != allocCount) ? allocCount() : pool.getHeapAllocs()) - startAllocs;
+}
+
+uint32_t locMsgTaskCheckInOrder(uint32_t rounds) {
+    struct MsgOrder : public LocMsg {
+        const uint32_t mIndex;
+        std::vector<uint32_t>& mRun;
+        inline MsgOrder(uint32_t index, std::vector<uint32_t>& run, LocMsgPriority priority,
+                        bool inOrder) : LocMsg(), mIndex(index), mRun(run) {
+            setPriority(priority);
+            if (inOrder) {
+                setInOrder();
+            }
+        }
+        inline virtual void proc() const override { mRun.push_back(mIndex); }
+    };
+    // sent in this order, the in-order msg in the middle
+    static const LocMsgPriority priorities[] = {
+        LOC_MSG_PRIORITY_CONTROL, LOC_MSG_PRIORITY_BULK, LOC_MSG_PRIORITY_CONTROL,
+        LOC_MSG_PRIORITY_CONTROL, LOC_MSG_PRIORITY_REALTIME, LOC_MSG_PRIORITY_BULK
+    };
+    const uint32_t numMsgs = sizeof(priorities) / sizeof(priorities[0]);
+    const uint32_t inOrderIndex = 3;
+
+    MsgTask msgTask("LocMsgOrderTest");
+    uint32_t errors = 0;
+    for (uint32_t r = 0; r < rounds; r++) {
+        std::vector<uint32_t> run;
+        std::atomic<bool> blocked(true);
+        std::atomic<bool> done(false);
+        // hold the MsgTask thread so that all msgs are staged together
+        msgTask.sendMsg([&blocked] () {
+            while (blocked.load(std::memory_order_acquire)) {
+                sched_yield();
+            }
+        });
+        for (uint32_t i = 0; i < numMsgs; i++) {
+            msgTask.sendMsg(new MsgOrder(i, run, priorities[i], i == inOrderIndex));
+        }
+        msgTask.sendMsg([&done] () { done.store(true, std::memory_order_release); });
+        blocked.store(false, std::memory_order_release);
+        while (!done.load(std::memory_order_acquire)) {
+            sched_yield();
+        }
+
+        if (run.size() != numMsgs) {
+            errors++;
+            continue;
+        }
+        // every msg sent before the in-order one runs before it, every msg
+        // sent after it runs after it
+        for (uint32_t pos = 0; pos < numMsgs; pos++) {
+            if ((pos < inOrderIndex) != (run[pos] < inOrderIndex) ||
+                    (pos == inOrderIndex) != (run[pos] == inOrderIndex)) {
+                errors++;
+            }
+        }
+    }
+    return errors;
 }
+#endif
 
 } // namespace loc_util
@@ -29,28 +29,113 @@
 #ifndef __MSG_TASK__
 #define __MSG_TASK__
 
+#include <stdint.h>
 #include <functional>
+#include <memory>
+#include <vector>
 #include <LocThread.h>
+#include <LocMsgQueue.h>
 
 namespace loc_util {
 
+// Dispatch classes of a LocMsg. MsgTask always runs the highest class
+// that has msgs pending, but lower classes are guaranteed a turn every
+// LOC_MSG_STARVATION_LIMIT dispatches. Msgs of the same class stay FIFO,
+// and an in-order msg, see LocMsg::setInOrder(), is never overtaken.
+typedef enum {
+    // fix delivery, e.g. position reports
+    LOC_MSG_PRIORITY_REALTIME = 0,
+    // commands, config, responses; the default
+    LOC_MSG_PRIORITY_CONTROL,
+    // high rate telemetry, e.g. SV, measurements, NMEA, data
+    LOC_MSG_PRIORITY_BULK,
+    LOC_MSG_PRIORITY_MAX
+} LocMsgPriority;
+
+#define LOC_MSG_STARVATION_LIMIT 8
+
 struct LocMsg {
-    inline LocMsg() {}
+    LocMsgPriority mPriority;
+    // CLOCK_MONOTONIC ns by which proc() should run; 0 if none
+    uint64_t mDeadlineNs;
+    // if late, drop instead of running proc()
+    bool mDropIfLate;
+    // msgs with the same non null key replace each other while waiting to
+    // be run, so that only the latest one is run; see locMsgTypeKey()
+    const void* mCoalesceKey;
+    // run in enqueue order with msgs of all priorities
+    bool mInOrder;
+    // used by MsgTask to link msgs waiting in a priority lane, and to
+    // order them by arrival
+    LocMsg* mNextInLane;
+    uint64_t mSeq;
+
+    inline LocMsg() : mPriority(LOC_MSG_PRIORITY_CONTROL), mDeadlineNs(0),
+            mDropIfLate(false), mCoalesceKey(nullptr), mInOrder(false),
+            mNextInLane(nullptr), mSeq(0) {}
     inline virtual ~LocMsg() {}
     virtual void proc() const = 0;
     inline virtual void log() const {}
+
+    inline void setPriority(LocMsgPriority priority) { mPriority = priority; }
+    // sets deadline to deadlineMs from now
+    void setDeadline(uint32_t deadlineMs, bool dropIfLate = false);
+    inline void setCoalesceKey(const void* key) { mCoalesceKey = key; }
+    // for msgs that depend on those sent before them, e.g. starting a
+    // session for a client just added: runs after every msg queued ahead
+    // of it and before every msg queued after it, whatever their priority
+    inline void setInOrder() { mInOrder = true; }
+};
+
+// a distinct LocMsg coalesce key per type T
+template <typename T>
+inline const void* locMsgTypeKey() {
+    static const char sKey = 0;
+    return &sKey;
+}
+
+// max number of distinct coalesce keys a MsgTask tracks, msgs of any
+// further keys are queued as usual
+#define LOC_MSG_MAX_COALESCE_KEYS 8
+
+// dispatch counters of a MsgTask, per LocMsgPriority
+struct LocMsgTaskCounters {
+    // msgs whose proc() was run
+    uint64_t mDispatched[LOC_MSG_PRIORITY_MAX];
+    // msgs run past their deadline
+    uint64_t mLate[LOC_MSG_PRIORITY_MAX];
+    // msgs dropped for being past their deadline
+    uint64_t mDropped[LOC_MSG_PRIORITY_MAX];
+    // msgs replaced by a later msg of the same coalesce key before running
+    uint64_t mCoalesced[LOC_MSG_PRIORITY_MAX];
 };
 
+class MTRunnable;
+
 class MsgTask {
-    const void* mQ;
+    LocMsgQueue* mQ;
+    std::shared_ptr<MTRunnable> mRunnable;
     LocThread mThread;
 public:
     ~MsgTask() = default;
     MsgTask(const char* threadName = NULL);
     void sendMsg(const LocMsg* msg) const;
     void sendMsg(const std::function<void()> runnable) const;
+    void getCounters(LocMsgTaskCounters& counters) const;
+    // Runs func on the calling MsgTask thread once it has no more msgs to
+    // run, i.e. at the end of the burst of msgs it is working through, so
+    // that output produced by several msgs can be handed on in one go.
+    // Returns false, and func is not run, if not called on a MsgTask thread.
+    static bool runWhenIdle(const std::function<void()>& func);
 };
 
+#ifdef __LOC_UNIT_TEST__
+// per round, queues control msgs, an in-order control msg and realtime
+// msgs behind a blocked MsgTask; returns the number of msgs run out of
+// order around the in-order one, 0 on success
+uint32_t locMsgTaskCheckInOrder(uint32_t rounds);
+#endif
+
 } //
 
 #endif //__MSG_TASK__
@@ -39,6 +39,14 @@
 #include <time.h>
 #include <grp.h>
 #include <errno.h>
+#include <limits.h>
+#include <sys/inotify.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include <loc_cfg.h>
 #include <loc_pla.h>
 #include <loc_target.h>
@@ -47,6 +55,7 @@
 #include <glib.h>
 #endif
 #include "log_util.h"
+#include "LocThread.h"
 
 /*=============================================================================
  *
@@ -218,6 +227,46 @@ int loc_set_config_entry(const loc_param_s_type* config_entry,
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_parse_conf_value
+
+DESCRIPTION
+   Trims the name and value of a configuration item split off a line, and
+   parses the value as a hex or decimal number.
+
+PARAMETERS:
+   config_value: item with param_name and param_str_value set
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   None
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static void loc_parse_conf_value(loc_param_v_type* config_value)
+{
+    /* Trim leading and trailing spaces */
+    loc_util_trim_space(config_value->param_name);
+    loc_util_trim_space(config_value->param_str_value);
+
+    /* Parse numerical value */
+    if ((strlen(config_value->param_str_value) >=3) &&
+        (config_value->param_str_value[0] == '0') &&
+        (tolower(config_value->param_str_value[1]) == 'x'))
+    {
+        /* hex */
+        config_value->param_int_value = (int) strtol(&config_value->param_str_value[2],
+                                                     (char**) NULL, 16);
+    }
+    else {
+        config_value->param_double_value = (double) atof(config_value->param_str_value); /* float */
+        config_value->param_int_value = atoi(config_value->param_str_value); /* dec */
+    }
+}
+
 /*===========================================================================
 FUNCTION loc_fill_conf_item
 
@@ -259,23 +308,7 @@ int loc_fill_conf_item(char* input_buf,
 
             /* skip lines that do not contain two operands */
             if (config_value.param_str_value) {
-                /* Trim leading and trailing spaces */
-                loc_util_trim_space(config_value.param_name);
-                loc_util_trim_space(config_value.param_str_value);
-
-                /* Parse numerical value */
-                if ((strlen(config_value.param_str_value) >=3) &&
-                    (config_value.param_str_value[0] == '0') &&
-                    (tolower(config_value.param_str_value[1]) == 'x'))
-                {
-                    /* hex */
-                    config_value.param_int_value = (int) strtol(&config_value.param_str_value[2],
-                                                                (char**) NULL, 16);
-                }
-                else {
-                    config_value.param_double_value = (double) atof(config_value.param_str_value); /* float */
-                    config_value.param_int_value = atoi(config_value.param_str_value); /* dec */
-                }
+                loc_parse_conf_value(&config_value);
 
                 for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
                 {
@@ -418,6 +451,228 @@ int loc_update_conf_long(const char* conf_data, int32_t length,
     return ret;
 }
 
+/*=============================================================================
+ *
+ *   Parsed configuration file cache
+ *
+ *============================================================================*/
+using std::string;
+using std::vector;
+using std::unordered_map;
+using std::shared_ptr;
+using loc_util::LocThread;
+using loc_util::LocRunnable;
+
+/* Immutable parsed copy of one configuration file. Items are indexed by name,
+   so filling a table is one hash lookup per table entry instead of a scan of
+   the whole file per table entry. A name set more than once in the file takes
+   the value of its first line, later ones are ignored. */
+class LocConfSnapshot {
+    struct Item {
+        string mName;
+        string mStrValue;
+        int mIntValue;
+        double mDoubleValue;
+    };
+    bool mValid;
+    vector<Item> mItems;
+    unordered_map<string, uint32_t> mIndex;
+public:
+    LocConfSnapshot(const char* conf_file_name) : mValid(false) {
+        FILE* conf_fp = fopen(conf_file_name, "r");
+        if (NULL == conf_fp) {
+            return;
+        }
+        mValid = true;
+        char input_buf[LOC_MAX_PARAM_LINE];
+        while (fgets(input_buf, sizeof(input_buf), conf_fp)) {
+            char *lasts;
+            loc_param_v_type config_value;
+            memset(&config_value, 0, sizeof(config_value));
+
+            config_value.param_name = strtok_r(input_buf, "=", &lasts);
+            if (NULL == config_value.param_name) {
+                continue;
+            }
+            config_value.param_str_value = strtok_r(NULL, "\0", &lasts);
+            if (NULL == config_value.param_str_value) {
+                continue;
+            }
+            loc_parse_conf_value(&config_value);
+            Item item = {config_value.param_name, config_value.param_str_value,
+                         config_value.param_int_value, config_value.param_double_value};
+            // a repeated name keeps its first value
+            if (mIndex.emplace(item.mName, mItems.size()).second) {
+                mItems.push_back(std::move(item));
+            }
+        }
+        fclose(conf_fp);
+    }
+
+    // false if the file could not be opened
+    inline bool isValid() const { return mValid; }
+
+    void fillTable(const loc_param_s_type* config_table, uint32_t table_length,
+                   uint16_t string_len) const {
+        for (uint32_t i = 0; i < table_length; i++) {
+            /* Clear validity bit */
+            if (NULL != config_table[i].param_set) {
+                *(config_table[i].param_set) = 0;
+            }
+            auto it = mIndex.find(config_table[i].param_name);
+            if (mIndex.end() != it) {
+                const Item& item = mItems[it->second];
+                loc_param_v_type config_value;
+                config_value.param_name = (char*)item.mName.c_str();
+                config_value.param_str_value = (char*)item.mStrValue.c_str();
+                config_value.param_int_value = item.mIntValue;
+                config_value.param_double_value = item.mDoubleValue;
+                loc_set_config_entry(&config_table[i], &config_value, string_len);
+            }
+        }
+    }
+};
+
+/* Process wide list of the configuration files read so far, each holding the
+   latest snapshot of its file. Files are only ever added, so readers walk the
+   list without a lock. The snapshot is replaced RCU style: the watcher thread
+   publishes a new one when inotify reports the file was rewritten, and readers
+   still holding the old one keep using it until they drop it. */
+class LocConfFile {
+    const string mPath;
+    // mPath with its directory resolved, as inotify events are matched
+    const string mWatchPath;
+    shared_ptr<const LocConfSnapshot> mSnapshot;
+    LocConfFile* const mNext;
+
+    static std::atomic<LocConfFile*> sFiles;
+    // serializes adding files and watches, never taken by readers of cached files
+    static std::mutex sAddLock;
+    static int sInotifyFd;
+    static unordered_map<int, string> sWatchDirs;
+
+    inline LocConfFile(const char* path, LocConfFile* next) :
+        mPath(path), mWatchPath(resolve(mPath, nullptr)),
+        mSnapshot(std::make_shared<const LocConfSnapshot>(path)), mNext(next) {}
+
+    // returns path with its directory made absolute and free of "." and ".."
+    // and symlinks, so that "gps.conf" and "./gps.conf" resolve alike; the
+    // file itself may not exist. Sets dir, if not null, to that directory.
+    static string resolve(const string& path, string* dir) {
+        size_t pos = path.rfind('/');
+        string dirName = (string::npos == pos) ? "." : path.substr(0, (0 == pos) ? 1 : pos);
+        string fileName = (string::npos == pos) ? path : path.substr(pos + 1);
+        char resolved[PATH_MAX];
+        if (NULL != realpath(dirName.c_str(), resolved)) {
+            dirName = resolved;
+        }
+        if (nullptr != dir) {
+            *dir = dirName;
+        }
+        return ('/' == dirName.back()) ? dirName + fileName : dirName + "/" + fileName;
+    }
+
+    static LocConfFile* find(const char* path, LocConfFile* head) {
+        for (LocConfFile* file = head; nullptr != file; file = file->mNext) {
+            if (file->mPath == path) {
+                return file;
+            }
+        }
+        return nullptr;
+    }
+
+    class Watcher : public LocRunnable {
+    public:
+        virtual bool run() override {
+            char buf[sizeof(struct inotify_event) + NAME_MAX + 1]
+                    __attribute__((aligned(__alignof__(struct inotify_event))));
+            ssize_t len = read(sInotifyFd, buf, sizeof(buf));
+            if (len <= 0) {
+                return (len < 0 && EINTR == errno);
+            }
+            for (char* p = buf; p < buf + len;
+                 p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+                struct inotify_event* event = (struct inotify_event*)p;
+                if (0 == event->len) {
+                    continue;
+                }
+                string path;
+                {
+                    std::lock_guard<std::mutex> guard(sAddLock);
+                    auto it = sWatchDirs.find(event->wd);
+                    if (sWatchDirs.end() == it) {
+                        continue;
+                    }
+                    path = ('/' == it->second.back()) ? it->second + event->name :
+                                                          it->second + "/" + event->name;
+                }
+                // the same file may have been read under several names
+                for (LocConfFile* file = sFiles.load(std::memory_order_acquire);
+                     nullptr != file; file = file->mNext) {
+                    if (file->mWatchPath == path) {
+                        LOC_LOGi("%s changed, reloading", file->mPath.c_str());
+                        std::atomic_store(&file->mSnapshot,
+                                shared_ptr<const LocConfSnapshot>(
+                                        std::make_shared<const LocConfSnapshot>(
+                                                file->mPath.c_str())));
+                    }
+                }
+            }
+            return true;
+        }
+        virtual void interrupt() override {}
+    };
+
+    // sAddLock must be held
+    static void watch(const string& path) {
+        if (sInotifyFd < 0) {
+            sInotifyFd = inotify_init1(IN_CLOEXEC);
+            if (sInotifyFd < 0) {
+                LOC_LOGw("inotify_init1 failed, errno %d, no config reload", errno);
+                return;
+            }
+            LocThread* thread = new LocThread();
+            if (!thread->start("LocConfWatcher", std::make_shared<Watcher>())) {
+                LOC_LOGw("failed to start config watcher, no config reload");
+            }
+        }
+        string dir;
+        resolve(path, &dir);
+        // the file itself may not exist yet, or be replaced by a rename
+        int wd = inotify_add_watch(sInotifyFd, dir.c_str(),
+                                   IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+        if (wd < 0) {
+            LOC_LOGd("inotify_add_watch %s failed, errno %d", dir.c_str(), errno);
+        } else {
+            sWatchDirs[wd] = dir;
+        }
+    }
+
+public:
+    static shared_ptr<const LocConfSnapshot> getSnapshot(const char* path) {
+        if (NULL == path) {
+            return nullptr;
+        }
+        LocConfFile* file = find(path, sFiles.load(std::memory_order_acquire));
+        if (nullptr == file) {
+            std::lock_guard<std::mutex> guard(sAddLock);
+            LocConfFile* head = sFiles.load(std::memory_order_acquire);
+            file = find(path, head);
+            if (nullptr == file) {
+                file = new LocConfFile(path, head);
+                sFiles.store(file, std::memory_order_release);
+                watch(file->mPath);
+            }
+        }
+        return std::atomic_load(&file->mSnapshot);
+    }
+};
+
+std::atomic<LocConfFile*> LocConfFile::sFiles(nullptr);
+std::mutex LocConfFile::sAddLock;
+int LocConfFile::sInotifyFd = -1;
+unordered_map<int, string> LocConfFile::sWatchDirs;
+
 /*===========================================================================
 FUNCTION loc_read_conf_long
 
@@ -425,6 +680,9 @@ DESCRIPTION
    Reads the specified configuration file and sets defined values based on
    the passed in configuration table. This table maps strings to values to
    set along with the type of each of these values.
+   The file is parsed on its first read and the table is filled from the
+   cached snapshot, which is reparsed whenever the file is rewritten. A name
+   repeated in the file takes its first value.
 
 PARAMETERS:
    conf_file_name: configuration file to read
@@ -443,18 +701,15 @@ SIDE EFFECTS
 void loc_read_conf_long(const char* conf_file_name, const loc_param_s_type* config_table,
                         uint32_t table_length, uint16_t string_len)
 {
-    FILE *conf_fp = NULL;
-
     log_buffer_init(false);
-    if((conf_fp = fopen(conf_file_name, "r")) != NULL)
+    shared_ptr<const LocConfSnapshot> snapshot = LocConfFile::getSnapshot(conf_file_name);
+    if (nullptr != snapshot && snapshot->isValid())
     {
         LOC_LOGD("%s: using %s", __FUNCTION__, conf_file_name);
         if(table_length && config_table) {
-            loc_read_conf_r_long(conf_fp, config_table, table_length, string_len);
-            rewind(conf_fp);
+            snapshot->fillTable(config_table, table_length, string_len);
         }
-        loc_read_conf_r_long(conf_fp, loc_param_table, loc_param_num, string_len);
-        fclose(conf_fp);
+        snapshot->fillTable(loc_param_table, loc_param_num, string_len);
     }
     /* Initialize logging mechanism with parsed data */
     loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
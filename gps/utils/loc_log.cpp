@@ -31,6 +31,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include "log_util.h"
@@ -38,7 +39,7 @@
 #include "msg_q.h"
 #include <loc_pla.h>
 #include "LogBuffer.h"
-#include <unordered_map>
+#include <atomic>
 #include <fstream>
 #include <algorithm>
 #include <string>
@@ -64,9 +65,63 @@ const string gUnknownStr = "UNKNOWN";
 /* Logging Mechanism */
 loc_logger_s_type loc_logger;
 
-/* tag base logging control map*/
-static std::unordered_map<std::string, uint8_t> tag_level_map;
-static bool tag_map_inited = false;
+/* tag base logging control table. Open addressed by a hash of the tag, slots
+   are only ever claimed, never freed, so lookups need no lock. */
+#define TAG_LEVEL_TABLE_SIZE 64
+typedef struct {
+    // copy of the tag, NULL marks a free slot
+    std::atomic<const char*> tag;
+    // hash of the tag, 0 until the claimer has set it
+    std::atomic<uint32_t> hash;
+    // level + 1, 0 while a claimed slot has no level yet or was cleared
+    std::atomic<int> level;
+} tag_level_slot;
+static tag_level_slot tag_level_table[TAG_LEVEL_TABLE_SIZE];
+static std::atomic<bool> tag_map_inited(false);
+int loc_log_level_gen = 0;
+
+/* FNV-1a, never 0 */
+static uint32_t tag_level_hash(const char* tag)
+{
+    uint32_t hash = 2166136261u;
+    for (; *tag != '\0'; tag++) {
+        hash = (hash ^ (uint8_t)*tag) * 16777619u;
+    }
+    return (0 == hash) ? 1 : hash;
+}
+
+static tag_level_slot* tag_level_find(const char* tag, bool claim)
+{
+    uint32_t hash = tag_level_hash(tag);
+    char* copy = NULL;
+    tag_level_slot* found = NULL;
+    for (uint32_t i = 0; i < TAG_LEVEL_TABLE_SIZE && NULL == found; i++) {
+        tag_level_slot& slot = tag_level_table[(hash + i) % TAG_LEVEL_TABLE_SIZE];
+        const char* slotTag = slot.tag.load(std::memory_order_acquire);
+        if (NULL == slotTag && claim) {
+            if (NULL == copy && NULL == (copy = strdup(tag))) {
+                break;
+            }
+            if (slot.tag.compare_exchange_strong(slotTag, copy, std::memory_order_acq_rel)) {
+                slot.hash.store(hash, std::memory_order_release);
+                copy = NULL;
+                found = &slot;
+                break;
+            }
+            // lost the slot to another writer, slotTag now holds its tag
+        }
+        if (NULL == slotTag) {
+            break;
+        }
+        // tags of colliding hashes get slots of their own
+        uint32_t slotHash = slot.hash.load(std::memory_order_acquire);
+        if ((0 == slotHash || hash == slotHash) && 0 == strcmp(slotTag, tag)) {
+            found = &slot;
+        }
+    }
+    free(copy);
+    return found;
+}
 
 /* returns the least signification bit that is set in the mask
    Param
@@ -224,11 +279,32 @@ void log_buffer_insert(char *str, unsigned long buf_size, int level)
 {
     timespec tv;
     clock_gettime(CLOCK_BOOTTIME, &tv);
-    uint64_t elapsedTime = (uint64_t)tv.tv_sec + (uint64_t)tv.tv_nsec/1000000000;
+    uint64_t elapsedTime = (uint64_t)tv.tv_sec * 1000000000ULL + tv.tv_nsec;
     string ss = str;
     loc_util::LogBuffer::getInstance()->append(ss, level, elapsedTime);
 }
 
+/*===========================================================================
+
+FUNCTION log_buffer_insert_format
+
+DESCRIPTION
+   Insert a log sentence with specific level to the log buffer, in binary
+   form. format and tag must be string literals, the args are formatted
+   only when the log buffer is dumped.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+void log_buffer_insert_format(int level, const char* tag, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    loc_util::LogBuffer::getInstance()->append(level, tag, format, args);
+    va_end(args);
+}
+
 void log_tag_level_map_init()
 {
     if (tag_map_inited) {
@@ -244,8 +320,8 @@ void log_tag_level_map_init()
         std::string line;
         while (std::getline(s, line)) {
             line.erase(std::remove(line.begin(), line.end(), ' '), line.end());
-            int pos = line.find('=');
-            if (pos <= 0 || pos >= (line.size() - 1)) {
+            size_t pos = line.find('=');
+            if (std::string::npos == pos || 0 == pos || pos + 1 >= line.size()) {
                 ALOGE("wrong format in gps.prop");
                 continue;
             }
@@ -255,10 +331,27 @@ void log_tag_level_map_init()
                 ALOGE("wrong format in gps.prop");
                 continue;
             }
-            tag_level_map[tag] = (uint8_t)std::stoul(level);
+            if (0 != loc_set_tag_log_level(tag.c_str(), (int)std::stoul(level))) {
+                ALOGE("too many tags in gps.prop, %s ignored", tag.c_str());
+            }
         }
     }
     tag_map_inited = true;
+    __atomic_add_fetch(&loc_log_level_gen, 1, __ATOMIC_RELEASE);
+}
+
+int loc_set_tag_log_level(const char* tag, int level)
+{
+    if (tag == NULL) {
+        return -1;
+    }
+    tag_level_slot* slot = tag_level_find(tag, level >= 0);
+    if (NULL == slot) {
+        return (level >= 0) ? -1 : 0;
+    }
+    slot->level.store((level >= 0) ? level + 1 : 0, std::memory_order_release);
+    __atomic_add_fetch(&loc_log_level_gen, 1, __ATOMIC_RELEASE);
+    return 0;
 }
 
 int get_tag_log_level(const char* tag)
@@ -271,11 +364,9 @@ int get_tag_log_level(const char* tag)
     if (tag == NULL) {
         return loc_logger.DEBUG_LEVEL;
     }
-    int log_level;
-    auto search = tag_level_map.find(std::string(tag));
-    if (tag_level_map.end() != search) {
-        log_level = search->second;
-    } else {
+    tag_level_slot* slot = tag_level_find(tag, false);
+    int log_level = (NULL != slot) ? slot->level.load(std::memory_order_acquire) - 1 : -1;
+    if (log_level < 0) {
         log_level = loc_logger.DEBUG_LEVEL;
     }
     return log_level;
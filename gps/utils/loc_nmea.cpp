@@ -31,6 +31,11 @@
 #define LOG_TAG "LocSvc_nmea"
 #include <loc_nmea.h>
 #include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
 #include <log_util.h>
 #include <loc_pla.h>
 #include <loc_cfg.h>
@@ -552,46 +557,375 @@ static loc_nmea_sv_meta* loc_nmea_sv_meta_init(loc_nmea_sv_meta& sv_meta,
 }
 
 /*===========================================================================
-FUNCTION    loc_nmea_put_checksum
+FUNCTION    loc_nmea_checksum
 
 DESCRIPTION
-   Generate NMEA sentences generated based on position report
+   XOR of all the characters in [begin, end). Eight characters are folded
+   in per step, which the compiler turns into vector XORs where available.
 
 DEPENDENCIES
    NONE
 
 RETURN VALUE
-   Total length of the nmea sentence
+   NMEA checksum of the characters
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static int loc_nmea_put_checksum(char *pNmea, int maxSize, bool isTagBlock)
+static uint8_t loc_nmea_checksum(const char* begin, const char* end)
 {
-    uint8_t checksum = 0;
-    int length = 0;
-    int checksumLength = 0;
-    if(NULL == pNmea)
-        return 0;
+    uint64_t words = 0;
+    for (; end - begin >= (ptrdiff_t)sizeof(words); begin += sizeof(words)) {
+        uint64_t word;
+        memcpy(&word, begin, sizeof(word));
+        words ^= word;
+    }
+    words ^= words >> 32;
+    words ^= words >> 16;
+    words ^= words >> 8;
 
-    pNmea++; //skip the $ or / for Tag Block
-    while (*pNmea != '\0')
-    {
-        checksum ^= *pNmea++;
-        length++;
+    uint8_t checksum = (uint8_t)words;
+    while (begin < end) {
+        checksum ^= *begin++;
+    }
+    return checksum;
+}
+
+/*===========================================================================
+CLASS       LocNmeaSentence
+
+DESCRIPTION
+   Formats one NMEA sentence in place at the end of a LocNmeaOutput. The
+   number formatting gives the same text as the printf conversions the
+   sentences are specified with. Nothing is added to the output until
+   finish(), so a sentence that does not fit is dropped whole.
+
+DEPENDENCIES
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+class LocNmeaSentence {
+    LocNmeaOutput& mOut;
+    char* mStart;
+    char* mPos;
+    char* mEnd;
+    // the $ or \ the checksum is counted from
+    char* mChecksumStart;
+    bool mOverflow;
+
+    inline bool reserve(size_t length) {
+        if (mOverflow || (size_t)(mEnd - mPos) < length) {
+            mOverflow = true;
+            return false;
+        }
+        return true;
+    }
+
+    // zero padded to minDigits, no sign
+    inline void putDigits(uint64_t value, uint32_t minDigits) {
+        char digits[20];
+        uint32_t numDigits = 0;
+        do {
+            digits[numDigits++] = '0' + (value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (numDigits < minDigits) {
+            digits[numDigits++] = '0';
+        }
+        if (reserve(numDigits)) {
+            while (numDigits > 0) {
+                *mPos++ = digits[--numDigits];
+            }
+        }
+    }
+
+public:
+    inline LocNmeaSentence(LocNmeaOutput& out) :
+            mOut(out), mStart(out.mBuf + out.mLength), mPos(mStart), mEnd(mStart),
+            mChecksumStart(mStart), mOverflow(false) {
+        // one byte is kept for the NUL terminating the output
+        if (out.mNumSpans < LOC_NMEA_MAX_SENTENCES && out.mLength < out.mSize) {
+            mEnd += std::min<uint32_t>(out.mSize - out.mLength - 1, NMEA_SENTENCE_MAX_LENGTH);
+        } else {
+            mOverflow = true;
+        }
+    }
+
+    inline void put(char c) {
+        if (reserve(1)) {
+            *mPos++ = c;
+        }
+    }
+
+    inline void put(const char* str) {
+        size_t length = strlen(str);
+        if (reserve(length)) {
+            memcpy(mPos, str, length);
+            mPos += length;
+        }
+    }
+
+    // printf("%0<width>d")
+    inline void putInt(int64_t value, uint32_t width = 0) {
+        if (value < 0) {
+            put('-');
+            putDigits(-(uint64_t)value, width > 1 ? width - 1 : 0);
+        } else {
+            putDigits(value, width);
+        }
+    }
+
+    // printf("%0<minDigits>X")
+    inline void putHex(uint32_t value, uint32_t minDigits = 0) {
+        char digits[8];
+        uint32_t numDigits = 0;
+        do {
+            digits[numDigits++] = "0123456789ABCDEF"[value & 0xF];
+            value >>= 4;
+        } while (value > 0);
+        while (numDigits < minDigits) {
+            digits[numDigits++] = '0';
+        }
+        if (reserve(numDigits)) {
+            while (numDigits > 0) {
+                *mPos++ = digits[--numDigits];
+            }
+        }
+    }
+
+    // printf("%0<width>.<decimals>f")
+    void putFixed(double value, uint32_t decimals, uint32_t width = 0);
+
+    // closes a tag block, the sentence proper starts after it
+    inline void endTagBlock() {
+        char checksum[5] = {'*', 0, 0, '\\', 0};
+        uint8_t sum = loc_nmea_checksum(mChecksumStart + 1, mPos);
+        checksum[1] = "0123456789ABCDEF"[sum >> 4];
+        checksum[2] = "0123456789ABCDEF"[sum & 0xF];
+        put(checksum);
+        mChecksumStart = mPos;
+    }
+
+    // appends the checksum and adds the sentence to the output
+    bool finish();
+};
+
+void LocNmeaSentence::putFixed(double value, uint32_t decimals, uint32_t width)
+{
+    static const double sScale[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+    static const uint64_t sDivisor[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+    // Below 2^32 the scaled value is off by less than 1e-6, which cannot
+    // move it across a rounding boundary unless its fraction is that close
+    // to one half. Those ties, NaN, infinity and values that large go to
+    // snprintf, which rounds on the exact binary value.
+    double scaled = (decimals < sizeof(sScale) / sizeof(sScale[0])) ?
+            fabs(value) * sScale[decimals] : NAN;
+    double integral = floor(scaled);
+    double fraction = scaled - integral;
+    if (!(scaled < 4294967296.0) || fabs(fraction - 0.5) < 1e-6) {
+        if (!mOverflow) {
+            int length = snprintf(mPos, mEnd - mPos + 1, "%0*.*f", width, decimals, value);
+            if (length < 0 || length > mEnd - mPos) {
+                mOverflow = true;
+            } else {
+                mPos += length;
+            }
+        }
+        return;
     }
 
-    if (isTagBlock) {
-        // length now contains tag block sentence string length not including / sign.
-        checksumLength = snprintf(pNmea, (maxSize-length-1), "*%02X\\", checksum);
+    uint64_t units = (uint64_t)integral + (fraction > 0.5 ? 1 : 0);
+    uint32_t intWidth = width;
+    if (signbit(value)) {
+        put('-');
+        intWidth = (intWidth > 0) ? intWidth - 1 : 0;
+    }
+    if (decimals > 0) {
+        intWidth = (intWidth > decimals + 1) ? intWidth - decimals - 1 : 0;
+        putDigits(units / sDivisor[decimals], intWidth);
+        put('.');
+        putDigits(units % sDivisor[decimals], decimals);
     } else {
-        // length now contains nmea sentence string length not including $ sign.
-        checksumLength = snprintf(pNmea, (maxSize-length-1), "*%02X\r\n", checksum);
+        putDigits(units, intWidth);
+    }
+}
+
+bool LocNmeaSentence::finish()
+{
+    uint8_t sum = loc_nmea_checksum(mChecksumStart + 1, mPos);
+    put('*');
+    putHex(sum, 2);
+    put("\r\n");
+    if (mOverflow) {
+        LOC_LOGE("NMEA Error in string formatting");
+        // drop what was written of the sentence
+        if (mStart < mEnd) {
+            *mStart = '\0';
+        }
+        return false;
+    }
+    *mPos = '\0';
+    mOut.mSpans[mOut.mNumSpans].offset = mStart - mOut.mBuf;
+    mOut.mSpans[mOut.mNumSpans].length = mPos - mStart;
+    mOut.mNumSpans++;
+    mOut.mLength = mPos - mOut.mBuf;
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    LocNmeaOutput::repeatSentence
+
+DESCRIPTION
+   Appends a copy of a sentence already in the output
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   true when the copy fits
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+bool LocNmeaOutput::repeatSentence(uint32_t index)
+{
+    if (index >= mNumSpans || mNumSpans >= LOC_NMEA_MAX_SENTENCES ||
+        mSpans[index].length >= mSize - mLength) {
+        LOC_LOGE("NMEA Error in string formatting");
+        return false;
+    }
+    memcpy(mBuf + mLength, mBuf + mSpans[index].offset, mSpans[index].length);
+    mSpans[mNumSpans].offset = mLength;
+    mSpans[mNumSpans].length = mSpans[index].length;
+    mNumSpans++;
+    mLength += mSpans[index].length;
+    mBuf[mLength] = '\0';
+    return true;
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_blank
+
+DESCRIPTION
+   Appends a sentence with all its fields empty
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_put_blank(const char* fields, LocNmeaOutput& out)
+{
+    LocNmeaSentence s(out);
+    s.put(fields);
+    s.finish();
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_utc_time
+
+DESCRIPTION
+   Appends the hhmmss.ss UTC time field and its comma
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_put_utc_time(LocNmeaSentence& s, int hours, int minutes, int seconds,
+                                  int mSeconds)
+{
+    s.putInt(hours, 2);
+    s.putInt(minutes, 2);
+    s.putInt(seconds, 2);
+    s.put('.');
+    s.putInt(mSeconds/10, 2);
+    s.put(',');
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_put_lat_long
+
+DESCRIPTION
+   Appends the ddmm.mmmmmm,N,dddmm.mmmmmm,E, latitude and longitude fields,
+   or empty ones if the location has none
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_put_lat_long(LocNmeaSentence& s, const UlpLocation &location,
+                                  const LocLla &ref_lla)
+{
+    if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
+    {
+        double latitude = ref_lla.lat;
+        double longitude = ref_lla.lon;
+        char latHemisphere;
+        char lonHemisphere;
+        double latMinutes;
+        double lonMinutes;
+
+        if (latitude > 0)
+        {
+            latHemisphere = 'N';
+        }
+        else
+        {
+            latHemisphere = 'S';
+            latitude *= -1.0;
+        }
+
+        if (longitude < 0)
+        {
+            lonHemisphere = 'W';
+            longitude *= -1.0;
+        }
+        else
+        {
+            lonHemisphere = 'E';
+        }
+
+        latMinutes = fmod(latitude * 60.0 , 60.0);
+        lonMinutes = fmod(longitude * 60.0 , 60.0);
+
+        s.putInt((uint8_t)floor(latitude), 2);
+        s.putFixed(latMinutes, 6, 9);
+        s.put(',');
+        s.put(latHemisphere);
+        s.put(',');
+        s.putInt((uint8_t)floor(longitude), 3);
+        s.putFixed(lonMinutes, 6, 9);
+        s.put(',');
+        s.put(lonHemisphere);
+        s.put(',');
+    }
+    else
+    {
+        s.put(",,,,");
     }
-    // total length of nmea sentence is length of nmea sentence inc $ sign plus
-    // length of checksum (+1 is to cover the $ character in the length).
-    return (length + checksumLength + 1);
 }
 
 /*===========================================================================
@@ -616,23 +950,16 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtended,
-                              char* sentence,
-                              int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr,
+                              LocNmeaOutput &out,
                               bool isTagBlockGroupingEnabled)
 {
-    if (!sentence || bufSize <= 0 || !sv_meta_p)
+    if (!sv_meta_p)
     {
         LOC_LOGE("NMEA Error invalid arguments.");
         return 0;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
-    int lengthTagBlock = 0;
-
     uint32_t svUsedCount = 0;
     uint32_t svUsedList[64] = {0};
     uint32_t sentenceCount = 0;
@@ -665,17 +992,18 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         svNumber = 1;
     }
     while (sentenceNumber <= sentenceCount) {
-        pMarker = sentence;
-        lengthRemaining = bufSize;
+        LocNmeaSentence s(out);
         if (svUsedCount > 12 && isTagBlockGroupingEnabled) {
-            lengthTagBlock = snprintf(pMarker, lengthRemaining, "\\g:%d-%d-%d", sentenceNumber,
-                     sentenceCount, code);
+            s.put("\\g:");
+            s.putInt(sentenceNumber);
+            s.put('-');
+            s.putInt(sentenceCount);
+            s.put('-');
+            s.putInt(code);
             if (MAX_TAG_BLOCK_GROUP_CODE == code) {
                 code = 1;
             }
-            lengthTagBlock = loc_nmea_put_checksum(sentence, bufSize, true);
-            pMarker += lengthTagBlock;
-            lengthRemaining -= lengthTagBlock;
+            s.endTagBlock();
         }
         if (sv_meta_p->totalSvUsedCount == 0)
             fixType = '1'; // no fix
@@ -694,53 +1022,42 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         // v.v : Vertical DOP
         // s : GNSS System Id
         // cc : Checksum value
-        length = snprintf(pMarker, lengthRemaining, "$%sGSA,A,%c,", talker, fixType);
-        if (length < 0 || length >= lengthRemaining) {
-            LOC_LOGE("NMEA Error in string formatting");
-            return 0;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        s.put('$');
+        s.put(talker);
+        s.put("GSA,A,");
+        s.put(fixType);
+        s.put(',');
 
         // Add 12 satellite IDs
         for (uint8_t i = 0; i < 12; i++, svNumber++)
         {
             if (svNumber <= svUsedCount)
-                length = snprintf(pMarker, lengthRemaining, "%02d,", svUsedList[svNumber - 1]);
-            else
-                length = snprintf(pMarker, lengthRemaining, ",");
-
-            if (length < 0 || length >= lengthRemaining) {
-                LOC_LOGE("NMEA Error in string formatting");
-                return 0;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+                s.putInt((int)svUsedList[svNumber - 1], 2);
+            s.put(',');
         }
 
         // Add the position/horizontal/vertical DOP values
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,%.1f,%.1f,",
-                    locationExtended.pdop,
-                    locationExtended.hdop,
-                    locationExtended.vdop);
+            s.putFixed(locationExtended.pdop, 1);
+            s.put(',');
+            s.putFixed(locationExtended.hdop, 1);
+            s.put(',');
+            s.putFixed(locationExtended.vdop, 1);
+            s.put(',');
         }
         else
         {   // no dop
-            length = snprintf(pMarker, lengthRemaining, ",,,");
+            s.put(",,,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         // system id
-        length = snprintf(pMarker, lengthRemaining, "%d", sv_meta_p->systemId);
-        pMarker += length;
-        lengthRemaining -= length;
+        s.putInt(sv_meta_p->systemId);
 
         /* Sentence is ready, add checksum and broadcast */
-        length = loc_nmea_put_checksum(sentence + lengthTagBlock, bufSize - lengthTagBlock, false);
-        nmeaArraystr.push_back(sentence);
+        if (!s.finish()) {
+            return 0;
+        }
         sentenceNumber++;
         if (!isTagBlockGroupingEnabled) {
             break;
@@ -773,20 +1090,15 @@ SIDE EFFECTS
 
 ===========================================================================*/
 static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
-                              char* sentence,
-                              int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaOutput &out)
 {
-    if (!sentence || bufSize <= 0)
+    if (!sv_meta_p)
     {
         LOC_LOGE("NMEA Error invalid argument.");
         return;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
     int sentenceCount = 0;
     int sentenceNumber = 1;
     size_t svNumber = 1;
@@ -809,19 +1121,16 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
 
     while (sentenceNumber <= sentenceCount)
     {
-        pMarker = sentence;
-        lengthRemaining = bufSize;
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGSV,%d,%d,%02d",
-                talker, sentenceCount, sentenceNumber, svCount);
+        LocNmeaSentence s(out);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        s.put('$');
+        s.put(talker);
+        s.put("GSV,");
+        s.putInt(sentenceCount);
+        s.put(',');
+        s.putInt(sentenceNumber);
+        s.put(',');
+        s.putInt(svCount, 2);
 
         for (int i=0; (svNumber <= svNotify.count) && (i < 4);  svNumber++)
         {
@@ -864,37 +1173,20 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
                 if (GNSS_SV_TYPE_SBAS == svNotify.gnssSvs[svNumber - 1].type) {
                     svIdOffset = SBAS_SV_ID_OFFSET;
                 }
-                if (GNSS_SV_TYPE_GLONASS == svNotify.gnssSvs[svNumber - 1].type &&
-                    GLO_SV_PRN_SLOT_UNKNOWN == svNotify.gnssSvs[svNumber - 1].svId) {
-                    length = snprintf(pMarker, lengthRemaining, ",,%02d,%03d,",
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
-                } else {
-                    length = snprintf(pMarker, lengthRemaining, ",%02d,%02d,%03d,",
-                        svNotify.gnssSvs[svNumber - 1].svId - svIdOffset,
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
+                s.put(',');
+                if (!(GNSS_SV_TYPE_GLONASS == svNotify.gnssSvs[svNumber - 1].type &&
+                      GLO_SV_PRN_SLOT_UNKNOWN == svNotify.gnssSvs[svNumber - 1].svId)) {
+                    s.putInt((int)(svNotify.gnssSvs[svNumber - 1].svId - svIdOffset), 2);
                 }
-                if (length < 0 || length >= lengthRemaining)
-                {
-                    LOC_LOGE("NMEA Error in string formatting");
-                    return;
-                }
-                pMarker += length;
-                lengthRemaining -= length;
+                s.put(',');
+                s.putInt((int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), 2); //float to int
+                s.put(',');
+                s.putInt((int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth), 3); //float to int
+                s.put(',');
 
                 if (svNotify.gnssSvs[svNumber - 1].cN0Dbhz > 0)
                 {
-                    length = snprintf(pMarker, lengthRemaining,"%02d",
-                            (int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz)); //float to int
-
-                    if (length < 0 || length >= lengthRemaining)
-                    {
-                        LOC_LOGE("NMEA Error in string formatting");
-                        return;
-                    }
-                    pMarker += length;
-                    lengthRemaining -= length;
+                    s.putInt((int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz), 2); //float to int
                 }
 
                 i++;
@@ -903,12 +1195,12 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         }
 
         // append signalId
-        length = snprintf(pMarker, lengthRemaining,",%X",sv_meta_p->signalId);
-        pMarker += length;
-        lengthRemaining -= length;
+        s.put(',');
+        s.putHex(sv_meta_p->signalId);
 
-        length = loc_nmea_put_checksum(sentence, bufSize, false);
-        nmeaArraystr.push_back(sentence);
+        if (!s.finish()) {
+            return;
+        }
         sentenceNumber++;
 
     }  //while
@@ -924,21 +1216,18 @@ DEPENDENCIES
    NONE
 
 RETURN VALUE
-   NONE
+   true when the sentence is added to the output
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void loc_nmea_generate_DTM(const LocLla &ref_lla,
+static bool loc_nmea_generate_DTM(const LocLla &ref_lla,
                                   const LocLla &local_lla,
                                   char *talker,
-                                  char *sentence,
-                                  int bufSize)
+                                  LocNmeaOutput &out)
 {
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
+    LocNmeaSentence s(out);
     int datum_type;
     char ref_datum[4] = {0};
     char local_datum[4] = {0};
@@ -969,13 +1258,11 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         default:
             break;
     }
-    length = snprintf(pMarker , lengthRemaining , "$%sDTM,%s,," , talker, local_datum);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
+    s.put('$');
+    s.put(talker);
+    s.put("DTM,");
+    s.put(local_datum);
+    s.put(",,");
 
     lla_offset[0] = local_lla.lat - ref_lla.lat;
     lla_offset[1] = fmod(local_lla.lon - ref_lla.lon, 360.0);
@@ -999,24 +1286,21 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         longHem = 'E';
     }
     longMins = fmod(lla_offset[1] * 60.0, 60.0);
-    length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,%.3lf,",
-                     (uint8_t)floor(lla_offset[0]), latMins, latHem,
-                     (uint8_t)floor(lla_offset[1]), longMins, longHem, lla_offset[2]);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
-    length = snprintf(pMarker , lengthRemaining , "%s" , ref_datum);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
-
-    length = loc_nmea_put_checksum(sentence, bufSize, false);
+    s.putInt((uint8_t)floor(lla_offset[0]), 2);
+    s.putFixed(latMins, 6, 9);
+    s.put(',');
+    s.put(latHem);
+    s.put(',');
+    s.putInt((uint8_t)floor(lla_offset[1]), 3);
+    s.putFixed(longMins, 6, 9);
+    s.put(',');
+    s.put(longHem);
+    s.put(',');
+    s.putFixed(lla_offset[2], 3);
+    s.put(',');
+    s.put(ref_datum);
+
+    return s.finish();
 }
 
 /*===========================================================================
@@ -1331,13 +1615,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                const LocationSystemInfo &systemInfo,
                                unsigned char generate_nmea,
                                bool custom_gga_fix_quality,
-                               std::vector<std::string> &nmeaArraystr,
-                               int& indexOfGGA,
+                               LocNmeaOutput &out,
                                bool isTagBlockGroupingEnabled)
 {
     ENTRY_LOG();
 
-    indexOfGGA = -1;
+    out.reset();
     LocGpsUtcTime utcPosTimestamp = 0;
     bool inLsTransition = false;
 
@@ -1352,14 +1635,6 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         return;
     }
 
-    char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char sentence_DTM[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char sentence_RMC[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char sentence_GNS[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char sentence_GGA[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char* pMarker = sentence;
-    int lengthRemaining = sizeof(sentence);
-    int length = 0;
     int utcYear = pTm->tm_year % 100; // 2 digit year
     int utcMonth = pTm->tm_mon + 1; // tm_mon starts at zero
     int utcDay = pTm->tm_mday;
@@ -1412,9 +1687,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GPGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GPS_L1CA, true), out, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1426,9 +1701,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GLGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GLONASS_G1, true), out, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1440,9 +1715,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GAGSA/$GNGSA---
         // -------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GALILEO_E1, true), out, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1453,9 +1728,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         // ---$GBGSA/$GNGSA (BEIDOU)---
         // ----------------------------
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_BEIDOU_B1I, true), out, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1467,9 +1742,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ---$GQGSA/$GNGSA (QZSS)---
         // --------------------------
 
-        count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
+        count = loc_nmea_generate_GSA(locationExtended,
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_QZSS_L1CA, true), out, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1480,9 +1755,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // if svUsedCount is 0, it means we do not generate any GSA sentence yet.
         // in this case, generate an empty GSA sentence
         if (svUsedCount == 0) {
-            strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
-            length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-            nmeaArraystr.push_back(sentence);
+            loc_nmea_put_blank("$GPGSA,A,1,,,,,,,,,,,,,,,,", out);
         }
 
         char ggaGpsQuality[3] = {'0', '\0', '\0'};
@@ -1496,9 +1769,10 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ------$--VTG-------
         // -------------------
 
-        pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
-
+        LocNmeaSentence vtg(out);
+        vtg.put('$');
+        vtg.put(talker);
+        vtg.put("VTG,");
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
             float magTrack = location.gpsLocation.bearing;
@@ -1511,45 +1785,36 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                     magTrack -= 360.0;
             }
 
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
+            vtg.putFixed(location.gpsLocation.bearing, 1);
+            vtg.put(",T,");
+            vtg.putFixed(magTrack, 1);
+            vtg.put(",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,,T,,M,", talker);
+            vtg.put(",T,,M,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
         {
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
             float speedKmPerHour = location.gpsLocation.speed * 3.6;
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
+            vtg.putFixed(speedKnots, 1);
+            vtg.put(",N,");
+            vtg.putFixed(speedKmPerHour, 1);
+            vtg.put(",K,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",N,,K,");
+            vtg.put(",N,,K,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
+        vtg.put(vtgModeIndicator);
+
+        if (!vtg.finish()) {
             return;
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
-
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
 
         memset(&ecef_w84, 0, sizeof(ecef_w84));
         memset(&ecef_p90, 0, sizeof(ecef_p90));
@@ -1589,14 +1854,16 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // -------------------
         // ------$--DTM-------
         // -------------------
-        loc_nmea_generate_DTM(ref_lla, local_lla, talker, sentence_DTM, sizeof(sentence_DTM));
+        uint32_t indexOfDTM = out.getNumSentences();
+        if (!loc_nmea_generate_DTM(ref_lla, local_lla, talker, out)) {
+            return;
+        }
 
         // -------------------
         // ------$--RMC-------
         // -------------------
 
-        pMarker = sentence_RMC;
-        lengthRemaining = sizeof(sentence_RMC);
+        LocNmeaSentence rmc(out);
 
         bool validFix = ((0 != sv_cache_info.gps_used_mask) ||
                 (0 != sv_cache_info.glo_used_mask) ||
@@ -1604,116 +1871,31 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 (0 != sv_cache_info.qzss_used_mask) ||
                 (0 != sv_cache_info.bds_used_mask));
 
-        if (validFix) {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        } else {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,V,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
-
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
+        rmc.put('$');
+        rmc.put(talker);
+        rmc.put("RMC,");
+        loc_nmea_put_utc_time(rmc, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+        rmc.put(validFix ? "A," : "V,");
 
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_lat_long(rmc, location, ref_lla);
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
         {
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            rmc.putFixed(speedKnots, 1);
         }
-        pMarker += length;
-        lengthRemaining -= length;
+        rmc.put(',');
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            rmc.putFixed(location.gpsLocation.bearing, 1);
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%2.2d%2.2d%2.2d,",
-                          utcDay, utcMonth, utcYear);
+        rmc.put(',');
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        rmc.putInt(utcDay, 2);
+        rmc.putInt(utcMonth, 2);
+        rmc.putInt(utcYear, 2);
+        rmc.put(',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
         {
@@ -1729,400 +1911,161 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 direction = 'E';
             }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,%c,",
-                              magneticVariation, direction);
+            rmc.putFixed(magneticVariation, 1);
+            rmc.put(',');
+            rmc.put(direction);
+            rmc.put(',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",,");
+            rmc.put(",,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%c", rmcModeIndicator);
-        pMarker += length;
-        lengthRemaining -= length;
+        rmc.put(rmcModeIndicator);
 
         // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
+        rmc.put(",V");
 
-        length = loc_nmea_put_checksum(sentence_RMC, sizeof(sentence_RMC), false);
+        if (!rmc.finish()) {
+            return;
+        }
+        if (LOC_GNSS_DATUM_PZ90 == datum_type) {
+            // ------$--DTM-------
+            out.repeatSentence(indexOfDTM);
+        }
 
         // -------------------
         // ------$--GNS-------
         // -------------------
 
-        pMarker = sentence_GNS;
-        lengthRemaining = sizeof(sentence_GNS);
+        LocNmeaSentence gns(out);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+        gns.put('$');
+        gns.put(talker);
+        gns.put("GNS,");
+        loc_nmea_put_utc_time(gns, utcHours, utcMinutes, utcSeconds, utcMSeconds);
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_lat_long(gns, location, ref_lla);
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
-
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
-
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%s,", gnsModeIndicator);
-
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.put(gnsModeIndicator);
+        gns.put(',');
 
+        gns.putInt(svUsedCount, 2);
+        gns.put(',');
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
-            length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
-                              svUsedCount, locationExtended.hdop);
-        }
-        else {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%02d,,",
-                              svUsedCount);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gns.putFixed(locationExtended.hdop, 1);
         }
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.put(',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",");
+            gns.putFixed(locationExtended.altitudeMeanSeaLevel, 1);
         }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.put(',');
 
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gns.putFixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1);
         }
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.put(',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gns.putFixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1);
         }
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.put(',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
         {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
-            {
-                LOC_LOGE("NMEA Error in string formatting");
-                return;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+            gns.putInt(locationExtended.dgnssRefStationId, 4);
         }
 
         // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.put(",V");
 
-        length = loc_nmea_put_checksum(sentence_GNS, sizeof(sentence_GNS), false);
+        if (!gns.finish()) {
+            return;
+        }
+        if (LOC_GNSS_DATUM_PZ90 == datum_type) {
+            // ------$--DTM-------
+            out.repeatSentence(indexOfDTM);
+        }
 
         // -------------------
         // ------$--GGA-------
         // -------------------
 
-        pMarker = sentence_GGA;
-        lengthRemaining = sizeof(sentence_GGA);
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        LocNmeaSentence gga(out);
 
-        if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
-        {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
+        gga.put('$');
+        gga.put(talker);
+        gga.put("GGA,");
+        loc_nmea_put_utc_time(gga, utcHours, utcMinutes, utcSeconds, utcMSeconds);
 
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
-
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
-        }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_put_lat_long(gga, location, ref_lla);
 
         // Number of satellites in use, 00-12
         if (svUsedCount > MAX_SATELLITES_IN_USE)
             svUsedCount = MAX_SATELLITES_IN_USE;
+        gga.put(ggaGpsQuality);
+        gga.put(',');
+        gga.putInt(svUsedCount, 2);
+        gga.put(',');
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
-                              ggaGpsQuality, svUsedCount, locationExtended.hdop);
-        }
-        else
-        {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,,",
-                              ggaGpsQuality, svUsedCount);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gga.putFixed(locationExtended.hdop, 1);
         }
-        pMarker += length;
-        lengthRemaining -= length;
+        gga.put(',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              locationExtended.altitudeMeanSeaLevel);
+            gga.putFixed(locationExtended.altitudeMeanSeaLevel, 1);
+            gga.put(",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,");
+            gga.put(",,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            gga.putFixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1);
+            gga.put(",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",,");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gga.put(",,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
+            gga.putFixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1);
         }
-        else
-        {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        gga.put(',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
         {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
-            {
-                LOC_LOGE("NMEA Error in string formatting");
-                return;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+            gga.putInt(locationExtended.dgnssRefStationId, 4);
         }
 
-        length = loc_nmea_put_checksum(sentence_GGA, sizeof(sentence_GGA), false);
-
-        // ------$--DTM-------
-        nmeaArraystr.push_back(sentence_DTM);
-        // ------$--RMC-------
-        nmeaArraystr.push_back(sentence_RMC);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
+        if (gga.finish()) {
+            out.setIndexOfGGA(out.getNumSentences() - 1);
         }
-        // ------$--GNS-------
-        nmeaArraystr.push_back(sentence_GNS);
-        if(LOC_GNSS_DATUM_PZ90 == datum_type) {
-            // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
-        }
-        // ------$--GGA-------
-        nmeaArraystr.push_back(sentence_GGA);
-        indexOfGGA = static_cast<int>(nmeaArraystr.size() - 1);
     }
     //Send blank NMEA reports for non-final fixes
     else {
-        strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
-
-        strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_put_blank("$GPGSA,A,1,,,,,,,,,,,,,,,,", out);
+        loc_nmea_put_blank("$GPVTG,,T,,M,,N,,K,N", out);
+        loc_nmea_put_blank("$GPDTM,,,,,,,,", out);
+        loc_nmea_put_blank("$GPRMC,,V,,,,,,,,,,N,V", out);
+        loc_nmea_put_blank("$GPGNS,,,,,,N,,,,,,,V", out);
+        loc_nmea_put_blank("$GPGGA,,,,,,0,,,,,,,,", out);
     }
 
     EXIT_LOG(%d, 0);
 }
-
-
-
 /*===========================================================================
 FUNCTION    loc_nmea_generate_sv
 
@@ -2140,11 +2083,11 @@ SIDE EFFECTS
 
 ===========================================================================*/
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaOutput &out)
 {
     ENTRY_LOG();
 
-    char sentence[NMEA_SENTENCE_MAX_LENGTH] = {0};
+    out.reset();
     loc_sv_cache_info sv_cache_info = {};
 
     //Count GPS SVs for saparating GPS from GLONASS and throw others
@@ -2229,119 +2172,420 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
     // ------$GPGSV:L1CA----
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L1CA, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L1CA, false), out);
 
     // ---------------------
     // ------$GPGSV:L5------
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L5, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L5, false), out);
 
     // ---------------------
     // ------$GPGSV:L2------
     // ---------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L2, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L2, false), out);
 
     // ---------------------
     // ------$GLGSV:G1------
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G1, false), nmeaArraystr);
+            GNSS_SIGNAL_GLONASS_G1, false), out);
 
     // ---------------------
     // ------$GLGSV:G2------
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G2, false), nmeaArraystr);
+            GNSS_SIGNAL_GLONASS_G2, false), out);
 
     // ---------------------
     // ------$GAGSV:E1------
     // ---------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E1, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E1, false), out);
 
     // -------------------------
     // ------$GAGSV:E5A---------
     // -------------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5A, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E5A, false), out);
 
     // -------------------------
     // ------$GAGSV:E5B---------
     // -------------------------
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5B, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E5B, false), out);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L1CA-----
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L1CA, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L1CA, false), out);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L5-------
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L5, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L5, false), out);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L2-------
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L2, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L2, false), out);
 
 
     // -----------------------------
     // ------$GBGSV (BEIDOU:B1I)----
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1I, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B1I, false), out);
 
     // -----------------------------
     // ------$GBGSV (BEIDOU:B1C)----
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1C, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B1C, false), out);
 
     // -----------------------------
     // ------$GBGSV (BEIDOU:B2AI)---
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B2AI, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B2AI, false), out);
 
     // -----------------------------
     // ------$GIGSV (NAVIC:L5)------
     // -----------------------------
 
-    loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
+    loc_nmea_generate_GSV(svNotify,
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_NAVIC,
-            GNSS_SIGNAL_NAVIC_L5,false), nmeaArraystr);
+            GNSS_SIGNAL_NAVIC_L5,false), out);
 
     EXIT_LOG(%d, 0);
 }
+
+#ifdef __LOC_UNIT_TEST__
+/*===========================================================================
+ golden output, taken from the snprintf based generator this one replaced
+===========================================================================*/
+// fixes covering every field the position sentences print, their sign
+// and rounding edge cases, tag block grouping and the blank report
+static void loc_nmea_test_fix(uint32_t index, UlpLocation& location,
+                              GpsLocationExtended& locationExtended)
+{
+    memset(&location, 0, sizeof(location));
+    memset(&locationExtended, 0, sizeof(locationExtended));
+    location.size = sizeof(location);
+    location.gpsLocation.timestamp = 1602763519123ULL + index * 1050;
+    location.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING;
+    locationExtended.flags = GPS_LOCATION_EXTENDED_HAS_DOP |
+            GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL |
+            GPS_LOCATION_EXTENDED_HAS_MAG_DEV | GPS_LOCATION_EXTENDED_HAS_GNSS_SV_USED_DATA |
+            GPS_LOCATION_EXTENDED_HAS_POS_TECH_MASK;
+    locationExtended.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+    switch (index) {
+    case 0:
+        location.gpsLocation.latitude = 37.4220011;
+        location.gpsLocation.longitude = -122.0841012;
+        location.gpsLocation.altitude = 12.5;
+        location.gpsLocation.speed = 4.2f;
+        location.gpsLocation.bearing = 271.35f;
+        locationExtended.altitudeMeanSeaLevel = 44.25f;
+        locationExtended.pdop = 1.25f;
+        locationExtended.hdop = 0.95f;
+        locationExtended.vdop = 0.85f;
+        locationExtended.magneticDeviation = 13.2f;
+        locationExtended.gnss_sv_used_ids.gps_sv_used_ids_mask = 0x1f3;
+        locationExtended.gnss_sv_used_ids.glo_sv_used_ids_mask = 0x7;
+        locationExtended.gnss_sv_used_ids.gal_sv_used_ids_mask = 0x3;
+        break;
+    case 1:
+        location.gpsLocation.latitude = -33.8567844;
+        location.gpsLocation.longitude = 151.2152967;
+        location.gpsLocation.altitude = -3.75;
+        location.gpsLocation.speed = 0.05f;
+        location.gpsLocation.bearing = 359.96f;
+        locationExtended.altitudeMeanSeaLevel = -25.05f;
+        locationExtended.pdop = 12.35f;
+        locationExtended.hdop = 9.95f;
+        locationExtended.vdop = 0.05f;
+        locationExtended.magneticDeviation = -12.75f;
+        locationExtended.flags |= GPS_LOCATION_EXTENDED_HAS_NAV_SOLUTION_MASK |
+                GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE |
+                GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID;
+        locationExtended.navSolutionMask = LOC_NAV_MASK_DGNSS_CORRECTION;
+        locationExtended.tech_mask |= LOC_POS_TECH_MASK_SENSORS;
+        locationExtended.dgnssDataAgeMsec = 2350;
+        locationExtended.dgnssRefStationId = 42;
+        locationExtended.gnss_sv_used_ids.gps_sv_used_ids_mask = 0xfffff;
+        locationExtended.gnss_sv_used_ids.bds_sv_used_ids_mask = 0x3000f;
+        locationExtended.gnss_sv_used_ids.qzss_sv_used_ids_mask = 0x1;
+        break;
+    case 2:
+        // minutes that round up to 60 and a position on the equator
+        location.gpsLocation.latitude = 0.99999999999;
+        location.gpsLocation.longitude = 0.0;
+        location.gpsLocation.flags &= ~(LOC_GPS_LOCATION_HAS_SPEED |
+                LOC_GPS_LOCATION_HAS_BEARING);
+        locationExtended.flags &= ~(GPS_LOCATION_EXTENDED_HAS_DOP |
+                GPS_LOCATION_EXTENDED_HAS_MAG_DEV);
+        locationExtended.altitudeMeanSeaLevel = 0.04f;
+        locationExtended.gnss_sv_used_ids.navic_sv_used_ids_mask = 0x3;
+        break;
+    default:
+        break;
+    }
+}
+
+// SVs of every constellation and signal, SBAS, an unknown GLONASS slot
+// and SVs without C/N0
+static void loc_nmea_test_sv(GnssSvNotification& svNotify)
+{
+    static const struct {
+        uint16_t svId;
+        GnssSvType type;
+        GnssSignalTypeMask signal;
+    } svs[] = {
+        {1, GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L1CA}, {3, GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L1CA},
+        {7, GNSS_SV_TYPE_GPS, 0}, {8, GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L1CA},
+        {11, GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L1CA}, {14, GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L1CA},
+        {3, GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L5}, {8, GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L5},
+        {14, GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L2}, {131, GNSS_SV_TYPE_SBAS, GNSS_SIGNAL_SBAS_L1},
+        {65, GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G1},
+        {72, GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G1},
+        {GLO_SV_PRN_SLOT_UNKNOWN, GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G1},
+        {72, GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G2},
+        {301, GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E1},
+        {305, GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E1},
+        {305, GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E5A},
+        {336, GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E5B},
+        {193, GNSS_SV_TYPE_QZSS, GNSS_SIGNAL_QZSS_L1CA},
+        {193, GNSS_SV_TYPE_QZSS, GNSS_SIGNAL_QZSS_L5},
+        {201, GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B1I},
+        {206, GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B1I},
+        {230, GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B1C},
+        {230, GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B2AI},
+        {402, GNSS_SV_TYPE_NAVIC, GNSS_SIGNAL_NAVIC_L5},
+    };
+    memset(&svNotify, 0, sizeof(svNotify));
+    svNotify.size = sizeof(svNotify);
+    svNotify.count = sizeof(svs) / sizeof(svs[0]);
+    for (uint32_t i = 0; i < svNotify.count; i++) {
+        GnssSv& sv = svNotify.gnssSvs[i];
+        sv.size = sizeof(sv);
+        sv.svId = svs[i].svId;
+        sv.type = svs[i].type;
+        sv.gnssSignalTypeMask = svs[i].signal;
+        sv.cN0Dbhz = (i % 5) ? 18.5f + i : 0.0f;
+        sv.elevation = 4.49f + i * 3.5f;
+        sv.azimuth = 359.5f - i * 14.25f;
+        sv.gnssSvOptionsMask = (i % 2) ? GNSS_SV_OPTIONS_USED_IN_FIX_BIT : 0;
+    }
+}
+
+static const char* const sGoldenPos[] = {
+    // fix 0
+    "$GNGSA,A,3,01,02,05,06,07,08,09,,,,,,1.2,0.9,0.9,1*34\r\n"
+    "$GNGSA,A,3,65,66,67,,,,,,,,,,1.2,0.9,0.9,2*33\r\n"
+    "$GNGSA,A,3,01,02,,,,,,,,,,,1.2,0.9,0.9,3*33\r\n"
+    "$GNVTG,271.4,T,258.1,M,8.2,N,15.1,K,A*0C\r\n"
+    "$GNDTM,P90,,0000.000025,S,00000.000001,E,0.981,W84*58\r\n"
+    "$GNRMC,120519.12,A,3725.320066,N,12205.046072,W,8.2,271.4,151020,13.2,E,A,V*72\r\n"
+    "$GNGNS,120519.12,3725.320066,N,12205.046072,W,AAANNN,12,0.9,44.2,-31.8,,,V*2C\r\n"
+    "$GNGGA,120519.12,3725.320066,N,12205.046072,W,1,12,0.9,44.2,M,-31.8,M,,*73\r\n",
+    // fix 1
+    "\\g:1-2-1*6F\\$GNGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,12.4,9.9,0.1,1*04\r\n"
+    "\\g:2-2-1*6C\\$GNGSA,A,3,13,14,15,16,17,18,19,20,,,,,12.4,9.9,0.1,1*06\r\n"
+    "$GNGSA,A,3,01,02,03,04,17,18,,,,,,,12.4,9.9,0.1,4*09\r\n"
+    "$GNGSA,A,3,01,,,,,,,,,,,,12.4,9.9,0.1,5*02\r\n"
+    "$GNVTG,360.0,T,12.7,M,0.1,N,0.2,K,D*0A\r\n"
+    "$GNDTM,P90,,0000.000023,N,00000.000002,W,0.983,W84*50\r\n"
+    "$GNRMC,120520.17,A,3351.407064,S,15112.917802,E,0.1,360.0,151020,12.8,W,D,V*67\r\n"
+    "$GNGNS,120520.17,3351.407064,S,15112.917802,E,DNNDDN,27,9.9,-25.0,21.3,2.3,0042,V*07\r\n"
+    "$GNGGA,120520.17,3351.407064,S,15112.917802,E,62,12,9.9,-25.0,M,21.3,M,2.3,0042*6E\r\n",
+    // fix 2
+    "$GPGSA,A,1,,,,,,,,,,,,,,,,*32\r\n"
+    "$GPVTG,,T,,M,,N,,K,A*23\r\n"
+    "$GPDTM,P90,,0000.000000,S,00000.000001,E,1.003,W84*43\r\n"
+    "$GPRMC,120521.22,V,0060.000000,N,00000.000000,E,,,151020,,,A,V*37\r\n"
+    "$GPGNS,120521.22,0060.000000,N,00000.000000,E,NNNNNA,00,,0.0,-0.0,,,V*03\r\n"
+    "$GPGGA,120521.22,0060.000000,N,00000.000000,E,1,00,,0.0,M,-0.0,M,,*5C\r\n",
+    // blank report
+    "$GPGSA,A,1,,,,,,,,,,,,,,,,*32\r\n"
+    "$GPVTG,,T,,M,,N,,K,N*2C\r\n"
+    "$GPDTM,,,,,,,,*4A\r\n"
+    "$GPRMC,,V,,,,,,,,,,N,V*29\r\n"
+    "$GPGNS,,,,,,N,,,,,,,V*79\r\n"
+    "$GPGGA,,,,,,0,,,,,,,,*66\r\n",
+};
+static const int sGoldenIndexOfGGA[] = {7, 8, 5, -1};
+
+static const char* const sGoldenSv =
+    "$GPGSV,2,1,07,01,04,360,,03,08,345,20,07,11,331,21,08,15,317,22,1*67\r\n"
+    "$GPGSV,2,2,07,11,18,303,23,14,22,288,,44,36,231,28,1*53\r\n"
+    "$GPGSV,1,1,02,03,25,274,25,08,29,260,26,8*6E\r\n"
+    "$GPGSV,1,1,01,14,32,246,27,6*53\r\n"
+    "$GLGSV,1,1,03,65,39,217,,72,43,203,30,,46,189,31,1*46\r\n"
+    "$GLGSV,1,1,01,72,50,174,32,3*48\r\n"
+    "$GAGSV,1,1,02,01,53,160,33,05,57,146,,7*75\r\n"
+    "$GAGSV,1,1,01,05,60,132,35,1*41\r\n"
+    "$GAGSV,1,1,01,36,64,117,36,2*42\r\n"
+    "$GQGSV,1,1,01,01,67,103,37,1*52\r\n"
+    "$GQGSV,1,1,01,01,71,089,38,8*50\r\n"
+    "$GBGSV,1,1,02,01,74,075,,06,78,060,40,1*7F\r\n"
+    "$GBGSV,1,1,01,30,81,046,41,3*48\r\n"
+    "$GBGSV,1,1,01,30,85,032,42,5*4A\r\n"
+    "$GIGSV,1,1,01,02,88,018,43,1*40\r\n";
+
+// counts the sentences of out that differ from the golden text, which has
+// the same sentences back to back
+static uint32_t loc_nmea_compare(const LocNmeaOutput& out, const char* golden)
+{
+    uint32_t numBad = 0;
+    uint32_t i = 0;
+    while ('\0' != *golden || i < out.getNumSentences()) {
+        const char* end = strstr(golden, "\r\n");
+        size_t length = (nullptr == end) ? strlen(golden) : end + 2 - golden;
+        if (i >= out.getNumSentences() || length != out.getSentenceLength(i) ||
+            0 != memcmp(golden, out.getSentence(i), length)) {
+            LOC_LOGe("sentence %u: expected %.*s", i, (int)length, golden);
+            numBad++;
+        }
+        golden += length;
+        i++;
+    }
+    if (strlen(out.getNmea()) != out.getLength()) {
+        numBad++;
+    }
+    return numBad;
+}
+
+uint32_t loc_nmea_check_golden()
+{
+    static char buf[LOC_NMEA_OUTPUT_SIZE];
+    LocNmeaOutput out(buf, sizeof(buf));
+    LocationSystemInfo systemInfo = {};
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    uint32_t numBad = 0;
+
+    for (uint32_t i = 0; i < sizeof(sGoldenPos) / sizeof(sGoldenPos[0]); i++) {
+        bool blank = (i == 3);
+        loc_nmea_test_fix(blank ? 0 : i, location, locationExtended);
+        loc_nmea_generate_pos(location, locationExtended, systemInfo, !blank, i == 1, out,
+                              i == 1);
+        numBad += loc_nmea_compare(out, sGoldenPos[i]);
+        if (out.getIndexOfGGA() != sGoldenIndexOfGGA[i]) {
+            numBad++;
+        }
+    }
+
+    GnssSvNotification svNotify;
+    loc_nmea_test_sv(svNotify);
+    loc_nmea_generate_sv(svNotify, out);
+    numBad += loc_nmea_compare(out, sGoldenSv);
+
+    // a buffer too small for all sentences keeps the ones that fit
+    char small[100];
+    LocNmeaOutput smallOut(small, sizeof(small));
+    loc_nmea_generate_sv(svNotify, smallOut);
+    if (1 != smallOut.getNumSentences() || strlen(small) != smallOut.getLength()) {
+        numBad++;
+    }
+    return numBad;
+}
+
+uint32_t loc_nmea_check_format(uint32_t numValues)
+{
+    static const uint32_t sFormats[][2] = {{1, 0}, {3, 0}, {6, 9}, {0, 3}};
+    char buf[NMEA_SENTENCE_MAX_LENGTH];
+    char expected[64];
+    uint32_t numBad = 0;
+    uint64_t seed = 1;
+
+    for (uint32_t i = 0; i < numValues; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        double value = (double)(int64_t)(seed >> 11) / (1ULL << 40);
+        switch (i % 4) {
+        case 1:
+            // decimal ties, which are not ties in binary
+            value = floor(value * 1000.0) / 1000.0 + 0.0005;
+            break;
+        case 2:
+            // fields that are floats
+            value = (float)value;
+            break;
+        case 3:
+            value = fmod(fabs(value) * 60.0, 60.0);
+            break;
+        }
+        for (const uint32_t* format : sFormats) {
+            LocNmeaOutput out(buf, sizeof(buf));
+            LocNmeaSentence s(out);
+            s.putFixed(value, format[0], format[1]);
+            s.put('\0');
+            snprintf(expected, sizeof(expected), "%0*.*f", format[1], format[0], value);
+            if (0 != strcmp(buf, expected)) {
+                LOC_LOGe("%.17g: %s instead of %s", value, buf, expected);
+                numBad++;
+            }
+        }
+    }
+    return numBad;
+}
+
+void loc_nmea_benchmark(uint32_t rounds, uint64_t& posNs, uint64_t& svNs)
+{
+    static char buf[LOC_NMEA_OUTPUT_SIZE];
+    LocNmeaOutput out(buf, sizeof(buf));
+    LocationSystemInfo systemInfo = {};
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    GnssSvNotification svNotify;
+    loc_nmea_test_fix(0, location, locationExtended);
+    loc_nmea_test_sv(svNotify);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t r = 0; r < rounds; r++) {
+        loc_nmea_generate_pos(location, locationExtended, systemInfo, 1, false, out, false);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    posNs = (0 == rounds) ? 0 : ((end.tv_sec - start.tv_sec) * 1000000000ULL +
+            end.tv_nsec - start.tv_nsec) / rounds;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t r = 0; r < rounds; r++) {
+        loc_nmea_generate_sv(svNotify, out);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    svNs = (0 == rounds) ? 0 : ((end.tv_sec - start.tv_sec) * 1000000000ULL +
+            end.tv_nsec - start.tv_nsec) / rounds;
+}
+#endif
@@ -72,18 +72,83 @@ typedef struct {
     double     Z;
 } LocEcef;
 
+/** most sentences one loc_nmea_generate_pos / loc_nmea_generate_sv call
+    produces: a GSV per 4 of GNSS_SV_MAX SVs plus one per signal */
+#define LOC_NMEA_MAX_SENTENCES 64
+/** output buffer size that always holds all of them */
+#define LOC_NMEA_OUTPUT_SIZE   (LOC_NMEA_MAX_SENTENCES * NMEA_SENTENCE_MAX_LENGTH)
+
+/** Where a sentence is in a LocNmeaOutput */
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} LocNmeaSpan;
+
+class LocNmeaSentence;
+
+/** Caller provided buffer the NMEA generators write into. The sentences
+    are back to back, each ending in "\r\n", and the whole is NUL
+    terminated, so it can be reported as is. A sentence that does not fit
+    is dropped. */
+class LocNmeaOutput {
+public:
+    inline LocNmeaOutput(char* buf, uint32_t size) : mBuf(buf), mSize(size) { reset(); }
+
+    inline void reset() {
+        mLength = 0;
+        mNumSpans = 0;
+        mIndexOfGGA = -1;
+        if (mSize > 0) {
+            mBuf[0] = '\0';
+        }
+    }
+
+    inline const char* getNmea() const { return mBuf; }
+    inline uint32_t getLength() const { return mLength; }
+    inline uint32_t getNumSentences() const { return mNumSpans; }
+    inline const char* getSentence(uint32_t index) const {
+        return mBuf + mSpans[index].offset;
+    }
+    inline uint32_t getSentenceLength(uint32_t index) const { return mSpans[index].length; }
+    // sentence index of the GGA, -1 if there is none
+    inline int getIndexOfGGA() const { return mIndexOfGGA; }
+    inline void setIndexOfGGA(int index) { mIndexOfGGA = index; }
+
+    // appends a copy of the sentence at index
+    bool repeatSentence(uint32_t index);
+
+private:
+    friend class LocNmeaSentence;
+    char* mBuf;
+    uint32_t mSize;
+    uint32_t mLength;
+    LocNmeaSpan mSpans[LOC_NMEA_MAX_SENTENCES];
+    uint32_t mNumSpans;
+    int mIndexOfGGA;
+};
+
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr);
+                              LocNmeaOutput &out);
 
 void loc_nmea_generate_pos(const UlpLocation &location,
                                const GpsLocationExtended &locationExtended,
                                const LocationSystemInfo &systemInfo,
                                unsigned char generate_nmea,
                                bool custom_gga_fix_quality,
-                               std::vector<std::string> &nmeaArraystr,
-                               int& indexOfGGA,
+                               LocNmeaOutput &out,
                                bool isTagBlockGroupingEnabled);
 
+#ifdef __LOC_UNIT_TEST__
+// generates a fixed set of fixes and SV reports, with DATUM_TYPE 0, and
+// returns the number of sentences that differ from the golden output
+uint32_t loc_nmea_check_golden();
+// formats random values both with the NMEA generators' number formatting
+// and with snprintf, returns the number of values formatted differently
+uint32_t loc_nmea_check_format(uint32_t numValues);
+// ns per loc_nmea_generate_pos and loc_nmea_generate_sv call
+void loc_nmea_benchmark(uint32_t rounds, uint64_t& posNs, uint64_t& svNs);
+#endif
+
 #define DEBUG_NMEA_MINSIZE 6
 #define DEBUG_NMEA_MAXSIZE 4096
 inline bool loc_nmea_is_debug(const char* nmea, int length) {
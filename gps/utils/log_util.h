@@ -125,6 +125,10 @@ extern const char EXIT_ERROR_TAG[];
 #define BUILD_TYPE_PROP_INVALID 3
 extern int build_type_prop;
 
+/* bumped each time DEBUG_LEVEL or a tag override changes, so that every
+   source file re-reads the log level of its tag */
+extern int loc_log_level_gen;
+
 /*=============================================================================
  *
  *                        MODULE EXPORTED FUNCTIONS
@@ -154,6 +158,8 @@ inline void loc_logger_init(unsigned long debug, unsigned long timestamp)
      }
 
     loc_logger.TIMESTAMP = timestamp;
+    // tags without an override follow DEBUG_LEVEL
+    __atomic_add_fetch(&loc_log_level_gen, 1, __ATOMIC_RELEASE);
 }
 
 inline void log_buffer_init(bool enabled) {
@@ -161,8 +167,13 @@ inline void log_buffer_init(bool enabled) {
 }
 extern void log_tag_level_map_init();
 extern int get_tag_log_level(const char* tag);
+/* overrides the log level of tag at runtime, level < 0 removes the override.
+   Returns 0 on success, -1 if the override table is full. */
+extern int loc_set_tag_log_level(const char* tag, int level);
 extern char* get_timestamp(char* str, unsigned long buf_size);
 extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
+extern void log_buffer_insert_format(int level, const char* tag, const char* format, ...)
+        __attribute__((format(printf, 3, 4)));
 /*=============================================================================
  *
  *                          LOGGING BUFFER MACROS
@@ -174,16 +185,13 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 #define TOTAL_LOG_LEVELS 5
 #define LOGGING_BUFFER_MAX_LEN 1024
 #define IF_LOG_BUFFER_ENABLE if (loc_logger.LOG_BUFFER_ENABLE)
+/* format, a string literal, is kept with the raw args and only formatted
+   when the buffer is dumped */
 #define INSERT_BUFFER(flag, level, format, x...)                                              \
 {                                                                                             \
     IF_LOG_BUFFER_ENABLE {                                                                    \
         if (flag == 0) {                                                                      \
-            char timestr[32];                                                                 \
-            get_timestamp(timestr, sizeof(timestr));                                          \
-            char log_str[LOGGING_BUFFER_MAX_LEN];                                             \
-            snprintf(log_str, LOGGING_BUFFER_MAX_LEN, "%s %d %ld %s :" format "\n",           \
-                    timestr, getpid(), syscall(SYS_gettid), LOG_TAG==NULL ? "": LOG_TAG, ##x);\
-            log_buffer_insert(log_str, sizeof(log_str), level);                               \
+            log_buffer_insert_format(level, LOG_TAG, format, ##x);                            \
         }                                                                                     \
     }                                                                                         \
 }
@@ -199,18 +207,43 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 
 /* Tag based logging control MACROS */
 /* The logic is like this:
- * 1, LOCAL_LOG_LEVEL is defined as a static variable in log_util.h,
- *    then all source files which includes log_util.h will have its own LOCAL_LOG_LEVEL variable;
+ * 1, LOCAL_LOG_LEVEL and LOCAL_LOG_GEN are defined as static variables in log_util.h,
+ *    then all source files which includes log_util.h will have their own copies;
  * 2, For each source file,
- *    2.1, First time when LOC_LOG* is invoked(its LOCAL_LOG_LEVEL == -1),
- *         Set the tag based log level according to the <tag, level> map;
- *         If this tag isn't found in map, set local debug level as global loc_logger.DEBUG_LEVEL;
- *    2.2, If not the first time, use its LOCAL_LOG_LEVEL as the debug level of this tag.
+ *    2.1, When LOC_LOG* is invoked and LOCAL_LOG_GEN differs from loc_log_level_gen
+ *         (first call, or DEBUG_LEVEL / a tag override changed since), set the tag
+ *         based log level from the lock-free <tag, level> table, falling back to
+ *         the global loc_logger.DEBUG_LEVEL if this tag has no entry;
+ *    2.2, Otherwise use its LOCAL_LOG_LEVEL as the debug level of this tag.
+ * 3, Calls above LOC_LOG_COMPILED_LEVEL fail a constant test and are removed
+ *    by the compiler, arguments included.
 */
+#ifndef LOC_LOG_COMPILED_LEVEL
+#define LOC_LOG_COMPILED_LEVEL 5
+#endif
 static int LOCAL_LOG_LEVEL = -1;
-#define IF_LOC_LOG(x) \
-    if (((LOCAL_LOG_LEVEL == -1 && (LOCAL_LOG_LEVEL = get_tag_log_level(LOG_TAG)) >= x) ||\
-            LOCAL_LOG_LEVEL >= x) && LOCAL_LOG_LEVEL <= 5)
+static int LOCAL_LOG_GEN = -1;
+static inline int loc_log_refresh_level(int* level, int* gen, const char* tag)
+{
+    int curGen = __atomic_load_n(&loc_log_level_gen, __ATOMIC_ACQUIRE);
+    *level = get_tag_log_level(tag);
+    *gen = curGen;
+    return *level;
+}
+static inline bool loc_log_level_allows(int level, int x)
+{
+    return level >= x && level <= 5;
+}
+#define LOC_LOG_LOCAL_LEVEL()                                                       \
+    (LOCAL_LOG_GEN == __atomic_load_n(&loc_log_level_gen, __ATOMIC_RELAXED) ?       \
+            LOCAL_LOG_LEVEL :                                                       \
+            loc_log_refresh_level(&LOCAL_LOG_LEVEL, &LOCAL_LOG_GEN, LOG_TAG))
+/* true if a LOC_LOG call of level x would log; constant false when x is
+   compiled out. Work that only builds log arguments goes in an
+   IF_LOC_LOGx { } block so that it is skipped or removed with the call. */
+#define LOC_LOG_ENABLED(x) \
+    ((x) <= LOC_LOG_COMPILED_LEVEL && loc_log_level_allows(LOC_LOG_LOCAL_LEVEL(), (x)))
+#define IF_LOC_LOG(x) if (LOC_LOG_ENABLED(x))
 
 #define IF_LOC_LOGE IF_LOC_LOG(1)
 #define IF_LOC_LOGW IF_LOC_LOG(2)
@@ -258,6 +291,7 @@ static int LOCAL_LOG_LEVEL = -1;
 #define LOC_LOGd(fmt,...) LOC_LOGD(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
 #define LOC_LOGe(fmt,...) LOC_LOGE(LOC_LOG_HEAD(fmt), __FUNCTION__, __LINE__, ##__VA_ARGS__)
 
+
 #define LOG_I(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGI, ID, WHAT, SPEC, VAL)
 #define LOG_V(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGV, ID, WHAT, SPEC, VAL)
 #define LOG_E(ID, WHAT, SPEC, VAL) LOG_(LOC_LOGE, ID, WHAT, SPEC, VAL)
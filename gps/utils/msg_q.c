@@ -296,7 +296,7 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
    }
 
    if (linked_list_empty(p_msg_q->msg_list)) {
-      LOC_LOGW("%s: list is empty !!\n", __FUNCTION__);
+      LOC_LOGV("%s: list is empty !!\n", __FUNCTION__);
       pthread_mutex_unlock(&p_msg_q->list_mutex);
       return eLINKED_LIST_EMPTY;
    }
@@ -0,0 +1,115 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_UtilsTest"
+
+// Runs the __LOC_UNIT_TEST__ self checks of libgps.utils. Exits non-zero
+// if any of them fails.
+
+#define LOC_UNIT_TEST_COUNT_ALLOCS
+#include <LocUnitTest.h>
+#include <LocHeap.h>
+#include <LocMsgQueue.h>
+#include <LocMsgPool.h>
+#include <LocIpc.h>
+#include <LocTimerQueue.h>
+#include <loc_nmea.h>
+
+// where the LocIpc checks put their sockets
+#ifdef _ANDROID_
+#define LOC_UTILS_TEST_DIR "/data/local/tmp/"
+#else
+#define LOC_UTILS_TEST_DIR "/tmp/"
+#endif
+
+using namespace loc_util;
+
+int main(int argc, char** argv) {
+    LocUnitTest test(argc, argv);
+    test.report("LocHeap random ops", locHeapRandomTest(200000, 1));
+    test.report("LocMsgQueue legacy order",
+                LocMsgQueue::checkOrder(LOC_MSG_QUEUE_LEGACY, 4, 100000));
+    test.report("LocMsgQueue ring order",
+                LocMsgQueue::checkOrder(LOC_MSG_QUEUE_RING, 4, 100000));
+    test.report("LocMsgPool steady state allocs",
+                locMsgPoolCountSteadyStateAllocs(10000, locUnitTestAllocCount));
+    test.report("MsgTask in-order dispatch", locMsgTaskCheckInOrder(1000));
+    test.report("LocTimerQueue heap expiry",
+                LocTimerQueue::checkExpiry(LOC_TIMER_QUEUE_HEAP, 1000, 1000000));
+    test.report("LocTimerQueue wheel expiry",
+                LocTimerQueue::checkExpiry(LOC_TIMER_QUEUE_WHEEL, 1000, 1000000));
+    test.report("NMEA golden output", loc_nmea_check_golden());
+    test.report("NMEA number format", loc_nmea_check_format(100000));
+    test.report("LocIpc socket order",
+                LocIpc::checkLocal(LOC_UTILS_TEST_DIR "loc_utils_test_sock", false, 100));
+    test.report("LocIpc shm order",
+                LocIpc::checkLocal(LOC_UTILS_TEST_DIR "loc_utils_test_shm", true, 100));
+
+    if (test.runBenchmarks()) {
+        static const uint32_t producerCounts[] = {1, 4, 8};
+        for (uint32_t numProducers : producerCounts) {
+            uint64_t legacySendNs = 0, legacyLatencyNs = 0, ringSendNs = 0, ringLatencyNs = 0;
+            LocMsgQueue::benchmark(LOC_MSG_QUEUE_LEGACY, numProducers, 100000,
+                                   legacySendNs, legacyLatencyNs);
+            LocMsgQueue::benchmark(LOC_MSG_QUEUE_RING, numProducers, 100000,
+                                   ringSendNs, ringLatencyNs);
+            printf("LocMsgQueue %u producers: send %" PRIu64 " / %" PRIu64 " ns, "
+                   "latency %" PRIu64 " / %" PRIu64 " ns (legacy / ring)\n",
+                   numProducers, legacySendNs, ringSendNs, legacyLatencyNs, ringLatencyNs);
+        }
+
+        static const uint32_t msgSizes[] = {64, 4096, 60000};
+        const uint32_t numMsgs = 10000;
+        for (uint32_t msgSize : msgSizes) {
+            uint64_t sockCpuNs = 0, sockWallNs = 0, shmCpuNs = 0, shmWallNs = 0;
+            LocIpc::benchmarkLocal(LOC_UTILS_TEST_DIR "loc_utils_test_sock", false, msgSize,
+                                   numMsgs, sockCpuNs, sockWallNs);
+            LocIpc::benchmarkLocal(LOC_UTILS_TEST_DIR "loc_utils_test_shm", true, msgSize,
+                                   numMsgs, shmCpuNs, shmWallNs);
+            printf("LocIpc %u byte msgs: cpu %" PRIu64 " / %" PRIu64 " ns, "
+                   "wall %" PRIu64 " / %" PRIu64 " ns per msg (socket / shm)\n",
+                   msgSize, sockCpuNs / numMsgs, shmCpuNs / numMsgs,
+                   sockWallNs / numMsgs, shmWallNs / numMsgs);
+        }
+
+        uint64_t heapOpNs = 0, heapRearms = 0, wheelOpNs = 0, wheelRearms = 0;
+        LocTimerQueue::benchmark(LOC_TIMER_QUEUE_HEAP, 10000, 1000000, heapOpNs, heapRearms);
+        LocTimerQueue::benchmark(LOC_TIMER_QUEUE_WHEEL, 10000, 1000000, wheelOpNs, wheelRearms);
+        printf("LocTimerQueue 10000 timers: %" PRIu64 " / %" PRIu64 " ns per op, "
+               "%" PRIu64 " / %" PRIu64 " timerfd rearms (heap / wheel)\n",
+               heapOpNs, wheelOpNs, heapRearms, wheelRearms);
+
+        uint64_t posNs = 0, svNs = 0;
+        loc_nmea_benchmark(100000, posNs, svNs);
+        printf("NMEA generation: pos %" PRIu64 " ns, sv %" PRIu64 " ns per report\n",
+               posNs, svNs);
+    }
+
+    return test.finish();
+}
@@ -2527,6 +2527,18 @@ public:
         False otherwise. <br/>  */
     void updateNetworkAvailability(bool available);
 
+    /** @brief Have GnssSvCb and GnssMeasurementsCb reports sent by
+               the location hal daemon as changes from the report
+               before, with a full report at least every 10 reports,
+               which takes less IPC bandwidth. <br/>
+               C/N0, SNR, AGC, elevation and azimuth values are then
+               given to a resolution of 0.01. After a report lost to
+               a busy client, reports resume at the next full one.
+        @param enable
+        True to have reports sent as changes. <br/>
+        False to have every report sent in full, the default. <br/>  */
+    void setDeltaEncodedReports(bool enable);
+
     /** @brief Get energy consumed info of modem GNSS engine. <br/>
         If called while the previous call is still being processed,
         then the callback will be updated, and engery consumed info
@@ -477,6 +477,12 @@ void LocationClientApi::updateNetworkAvailability(bool available) {
     }
 }
 
+void LocationClientApi::setDeltaEncodedReports(bool enable) {
+    if (mApiImpl) {
+        mApiImpl->setDeltaEncodedReports(enable);
+    }
+}
+
 void LocationClientApi::getGnssEnergyConsumed(
         GnssEnergyConsumedCb gnssEnergyConsumedCallback,
         ResponseCb responseCallback) {
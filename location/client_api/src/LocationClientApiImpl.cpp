@@ -1121,6 +1121,7 @@ LocationClientApiImpl::LocationClientApiImpl(CapabilitiesCb capabitiescb) :
         mBatchingId(LOCATION_CLIENT_SESSION_ID_INVALID),
         mHalRegistered(false),
         mCallbacksMask(0),
+        mDeltaReports(false),
         mCapsMask((LocationCapabilitiesMask)0),
         mYearOfHw(0),
         mLastAddedClientIds({}),
@@ -1347,6 +1348,10 @@ void LocationClientApiImpl::updateCallbacks(LocationCallbacks& callbacks) {
             if (mCallBacks.gnssMeasurementsCb) {
                 callBacksMask |= E_LOC_CB_GNSS_MEAS_BIT;
             }
+            if (mApiImpl->mDeltaReports &&
+                    (callBacksMask & (E_LOC_CB_GNSS_SV_BIT | E_LOC_CB_GNSS_MEAS_BIT))) {
+                callBacksMask |= E_LOC_CB_DELTA_ENCODING_BIT;
+            }
             // handle callbacks that are not related to a fix session
             if (mApiImpl->mLocationSysInfoCb) {
                 callBacksMask |= E_LOC_CB_SYSTEM_INFO_BIT;
@@ -1911,6 +1916,47 @@ void LocationClientApiImpl::updateNetworkAvailability(bool available) {
     mMsgTask.sendMsg(new (nothrow) UpdateNetworkAvailabilityReq(this, available));
 }
 
+void LocationClientApiImpl::setDeltaEncodedReports(bool enable) {
+
+    struct SetDeltaEncodedReportsReq : public LocMsg {
+        SetDeltaEncodedReportsReq(LocationClientApiImpl* apiImpl, bool enable) :
+                mApiImpl(apiImpl), mEnable(enable) {}
+        virtual ~SetDeltaEncodedReportsReq() {}
+        void proc() const {
+            mApiImpl->mDeltaReports = mEnable;
+            LocationCallbacksMask callBacksMask =
+                    mApiImpl->mCallbacksMask & ~E_LOC_CB_DELTA_ENCODING_BIT;
+            if (mEnable &&
+                    (callBacksMask & (E_LOC_CB_GNSS_SV_BIT | E_LOC_CB_GNSS_MEAS_BIT))) {
+                callBacksMask |= E_LOC_CB_DELTA_ENCODING_BIT;
+            }
+
+            // update callback only when changed
+            if (mApiImpl->mCallbacksMask != callBacksMask) {
+                mApiImpl->mCallbacksMask = callBacksMask;
+                if (mApiImpl->mHalRegistered) {
+                    string pbStr;
+                    LocAPIUpdateCallbacksReqMsg msg(mApiImpl->mSocketName,
+                                                    mApiImpl->mCallbacksMask,
+                                                    &mApiImpl->mPbufMsgConv);
+                    if (msg.serializeToProtobuf(pbStr)) {
+                        bool rc = mApiImpl->sendMessage(
+                                reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()),
+                                pbStr.size());
+                        LOC_LOGd(">>> SetDeltaEncodedReportsReq callBacksMask=0x%x rc=%d",
+                                 mApiImpl->mCallbacksMask, rc);
+                    } else {
+                        LOC_LOGe("LocAPIUpdateCallbacksReqMsg serializeToProtobuf failed");
+                    }
+                }
+            }
+        }
+        LocationClientApiImpl* mApiImpl;
+        const bool mEnable;
+    };
+    mMsgTask.sendMsg(new (nothrow) SetDeltaEncodedReportsReq(this, enable));
+}
+
 void LocationClientApiImpl::getGnssEnergyConsumed(
         GnssEnergyConsumedCb gnssEnergyConsumedCallback,
         ResponseCb responseCallback) {
@@ -2196,11 +2242,16 @@ LocationClientApiImpl -ILocIpcListener
 ******************************************************************************/
 void IpcListener::onListenerReady() {
     struct ClientRegisterReq : public LocMsg {
-        ClientRegisterReq(LocationClientApiImpl& apiImpl) : mApiImpl(apiImpl) {}
+        ClientRegisterReq(LocationClientApiImpl& apiImpl, bool shmCapable) :
+                mApiImpl(apiImpl), mShmCapable(shmCapable) {}
         void proc() const {
             string pbStr;
+            // the daemon may have been restarted as an older one, so stay on v1
+            // until it answers in v2
+            mApiImpl.mPbufMsgConv.setWireVersion(LOCAPI_MSG_WIRE_V1);
+            mApiImpl.mPbufMsgConv.setClientHandle(0);
             LocAPIClientRegisterReqMsg msg(mApiImpl.mSocketName, LOCATION_CLIENT_API,
-                    &mApiImpl.mPbufMsgConv);
+                    &mApiImpl.mPbufMsgConv, mShmCapable, LOCAPI_MSG_WIRE_VERSION);
             if (msg.serializeToProtobuf(pbStr)) {
                 mApiImpl.sendMessage(
                         reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()), pbStr.size());
@@ -2209,13 +2260,15 @@ void IpcListener::onListenerReady() {
             }
         }
         LocationClientApiImpl& mApiImpl;
+        bool mShmCapable;
     };
     if (SockNode::Local == mSockTpye) {
         if (0 != chown(mApiImpl.mSocketName, getuid(), GID_LOCCLIENT)) {
             LOC_LOGe("chown to group locclient failed %s", strerror(errno));
         }
     }
-    mMsgTask.sendMsg(new (nothrow) ClientRegisterReq(mApiImpl));
+    // the local recver takes up a shared memory ring offered by the daemon
+    mMsgTask.sendMsg(new (nothrow) ClientRegisterReq(mApiImpl, SockNode::Local == mSockTpye));
 }
 
 void IpcListener::onReceive(const char* data, uint32_t length,
@@ -2229,38 +2282,51 @@ void IpcListener::onReceive(const char* data, uint32_t length,
         void proc() const {
             // Protobuff Encoding enabled, so we need to convert the message from proto
             // encoded format to local structure
-            PBLocAPIMsgHeader pbLocApiMsg;
-            if (0 == pbLocApiMsg.ParseFromString(mMsgData)) {
+            LocAPIMsgView pbLocApiMsg;
+            if (!pbLocApiMsg.parse(mMsgData.data(), mMsgData.length())) {
                 LOC_LOGe("Failed to parse pbLocApiMsg from input stream!! length: %u",
                         mMsgData.length());
                 return;
             }
 
-            ELocMsgID eLocMsgid = mApiImpl.mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgid());
-            string sockName = pbLocApiMsg.msocketname();
-            uint32_t msgVer = pbLocApiMsg.msgversion();
-            uint32_t payloadSize = pbLocApiMsg.payloadsize();
-            // pbLocApiMsg.payload() contains the payload data.
+            ELocMsgID eLocMsgid = mApiImpl.mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgId);
+            const char* sockName = pbLocApiMsg.sockName;
+            uint32_t msgVer = pbLocApiMsg.msgVersion;
+            uint32_t payloadSize = pbLocApiMsg.payloadSize;
+            // pbLocApiMsg.payload points to the payload data.
 
             LOC_LOGi(">-- onReceive Rcvd msg id: %d, sockname: %s, payload size: %d", eLocMsgid,
-                    sockName.c_str(), payloadSize);
-            LocAPIMsgHeader locApiMsg(sockName.c_str(), eLocMsgid);
+                    sockName, payloadSize);
+            LocAPIMsgHeader locApiMsg(sockName, eLocMsgid);
 
             // throw away message that does not come from location hal daemon
             if (false == locApiMsg.isValidServerMsg(payloadSize)) {
                 return;
             }
 
+            // the daemon sends v2 once it has our registration, so it takes v2 too
+            if (LOCAPI_MSG_WIRE_V2 == pbLocApiMsg.wireVersion) {
+                mApiImpl.mPbufMsgConv.setWireVersion(LOCAPI_MSG_WIRE_V2);
+                // and the handle it knows us by, for our msgs to carry, from
+                // its answer to our registration. Indications may be shared
+                // by all clients and carry none.
+                if (E_LOCAPI_CAPABILILTIES_MSG_ID == locApiMsg.msgId &&
+                        0 != pbLocApiMsg.clientHandle) {
+                    mApiImpl.mPbufMsgConv.setClientHandle(pbLocApiMsg.clientHandle);
+                }
+            }
+
             switch (locApiMsg.msgId) {
             case E_LOCAPI_CAPABILILTIES_MSG_ID:
             {
                 LOC_LOGd("<<< capabilities indication");
-                PBLocAPICapabilitiesIndMsg pbLocApiCapIndMsg;
-                if (0 == pbLocApiCapIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocAPICapabilitiesIndMsg& pbLocApiCapIndMsg =
+                        pbLocApiMsg.createPbMsg<PBLocAPICapabilitiesIndMsg>();
+                if (!pbLocApiMsg.parsePayload(pbLocApiCapIndMsg)) {
                     LOC_LOGe("Failed to parse pbLocApiCapIndMsg from payload!!");
                     return;
                 }
-                LocAPICapabilitiesIndMsg msg(sockName.c_str(), pbLocApiCapIndMsg,
+                LocAPICapabilitiesIndMsg msg(sockName, pbLocApiCapIndMsg,
                         &mApiImpl.mPbufMsgConv);
                 mApiImpl.capabilitesCallback(locApiMsg.msgId, (void*)&msg);
                 break;
@@ -2286,13 +2352,14 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID:
             {
                 LOC_LOGd("<<< response message %d\n", locApiMsg.msgId);
-                PBLocAPIGenericRespMsg pbLocApiGenericRsp;
-                if (0 == pbLocApiGenericRsp.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocAPIGenericRespMsg& pbLocApiGenericRsp =
+                        pbLocApiMsg.createPbMsg<PBLocAPIGenericRespMsg>();
+                if (!pbLocApiMsg.parsePayload(pbLocApiGenericRsp)) {
                     LOC_LOGe("Failed to parse pbLocApiGenericRsp from payload!!");
                     return;
                 }
                 if (locApiMsg.msgId != E_LOCAPI_STOP_TRACKING_MSG_ID) {
-                    LocAPIGenericRespMsg respMsg(sockName.c_str(), eLocMsgid, pbLocApiGenericRsp,
+                    LocAPIGenericRespMsg respMsg(sockName, eLocMsgid, pbLocApiGenericRsp,
                             &mApiImpl.mPbufMsgConv);
                     LocationResponse response = parseLocationError(respMsg.err);
                     mApiImpl.invokePositionSessionResponseCb(response);
@@ -2307,12 +2374,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_RESUME_GEOFENCES_MSG_ID:
             {
                 LOC_LOGd("<<< collective response message, msgId = %d", locApiMsg.msgId);
-                PBLocAPICollectiveRespMsg pbLocApiCollctvRespMsg;
-                if (0 == pbLocApiCollctvRespMsg.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocAPICollectiveRespMsg& pbLocApiCollctvRespMsg =
+                        pbLocApiMsg.createPbMsg<PBLocAPICollectiveRespMsg>();
+                if (!pbLocApiMsg.parsePayload(pbLocApiCollctvRespMsg)) {
                     LOC_LOGe("Failed to parse pbLocApiCollctvRespMsg from payload!!");
                     return;
                 }
-                LocAPICollectiveRespMsg msg(sockName.c_str(), eLocMsgid, pbLocApiCollctvRespMsg,
+                LocAPICollectiveRespMsg msg(sockName, eLocMsgid, pbLocApiCollctvRespMsg,
                         &mApiImpl.mPbufMsgConv);
                 const LocAPICollectiveRespMsg* pRespMsg = (LocAPICollectiveRespMsg*)(&msg);
                 std::vector<pair<Geofence, LocationResponse>> responses{};
@@ -2339,12 +2407,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_LOCATION_MSG_ID:
             {
                 LOC_LOGd("<<< message = location");
-                PBLocAPILocationIndMsg pbLocApiLocIndMsg;
-                if (0 == pbLocApiLocIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocAPILocationIndMsg& pbLocApiLocIndMsg =
+                        pbLocApiMsg.createPbMsg<PBLocAPILocationIndMsg>();
+                if (!pbLocApiMsg.parsePayload(pbLocApiLocIndMsg)) {
                     LOC_LOGe("Failed to parse pbLocApiLocIndMsg from payload!!");
                     return;
                 }
-                LocAPILocationIndMsg msg(sockName.c_str(), pbLocApiLocIndMsg,
+                LocAPILocationIndMsg msg(sockName, pbLocApiLocIndMsg,
                         &mApiImpl.mPbufMsgConv);
                 LocationCallbacksMask tempMask =
                         (E_LOC_CB_DISTANCE_BASED_TRACKING_BIT | E_LOC_CB_SIMPLE_LOCATION_INFO_BIT);
@@ -2380,12 +2449,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = batching");
                 if (mApiImpl.mCallbacksMask & E_LOC_CB_BATCHING_BIT) {
-                    PBLocAPIBatchingIndMsg pbLocApiBatchIndMsg;
-                    if (0 == pbLocApiBatchIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPIBatchingIndMsg& pbLocApiBatchIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPIBatchingIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiBatchIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiBatchIndMsg from payload!!");
                         return;
                     }
-                    LocAPIBatchingIndMsg msg(sockName.c_str(), pbLocApiBatchIndMsg,
+                    LocAPIBatchingIndMsg msg(sockName, pbLocApiBatchIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPIBatchingIndMsg* pBatchingIndMsg =
                             (LocAPIBatchingIndMsg*)(&msg);
@@ -2418,12 +2488,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = geofence breach");
                 if (mApiImpl.mCallbacksMask & E_LOC_CB_GEOFENCE_BREACH_BIT) {
-                    PBLocAPIGeofenceBreachIndMsg pbLocApiGfBreachIndMsg;
-                    if (0 == pbLocApiGfBreachIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPIGeofenceBreachIndMsg& pbLocApiGfBreachIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPIGeofenceBreachIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiGfBreachIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiGfBreachIndMsg from payload!!");
                         return;
                     }
-                    LocAPIGeofenceBreachIndMsg msg(sockName.c_str(), pbLocApiGfBreachIndMsg,
+                    LocAPIGeofenceBreachIndMsg msg(sockName, pbLocApiGfBreachIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPIGeofenceBreachIndMsg* pGfBreachIndMsg =
                         (LocAPIGeofenceBreachIndMsg*)(&msg);
@@ -2450,12 +2521,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 LOC_LOGd("<<< message = location info");
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                         (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT)) {
-                    PBLocAPILocationInfoIndMsg pbLocApiLocInfoIndMsg;
-                    if (0 == pbLocApiLocInfoIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPILocationInfoIndMsg& pbLocApiLocInfoIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPILocationInfoIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiLocInfoIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiLocInfoIndMsg from payload!!");
                         return;
                     }
-                    LocAPILocationInfoIndMsg msg(sockName.c_str(), pbLocApiLocInfoIndMsg,
+                    LocAPILocationInfoIndMsg msg(sockName, pbLocApiLocInfoIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPILocationInfoIndMsg* pLocationInfoIndMsg =
                         (LocAPILocationInfoIndMsg*)(&msg);
@@ -2475,12 +2547,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
 
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                         (mApiImpl.mCallbacksMask & E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT)) {
-                    PBLocAPIEngineLocationsInfoIndMsg pbLocApiEngLocInfoIndMsg;
-                    if (0 == pbLocApiEngLocInfoIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPIEngineLocationsInfoIndMsg& pbLocApiEngLocInfoIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPIEngineLocationsInfoIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiEngLocInfoIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiEngLocInfoIndMsg from payload!!");
                         return;
                     }
-                    LocAPIEngineLocationsInfoIndMsg msg(sockName.c_str(),
+                    LocAPIEngineLocationsInfoIndMsg msg(sockName,
                             pbLocApiEngLocInfoIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPIEngineLocationsInfoIndMsg* pEngLocationsInfoIndMsg =
@@ -2510,12 +2583,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = sv");
                 if (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_SV_BIT) {
-                    PBLocAPISatelliteVehicleIndMsg pbLocApiSatVehIndMsg;
-                    if (0 == pbLocApiSatVehIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPISatelliteVehicleIndMsg& pbLocApiSatVehIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPISatelliteVehicleIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiSatVehIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiSatVehIndMsg from payload!!");
                         return;
                     }
-                    LocAPISatelliteVehicleIndMsg msg(sockName.c_str(), pbLocApiSatVehIndMsg,
+                    LocAPISatelliteVehicleIndMsg msg(sockName, pbLocApiSatVehIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPISatelliteVehicleIndMsg* pSvIndMsg =
                         (LocAPISatelliteVehicleIndMsg*)(&msg);
@@ -2533,18 +2607,48 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 break;
             }
 
+            case E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID:
+            {
+                LOC_LOGd("<<< message = sv delta");
+                if (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_SV_BIT) {
+                    PBLocAPISatelliteVehicleDeltaIndMsg& pbLocApiSvDeltaIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPISatelliteVehicleDeltaIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiSvDeltaIndMsg)) {
+                        LOC_LOGe("Failed to parse pbLocApiSvDeltaIndMsg from payload!!");
+                        return;
+                    }
+                    // nullptr until the next keyframe after a delta missed
+                    const GnssSvNotification* pSvNotification = mApiImpl.mSvDeltaConv.decode(
+                            pbLocApiSvDeltaIndMsg.gnsssvdeltanotification(),
+                            mApiImpl.mPbufMsgConv);
+                    if (nullptr == pSvNotification) {
+                        break;
+                    }
+                    std::vector<GnssSv> gnssSvsVector;
+                    for (uint32_t i = 0; i < pSvNotification->count; i++) {
+                        gnssSvsVector.push_back(parseGnssSv(pSvNotification->gnssSvs[i]));
+                    }
+                    if (mApiImpl.mGnssSvCb) {
+                        mApiImpl.mGnssSvCb(gnssSvsVector);
+                    }
+                    mApiImpl.mLogger.log(gnssSvsVector);
+                }
+                break;
+            }
+
             case E_LOCAPI_NMEA_MSG_ID:
             {
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                         (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_NMEA_BIT) &&
                          mApiImpl.mGnssNmeaCb) {
 
-                    PBLocAPINmeaIndMsg pbLocApiNmeaIndMsg;
-                    if (0 == pbLocApiNmeaIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPINmeaIndMsg& pbLocApiNmeaIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPINmeaIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiNmeaIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiNmeaIndMsg from payload!!");
                         return;
                     }
-                    LocAPINmeaIndMsg msg(sockName.c_str(), pbLocApiNmeaIndMsg,
+                    LocAPINmeaIndMsg msg(sockName, pbLocApiNmeaIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     // nmea is variable length, can not be checked
                     const LocAPINmeaIndMsg* pNmeaIndMsg = (LocAPINmeaIndMsg*)(&msg);
@@ -2567,12 +2671,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 LOC_LOGd("<<< message = data");
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                         (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_DATA_BIT)) {
-                    PBLocAPIDataIndMsg pbLocApiDataIndMsg;
-                    if (0 == pbLocApiDataIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPIDataIndMsg& pbLocApiDataIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPIDataIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiDataIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiDataIndMsg from payload!!");
                         return;
                     }
-                    LocAPIDataIndMsg msg(sockName.c_str(), pbLocApiDataIndMsg,
+                    LocAPIDataIndMsg msg(sockName, pbLocApiDataIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPIDataIndMsg* pDataIndMsg = (LocAPIDataIndMsg*)(&msg);
                     GnssData gnssData =
@@ -2590,12 +2695,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
                     (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_MEAS_BIT)) {
 
-                    PBLocAPIMeasIndMsg pbLocApiMeasIndMsg;
-                    if (0 == pbLocApiMeasIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPIMeasIndMsg& pbLocApiMeasIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPIMeasIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiMeasIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiMeasIndMsg from payload!!");
                         return;
                     }
-                    LocAPIMeasIndMsg msg(sockName.c_str(), pbLocApiMeasIndMsg,
+                    LocAPIMeasIndMsg msg(sockName, pbLocApiMeasIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPIMeasIndMsg* pMeasIndMsg = (LocAPIMeasIndMsg*)(&msg);
                     GnssMeasurements gnssMeasurements =
@@ -2608,15 +2714,46 @@ void IpcListener::onReceive(const char* data, uint32_t length,
                 break;
             }
 
+            case E_LOCAPI_MEAS_DELTA_MSG_ID:
+            {
+                LOC_LOGd("<<< message = measurements delta");
+                if ((mApiImpl.mSessionId != LOCATION_CLIENT_SESSION_ID_INVALID) &&
+                    (mApiImpl.mCallbacksMask & E_LOC_CB_GNSS_MEAS_BIT)) {
+
+                    PBLocAPIMeasDeltaIndMsg& pbLocApiMeasDeltaIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPIMeasDeltaIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiMeasDeltaIndMsg)) {
+                        LOC_LOGe("Failed to parse pbLocApiMeasDeltaIndMsg from payload!!");
+                        return;
+                    }
+                    // nullptr until the next keyframe after a delta missed
+                    const GnssMeasurementsNotification* pMeasNotification =
+                            mApiImpl.mMeasDeltaConv.decode(
+                            pbLocApiMeasDeltaIndMsg.gnssmeasurementsdeltanotification(),
+                            mApiImpl.mPbufMsgConv);
+                    if (nullptr == pMeasNotification) {
+                        break;
+                    }
+                    GnssMeasurements gnssMeasurements =
+                        parseGnssMeasurements(*pMeasNotification);
+                    if (mApiImpl.mGnssMeasurementsCb) {
+                        mApiImpl.mGnssMeasurementsCb(gnssMeasurements);
+                    }
+                    mApiImpl.mLogger.log(gnssMeasurements);
+                }
+                break;
+            }
+
             case E_LOCAPI_GET_GNSS_ENGERY_CONSUMED_MSG_ID:
             {
                 LOC_LOGd("<<< message = GNSS power consumption\n");
-                PBLocAPIGnssEnergyConsumedIndMsg pbLocApiGnssEnergyConsmdIndMsg;
-                if (0 == pbLocApiGnssEnergyConsmdIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocAPIGnssEnergyConsumedIndMsg& pbLocApiGnssEnergyConsmdIndMsg =
+                        pbLocApiMsg.createPbMsg<PBLocAPIGnssEnergyConsumedIndMsg>();
+                if (!pbLocApiMsg.parsePayload(pbLocApiGnssEnergyConsmdIndMsg)) {
                     LOC_LOGe("Failed to parse pbLocApiGnssEnergyConsmdIndMsg from payload!!");
                     return;
                 }
-                LocAPIGnssEnergyConsumedIndMsg msg(sockName.c_str(),
+                LocAPIGnssEnergyConsumedIndMsg msg(sockName,
                         pbLocApiGnssEnergyConsmdIndMsg,
                         &mApiImpl.mPbufMsgConv);
                 LocAPIGnssEnergyConsumedIndMsg* pEnergyMsg =
@@ -2643,12 +2780,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = location system info");
                 if (mApiImpl.mCallbacksMask & E_LOC_CB_SYSTEM_INFO_BIT) {
-                    PBLocAPILocationSystemInfoIndMsg pbLocApiLocSysInfoIndMsg;
-                    if (0 == pbLocApiLocSysInfoIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPILocationSystemInfoIndMsg& pbLocApiLocSysInfoIndMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPILocationSystemInfoIndMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbLocApiLocSysInfoIndMsg)) {
                         LOC_LOGe("Failed to parse pbLocApiLocSysInfoIndMsg from payload!!");
                         return;
                     }
-                    LocAPILocationSystemInfoIndMsg msg(sockName.c_str(), pbLocApiLocSysInfoIndMsg,
+                    LocAPILocationSystemInfoIndMsg msg(sockName, pbLocApiLocSysInfoIndMsg,
                             &mApiImpl.mPbufMsgConv);
                     const LocAPILocationSystemInfoIndMsg * pDataIndMsg =
                             (LocAPILocationSystemInfoIndMsg*)(&msg);
@@ -2665,13 +2803,14 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             {
                 LOC_LOGd("<<< message = terrestrial pos info");
                 if (mApiImpl.mSingleTerrestrialPosCb) {
-                    PBLocAPIGetSingleTerrestrialPosRespMsg pbMsg;
-                    if (0 == pbMsg.ParseFromString(pbLocApiMsg.payload())) {
+                    PBLocAPIGetSingleTerrestrialPosRespMsg& pbMsg =
+                            pbLocApiMsg.createPbMsg<PBLocAPIGetSingleTerrestrialPosRespMsg>();
+                    if (!pbLocApiMsg.parsePayload(pbMsg)) {
                         LOC_LOGe("Failed to parse PBLocAPIGetSingleTerrestrialPosRespMsg!!");
                         return;
                     }
 
-                    LocAPIGetSingleTerrestrialPosRespMsg msg(sockName.c_str(), pbMsg,
+                    LocAPIGetSingleTerrestrialPosRespMsg msg(sockName, pbMsg,
                                                              &mApiImpl.mPbufMsgConv);
                     if (mApiImpl.mSingleTerrestrialPosRespCb) {
                         mApiImpl.mSingleTerrestrialPosRespCb(parseLocationError(msg.mErrorCode));
@@ -2690,12 +2829,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_LOCAPI_PINGTEST_MSG_ID:
             {
                 LOC_LOGd("<<< ping message %d", locApiMsg.msgId);
-                PBLocAPIPingTestIndMsg pbLocApiPingTestIndMsg;
-                if (0 == pbLocApiPingTestIndMsg.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocAPIPingTestIndMsg& pbLocApiPingTestIndMsg =
+                        pbLocApiMsg.createPbMsg<PBLocAPIPingTestIndMsg>();
+                if (!pbLocApiMsg.parsePayload(pbLocApiPingTestIndMsg)) {
                     LOC_LOGe("Failed to parse pbLocApiPingTestIndMsg from payload!!");
                     return;
                 }
-                LocAPIPingTestIndMsg msg(sockName.c_str(), pbLocApiPingTestIndMsg,
+                LocAPIPingTestIndMsg msg(sockName, pbLocApiPingTestIndMsg,
                         &mApiImpl.mPbufMsgConv);
                 const LocAPIPingTestIndMsg* pIndMsg = (LocAPIPingTestIndMsg*)(&msg);
                 if (mApiImpl.mPingTestCb) {
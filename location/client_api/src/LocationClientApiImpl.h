@@ -39,6 +39,7 @@
 #include <MsgTask.h>
 #include <LocationApiMsg.h>
 #include <LocationApiPbMsgConv.h>
+#include <LocationApiDeltaConv.h>
 #include <LCAReportLoggerUtil.h>
 #ifdef NO_UNORDERED_SET_OR_MAP
     #include <set>
@@ -139,6 +140,7 @@ public:
 
     // other interface
     void updateNetworkAvailability(bool available);
+    void setDeltaEncodedReports(bool enable);
     void updateCallbackFunctions(const ClientCallbacks&,
                                  ReportCbEnumType reportCbType = REPORT_CB_TYPE_NONE);
     void getGnssEnergyConsumed(GnssEnergyConsumedCb gnssEnergyConsumedCallback,
@@ -190,6 +192,10 @@ private:
     // for client on a different processor, 0 is invalid
     uint32_t                   mInstanceId;
     LocationCallbacksMask      mCallbacksMask;
+    // SV and measurement reports asked for as deltas, decoded by these
+    bool                       mDeltaReports;
+    LocAPISvDeltaConv          mSvDeltaConv;
+    LocAPIMeasDeltaConv        mMeasDeltaConv;
     LocationOptions            mLocationOptions;
     BatchingOptions            mBatchingOptions;
     LocationCapabilitiesMask   mCapsMask;
@@ -337,28 +337,40 @@ void IpcListener::onReceive(const char* data, uint32_t length,
         void proc() const {
             // Protobuff Encoding enabled, so we need to convert the message from proto
             // encoded format to local structure
-            PBLocAPIMsgHeader pbLocApiMsg;
-            if (0 == pbLocApiMsg.ParseFromString(mMsgData)) {
+            LocAPIMsgView pbLocApiMsg;
+            if (!pbLocApiMsg.parse(mMsgData.data(), mMsgData.length())) {
                 LOC_LOGe("Failed to parse pbLocApiMsg from input stream!! length: %u",
                         mMsgData.length());
                 return;
             }
 
-            ELocMsgID eLocMsgid = mApiImpl.mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgid());
-            string sockName = pbLocApiMsg.msocketname();
-            uint32_t msgVer = pbLocApiMsg.msgversion();
-            uint32_t payloadSize = pbLocApiMsg.payloadsize();
-            // pbLocApiMsg.payload() contains the payload data.
+            ELocMsgID eLocMsgid = mApiImpl.mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgId);
+            const char* sockName = pbLocApiMsg.sockName;
+            uint32_t msgVer = pbLocApiMsg.msgVersion;
+            uint32_t payloadSize = pbLocApiMsg.payloadSize;
+            // pbLocApiMsg.payload points to the payload data.
 
             LOC_LOGi(">-- onReceive Rcvd msg id: %d, sockname: %s, payload size: %d", eLocMsgid,
-                    sockName.c_str(), payloadSize);
-            LocAPIMsgHeader locApiMsg(sockName.c_str(), eLocMsgid);
+                    sockName, payloadSize);
+            LocAPIMsgHeader locApiMsg(sockName, eLocMsgid);
 
             // throw away message that does not come from location hal daemon
             if (false == locApiMsg.isValidServerMsg(payloadSize)) {
                 return;
             }
 
+            // the daemon sends v2 once it has our registration, so it takes v2 too
+            if (LOCAPI_MSG_WIRE_V2 == pbLocApiMsg.wireVersion) {
+                mApiImpl.mPbufMsgConv.setWireVersion(LOCAPI_MSG_WIRE_V2);
+                // and the handle it knows us by, for our msgs to carry, from
+                // its responses to our requests. Hal ready goes out before
+                // any registration and carries none.
+                if (E_LOCAPI_HAL_READY_MSG_ID != locApiMsg.msgId &&
+                        0 != pbLocApiMsg.clientHandle) {
+                    mApiImpl.mPbufMsgConv.setClientHandle(pbLocApiMsg.clientHandle);
+                }
+            }
+
             switch (locApiMsg.msgId) {
             case E_LOCAPI_HAL_READY_MSG_ID:
                 LOC_LOGd("<<< HAL ready");
@@ -383,12 +395,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
             case E_INTAPI_GET_MIN_SV_ELEVATION_REQ_MSG_ID:
             case E_INTAPI_GET_CONSTELLATION_SECONDARY_BAND_CONFIG_REQ_MSG_ID:
             {
-                PBLocAPIGenericRespMsg pbLocApiGenericRsp;
-                if (0 == pbLocApiGenericRsp.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocAPIGenericRespMsg& pbLocApiGenericRsp =
+                        pbLocApiMsg.createPbMsg<PBLocAPIGenericRespMsg>();
+                if (!pbLocApiMsg.parsePayload(pbLocApiGenericRsp)) {
                     LOC_LOGe("Failed to parse pbLocApiGenericRsp from payload!!");
                     return;
                 }
-                LocAPIGenericRespMsg msg(sockName.c_str(), eLocMsgid, pbLocApiGenericRsp,
+                LocAPIGenericRespMsg msg(sockName, eLocMsgid, pbLocApiGenericRsp,
                         &mApiImpl.mPbufMsgConv);
                 mApiImpl.processConfigRespCb((LocAPIGenericRespMsg*)&msg);
                 break;
@@ -396,12 +409,13 @@ void IpcListener::onReceive(const char* data, uint32_t length,
 
             case E_INTAPI_GET_MIN_GPS_WEEK_RESP_MSG_ID:
             {
-                PBLocConfigGetMinGpsWeekRespMsg configGeMinGpsWeek;
-                if (0 == configGeMinGpsWeek.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocConfigGetMinGpsWeekRespMsg& configGeMinGpsWeek =
+                        pbLocApiMsg.createPbMsg<PBLocConfigGetMinGpsWeekRespMsg>();
+                if (!pbLocApiMsg.parsePayload(configGeMinGpsWeek)) {
                     LOC_LOGe("Failed to parse configGeMinGpsWeek from payload!!");
                     return;
                 }
-                LocConfigGetMinGpsWeekRespMsg msg(sockName.c_str(), configGeMinGpsWeek,
+                LocConfigGetMinGpsWeekRespMsg msg(sockName, configGeMinGpsWeek,
                         &mApiImpl.mPbufMsgConv);
                 mApiImpl.processGetMinGpsWeekRespCb((LocConfigGetMinGpsWeekRespMsg*)&msg);
                 break;
@@ -409,13 +423,14 @@ void IpcListener::onReceive(const char* data, uint32_t length,
 
             case E_INTAPI_GET_ROBUST_LOCATION_CONFIG_RESP_MSG_ID:
             {
-                PBLocConfigGetRobustLocationConfigRespMsg configGetRobustLoc;
-                if (0 == configGetRobustLoc.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocConfigGetRobustLocationConfigRespMsg& configGetRobustLoc =
+                        pbLocApiMsg.createPbMsg<PBLocConfigGetRobustLocationConfigRespMsg>();
+                if (!pbLocApiMsg.parsePayload(configGetRobustLoc)) {
                     LOC_LOGe("Failed to parse configGetRobustLoc from payload!!");
                     return;
                 }
 
-                LocConfigGetRobustLocationConfigRespMsg msg(sockName.c_str(), configGetRobustLoc,
+                LocConfigGetRobustLocationConfigRespMsg msg(sockName, configGetRobustLoc,
                         &mApiImpl.mPbufMsgConv);
                 mApiImpl.processGetRobustLocationConfigRespCb(
                         (LocConfigGetRobustLocationConfigRespMsg*)&msg);
@@ -424,13 +439,14 @@ void IpcListener::onReceive(const char* data, uint32_t length,
 
             case E_INTAPI_GET_MIN_SV_ELEVATION_RESP_MSG_ID:
             {
-                PBLocConfigGetMinSvElevationRespMsg configGetMinSvElev;
-                if (0 == configGetMinSvElev.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocConfigGetMinSvElevationRespMsg& configGetMinSvElev =
+                        pbLocApiMsg.createPbMsg<PBLocConfigGetMinSvElevationRespMsg>();
+                if (!pbLocApiMsg.parsePayload(configGetMinSvElev)) {
                     LOC_LOGe("Failed to parse configGetMinSvElev from payload!!");
                     return;
                 }
 
-                LocConfigGetMinSvElevationRespMsg msg(sockName.c_str(), configGetMinSvElev,
+                LocConfigGetMinSvElevationRespMsg msg(sockName, configGetMinSvElev,
                         &mApiImpl.mPbufMsgConv);
                 mApiImpl.processGetMinSvElevationRespCb((LocConfigGetMinSvElevationRespMsg*)&msg);
                 break;
@@ -438,13 +454,14 @@ void IpcListener::onReceive(const char* data, uint32_t length,
 
             case E_INTAPI_GET_CONSTELLATION_SECONDARY_BAND_CONFIG_RESP_MSG_ID:
             {
-                PBLocConfigGetConstltnSecondaryBandConfigRespMsg cfgGetConstlnSecBandCfgRespMsg;
-                if (0 == cfgGetConstlnSecBandCfgRespMsg.ParseFromString(pbLocApiMsg.payload())) {
+                PBLocConfigGetConstltnSecondaryBandConfigRespMsg& cfgGetConstlnSecBandCfgRespMsg =
+                        pbLocApiMsg.createPbMsg<PBLocConfigGetConstltnSecondaryBandConfigRespMsg>();
+                if (!pbLocApiMsg.parsePayload(cfgGetConstlnSecBandCfgRespMsg)) {
                     LOC_LOGe("Failed to parse cfgGetConstlnSecBandCfgRespMsg from payload!!");
                     return;
                 }
 
-                LocConfigGetConstellationSecondaryBandConfigRespMsg msg(sockName.c_str(),
+                LocConfigGetConstellationSecondaryBandConfigRespMsg msg(sockName,
                         cfgGetConstlnSecBandCfgRespMsg, &mApiImpl.mPbufMsgConv);
                 mApiImpl.processGetConstellationSecondaryBandConfigRespCb(
                         (LocConfigGetConstellationSecondaryBandConfigRespMsg*)&msg);
@@ -1016,7 +1033,12 @@ void LocationIntegrationApiImpl::sendConfigMsgToHalDaemon(
 
 void LocationIntegrationApiImpl::sendClientRegMsgToHalDaemon(){
     string pbStr;
-    LocAPIClientRegisterReqMsg msg(mSocketName, LOCATION_INTEGRATION_API, &mPbufMsgConv);
+    // the daemon may have been restarted as an older one, so stay on v1
+    // until it answers in v2
+    mPbufMsgConv.setWireVersion(LOCAPI_MSG_WIRE_V1);
+    mPbufMsgConv.setClientHandle(0);
+    LocAPIClientRegisterReqMsg msg(mSocketName, LOCATION_INTEGRATION_API, &mPbufMsgConv,
+            false, LOCAPI_MSG_WIRE_VERSION);
     if (msg.serializeToProtobuf(pbStr)) {
         bool rc = sendMessage(reinterpret_cast<uint8_t *>((uint8_t *)pbStr.c_str()),
                 pbStr.size());
@@ -0,0 +1,739 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#define LOG_TAG "LocSvc_LocationApiMsg"
+
+#include <math.h>
+#include <string.h>
+#include <log_util.h>
+#include <LocationApiMsg.h>
+#include <LocationApiPbMsgConv.h>
+#include <LocationApiDeltaConv.h>
+
+// quantized values are kept within this, so that a change fits an int32
+#define LOC_DELTA_QUANT_MAX (1 << 30)
+
+// LocAPIDeltaConv
+// ***************
+LocAPIDeltaConv::LocAPIDeltaConv() :
+        mSeq(0), mNumDeltas(0), mKeyframeRequested(false), mValid(false), mCur(0) {
+}
+
+void LocAPIDeltaConv::nextSeq(uint32_t& seq, uint32_t& baseSeq) {
+    bool keyframe = mKeyframeRequested.exchange(false) || (0 == mSeq) ||
+            (mNumDeltas + 1 >= LOC_DELTA_KEYFRAME_INTERVAL);
+    baseSeq = keyframe ? 0 : mSeq;
+    mNumDeltas = keyframe ? 0 : mNumDeltas + 1;
+    // 0 is the base of a keyframe, never a seq
+    mSeq = (UINT32_MAX == mSeq) ? 1 : mSeq + 1;
+    seq = mSeq;
+}
+
+bool LocAPIDeltaConv::checkSeq(uint32_t seq, uint32_t baseSeq) {
+    if ((0 != seq) && ((0 == baseSeq) || (mValid && baseSeq == mSeq))) {
+        return true;
+    }
+    if (mValid) {
+        LOC_LOGw("delta %u on %u, last decoded %u, dropping deltas until keyframe",
+                 seq, baseSeq, mSeq);
+    }
+    mValid = false;
+    return false;
+}
+
+bool LocAPIDeltaConv::quantizeValue(double value, int32_t& quantized) {
+    double scaled = value * LOC_DELTA_QUANT_SCALE;
+    // also false for NaN
+    if (!(fabs(scaled) < LOC_DELTA_QUANT_MAX)) {
+        return false;
+    }
+    quantized = (int32_t)lround(scaled);
+    return true;
+}
+
+double LocAPIDeltaConv::dequantizeValue(int32_t quantized) {
+    return (double)quantized / LOC_DELTA_QUANT_SCALE;
+}
+
+// base + delta into value, false if that is out of the range encode keeps to
+static inline bool addDelta(int32_t base, int32_t delta, int32_t& value) {
+    int64_t sum = (int64_t)base + delta;
+    if (sum > LOC_DELTA_QUANT_MAX || sum < -LOC_DELTA_QUANT_MAX) {
+        return false;
+    }
+    value = (int32_t)sum;
+    return true;
+}
+
+// LocAPISvDeltaConv
+// *****************
+LocAPISvDeltaConv::LocAPISvDeltaConv() : mReports{}, mQuantized{} {
+}
+
+bool LocAPISvDeltaConv::isSameSignal(const GnssSv& sv, const GnssSv& baseSv) {
+    // an SV whose values not sent in deltas changed is sent in full
+    return (sv.svId == baseSv.svId) && (sv.type == baseSv.type) &&
+            (sv.gnssSignalTypeMask == baseSv.gnssSignalTypeMask) &&
+            (sv.carrierFrequencyHz == baseSv.carrierFrequencyHz) &&
+            (sv.gloFrequency == baseSv.gloFrequency);
+}
+
+LocAPIDeltaConv::Quantized LocAPISvDeltaConv::quantize(const GnssSv& sv) {
+    Quantized quantized = {};
+    quantized.valid = quantizeValue(sv.cN0Dbhz, quantized.values[0]) &&
+            quantizeValue(sv.elevation, quantized.values[1]) &&
+            quantizeValue(sv.azimuth, quantized.values[2]) &&
+            quantizeValue(sv.basebandCarrierToNoiseDbHz, quantized.values[3]);
+    return quantized;
+}
+
+int LocAPISvDeltaConv::encode(const GnssSvNotification& report,
+        const LocationApiPbMsgConv& pbConv, PBLocApiGnssSvDeltaNotification& pbDelta) {
+    uint32_t seq = 0;
+    uint32_t baseSeq = 0;
+    nextSeq(seq, baseSeq);
+    const GnssSvNotification& base = mReports[mCur];
+    const Quantized* baseQuantized = mQuantized[mCur];
+    // a keyframe finds no SV in the base
+    const uint32_t baseCount = (0 == baseSeq) ? 0 : base.count;
+    GnssSvNotification& next = mReports[mCur ^ 1];
+    Quantized* nextQuantized = mQuantized[mCur ^ 1];
+    uint32_t count = min(report.count, (uint32_t)GNSS_SV_MAX);
+
+    pbDelta.set_seq(seq);
+    pbDelta.set_baseseq(baseSeq);
+    pbDelta.set_gnsssignaltypemaskvalid(report.gnssSignalTypeMaskValid);
+    pbDelta.mutable_baseindex()->Reserve(count);
+    pbDelta.mutable_cn0dbhz()->Reserve(count);
+    pbDelta.mutable_elevation()->Reserve(count);
+    pbDelta.mutable_azimuth()->Reserve(count);
+    pbDelta.mutable_basebandcarriertonoisedbhz()->Reserve(count);
+    pbDelta.mutable_gnsssvoptionsmask()->Reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const GnssSv& sv = report.gnssSvs[i];
+        Quantized quantized = quantize(sv);
+        // SVs mostly keep their place from one report to the next
+        uint32_t b = i;
+        if (b >= baseCount || !isSameSignal(sv, base.gnssSvs[b])) {
+            for (b = 0; b < baseCount && !isSameSignal(sv, base.gnssSvs[b]); b++) {}
+        }
+        if (b < baseCount && quantized.valid && baseQuantized[b].valid) {
+            pbDelta.add_baseindex(b + 1);
+            pbDelta.add_cn0dbhz(quantized.values[0] - baseQuantized[b].values[0]);
+            pbDelta.add_elevation(quantized.values[1] - baseQuantized[b].values[1]);
+            pbDelta.add_azimuth(quantized.values[2] - baseQuantized[b].values[2]);
+            pbDelta.add_basebandcarriertonoisedbhz(
+                    quantized.values[3] - baseQuantized[b].values[3]);
+            pbDelta.add_gnsssvoptionsmask(
+                    pbConv.getPBMaskForGnssSvOptionsMask(sv.gnssSvOptionsMask));
+        } else {
+            pbDelta.add_baseindex(0);
+            if (pbConv.convertGnssSvToPB(sv, pbDelta.add_newsvs())) {
+                LOC_LOGe("convertGnssSvToPB failed");
+                requestKeyframe();
+                return 1;
+            }
+        }
+        next.gnssSvs[i] = sv;
+        nextQuantized[i] = quantized;
+    }
+    next.size = sizeof(GnssSvNotification);
+    next.count = count;
+    next.gnssSignalTypeMaskValid = report.gnssSignalTypeMaskValid;
+    flip(true);
+    LOC_LOGv("SV delta %u on %u, %u SVs, %d new", seq, baseSeq, count, pbDelta.newsvs_size());
+    return 0;
+}
+
+const GnssSvNotification* LocAPISvDeltaConv::decode(
+        const PBLocApiGnssSvDeltaNotification& pbDelta, const LocationApiPbMsgConv& pbConv) {
+    if (isRepeat(pbDelta.seq())) {
+        return &mReports[mCur];
+    }
+    if (!checkSeq(pbDelta.seq(), pbDelta.baseseq())) {
+        return nullptr;
+    }
+    const GnssSvNotification& base = mReports[mCur];
+    const Quantized* baseQuantized = mQuantized[mCur];
+    const uint32_t baseCount = (0 == pbDelta.baseseq()) ? 0 : base.count;
+    GnssSvNotification& next = mReports[mCur ^ 1];
+    Quantized* nextQuantized = mQuantized[mCur ^ 1];
+
+    int count = pbDelta.baseindex_size();
+    int numNew = pbDelta.newsvs_size();
+    int numDeltas = count - numNew;
+    bool valid = (count <= (int)GNSS_SV_MAX) && (numDeltas >= 0) &&
+            (pbDelta.cn0dbhz_size() == numDeltas) && (pbDelta.elevation_size() == numDeltas) &&
+            (pbDelta.azimuth_size() == numDeltas) &&
+            (pbDelta.basebandcarriertonoisedbhz_size() == numDeltas) &&
+            (pbDelta.gnsssvoptionsmask_size() == numDeltas);
+    int d = 0;
+    int n = 0;
+    for (int i = 0; valid && i < count; i++) {
+        uint32_t b = pbDelta.baseindex(i);
+        GnssSv& sv = next.gnssSvs[i];
+        Quantized& quantized = nextQuantized[i];
+        if (0 == b) {
+            valid = (n < numNew);
+            if (valid) {
+                pbConv.pbConvertToGnssSv(pbDelta.newsvs(n++), sv);
+                quantized = quantize(sv);
+            }
+            continue;
+        }
+        valid = (b <= baseCount) && (d < numDeltas) && baseQuantized[b - 1].valid &&
+                addDelta(baseQuantized[b - 1].values[0], pbDelta.cn0dbhz(d),
+                         quantized.values[0]) &&
+                addDelta(baseQuantized[b - 1].values[1], pbDelta.elevation(d),
+                         quantized.values[1]) &&
+                addDelta(baseQuantized[b - 1].values[2], pbDelta.azimuth(d),
+                         quantized.values[2]) &&
+                addDelta(baseQuantized[b - 1].values[3], pbDelta.basebandcarriertonoisedbhz(d),
+                         quantized.values[3]);
+        if (valid) {
+            quantized.valid = true;
+            sv = base.gnssSvs[b - 1];
+            sv.cN0Dbhz = dequantizeValue(quantized.values[0]);
+            sv.elevation = dequantizeValue(quantized.values[1]);
+            sv.azimuth = dequantizeValue(quantized.values[2]);
+            sv.basebandCarrierToNoiseDbHz = dequantizeValue(quantized.values[3]);
+            sv.gnssSvOptionsMask = pbConv.getGnssSvOptionsMaskFromPB(
+                    pbDelta.gnsssvoptionsmask(d));
+            d++;
+        }
+    }
+    if (!valid) {
+        LOC_LOGe("malformed SV delta %u, dropping deltas until keyframe", pbDelta.seq());
+        mValid = false;
+        return nullptr;
+    }
+    next.size = sizeof(GnssSvNotification);
+    next.count = count;
+    next.gnssSignalTypeMaskValid = pbDelta.gnsssignaltypemaskvalid();
+    mSeq = pbDelta.seq();
+    flip(true);
+    return &mReports[mCur];
+}
+
+// LocAPIMeasDeltaConv
+// *******************
+// sent exact, and only when changed: bit i of changedMask for value i
+static double GnssMeasurementsData::* const sMeasExactValues[] = {
+    &GnssMeasurementsData::timeOffsetNs,
+    &GnssMeasurementsData::pseudorangeRateMps,
+    &GnssMeasurementsData::pseudorangeRateUncertaintyMps,
+    &GnssMeasurementsData::adrMeters,
+    &GnssMeasurementsData::adrUncertaintyMeters,
+    &GnssMeasurementsData::carrierPhase,
+    &GnssMeasurementsData::carrierPhaseUncertainty,
+    &GnssMeasurementsData::fullInterSignalBiasNs,
+    &GnssMeasurementsData::fullInterSignalBiasUncertaintyNs,
+};
+#define LOC_MEAS_EXACT_VALUES (sizeof(sMeasExactValues) / sizeof(sMeasExactValues[0]))
+
+// change of an int64, wrapping, so that any change is sent exact
+static inline int64_t int64Delta(int64_t value, int64_t base) {
+    return (int64_t)((uint64_t)value - (uint64_t)base);
+}
+
+static inline int64_t int64AddDelta(int64_t base, int64_t delta) {
+    return (int64_t)((uint64_t)base + (uint64_t)delta);
+}
+
+LocAPIMeasDeltaConv::LocAPIMeasDeltaConv() : mReports{}, mQuantized{} {
+}
+
+bool LocAPIMeasDeltaConv::isSameSignal(const GnssMeasurementsData& meas,
+        const GnssMeasurementsData& baseMeas) {
+    // a measurement whose values not sent in deltas changed is sent in full
+    return (meas.svId == baseMeas.svId) && (meas.svType == baseMeas.svType) &&
+            (meas.gnssSignalType == baseMeas.gnssSignalType) &&
+            (meas.carrierFrequencyHz == baseMeas.carrierFrequencyHz);
+}
+
+LocAPIDeltaConv::Quantized LocAPIMeasDeltaConv::quantize(const GnssMeasurementsData& meas) {
+    Quantized quantized = {};
+    quantized.valid = quantizeValue(meas.carrierToNoiseDbHz, quantized.values[0]) &&
+            quantizeValue(meas.signalToNoiseRatioDb, quantized.values[1]) &&
+            quantizeValue(meas.agcLevelDb, quantized.values[2]) &&
+            quantizeValue(meas.basebandCarrierToNoiseDbHz, quantized.values[3]);
+    return quantized;
+}
+
+int LocAPIMeasDeltaConv::encode(const GnssMeasurementsNotification& report,
+        const LocationApiPbMsgConv& pbConv, PBGnssMeasurementsDeltaNotification& pbDelta) {
+    uint32_t seq = 0;
+    uint32_t baseSeq = 0;
+    nextSeq(seq, baseSeq);
+    const GnssMeasurementsNotification& base = mReports[mCur];
+    const Quantized* baseQuantized = mQuantized[mCur];
+    // a keyframe finds no measurement in the base
+    const uint32_t baseCount = (0 == baseSeq) ? 0 : base.count;
+    GnssMeasurementsNotification& next = mReports[mCur ^ 1];
+    Quantized* nextQuantized = mQuantized[mCur ^ 1];
+    uint32_t count = min(report.count, (uint32_t)GNSS_MEASUREMENTS_MAX);
+
+    pbDelta.set_seq(seq);
+    pbDelta.set_baseseq(baseSeq);
+    if (pbConv.convertGnssMeasClockToPB(report.clock, pbDelta.mutable_clock())) {
+        LOC_LOGe("convertGnssMeasClockToPB failed");
+        requestKeyframe();
+        return 1;
+    }
+    pbDelta.mutable_baseindex()->Reserve(count);
+    pbDelta.mutable_flags()->Reserve(count);
+    pbDelta.mutable_statemask()->Reserve(count);
+    pbDelta.mutable_adrstatemask()->Reserve(count);
+    pbDelta.mutable_multipathindicator()->Reserve(count);
+    pbDelta.mutable_cycleslipcount()->Reserve(count);
+    pbDelta.mutable_receivedsvtimens()->Reserve(count);
+    pbDelta.mutable_receivedsvtimeuncertaintyns()->Reserve(count);
+    pbDelta.mutable_carriercycles()->Reserve(count);
+    pbDelta.mutable_carriertonoisedbhz()->Reserve(count);
+    pbDelta.mutable_signaltonoiseratiodb()->Reserve(count);
+    pbDelta.mutable_agcleveldb()->Reserve(count);
+    pbDelta.mutable_basebandcarriertonoisedbhz()->Reserve(count);
+    pbDelta.mutable_changedmask()->Reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const GnssMeasurementsData& meas = report.measurements[i];
+        Quantized quantized = quantize(meas);
+        // measurements mostly keep their place from one report to the next
+        uint32_t b = i;
+        if (b >= baseCount || !isSameSignal(meas, base.measurements[b])) {
+            for (b = 0; b < baseCount && !isSameSignal(meas, base.measurements[b]); b++) {}
+        }
+        if (b < baseCount && quantized.valid && baseQuantized[b].valid) {
+            const GnssMeasurementsData& baseMeas = base.measurements[b];
+            pbDelta.add_baseindex(b + 1);
+            pbDelta.add_flags(pbConv.getPBMaskForGnssMeasurementsDataFlagsMask(meas.flags));
+            pbDelta.add_statemask(pbConv.getPBMaskForGnssMeasurementsStateMask(meas.stateMask));
+            pbDelta.add_adrstatemask(
+                    pbConv.getPBMaskForGnssMeasurementsAdrStateMask(meas.adrStateMask));
+            pbDelta.add_multipathindicator(
+                    pbConv.getPBEnumForGnssMeasMultiPathIndic(meas.multipathIndicator));
+            pbDelta.add_cycleslipcount(meas.cycleSlipCount);
+            pbDelta.add_receivedsvtimens(
+                    int64Delta(meas.receivedSvTimeNs, baseMeas.receivedSvTimeNs));
+            pbDelta.add_receivedsvtimeuncertaintyns(int64Delta(
+                    meas.receivedSvTimeUncertaintyNs, baseMeas.receivedSvTimeUncertaintyNs));
+            pbDelta.add_carriercycles(int64Delta(meas.carrierCycles, baseMeas.carrierCycles));
+            pbDelta.add_carriertonoisedbhz(quantized.values[0] - baseQuantized[b].values[0]);
+            pbDelta.add_signaltonoiseratiodb(quantized.values[1] - baseQuantized[b].values[1]);
+            pbDelta.add_agcleveldb(quantized.values[2] - baseQuantized[b].values[2]);
+            pbDelta.add_basebandcarriertonoisedbhz(
+                    quantized.values[3] - baseQuantized[b].values[3]);
+            uint32_t changedMask = 0;
+            for (uint32_t v = 0; v < LOC_MEAS_EXACT_VALUES; v++) {
+                const double& value = meas.*sMeasExactValues[v];
+                if (0 != memcmp(&value, &(baseMeas.*sMeasExactValues[v]), sizeof(value))) {
+                    changedMask |= (1 << v);
+                    pbDelta.add_changedvalues(value);
+                }
+            }
+            pbDelta.add_changedmask(changedMask);
+        } else {
+            pbDelta.add_baseindex(0);
+            if (pbConv.convertGnssMeasDataToPB(meas, pbDelta.add_newmeasurements())) {
+                LOC_LOGe("convertGnssMeasDataToPB failed");
+                requestKeyframe();
+                return 1;
+            }
+        }
+        next.measurements[i] = meas;
+        nextQuantized[i] = quantized;
+    }
+    next.size = sizeof(GnssMeasurementsNotification);
+    next.count = count;
+    flip(true);
+    LOC_LOGv("Meas delta %u on %u, %u meas, %d new", seq, baseSeq, count,
+             pbDelta.newmeasurements_size());
+    return 0;
+}
+
+const GnssMeasurementsNotification* LocAPIMeasDeltaConv::decode(
+        const PBGnssMeasurementsDeltaNotification& pbDelta, const LocationApiPbMsgConv& pbConv) {
+    if (isRepeat(pbDelta.seq())) {
+        return &mReports[mCur];
+    }
+    if (!checkSeq(pbDelta.seq(), pbDelta.baseseq())) {
+        return nullptr;
+    }
+    const GnssMeasurementsNotification& base = mReports[mCur];
+    const Quantized* baseQuantized = mQuantized[mCur];
+    const uint32_t baseCount = (0 == pbDelta.baseseq()) ? 0 : base.count;
+    GnssMeasurementsNotification& next = mReports[mCur ^ 1];
+    Quantized* nextQuantized = mQuantized[mCur ^ 1];
+
+    int count = pbDelta.baseindex_size();
+    int numNew = pbDelta.newmeasurements_size();
+    int numDeltas = count - numNew;
+    bool valid = (count <= (int)GNSS_MEASUREMENTS_MAX) && (numDeltas >= 0) &&
+            (pbDelta.flags_size() == numDeltas) && (pbDelta.statemask_size() == numDeltas) &&
+            (pbDelta.adrstatemask_size() == numDeltas) &&
+            (pbDelta.multipathindicator_size() == numDeltas) &&
+            (pbDelta.cycleslipcount_size() == numDeltas) &&
+            (pbDelta.receivedsvtimens_size() == numDeltas) &&
+            (pbDelta.receivedsvtimeuncertaintyns_size() == numDeltas) &&
+            (pbDelta.carriercycles_size() == numDeltas) &&
+            (pbDelta.carriertonoisedbhz_size() == numDeltas) &&
+            (pbDelta.signaltonoiseratiodb_size() == numDeltas) &&
+            (pbDelta.agcleveldb_size() == numDeltas) &&
+            (pbDelta.basebandcarriertonoisedbhz_size() == numDeltas) &&
+            (pbDelta.changedmask_size() == numDeltas);
+    int d = 0;
+    int n = 0;
+    int c = 0;
+    for (int i = 0; valid && i < count; i++) {
+        uint32_t b = pbDelta.baseindex(i);
+        GnssMeasurementsData& meas = next.measurements[i];
+        Quantized& quantized = nextQuantized[i];
+        if (0 == b) {
+            valid = (n < numNew);
+            if (valid) {
+                // fields not in PBGnssMeasurementsData are left 0
+                memset(&meas, 0, sizeof(meas));
+                pbConv.pbConvertToGnssMeasurementsData(pbDelta.newmeasurements(n++), meas);
+                quantized = quantize(meas);
+            }
+            continue;
+        }
+        valid = (b <= baseCount) && (d < numDeltas) && baseQuantized[b - 1].valid &&
+                addDelta(baseQuantized[b - 1].values[0], pbDelta.carriertonoisedbhz(d),
+                         quantized.values[0]) &&
+                addDelta(baseQuantized[b - 1].values[1], pbDelta.signaltonoiseratiodb(d),
+                         quantized.values[1]) &&
+                addDelta(baseQuantized[b - 1].values[2], pbDelta.agcleveldb(d),
+                         quantized.values[2]) &&
+                addDelta(baseQuantized[b - 1].values[3], pbDelta.basebandcarriertonoisedbhz(d),
+                         quantized.values[3]);
+        if (!valid) {
+            break;
+        }
+        const GnssMeasurementsData& baseMeas = base.measurements[b - 1];
+        quantized.valid = true;
+        meas = baseMeas;
+        meas.flags = pbConv.getGnssMeasurementsDataFlagsMaskFromPB(pbDelta.flags(d));
+        // as pbConvertToGnssMeasurementsData takes it
+        meas.stateMask = pbDelta.statemask(d);
+        meas.adrStateMask = pbConv.getGnssMeasurementsAdrStateMaskFromPB(
+                pbDelta.adrstatemask(d));
+        meas.multipathIndicator = pbConv.getEnumForPBGnssMeasMultipathIndic(
+                (PBGnssMeasurementsMultipathIndicator)pbDelta.multipathindicator(d));
+        meas.cycleSlipCount = pbDelta.cycleslipcount(d);
+        meas.receivedSvTimeNs = int64AddDelta(baseMeas.receivedSvTimeNs,
+                                              pbDelta.receivedsvtimens(d));
+        meas.receivedSvTimeUncertaintyNs = int64AddDelta(baseMeas.receivedSvTimeUncertaintyNs,
+                pbDelta.receivedsvtimeuncertaintyns(d));
+        meas.carrierCycles = int64AddDelta(baseMeas.carrierCycles, pbDelta.carriercycles(d));
+        meas.carrierToNoiseDbHz = dequantizeValue(quantized.values[0]);
+        meas.signalToNoiseRatioDb = dequantizeValue(quantized.values[1]);
+        meas.agcLevelDb = dequantizeValue(quantized.values[2]);
+        meas.basebandCarrierToNoiseDbHz = dequantizeValue(quantized.values[3]);
+        uint32_t changedMask = pbDelta.changedmask(d);
+        for (uint32_t v = 0; valid && v < LOC_MEAS_EXACT_VALUES; v++) {
+            if (changedMask & (1 << v)) {
+                valid = (c < pbDelta.changedvalues_size());
+                if (valid) {
+                    meas.*sMeasExactValues[v] = pbDelta.changedvalues(c++);
+                }
+            }
+        }
+        d++;
+    }
+    if (!valid || c != pbDelta.changedvalues_size()) {
+        LOC_LOGe("malformed Meas delta %u, dropping deltas until keyframe", pbDelta.seq());
+        mValid = false;
+        return nullptr;
+    }
+    next.size = sizeof(GnssMeasurementsNotification);
+    next.count = count;
+    pbConv.pbConvertToGnssMeasurementsClock(pbDelta.clock(), next.clock);
+    mSeq = pbDelta.seq();
+    flip(true);
+    return &mReports[mCur];
+}
+
+#ifdef __LOC_UNIT_TEST__
+static inline uint32_t checkRand(uint32_t& seed) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+// a random walk step of up to +/- max
+static inline double checkStep(uint32_t& seed, double max) {
+    return max * ((double)checkRand(seed) / 0x3fff - 1.0);
+}
+
+static inline bool checkNear(double a, double b) {
+    // quantized to 1 / LOC_DELTA_QUANT_SCALE, and floats kept to 1e-4
+    return fabs(a - b) <= 0.5 / LOC_DELTA_QUANT_SCALE + 1e-4;
+}
+
+// Sends reports rounds times through the full msg and the delta msg, with
+// the delta of round lostRound lost. move() changes report for the next
+// round, and same() checks what the delta msg gives against the full msg.
+// A delta stream no smaller than the full msgs counts as one more mismatch.
+template <typename Report, typename FullMsg, typename FullPb, typename DeltaMsg,
+          typename DeltaPb, typename DeltaConv, typename FromFullPb, typename FromDeltaPb,
+          typename Move, typename Same>
+static uint32_t checkDelta(uint32_t rounds, Report& report, FromFullPb fromFullPb,
+        FromDeltaPb fromDeltaPb, Move move, Same same) {
+    LocationApiPbMsgConv pbConv;
+    pbConv.setWireVersion(LOCAPI_MSG_WIRE_V2);
+    // encoder of the daemon, decoder of the client
+    std::unique_ptr<DeltaConv> encoder(new DeltaConv());
+    std::unique_ptr<DeltaConv> decoder(new DeltaConv());
+    const uint32_t lostRound = LOC_DELTA_KEYFRAME_INTERVAL + 3;
+    const uint32_t repeatRound = 2 * LOC_DELTA_KEYFRAME_INTERVAL + 5;
+    uint32_t numBad = 0;
+    string pbStr;
+    uint64_t fullBytes = 0;
+    uint64_t deltaBytes = 0;
+
+    for (uint32_t r = 0; r < rounds; r++) {
+        const Report* fullReport = nullptr;
+        {
+            FullMsg msg("check", report, &pbConv);
+            msg.serializeToProtobuf(pbStr);
+        }
+        fullBytes += pbStr.size();
+        LocAPIMsgView fullView;
+        fullView.parse(pbStr.data(), pbStr.size());
+        FullPb& fullPb = fullView.createPbMsg<FullPb>();
+        fullView.parsePayload(fullPb);
+        FullMsg fullMsg("check", fullPb, &pbConv);
+        fullReport = &fromFullPb(fullMsg);
+
+        const Report* deltaReport = nullptr;
+        {
+            DeltaMsg msg("check", report, *encoder, &pbConv);
+            msg.serializeToProtobuf(pbStr);
+        }
+        deltaBytes += pbStr.size();
+        if (lostRound != r) {
+            LocAPIMsgView deltaView;
+            deltaView.parse(pbStr.data(), pbStr.size());
+            DeltaPb& deltaPb = deltaView.createPbMsg<DeltaPb>();
+            deltaView.parsePayload(deltaPb);
+            deltaReport = decoder->decode(fromDeltaPb(deltaPb), pbConv);
+            // a msg resent for a report identical to the one before
+            if (repeatRound == r && nullptr != deltaReport) {
+                deltaReport = decoder->decode(fromDeltaPb(deltaPb), pbConv);
+            }
+        }
+
+        // none from the lost delta up to the next keyframe
+        bool lost = (r >= lostRound) &&
+                (r / LOC_DELTA_KEYFRAME_INTERVAL == lostRound / LOC_DELTA_KEYFRAME_INTERVAL);
+        if (lost) {
+            numBad += (nullptr != deltaReport);
+        } else {
+            numBad += (nullptr == deltaReport || !same(*fullReport, *deltaReport));
+        }
+        move(report);
+    }
+    if (rounds > 0 && deltaBytes >= fullBytes) {
+        numBad++;
+    }
+    return numBad;
+}
+
+uint32_t LocAPISvDeltaConv::check(uint32_t rounds) {
+    static GnssSvNotification sv;
+    uint32_t seed = 1;
+    uint16_t nextSvId = 1;
+    memset(&sv, 0, sizeof(sv));
+    sv.size = sizeof(sv);
+    sv.gnssSignalTypeMaskValid = true;
+    sv.count = 48;
+    auto rise = [&](GnssSv& gnssSv) {
+        memset(&gnssSv, 0, sizeof(gnssSv));
+        gnssSv.size = sizeof(gnssSv);
+        gnssSv.svId = nextSvId++;
+        gnssSv.type = GNSS_SV_TYPE_GPS;
+        gnssSv.cN0Dbhz = 25.0f + checkRand(seed) % 20;
+        gnssSv.elevation = 5.0f;
+        gnssSv.azimuth = checkRand(seed) % 360;
+        gnssSv.gnssSvOptionsMask = GNSS_SV_OPTIONS_HAS_EPHEMER_BIT;
+        gnssSv.carrierFrequencyHz = 1575420000.0f;
+        gnssSv.gnssSignalTypeMask = GNSS_SIGNAL_GPS_L1CA;
+        gnssSv.basebandCarrierToNoiseDbHz = gnssSv.cN0Dbhz - 1.5;
+    };
+    for (uint32_t i = 0; i < sv.count; i++) {
+        rise(sv.gnssSvs[i]);
+    }
+    return checkDelta<GnssSvNotification, LocAPISatelliteVehicleIndMsg,
+            PBLocAPISatelliteVehicleIndMsg, LocAPISatelliteVehicleDeltaIndMsg,
+            PBLocAPISatelliteVehicleDeltaIndMsg, LocAPISvDeltaConv>(rounds, sv,
+            [](const LocAPISatelliteVehicleIndMsg& msg) -> const GnssSvNotification& {
+                return msg.gnssSvNotification;
+            },
+            [](const PBLocAPISatelliteVehicleDeltaIndMsg& pbMsg)
+                    -> const PBLocApiGnssSvDeltaNotification& {
+                return pbMsg.gnsssvdeltanotification();
+            },
+            [&](GnssSvNotification& report) {
+                for (uint32_t i = 0; i < report.count; i++) {
+                    GnssSv& gnssSv = report.gnssSvs[i];
+                    gnssSv.cN0Dbhz += checkStep(seed, 0.5);
+                    gnssSv.basebandCarrierToNoiseDbHz = gnssSv.cN0Dbhz - 1.5;
+                    gnssSv.elevation += 0.01f;
+                    gnssSv.azimuth += checkStep(seed, 0.02);
+                }
+                // every few reports an SV sets and another rises, and two swap
+                if (0 == checkRand(seed) % 4) {
+                    rise(report.gnssSvs[checkRand(seed) % report.count]);
+                    std::swap(report.gnssSvs[checkRand(seed) % report.count],
+                              report.gnssSvs[checkRand(seed) % report.count]);
+                }
+            },
+            [](const GnssSvNotification& full, const GnssSvNotification& delta) {
+                bool same = (full.count == delta.count) &&
+                        (full.gnssSignalTypeMaskValid == delta.gnssSignalTypeMaskValid);
+                for (uint32_t i = 0; same && i < full.count; i++) {
+                    const GnssSv& a = full.gnssSvs[i];
+                    const GnssSv& b = delta.gnssSvs[i];
+                    same = (a.svId == b.svId) && (a.type == b.type) &&
+                            (a.gnssSvOptionsMask == b.gnssSvOptionsMask) &&
+                            (a.carrierFrequencyHz == b.carrierFrequencyHz) &&
+                            (a.gnssSignalTypeMask == b.gnssSignalTypeMask) &&
+                            (a.gloFrequency == b.gloFrequency) &&
+                            checkNear(a.cN0Dbhz, b.cN0Dbhz) &&
+                            checkNear(a.elevation, b.elevation) &&
+                            checkNear(a.azimuth, b.azimuth) &&
+                            checkNear(a.basebandCarrierToNoiseDbHz,
+                                      b.basebandCarrierToNoiseDbHz);
+                }
+                return same;
+            });
+}
+
+uint32_t LocAPIMeasDeltaConv::check(uint32_t rounds) {
+    static GnssMeasurementsNotification meas;
+    uint32_t seed = 1;
+    int16_t nextSvId = 1;
+    memset(&meas, 0, sizeof(meas));
+    meas.size = sizeof(meas);
+    meas.count = 48;
+    meas.clock.size = sizeof(meas.clock);
+    meas.clock.flags = GNSS_MEASUREMENTS_CLOCK_FLAGS_FULL_BIAS_BIT |
+            GNSS_MEASUREMENTS_CLOCK_FLAGS_BIAS_BIT;
+    meas.clock.timeNs = 1000000000LL;
+    meas.clock.fullBiasNs = -1234567890123456789LL;
+    auto rise = [&](GnssMeasurementsData& data) {
+        memset(&data, 0, sizeof(data));
+        data.size = sizeof(data);
+        data.flags = GNSS_MEASUREMENTS_DATA_SV_ID_BIT | GNSS_MEASUREMENTS_DATA_SV_TYPE_BIT |
+                GNSS_MEASUREMENTS_DATA_STATE_BIT |
+                GNSS_MEASUREMENTS_DATA_RECEIVED_SV_TIME_BIT |
+                GNSS_MEASUREMENTS_DATA_CARRIER_TO_NOISE_BIT;
+        data.svId = nextSvId++;
+        data.svType = GNSS_SV_TYPE_GPS;
+        data.stateMask = GNSS_MEASUREMENTS_STATE_CODE_LOCK_BIT |
+                GNSS_MEASUREMENTS_STATE_TOW_DECODED_BIT;
+        data.receivedSvTimeNs = 345600000000000LL + checkRand(seed);
+        data.receivedSvTimeUncertaintyNs = 20;
+        data.carrierToNoiseDbHz = 25.0 + checkRand(seed) % 20;
+        data.pseudorangeRateMps = checkStep(seed, 800.0);
+        data.pseudorangeRateUncertaintyMps = 0.05;
+        data.adrStateMask = GNSS_MEASUREMENTS_ACCUMULATED_DELTA_RANGE_STATE_VALID_BIT;
+        data.adrMeters = checkStep(seed, 10000.0);
+        data.adrUncertaintyMeters = 0.01;
+        data.carrierFrequencyHz = 1575420000.0f;
+        data.carrierCycles = 1000000 + checkRand(seed);
+        data.multipathIndicator = GNSS_MEASUREMENTS_MULTIPATH_INDICATOR_NOT_PRESENT;
+        data.agcLevelDb = 2.5;
+        data.basebandCarrierToNoiseDbHz = data.carrierToNoiseDbHz - 1.5;
+        data.gnssSignalType = GNSS_SIGNAL_GPS_L1CA;
+    };
+    for (uint32_t i = 0; i < meas.count; i++) {
+        rise(meas.measurements[i]);
+    }
+    return checkDelta<GnssMeasurementsNotification, LocAPIMeasIndMsg, PBLocAPIMeasIndMsg,
+            LocAPIMeasDeltaIndMsg, PBLocAPIMeasDeltaIndMsg, LocAPIMeasDeltaConv>(rounds, meas,
+            [](const LocAPIMeasIndMsg& msg) -> const GnssMeasurementsNotification& {
+                return msg.gnssMeasurementsNotification;
+            },
+            [](const PBLocAPIMeasDeltaIndMsg& pbMsg)
+                    -> const PBGnssMeasurementsDeltaNotification& {
+                return pbMsg.gnssmeasurementsdeltanotification();
+            },
+            [&](GnssMeasurementsNotification& report) {
+                report.clock.timeNs += 1000000000LL;
+                report.clock.biasNs = checkStep(seed, 100.0);
+                report.clock.driftNsps = checkStep(seed, 10.0);
+                for (uint32_t i = 0; i < report.count; i++) {
+                    GnssMeasurementsData& data = report.measurements[i];
+                    data.receivedSvTimeNs += 1000000000LL + checkRand(seed) % 1000;
+                    data.carrierToNoiseDbHz += checkStep(seed, 0.5);
+                    data.basebandCarrierToNoiseDbHz = data.carrierToNoiseDbHz - 1.5;
+                    data.pseudorangeRateMps += checkStep(seed, 0.1);
+                    data.adrMeters += data.pseudorangeRateMps;
+                    data.carrierCycles += 5000 + checkRand(seed) % 100;
+                }
+                // every few reports a signal is lost and another found, and two swap
+                if (0 == checkRand(seed) % 4) {
+                    rise(report.measurements[checkRand(seed) % report.count]);
+                    std::swap(report.measurements[checkRand(seed) % report.count],
+                              report.measurements[checkRand(seed) % report.count]);
+                }
+            },
+            [](const GnssMeasurementsNotification& full,
+               const GnssMeasurementsNotification& delta) {
+                bool same = (full.count == delta.count) &&
+                        (full.clock.flags == delta.clock.flags) &&
+                        (full.clock.timeNs == delta.clock.timeNs) &&
+                        (full.clock.fullBiasNs == delta.clock.fullBiasNs) &&
+                        (full.clock.biasNs == delta.clock.biasNs) &&
+                        (full.clock.driftNsps == delta.clock.driftNsps);
+                for (uint32_t i = 0; same && i < full.count; i++) {
+                    const GnssMeasurementsData& a = full.measurements[i];
+                    const GnssMeasurementsData& b = delta.measurements[i];
+                    same = (a.flags == b.flags) && (a.svId == b.svId) &&
+                            (a.svType == b.svType) && (a.stateMask == b.stateMask) &&
+                            (a.receivedSvTimeNs == b.receivedSvTimeNs) &&
+                            (a.receivedSvTimeUncertaintyNs == b.receivedSvTimeUncertaintyNs) &&
+                            (a.adrStateMask == b.adrStateMask) &&
+                            (a.carrierFrequencyHz == b.carrierFrequencyHz) &&
+                            (a.carrierCycles == b.carrierCycles) &&
+                            (a.multipathIndicator == b.multipathIndicator) &&
+                            (a.gnssSignalType == b.gnssSignalType) &&
+                            (a.cycleSlipCount == b.cycleSlipCount) &&
+                            checkNear(a.carrierToNoiseDbHz, b.carrierToNoiseDbHz) &&
+                            checkNear(a.signalToNoiseRatioDb, b.signalToNoiseRatioDb) &&
+                            checkNear(a.agcLevelDb, b.agcLevelDb) &&
+                            checkNear(a.basebandCarrierToNoiseDbHz,
+                                      b.basebandCarrierToNoiseDbHz);
+                    for (uint32_t v = 0; same && v < LOC_MEAS_EXACT_VALUES; v++) {
+                        same = (a.*sMeasExactValues[v] == b.*sMeasExactValues[v]);
+                    }
+                }
+                return same;
+            });
+}
+#endif
@@ -0,0 +1,156 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef LOCATION_API_DELTA_CONV_H
+#define LOCATION_API_DELTA_CONV_H
+
+#include <stdint.h>
+#include <atomic>
+#include <LocationDataTypes.h>
+#include "LocationApiDataTypes.pb.h"
+
+class LocationApiPbMsgConv;
+
+// a keyframe at least every this many reports, for a client whose chain of
+// deltas broke, e.g. on a report dropped from its send queue, to get back in
+#define LOC_DELTA_KEYFRAME_INTERVAL (10)
+// values sent as changes are quantized to 1 / LOC_DELTA_QUANT_SCALE units,
+// e.g. 0.01 dB-Hz for C/N0
+#define LOC_DELTA_QUANT_SCALE (100)
+
+/******************************************************************************
+LocAPIDeltaConv
+
+SV and measurement reports mostly carry the signals of the report before,
+with values that change a little from one report to the next. A client that
+subscribes E_LOC_CB_DELTA_ENCODING_BIT gets them as keyframes, with every
+signal in full, and deltas, with each signal of the report before sent as
+the change of its values and only the others in full. The daemon encodes a
+report once for all such clients, and each client decodes with a conv of its
+own into the report the full msg would have given, but for the values sent
+as quantized changes.
+
+A delta is only decoded on the report it was made from. After a gap in seq
+the client drops deltas until the next keyframe, which is sent at least
+every LOC_DELTA_KEYFRAME_INTERVAL reports and on requestKeyframe(), e.g.
+when a client subscribes. encode() and decode() are not thread safe,
+requestKeyframe() is.
+******************************************************************************/
+class LocAPIDeltaConv {
+public:
+    // the next report encoded is a keyframe
+    inline void requestKeyframe() { mKeyframeRequested = true; }
+
+protected:
+    // quantized values of a signal, valid if all of them are in range
+    struct Quantized {
+        bool valid;
+        int32_t values[4];
+    };
+
+    LocAPIDeltaConv();
+    // encoder: takes seq of the next report and the one it is a delta on,
+    // 0 for a keyframe
+    void nextSeq(uint32_t& seq, uint32_t& baseSeq);
+    // decoder: returns true if the report of seq can be decoded, which a
+    // keyframe always can, and a delta only on the last report decoded
+    bool checkSeq(uint32_t seq, uint32_t baseSeq);
+    // decoder: the daemon sends a report identical to the one before as the
+    // msg it already sent, which gives the last report decoded again
+    inline bool isRepeat(uint32_t seq) const { return mValid && (seq == mSeq); }
+    // puts the report just built in place of the base
+    inline void flip(bool valid) { mCur ^= 1; mValid = valid; }
+    static bool quantizeValue(double value, int32_t& quantized);
+    static double dequantizeValue(int32_t quantized);
+
+    uint32_t mSeq;
+    uint32_t mNumDeltas;
+    std::atomic<bool> mKeyframeRequested;
+    // decoder holds the report of mSeq
+    bool mValid;
+    // of the two reports held, index of the base; the other is built from it
+    uint8_t mCur;
+};
+
+class LocAPISvDeltaConv : public LocAPIDeltaConv {
+public:
+    LocAPISvDeltaConv();
+
+    // encodes report as a delta on the last report encoded, or as a
+    // keyframe. Returns 0 on success.
+    int encode(const GnssSvNotification& report, const LocationApiPbMsgConv& pbConv,
+               PBLocApiGnssSvDeltaNotification& pbDelta);
+    // the report pbDelta rebuilds, valid until the next decode, or nullptr
+    // if it is a delta on a report not decoded
+    const GnssSvNotification* decode(const PBLocApiGnssSvDeltaNotification& pbDelta,
+                                     const LocationApiPbMsgConv& pbConv);
+
+#ifdef __LOC_UNIT_TEST__
+    // Sends rounds reports of a sky of moving SVs, some rising and setting,
+    // as full msgs and as deltas through serialize, parse and decode, with
+    // one delta lost. Returns the number of reports not decoded as the full
+    // msgs give them, plus one if the deltas took no fewer bytes; 0 on success.
+    static uint32_t check(uint32_t rounds);
+#endif
+
+private:
+    static bool isSameSignal(const GnssSv& sv, const GnssSv& baseSv);
+    static Quantized quantize(const GnssSv& sv);
+
+    GnssSvNotification mReports[2];
+    Quantized mQuantized[2][GNSS_SV_MAX];
+};
+
+class LocAPIMeasDeltaConv : public LocAPIDeltaConv {
+public:
+    LocAPIMeasDeltaConv();
+
+    // encodes report as a delta on the last report encoded, or as a
+    // keyframe. Returns 0 on success.
+    int encode(const GnssMeasurementsNotification& report, const LocationApiPbMsgConv& pbConv,
+               PBGnssMeasurementsDeltaNotification& pbDelta);
+    // the report pbDelta rebuilds, valid until the next decode, or nullptr
+    // if it is a delta on a report not decoded
+    const GnssMeasurementsNotification* decode(
+            const PBGnssMeasurementsDeltaNotification& pbDelta,
+            const LocationApiPbMsgConv& pbConv);
+
+#ifdef __LOC_UNIT_TEST__
+    // as LocAPISvDeltaConv::check(), with a measurement per SV
+    static uint32_t check(uint32_t rounds);
+#endif
+
+private:
+    static bool isSameSignal(const GnssMeasurementsData& meas,
+                             const GnssMeasurementsData& baseMeas);
+    static Quantized quantize(const GnssMeasurementsData& meas);
+
+    GnssMeasurementsNotification mReports[2];
+    Quantized mQuantized[2][GNSS_MEASUREMENTS_MAX];
+};
+
+#endif //LOCATION_API_DELTA_CONV_H
@@ -29,6 +29,7 @@
 
 #include <inttypes.h>
 #include <dirent.h>
+#include <endian.h>
 
 #include <loc_pla.h>
 #include <log_util.h>
@@ -40,8 +41,203 @@
 
 #include <LocationApiMsg.h>
 #include <LocationApiPbMsgConv.h>
+#include <LocationApiDeltaConv.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+#ifdef __LOC_UNIT_TEST__
+#include <time.h>
+#endif
 
 using namespace loc_util;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+// IPC WIRE FORMAT
+// ***************
+int LocAPIMsgHeader::encodeToProtobuf(PBLocAPIMsgHeader& pbHdr,
+        const google::protobuf::MessageLite* pbPayload, uint32_t payloadSize,
+        string& protoStr) const {
+    // also caches the sizes SerializeWithCachedSizesToArray needs
+    size_t pbPayloadSize = (nullptr != pbPayload) ? pbPayload->ByteSizeLong() : 0;
+    if (pbPayloadSize > INT32_MAX) {
+        LOC_LOGe("payload of msg id %d too big %zu", msgId, pbPayloadSize);
+        return 0;
+    }
+
+    if (LOCAPI_MSG_WIRE_V2 == pLocApiPbMsgConv->getWireVersion()) {
+        const string& sockName = pbHdr.msocketname();
+        LocAPIMsgWireHeader wireHdr;
+        wireHdr.magic = htole32(LOCAPI_MSG_WIRE_V2_MAGIC);
+        wireHdr.msgId = htole32((uint32_t)pbHdr.msgid());
+        wireHdr.msgVersion = htole32(pbHdr.msgversion());
+        wireHdr.payloadSize = htole32(payloadSize);
+        wireHdr.sockNameLength = htole32(sockName.size() + 1);
+        wireHdr.clientHandle = htole32(pLocApiPbMsgConv->getClientHandle());
+
+        protoStr.resize(sizeof(wireHdr) + sockName.size() + 1 + pbPayloadSize);
+        char* target = &protoStr[0];
+        memcpy(target, &wireHdr, sizeof(wireHdr));
+        target += sizeof(wireHdr);
+        memcpy(target, sockName.c_str(), sockName.size() + 1);
+        target += sockName.size() + 1;
+        if (pbPayloadSize > 0) {
+            pbPayload->SerializeWithCachedSizesToArray((uint8_t*)target);
+        }
+    } else {
+        // uint32   payloadSize = 5;
+        pbHdr.set_payloadsize(payloadSize);
+        if (!pbHdr.SerializeToString(&protoStr)) {
+            LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+            return 0;
+        }
+        // bytes       payload = 4;
+        // appended after the other fields, which parsers take in any order, so
+        // the typed msg is serialized in place instead of into a copied string
+        if (pbPayloadSize > 0) {
+            uint8_t prefix[10]; // tag and length, 5 bytes max each
+            uint8_t* prefixEnd = CodedOutputStream::WriteTagToArray(
+                    WireFormatLite::MakeTag(PBLocAPIMsgHeader::kPayloadFieldNumber,
+                                            WireFormatLite::WIRETYPE_LENGTH_DELIMITED),
+                    prefix);
+            prefixEnd = CodedOutputStream::WriteVarint32ToArray(pbPayloadSize, prefixEnd);
+            size_t offset = protoStr.size();
+            protoStr.resize(offset + (prefixEnd - prefix) + pbPayloadSize);
+            memcpy(&protoStr[offset], prefix, prefixEnd - prefix);
+            pbPayload->SerializeWithCachedSizesToArray(
+                    (uint8_t*)&protoStr[offset + (prefixEnd - prefix)]);
+        }
+    }
+    return protoStr.size();
+}
+
+void LocAPIMsgHeader::setWireClientHandle(string& protoStr, uint32_t clientHandle) {
+    LocAPIMsgWireHeader wireHdr;
+    if (protoStr.size() >= sizeof(wireHdr)) {
+        memcpy(&wireHdr, protoStr.data(), sizeof(wireHdr));
+        if (LOCAPI_MSG_WIRE_V2_MAGIC == le32toh(wireHdr.magic)) {
+            wireHdr.clientHandle = htole32(clientHandle);
+            memcpy(&protoStr[0], &wireHdr, sizeof(wireHdr));
+        }
+    }
+}
+
+// PROTOBUF ARENA
+// **************
+// first block of a thread's arena, holds an indication of GNSS_MEASUREMENTS_MAX
+// measurements, the biggest there is
+#define LOCAPI_PB_ARENA_BLOCK_SIZE (64 * 1024)
+
+struct LocAPIPbArena::ThreadArena {
+    std::unique_ptr<char[]> mBlock;
+    google::protobuf::Arena mArena;
+    bool mInUse;
+
+    static inline google::protobuf::ArenaOptions blockOptions(char* block) {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block;
+        options.initial_block_size = LOCAPI_PB_ARENA_BLOCK_SIZE;
+        return options;
+    }
+    inline ThreadArena() :
+        mBlock(new char[LOCAPI_PB_ARENA_BLOCK_SIZE]),
+        mArena(blockOptions(mBlock.get())), mInUse(false) {}
+};
+
+thread_local std::unique_ptr<LocAPIPbArena::ThreadArena> LocAPIPbArena::sThreadArena;
+
+LocAPIPbArena::LocAPIPbArena() : mThreadArena(nullptr), mArena(nullptr) {
+    if (nullptr == sThreadArena) {
+        sThreadArena.reset(new ThreadArena());
+    }
+    if (!sThreadArena->mInUse) {
+        mThreadArena = sThreadArena.get();
+        mThreadArena->mInUse = true;
+        mArena = &mThreadArena->mArena;
+    } else {
+        mOwnArena.reset(new google::protobuf::Arena());
+        mArena = mOwnArena.get();
+    }
+}
+
+LocAPIPbArena::~LocAPIPbArena() {
+    if (nullptr != mThreadArena) {
+        // keeps the first block, frees any the msg took beyond it
+        mThreadArena->mArena.Reset();
+        mThreadArena->mInUse = false;
+    }
+}
+
+bool LocAPIMsgView::parse(const char* data, uint32_t length) {
+    LocAPIMsgWireHeader wireHdr;
+    if (length >= sizeof(wireHdr)) {
+        memcpy(&wireHdr, data, sizeof(wireHdr));
+    }
+    if (length >= sizeof(wireHdr) && LOCAPI_MSG_WIRE_V2_MAGIC == le32toh(wireHdr.magic)) {
+        uint32_t sockNameLength = le32toh(wireHdr.sockNameLength);
+        const char* sockNameStart = data + sizeof(wireHdr);
+        if (0 == sockNameLength || sockNameLength > length - sizeof(wireHdr) ||
+                '\0' != sockNameStart[sockNameLength - 1]) {
+            LOC_LOGe("bad socket name length %u", sockNameLength);
+            return false;
+        }
+        wireVersion = LOCAPI_MSG_WIRE_V2;
+        msgId = (PBELocMsgID)le32toh(wireHdr.msgId);
+        msgVersion = le32toh(wireHdr.msgVersion);
+        payloadSize = le32toh(wireHdr.payloadSize);
+        clientHandle = le32toh(wireHdr.clientHandle);
+        strlcpy(sockName, sockNameStart, sizeof(sockName));
+        payload = sockNameStart + sockNameLength;
+        payloadLength = length - sizeof(wireHdr) - sockNameLength;
+        return true;
+    }
+
+    // v1, PBLocAPIMsgHeader is read field by field so that payload can
+    // point into data rather than be copied into a string
+    CodedInputStream input((const uint8_t*)data, length);
+    wireVersion = LOCAPI_MSG_WIRE_V1;
+    for (uint32_t tag = input.ReadTag(); 0 != tag; tag = input.ReadTag()) {
+        int field = WireFormatLite::GetTagFieldNumber(tag);
+        WireFormatLite::WireType type = WireFormatLite::GetTagWireType(tag);
+        if (WireFormatLite::WIRETYPE_LENGTH_DELIMITED == type &&
+                (PBLocAPIMsgHeader::kMSocketNameFieldNumber == field ||
+                 PBLocAPIMsgHeader::kPayloadFieldNumber == field)) {
+            uint32_t fieldLength = 0;
+            if (!input.ReadVarint32(&fieldLength) ||
+                    fieldLength > length - input.CurrentPosition()) {
+                return false;
+            }
+            const char* fieldStart = data + input.CurrentPosition();
+            if (PBLocAPIMsgHeader::kMSocketNameFieldNumber == field) {
+                size_t nameLength = std::min((size_t)fieldLength, sizeof(sockName) - 1);
+                memcpy(sockName, fieldStart, nameLength);
+                sockName[nameLength] = '\0';
+            } else {
+                payload = fieldStart;
+                payloadLength = fieldLength;
+            }
+            input.Skip(fieldLength);
+        } else if (WireFormatLite::WIRETYPE_VARINT == type &&
+                (PBLocAPIMsgHeader::kMsgIdFieldNumber == field ||
+                 PBLocAPIMsgHeader::kMsgVersionFieldNumber == field ||
+                 PBLocAPIMsgHeader::kPayloadSizeFieldNumber == field)) {
+            uint64_t value = 0;
+            if (!input.ReadVarint64(&value)) {
+                return false;
+            }
+            if (PBLocAPIMsgHeader::kMsgIdFieldNumber == field) {
+                msgId = (PBELocMsgID)value;
+            } else if (PBLocAPIMsgHeader::kMsgVersionFieldNumber == field) {
+                msgVersion = (uint32_t)value;
+            } else {
+                payloadSize = (uint32_t)value;
+            }
+        } else if (!WireFormatLite::SkipField(&input, tag)) {
+            return false;
+        }
+    }
+    return input.ConsumedEntireMessage();
+}
 
 
 // SERIALIZE RIGID TO PROTOBUF FORMAT
@@ -70,20 +266,14 @@ int LocAPIClientRegisterReqMsg::serializeToProtobuf(string& protoStr) {
     // >>>> PBLocAPIClientRegisterReqMsg conversion
     // PBClientType mClientType = 1;
     pbLocApiClientRegMsg.set_mclienttype(pLocApiPbMsgConv->getPBEnumForClientType(mClientType));
+    // bool mShmCapable = 2;
+    pbLocApiClientRegMsg.set_mshmcapable(mShmCapable);
+    // uint32 mWireVersion = 3;
+    pbLocApiClientRegMsg.set_mwireversion(mWireVersion);
 
-    string pbStr;
-    if (!pbLocApiClientRegMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiClientRegMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIClientRegisterReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiClientRegMsg, sizeof(LocAPIClientRegisterReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -106,10 +296,7 @@ int LocAPIClientDeregisterReqMsg::serializeToProtobuf(string& protoStr) {
     // bytes       payload = 4;
     // LocAPIClientDeregisterReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIClientDeregisterReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocAPIClientDeregisterReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -137,19 +324,9 @@ int LocAPICapabilitiesIndMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiCapabInd.set_capabilitiesmask(
             pLocApiPbMsgConv->getPBMaskForLocationCapabilitiesMask(capabilitiesMask));
 
-    string pbStr;
-    if (!pbLocApiCapabInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiCapabInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPICapabilitiesIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiCapabInd, sizeof(LocAPICapabilitiesIndMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -173,10 +350,7 @@ int LocAPIHalReadyIndMsg::serializeToProtobuf(string& protoStr) {
     // bytes       payload = 4;
     // LocAPIHalReadyIndMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIHalReadyIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocAPIHalReadyIndMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -202,19 +376,9 @@ int LocAPIGenericRespMsg::serializeToProtobuf(string& protoStr) {
     // PBLocationError err = 1;
     pbLocApiGenericMsg.set_err(pLocApiPbMsgConv->getPBEnumForLocationError(err));
 
-    string pbStr;
-    if (!pbLocApiGenericMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGenericMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGenericRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiGenericMsg, sizeof(LocAPIGenericRespMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -242,7 +406,6 @@ int LocAPICollectiveRespMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != collectiveResp) {
         if (pLocApiPbMsgConv->convertCollectiveResPayloadToPB(collectiveRes, collectiveResp)) {
             LOC_LOGe("convertCollectiveResPayloadToPB failed");
-            free(collectiveResp);
             return 0;
         }
     } else {
@@ -250,19 +413,9 @@ int LocAPICollectiveRespMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiCollctvRspMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiCollctvRspMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPICollectiveRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiCollctvRspMsg, sizeof(LocAPICollectiveRespMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -292,7 +445,6 @@ int LocAPIStartTrackingReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != locOpt) {
         if (pLocApiPbMsgConv->convertLocationOptionsToPB(locOptions, locOpt)) {
             LOC_LOGe("convertLocationOptionsToPB failed");
-            free(locOpt);
             return 0;
         }
     } else {
@@ -300,19 +452,9 @@ int LocAPIStartTrackingReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiStartTrack.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiStartTrack failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStartTrackingReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiStartTrack, sizeof(LocAPIStartTrackingReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -337,10 +479,7 @@ int LocAPIStopTrackingReqMsg::serializeToProtobuf(string& protoStr) {
     // bytes       payload = 4;
     // LocAPIStopTrackingReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStopTrackingReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocAPIStopTrackingReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -367,19 +506,9 @@ int LocAPIUpdateCallbacksReqMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiUpdateCbsReg.set_locationcallbacks(
             pLocApiPbMsgConv->getPBMaskForLocationCallbacksMask(locationCallbacks));
 
-    string pbStr;
-    if (!pbLocApiUpdateCbsReg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUpdateCbsReg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateCallbacksReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiUpdateCbsReg, sizeof(LocAPIUpdateCallbacksReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -407,7 +536,6 @@ int LocAPIUpdateTrackingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != locOpt) {
         if (pLocApiPbMsgConv->convertLocationOptionsToPB(locOptions, locOpt)) {
             LOC_LOGe("convertLocationOptionsToPB failed");
-            free(locOpt);
             return 0;
         }
     } else {
@@ -415,19 +543,9 @@ int LocAPIUpdateTrackingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiUpdtTrackOpt.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUpdtTrackOpt failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateTrackingOptionsReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiUpdtTrackOpt, sizeof(LocAPIUpdateTrackingOptionsReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -459,19 +577,9 @@ int LocAPIStartBatchingReqMsg::serializeToProtobuf(string& protoStr) {
     // PBBatchingMode batchingMode = 3;
     pbLocApiStartBatch.set_batchingmode(pLocApiPbMsgConv->getPBEnumForBatchingMode(batchingMode));
 
-    string pbStr;
-    if (!pbLocApiStartBatch.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiStartBatch failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStartBatchingReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiStartBatch, sizeof(LocAPIStartBatchingReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -494,10 +602,7 @@ int LocAPIStopBatchingReqMsg::serializeToProtobuf(string& protoStr) {
     // bytes       payload = 4;
     // LocAPIStopBatchingReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIStopBatchingReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocAPIStopBatchingReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -527,19 +632,9 @@ int LocAPIUpdateBatchingOptionsReqMsg::serializeToProtobuf(string& protoStr) {
     // PBBatchingMode batchingMode = 3;
     pbLocApiUptBatchOpt.set_batchingmode(pLocApiPbMsgConv->getPBEnumForBatchingMode(batchingMode));
 
-    string pbStr;
-    if (!pbLocApiUptBatchOpt.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUptBatchOpt failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateBatchingOptionsReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiUptBatchOpt, sizeof(LocAPIUpdateBatchingOptionsReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -567,7 +662,6 @@ int LocAPIAddGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gfAddReqPayload) {
         if (pLocApiPbMsgConv->convertGfAddedReqPayloadToPB(geofences, gfAddReqPayload)) {
             LOC_LOGe("convertGfAddedReqPayloadToPB failed");
-            free(gfAddReqPayload);
             return 0;
         }
     } else {
@@ -575,19 +669,9 @@ int LocAPIAddGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiAddGfReqMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiAddGfReqMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIAddGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiAddGfReqMsg, sizeof(LocAPIAddGeofencesReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -617,7 +701,6 @@ int LocAPIRemoveGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gfReqClntIdPayload) {
         if (pLocApiPbMsgConv->convertGfReqClientIdPayloadToPB(gfClientIds, gfReqClntIdPayload)) {
             LOC_LOGe("convertGfReqClientIdPayloadToPB failed");
-            free(gfReqClntIdPayload);
             return 0;
         }
     } else {
@@ -625,19 +708,9 @@ int LocAPIRemoveGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiRemGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiRemGf failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIRemoveGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiRemGf, sizeof(LocAPIRemoveGeofencesReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -667,7 +740,6 @@ int LocAPIModifyGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gfModReqPayload) {
         if (pLocApiPbMsgConv->convertGfAddedReqPayloadToPB(geofences, gfModReqPayload)) {
             LOC_LOGe("convertGfAddedReqPayloadToPB failed");
-            free(gfModReqPayload);
             return 0;
         }
     } else {
@@ -675,19 +747,9 @@ int LocAPIModifyGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiModGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiModGf failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIModifyGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiModGf, sizeof(LocAPIModifyGeofencesReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -717,7 +779,6 @@ int LocAPIPauseGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gfReqClntIdPayload) {
         if (pLocApiPbMsgConv->convertGfReqClientIdPayloadToPB(gfClientIds, gfReqClntIdPayload)) {
             LOC_LOGe("convertGfReqClientIdPayloadToPB failed");
-            free(gfReqClntIdPayload);
             return 0;
         }
     } else {
@@ -725,19 +786,9 @@ int LocAPIPauseGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiPauseGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPauseGf failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPauseGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiPauseGf, sizeof(LocAPIPauseGeofencesReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -767,7 +818,6 @@ int LocAPIResumeGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gfReqClntIdPayload) {
         if (pLocApiPbMsgConv->convertGfReqClientIdPayloadToPB(gfClientIds, gfReqClntIdPayload)) {
             LOC_LOGe("convertGfReqClientIdPayloadToPB failed");
-            free(gfReqClntIdPayload);
             return 0;
         }
     } else {
@@ -775,19 +825,9 @@ int LocAPIResumeGeofencesReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiResumeGf.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiResumeGf failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIResumeGeofencesReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiResumeGf, sizeof(LocAPIResumeGeofencesReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -815,19 +855,9 @@ int LocAPIUpdateNetworkAvailabilityReqMsg::serializeToProtobuf(string& protoStr)
     // bool mAvailability = 1;
     pbLocApiUptNetwAvail.set_mavailability(mAvailability);
 
-    string pbStr;
-    if (!pbLocApiUptNetwAvail.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiUptNetwAvail failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIUpdateNetworkAvailabilityReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiUptNetwAvail, sizeof(LocAPIUpdateNetworkAvailabilityReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -850,10 +880,7 @@ int LocAPIGetGnssEnergyConsumedReqMsg::serializeToProtobuf(string& protoStr) {
     // bytes       payload = 4;
     // LocAPIGetGnssEnergyConsumedReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetGnssEnergyConsumedReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocAPIGetGnssEnergyConsumedReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -885,20 +912,9 @@ int LocAPIGetSingleTerrestrialPosReqMsg::serializeToProtobuf(string& protoStr) {
     // float horQoS = 3;
     pbLocGetTerrestrialPosReq.set_horqos(mHorQoS);
 
-    string pbStr;
-    if (!pbLocGetTerrestrialPosReq.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocGetTerrestrialPosReq failed!");
-        return 0;
-    }
-
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetSingleTerrestrialPosReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocGetTerrestrialPosReq, sizeof(LocAPIGetSingleTerrestrialPosReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -942,7 +958,6 @@ int LocAPIGetSingleTerrestrialPosRespMsg::serializeToProtobuf(string& protoStr)
     if (nullptr != pbLocation) {
         if (pLocApiPbMsgConv->convertLocationToPB(mLocation, pbLocation)) {
             LOC_LOGe("convertLocationToPB failed");
-            free(pbLocation);
             return 0;
         }
     } else {
@@ -950,20 +965,9 @@ int LocAPIGetSingleTerrestrialPosRespMsg::serializeToProtobuf(string& protoStr)
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocGetTerrestrialPosResp.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocGetTerrestrialPosResp failed!");
-        return 0;
-    }
-
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGetSingleTerrestrialPosRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocGetTerrestrialPosResp, sizeof(LocAPIGetSingleTerrestrialPosRespMsg), protoStr)) {
         return 0;
     }
 
@@ -1013,7 +1017,6 @@ int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != location) {
         if (pLocApiPbMsgConv->convertLocationToPB(locationNotification, location)) {
             LOC_LOGe("convertLocationToPB failed");
-            free(location);
             return 0;
         }
     } else {
@@ -1021,19 +1024,9 @@ int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiLocInd, sizeof(LocAPILocationIndMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -1043,8 +1036,10 @@ int LocAPILocationIndMsg::serializeToProtobuf(string& protoStr) {
 
 // Convert LocAPIBatchingIndMsg -> PBLocAPIBatchingIndMsg
 int LocAPIBatchingIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIBatchingIndMsg pbLocApiBatchInd;
+    // both freed with the arena
+    LocAPIPbArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = *arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIBatchingIndMsg& pbLocApiBatchInd = *arena.create<PBLocAPIBatchingIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
@@ -1064,7 +1059,6 @@ int LocAPIBatchingIndMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertLocAPIBatchingNotifMsgToPB(batchNotification,
                 locApiBatchIndMsg)) {
             LOC_LOGe("convertLocAPIBatchingNotifMsgToPB failed");
-            free(locApiBatchIndMsg);
             return 0;
         }
     } else {
@@ -1072,23 +1066,11 @@ int LocAPIBatchingIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiBatchInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiBatchInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIBatchingIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiBatchInd, sizeof(LocAPIBatchingIndMsg), protoStr)) {
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIBatchingIndMsg(pbLocApiBatchInd);
     return protoStr.size();
 }
 
@@ -1116,7 +1098,6 @@ int LocAPIGeofenceBreachIndMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertLocAPIGfBreachNotifToPB(gfBreachNotification,
                 locApiGfBreachNotif)) {
             LOC_LOGe("convertLocAPIGfBreachNotifToPB failed");
-            free(locApiGfBreachNotif);
             return 0;
         }
     } else {
@@ -1124,19 +1105,9 @@ int LocAPIGeofenceBreachIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiGfBreach.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGfBreach failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGeofenceBreachIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiGfBreach, sizeof(LocAPIGeofenceBreachIndMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -1146,8 +1117,10 @@ int LocAPIGeofenceBreachIndMsg::serializeToProtobuf(string& protoStr) {
 
 // Convert LocAPILocationInfoIndMsg -> PBLocAPILocationInfoIndMsg
 int LocAPILocationInfoIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPILocationInfoIndMsg pbLocApiLocInfoInd;
+    // both freed with the arena
+    LocAPIPbArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = *arena.create<PBLocAPIMsgHeader>();
+    PBLocAPILocationInfoIndMsg& pbLocApiLocInfoInd = *arena.create<PBLocAPILocationInfoIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
@@ -1168,7 +1141,6 @@ int LocAPILocationInfoIndMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertGnssLocInfoNotifToPB(gnssLocationInfoNotification,
                 gnssLocInfoNotif)) {
             LOC_LOGe("convertGnssLocInfoNotifToPB failed");
-            free(gnssLocInfoNotif);
             return 0;
         }
     } else {
@@ -1176,30 +1148,21 @@ int LocAPILocationInfoIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocInfoInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocInfoInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationInfoIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiLocInfoInd, sizeof(LocAPILocationInfoIndMsg), protoStr)) {
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPILocationInfoIndMsg(pbLocApiLocInfoInd);
     return protoStr.size();
 }
 
 // Convert LocAPIEngineLocationsInfoIndMsg -> PBLocAPIEngineLocationsInfoIndMsg
 int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIEngineLocationsInfoIndMsg pbLocApiEngLocInfo;
+    // both freed with the arena
+    LocAPIPbArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = *arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIEngineLocationsInfoIndMsg& pbLocApiEngLocInfo =
+            *arena.create<PBLocAPIEngineLocationsInfoIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
@@ -1216,6 +1179,7 @@ int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
     // max array size - PBLocApiOutputEngineType::PB_LOC_OUTPUT_ENGINE_COUNT
     // repeated PBGnssLocationInfoNotification engineLocationsInfo = 1;
     uint32_t arrLen = min(count, (uint32_t) LOC_OUTPUT_ENGINE_COUNT);
+    pbLocApiEngLocInfo.mutable_enginelocationsinfo()->Reserve(arrLen);
     for (uint32_t i = 0; i < arrLen; i++) {
         PBGnssLocationInfoNotification *gnssLocInfoNotif =
                 pbLocApiEngLocInfo.add_enginelocationsinfo();
@@ -1223,7 +1187,6 @@ int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
             if (pLocApiPbMsgConv->convertGnssLocInfoNotifToPB(engineLocationsInfo[i],
                     gnssLocInfoNotif)) {
                 LOC_LOGe("convertGnssLocInfoNotifToPB failed");
-                free(gnssLocInfoNotif);
                 return 0;
             }
         } else {
@@ -1232,30 +1195,21 @@ int LocAPIEngineLocationsInfoIndMsg::serializeToProtobuf(string& protoStr) {
         }
     }
 
-    string pbStr;
-    if (!pbLocApiEngLocInfo.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiEngLocInfo failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIEngineLocationsInfoIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiEngLocInfo, sizeof(LocAPIEngineLocationsInfoIndMsg), protoStr)) {
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIEngineLocationsInfoIndMsg(pbLocApiEngLocInfo);
     return protoStr.size();
 }
 
 // Convert LocAPISatelliteVehicleIndMsg -> PBLocAPISatelliteVehicleIndMsg
 int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPISatelliteVehicleIndMsg pbLocApiSatVehInd;
+    // both freed with the arena
+    LocAPIPbArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = *arena.create<PBLocAPIMsgHeader>();
+    PBLocAPISatelliteVehicleIndMsg& pbLocApiSatVehInd =
+            *arena.create<PBLocAPISatelliteVehicleIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
@@ -1274,7 +1228,6 @@ int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gnssSvNotif) {
         if (pLocApiPbMsgConv->convertGnssSvNotifToPB(gnssSvNotification, gnssSvNotif)) {
             LOC_LOGe("convertGnssSvNotifToPB failed");
-            free(gnssSvNotif);
             return 0;
         }
     } else {
@@ -1282,23 +1235,11 @@ int LocAPISatelliteVehicleIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiSatVehInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiSatVehInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPISatelliteVehicleIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiSatVehInd, sizeof(LocAPISatelliteVehicleIndMsg), protoStr)) {
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPISatelliteVehicleIndMsg(pbLocApiSatVehInd);
     return protoStr.size();
 }
 
@@ -1326,7 +1267,6 @@ int LocAPINmeaIndMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertLocAPINmeaSerializedPayloadToPB(gnssNmeaNotification,
                 locAPINmeaSerPload)) {
             LOC_LOGe("convertLocAPINmeaSerializedPayloadToPB failed");
-            free(locAPINmeaSerPload);
             return 0;
         }
     } else {
@@ -1334,19 +1274,9 @@ int LocAPINmeaIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiNmeaInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiNmeaInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPINmeaIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiNmeaInd, sizeof(LocAPINmeaIndMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -1356,8 +1286,10 @@ int LocAPINmeaIndMsg::serializeToProtobuf(string& protoStr) {
 
 // Convert LocAPIDataIndMsg -> PBLocAPIDataIndMsg
 int LocAPIDataIndMsg ::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIDataIndMsg pbLocApiDataInd;
+    // both freed with the arena
+    LocAPIPbArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = *arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIDataIndMsg& pbLocApiDataInd = *arena.create<PBLocAPIDataIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
@@ -1376,7 +1308,6 @@ int LocAPIDataIndMsg ::serializeToProtobuf(string& protoStr) {
     if (nullptr != gnssDataNotif) {
         if (pLocApiPbMsgConv->convertGnssDataNotifToPB(gnssDataNotification, gnssDataNotif)) {
             LOC_LOGe("convertGnssDataNotifToPB failed");
-            free(gnssDataNotif);
             return 0;
         }
     } else {
@@ -1384,30 +1315,20 @@ int LocAPIDataIndMsg ::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiDataInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiDataInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIDataIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiDataInd, sizeof(LocAPIDataIndMsg), protoStr)) {
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIDataIndMsg(pbLocApiDataInd);
     return protoStr.size();
 }
 
 // Convert LocAPIMeasIndMsg -> PBLocAPIMeasIndMsg
 int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
-    PBLocAPIMsgHeader pLocApiMsgHdr;
-    PBLocAPIMeasIndMsg pbLocApiMeasInd;
+    // both freed with the arena
+    LocAPIPbArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = *arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIMeasIndMsg& pbLocApiMeasInd = *arena.create<PBLocAPIMeasIndMsg>();
 
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
@@ -1428,7 +1349,6 @@ int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertGnssMeasNotifToPB(gnssMeasurementsNotification,
                 gnssMeasNotif)) {
             LOC_LOGe("convertGnssMeasNotifToPB failed");
-            free(gnssMeasNotif);
             return 0;
         }
     } else {
@@ -1436,23 +1356,86 @@ int LocAPIMeasIndMsg ::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiMeasInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiMeasInd failed!");
+    // bytes       payload = 4;
+    // uint32   payloadSize = 5;
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiMeasInd, sizeof(LocAPIMeasIndMsg), protoStr)) {
         return 0;
     }
-    // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
+    return protoStr.size();
+}
+
+// Convert LocAPISatelliteVehicleDeltaIndMsg -> PBLocAPISatelliteVehicleDeltaIndMsg
+int LocAPISatelliteVehicleDeltaIndMsg::serializeToProtobuf(string& protoStr) {
+    // both freed with the arena
+    LocAPIPbArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = *arena.create<PBLocAPIMsgHeader>();
+    PBLocAPISatelliteVehicleDeltaIndMsg& pbLocApiSatVehDeltaInd =
+            *arena.create<PBLocAPISatelliteVehicleDeltaIndMsg>();
 
+    if (nullptr == pLocApiPbMsgConv) {
+        LOC_LOGe("pLocApiPbMsgConv is null!");
+        return 0;
+    }
+    // string      mSocketName = 1;
+    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // PBELocMsgID  msgId = 2;
+    pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
+    // uint32   msgVersion = 3;
+    pLocApiMsgHdr.set_msgversion(msgVersion);
+
+    // >>>> PBLocAPISatelliteVehicleDeltaIndMsg conversion
+    // PBLocApiGnssSvDeltaNotification gnssSvDeltaNotification = 1;
+    if (deltaConv.encode(gnssSvNotification, *pLocApiPbMsgConv,
+            *pbLocApiSatVehDeltaInd.mutable_gnsssvdeltanotification())) {
+        LOC_LOGe("LocAPISvDeltaConv encode failed");
+        return 0;
+    }
+
+    // bytes       payload = 4;
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIMeasIndMsg));
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiSatVehDeltaInd,
+            sizeof(LocAPISatelliteVehicleDeltaIndMsg), protoStr)) {
+        // the delta encoded is not sent, so the next can not be one on it
+        deltaConv.requestKeyframe();
+        return 0;
+    }
+    return protoStr.size();
+}
+
+// Convert LocAPIMeasDeltaIndMsg -> PBLocAPIMeasDeltaIndMsg
+int LocAPIMeasDeltaIndMsg::serializeToProtobuf(string& protoStr) {
+    // both freed with the arena
+    LocAPIPbArena arena;
+    PBLocAPIMsgHeader& pLocApiMsgHdr = *arena.create<PBLocAPIMsgHeader>();
+    PBLocAPIMeasDeltaIndMsg& pbLocApiMeasDeltaInd = *arena.create<PBLocAPIMeasDeltaIndMsg>();
 
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (nullptr == pLocApiPbMsgConv) {
+        LOC_LOGe("pLocApiPbMsgConv is null!");
+        return 0;
+    }
+    // string      mSocketName = 1;
+    pLocApiMsgHdr.set_msocketname(mSocketName);
+    // PBELocMsgID  msgId = 2;
+    pLocApiMsgHdr.set_msgid(pLocApiPbMsgConv->getPBEnumForELocMsgID(msgId));
+    // uint32   msgVersion = 3;
+    pLocApiMsgHdr.set_msgversion(msgVersion);
+
+    // >>>> PBLocAPIMeasDeltaIndMsg conversion
+    // PBGnssMeasurementsDeltaNotification gnssMeasurementsDeltaNotification = 1;
+    if (deltaConv.encode(gnssMeasurementsNotification, *pLocApiPbMsgConv,
+            *pbLocApiMeasDeltaInd.mutable_gnssmeasurementsdeltanotification())) {
+        LOC_LOGe("LocAPIMeasDeltaConv encode failed");
+        return 0;
+    }
+
+    // bytes       payload = 4;
+    // uint32   payloadSize = 5;
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiMeasDeltaInd,
+            sizeof(LocAPIMeasDeltaIndMsg), protoStr)) {
+        // the delta encoded is not sent, so the next can not be one on it
+        deltaConv.requestKeyframe();
         return 0;
     }
-    // free memory
-    pLocApiPbMsgConv->freeUpPBLocAPIMeasIndMsg(pbLocApiMeasInd);
     return protoStr.size();
 }
 
@@ -1477,19 +1460,9 @@ int LocAPIGnssEnergyConsumedIndMsg::serializeToProtobuf(string& protoStr) {
     pbLocApiGnssEnrgyConsmdInd.set_totalgnssenergyconsumedsincefirstboot(
             totalGnssEnergyConsumedSinceFirstBoot);
 
-    string pbStr;
-    if (!pbLocApiGnssEnrgyConsmdInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiGnssEnrgyConsmdInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIGnssEnergyConsumedIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiGnssEnrgyConsmdInd, sizeof(LocAPIGnssEnergyConsumedIndMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -1517,7 +1490,6 @@ int LocAPILocationSystemInfoIndMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != locSysInfo) {
         if (pLocApiPbMsgConv->convertLocSysInfoToPB(locationSystemInfo, locSysInfo)) {
             LOC_LOGe("convertLocSysInfoToPB failed");
-            free(locSysInfo);
             return 0;
         }
     } else {
@@ -1525,19 +1497,9 @@ int LocAPILocationSystemInfoIndMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocApiLocSysInfoInd.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiLocSysInfoInd failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPILocationSystemInfoIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiLocSysInfoInd, sizeof(LocAPILocationSystemInfoIndMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -1569,19 +1531,9 @@ int LocConfigConstrainedTuncReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32   mEnergyBudget = 3;
     pbLocConfConstrTunc.set_menergybudget(mEnergyBudget);
 
-    string pbStr;
-    if (!pbLocConfConstrTunc.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfConstrTunc failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigConstrainedTuncReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfConstrTunc, sizeof(LocConfigConstrainedTuncReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -1608,19 +1560,9 @@ int LocConfigPositionAssistedClockEstimatorReqMsg::serializeToProtobuf(string& p
     // bool     mEnable = 1;
     pbLocConfPosAsstdClockEst.set_menable(mEnable);
 
-    string pbStr;
-    if (!pbLocConfPosAsstdClockEst.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfPosAsstdClockEst failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigPositionAssistedClockEstimatorReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfPosAsstdClockEst, sizeof(LocConfigPositionAssistedClockEstimatorReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -1648,7 +1590,6 @@ int LocConfigSvConstellationReqMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertGnssSvTypeConfigToPB(mConstellationEnablementConfig,
                 gnssSvTypCfg)) {
             LOC_LOGe("convertGnssSvTypeConfigToPB failed");
-            free(gnssSvTypCfg);
             return 0;
         }
     } else {
@@ -1661,7 +1602,6 @@ int LocConfigSvConstellationReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != gnssSvIdCfg) {
         if (pLocApiPbMsgConv->convertGnssSvIdConfigToPB(mBlacklistSvConfig, gnssSvIdCfg)) {
             LOC_LOGe("convertGnssSvIdConfigToPB failed");
-            free(gnssSvIdCfg);
             return 0;
         }
     } else {
@@ -1674,19 +1614,9 @@ int LocConfigSvConstellationReqMsg::serializeToProtobuf(string& protoStr) {
     bool resetToDefault = (0 == mConstellationEnablementConfig.size);
     pbLocConfSvConst.set_mresettodefault(resetToDefault);
 
-    string pbStr;
-    if (!pbLocConfSvConst.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfSvConst failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigSvConstellationReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfSvConst, sizeof(LocConfigSvConstellationReqMsg), protoStr)) {
         return 0;
     }
 
@@ -1719,7 +1649,6 @@ int LocConfigConstellationSecondaryBandReqMsg::serializeToProtobuf(string& proto
         if (pLocApiPbMsgConv->convertGnssSvTypeConfigToPB(mSecondaryBandConfig,
                 gnssSvTypCfg)) {
             LOC_LOGe("convertGnssSvTypeConfigToPB failed");
-            free(gnssSvTypCfg);
             return 0;
         }
     } else {
@@ -1727,19 +1656,9 @@ int LocConfigConstellationSecondaryBandReqMsg::serializeToProtobuf(string& proto
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgConstlSecBandReqMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocCfgConstlSecBandReqMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigConstellationSecondaryBandReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocCfgConstlSecBandReqMsg, sizeof(LocConfigConstellationSecondaryBandReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -1769,7 +1688,6 @@ int LocConfigAidingDataDeletionReqMsg::serializeToProtobuf(string& protoStr) {
     if (nullptr != aidingData) {
         if (pLocApiPbMsgConv->convertGnssAidingDataToPB(mAidingData, aidingData)) {
             LOC_LOGe("convertGnssAidingDataToPB failed");
-            free(aidingData);
             return 0;
         }
     } else {
@@ -1777,19 +1695,9 @@ int LocConfigAidingDataDeletionReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfAidDataDel.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfAidDataDel failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigAidingDataDeletionReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfAidDataDel, sizeof(LocConfigAidingDataDeletionReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -1820,7 +1728,6 @@ int LocConfigLeverArmReqMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertLeverArmConfigInfoToPB(mLeverArmConfigInfo,
                 leverArmCfgInfo)) {
             LOC_LOGe("convertLeverArmConfigInfoToPB failed");
-            free(leverArmCfgInfo);
             return 0;
         }
     } else {
@@ -1828,19 +1735,9 @@ int LocConfigLeverArmReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfLeverArm.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfLeverArm failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigLeverArmReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfLeverArm, sizeof(LocConfigLeverArmReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -1870,19 +1767,9 @@ int LocConfigRobustLocationReqMsg::serializeToProtobuf(string& protoStr) {
     // bool mEnableForE911 = 2;
     pbLocConfRobustLoc.set_menablefore911(mEnableForE911);
 
-    string pbStr;
-    if (!pbLocConfRobustLoc.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfRobustLoc failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigRobustLocationReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfRobustLoc, sizeof(LocConfigRobustLocationReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -1908,19 +1795,9 @@ int LocConfigMinGpsWeekReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinGpsWeek = 1;
     pbLocConfMinGpsWeek.set_mmingpsweek(mMinGpsWeek);
 
-    string pbStr;
-    if (!pbLocConfMinGpsWeek.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfMinGpsWeek failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigMinGpsWeekReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfMinGpsWeek, sizeof(LocConfigMinGpsWeekReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -1949,7 +1826,6 @@ int LocConfigDrEngineParamsReqMsg::serializeToProtobuf(string& protoStr) {
         if (pLocApiPbMsgConv->convertDeadReckoningEngineConfigToPB(mDreConfig,
                 drReckoningEngConfig)) {
             LOC_LOGe("pbConvertToDeadReckoningEngineConfig failed");
-            free(drReckoningEngConfig);
             return 0;
         }
     } else {
@@ -1957,19 +1833,9 @@ int LocConfigDrEngineParamsReqMsg::serializeToProtobuf(string& protoStr) {
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgDrEngParamReq.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfB2sMntParam failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigDrEngineParamsReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocCfgDrEngParamReq, sizeof(LocConfigDrEngineParamsReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -1997,19 +1863,9 @@ int LocConfigMinSvElevationReqMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinSvElevation = 1;
     pbLocConfMinSvElev.set_mminsvelevation(mMinSvElevation);
 
-    string pbStr;
-    if (!pbLocConfMinSvElev.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfMinSvElev failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigMinSvElevationReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfMinSvElev, sizeof(LocConfigMinSvElevationReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2039,19 +1895,9 @@ int LocConfigEngineRunStateReqMsg::serializeToProtobuf(string& protoStr) {
     pbLocConfEngineRunState.set_mengstate((::PBLocEngineRunState)
             pLocApiPbMsgConv->getPBEnumForLocEngineRunState(mEngState));
 
-    string pbStr;
-    if (!pbLocConfEngineRunState.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfEngineRunState failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigEngineRunStateReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfEngineRunState, sizeof(LocConfigEngineRunStateReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2079,20 +1925,9 @@ int LocConfigUserConsentTerrestrialPositioningReqMsg::serializeToProtobuf(
     // bool userConsent
     pbMsg.set_userconsent(mUserConsent);
 
-    string pbStr;
-    if (!pbMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(
-            sizeof(LocConfigUserConsentTerrestrialPositioningReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbMsg, sizeof(LocConfigUserConsentTerrestrialPositioningReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2127,10 +1962,7 @@ int LocConfigGetRobustLocationConfigReqMsg::serializeToProtobuf(string& protoStr
     // bytes       payload = 4;
     // LocConfigGetRobustLocationConfigReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetRobustLocationConfigReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocConfigGetRobustLocationConfigReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2160,7 +1992,6 @@ int LocConfigGetRobustLocationConfigRespMsg::serializeToProtobuf(string& protoSt
         if (pLocApiPbMsgConv->convertGnssConfigRobustLocationToPB(mRobustLoationConfig,
                 gnssCfgRbstLoc)) {
             LOC_LOGe("convertGnssConfigRobustLocationToPB failed");
-            free(gnssCfgRbstLoc);
             return 0;
         }
     } else {
@@ -2168,19 +1999,9 @@ int LocConfigGetRobustLocationConfigRespMsg::serializeToProtobuf(string& protoSt
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocConfGetRobustLocConfg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetRobustLocConfg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetRobustLocationConfigRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfGetRobustLocConfg, sizeof(LocConfigGetRobustLocationConfigRespMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -2205,10 +2026,7 @@ int LocConfigGetMinGpsWeekReqMsg::serializeToProtobuf(string& protoStr) {
     // bytes       payload = 4;
     // LocConfigGetMinGpsWeekReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetMinGpsWeekReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocConfigGetMinGpsWeekReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2234,19 +2052,9 @@ int LocConfigGetMinGpsWeekRespMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinGpsWeek = 1;
     pbLocConfGetMinGpsWeekRsp.set_mmingpsweek(mMinGpsWeek);
 
-    string pbStr;
-    if (!pbLocConfGetMinGpsWeekRsp.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetMinGpsWeekRsp failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetMinGpsWeekRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfGetMinGpsWeekRsp, sizeof(LocConfigGetMinGpsWeekRespMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2269,10 +2077,7 @@ int LocConfigGetMinSvElevationReqMsg::serializeToProtobuf(string& protoStr) {
     // bytes       payload = 4;
     // LocConfigGetMinSvElevationReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetMinSvElevationReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocConfigGetMinSvElevationReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2298,19 +2103,9 @@ int LocConfigGetMinSvElevationRespMsg::serializeToProtobuf(string& protoStr) {
     // uint32 mMinSvElevation = 1;
     pbLocConfGetMinSvElev.set_mminsvelevation(mMinSvElevation);
 
-    string pbStr;
-    if (!pbLocConfGetMinSvElev.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocConfGetMinSvElev failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetMinSvElevationRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocConfGetMinSvElev, sizeof(LocConfigGetMinSvElevationRespMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2334,10 +2129,7 @@ int LocConfigGetConstellationSecondaryBandConfigReqMsg::serializeToProtobuf(stri
     // bytes       payload = 4;
     // LocConfigGetConstellationSecondaryBandConfigReqMsg - no struct member. No payload to send
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetConstellationSecondaryBandConfigReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, nullptr, sizeof(LocConfigGetConstellationSecondaryBandConfigReqMsg), protoStr)) {
         return 0;
     }
     return protoStr.size();
@@ -2368,7 +2160,6 @@ int LocConfigGetConstellationSecondaryBandConfigRespMsg::serializeToProtobuf(str
         if (pLocApiPbMsgConv->convertGnssSvTypeConfigToPB(mSecondaryBandConfig,
                 gnssSvTypCfg)) {
             LOC_LOGe("convertGnssSvTypeConfigToPB failed");
-            free(gnssSvTypCfg);
             return 0;
         }
     } else {
@@ -2376,19 +2167,9 @@ int LocConfigGetConstellationSecondaryBandConfigRespMsg::serializeToProtobuf(str
         return 0;
     }
 
-    string pbStr;
-    if (!pbLocCfgGetConstlSecBandRespMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocCfgGetConstlSecBandRespMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocConfigGetConstellationSecondaryBandConfigRespMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocCfgGetConstlSecBandRespMsg, sizeof(LocConfigGetConstellationSecondaryBandConfigRespMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -2421,19 +2202,9 @@ int LocAPIPingTestReqMsg::serializeToProtobuf(string& protoStr) {
         pbLocApiPingTest.add_data(data[i]);
     }
 
-    string pbStr;
-    if (!pbLocApiPingTest.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPingTest failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPingTestReqMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiPingTest, sizeof(LocAPIPingTestReqMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -2466,19 +2237,9 @@ int LocAPIPingTestIndMsg::serializeToProtobuf(string& protoStr) {
         pbLocApiPingTestIndMsg.add_data(data[i]);
     }
 
-    string pbStr;
-    if (!pbLocApiPingTestIndMsg.SerializeToString(&pbStr)) {
-        LOC_LOGe("SerializeToString on pbLocApiPingTestIndMsg failed!");
-        return 0;
-    }
     // bytes       payload = 4;
-    pLocApiMsgHdr.set_payload(pbStr);
-
     // uint32   payloadSize = 5;
-    pLocApiMsgHdr.set_payloadsize(sizeof(LocAPIPingTestIndMsg));
-
-    if (!pLocApiMsgHdr.SerializeToString(&protoStr)) {
-        LOC_LOGe("SerializeToString on pLocApiMsgHdr failed!");
+    if (0 == encodeToProtobuf(pLocApiMsgHdr, &pbLocApiPingTestIndMsg, sizeof(LocAPIPingTestIndMsg), protoStr)) {
         return 0;
     }
     // free memory
@@ -2496,7 +2257,8 @@ int LocAPIPingTestIndMsg::serializeToProtobuf(string& protoStr) {
 LocAPIClientRegisterReqMsg::LocAPIClientRegisterReqMsg(const char* name,
             const PBLocAPIClientRegisterReqMsg &pbLocApiClientRegReqMsg,
             const LocationApiPbMsgConv *pbMsgConv):
-        LocAPIMsgHeader(name, E_LOCAPI_CLIENT_REGISTER_MSG_ID, pbMsgConv) {
+        LocAPIMsgHeader(name, E_LOCAPI_CLIENT_REGISTER_MSG_ID, pbMsgConv),
+        mShmCapable(false), mWireVersion(0) {
     if (nullptr == pLocApiPbMsgConv) {
         LOC_LOGe("pLocApiPbMsgConv is null!");
         return;
@@ -2504,6 +2266,10 @@ LocAPIClientRegisterReqMsg::LocAPIClientRegisterReqMsg(const char* name,
     // >>>> PBLocAPIClientRegisterReqMsg conversion
     // PBClientType mClientType = 1;
     mClientType = pLocApiPbMsgConv->getEnumForPBClientType(pbLocApiClientRegReqMsg.mclienttype());
+    // bool mShmCapable = 2;
+    mShmCapable = pbLocApiClientRegReqMsg.mshmcapable();
+    // uint32 mWireVersion = 3;
+    mWireVersion = pbLocApiClientRegReqMsg.mwireversion();
 }
 
 // Decode PBLocAPICapabilitiesIndMsg -> LocAPICapabilitiesIndMsg
@@ -3144,3 +2910,189 @@ LocAPIPingTestIndMsg::LocAPIPingTestIndMsg(const char* name,
         LOC_LOGv("LocApiPB: LocAPIPingTestIndMsg pingData[%d]: %d", i, data[i]);
     }
 }
+
+#ifdef __LOC_UNIT_TEST__
+static inline uint64_t benchmarkNowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// one indication both ways: toPb fills the msg, fromPb converts it back and
+// returns true if it came back as sent, and freeUp is what
+// serializeToProtobuf called on a msg on the heap. Returns the number of
+// round trips that came back different, and ns and heap allocations per
+// round trip in result.
+template <typename PbMsg, typename ToPb, typename FromPb, typename FreeUp>
+static uint32_t roundTripIndication(uint32_t rounds, uint64_t (*allocCount)(), ToPb toPb,
+        FromPb fromPb, FreeUp freeUp, LocAPIPbArena::BenchResult& result) {
+    string payload;
+    uint32_t mismatches = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        bool useArena = (1 == pass);
+        uint64_t allocs = allocCount();
+        uint64_t start = benchmarkNowNs();
+        for (uint32_t r = 0; r < rounds; r++) {
+            if (useArena) {
+                {
+                    LocAPIPbArena arena;
+                    PbMsg* pbMsg = arena.create<PbMsg>();
+                    toPb(*pbMsg);
+                    pbMsg->SerializeToString(&payload);
+                }
+                LocAPIPbArena arena;
+                PbMsg* pbMsg = arena.create<PbMsg>();
+                if (!pbMsg->ParseFromString(payload) || !fromPb(*pbMsg)) {
+                    mismatches++;
+                }
+            } else {
+                {
+                    PbMsg pbMsg;
+                    toPb(pbMsg);
+                    pbMsg.SerializeToString(&payload);
+                    freeUp(pbMsg);
+                }
+                // parsed as LocAPIMsgView did, on an arena of a 2k block
+                alignas(8) char block[2048];
+                google::protobuf::ArenaOptions options;
+                options.initial_block = block;
+                options.initial_block_size = sizeof(block);
+                google::protobuf::Arena viewArena(options);
+                PbMsg* pbMsg = google::protobuf::Arena::CreateMessage<PbMsg>(&viewArena);
+                if (!pbMsg->ParseFromString(payload) || !fromPb(*pbMsg)) {
+                    mismatches++;
+                }
+            }
+        }
+        uint64_t ns = (0 == rounds) ? 0 : (benchmarkNowNs() - start) / rounds;
+        allocs = (0 == rounds) ? 0 : (allocCount() - allocs) / rounds;
+        if (useArena) {
+            result.arenaNs = ns;
+            result.arenaAllocs = allocs;
+        } else {
+            result.heapNs = ns;
+            result.heapAllocs = allocs;
+        }
+    }
+    return mismatches;
+}
+
+// round trips of a representative location info, SV and measurement
+// indication, returns the number that came back different
+static uint32_t roundTrip(uint32_t rounds, uint64_t (*allocCount)(),
+                          LocAPIPbArena::BenchResult results[LocAPIPbArena::BENCH_COUNT]) {
+    LocationApiPbMsgConv pbConv;
+    static GnssLocationInfoNotification locInfo, locInfoOut;
+    static GnssSvNotification sv, svOut;
+    static GnssMeasurementsNotification meas, measOut;
+
+    memset(&locInfo, 0, sizeof(locInfo));
+    locInfo.size = sizeof(locInfo);
+    locInfo.location.latitude = 37.3861;
+    locInfo.location.longitude = -122.0839;
+    locInfo.numOfMeasReceived = 40;
+    for (uint32_t i = 0; i < locInfo.numOfMeasReceived; i++) {
+        locInfo.measUsageInfo[i].gnssSvId = i + 1;
+        locInfo.measUsageInfo[i].gnssConstellation = GNSS_LOC_SV_SYSTEM_GPS;
+    }
+    memset(&sv, 0, sizeof(sv));
+    sv.size = sizeof(sv);
+    sv.count = 64;
+    for (uint32_t i = 0; i < sv.count; i++) {
+        sv.gnssSvs[i].svId = i + 1;
+        sv.gnssSvs[i].cN0Dbhz = 30.0f + (i % 20);
+        sv.gnssSvs[i].elevation = i % 90;
+        sv.gnssSvs[i].azimuth = 5.0f * i;
+    }
+    memset(&meas, 0, sizeof(meas));
+    meas.size = sizeof(meas);
+    meas.count = GNSS_MEASUREMENTS_MAX;
+    for (uint32_t i = 0; i < meas.count; i++) {
+        meas.measurements[i].svId = i + 1;
+        meas.measurements[i].receivedSvTimeNs = 1000000LL * i;
+        meas.measurements[i].carrierToNoiseDbHz = 30.0 + (i % 20);
+        meas.measurements[i].pseudorangeRateMps = 100.0 * i;
+    }
+
+    uint32_t mismatches = 0;
+    mismatches += roundTripIndication<PBLocAPILocationInfoIndMsg>(rounds, allocCount,
+            [&](PBLocAPILocationInfoIndMsg& pbMsg) {
+                pbConv.convertGnssLocInfoNotifToPB(locInfo,
+                        pbMsg.mutable_gnsslocationinfonotification());
+            },
+            [&](const PBLocAPILocationInfoIndMsg& pbMsg) {
+                memset(&locInfoOut, 0, sizeof(locInfoOut));
+                pbConv.pbConvertToGnssLocInfoNotif(pbMsg.gnsslocationinfonotification(),
+                        locInfoOut);
+                return locInfoOut.location.latitude == locInfo.location.latitude &&
+                        locInfoOut.location.longitude == locInfo.location.longitude &&
+                        locInfoOut.numOfMeasReceived == locInfo.numOfMeasReceived &&
+                        0 == memcmp(locInfoOut.measUsageInfo, locInfo.measUsageInfo,
+                                    locInfo.numOfMeasReceived * sizeof(locInfo.measUsageInfo[0]));
+            },
+            [&](PBLocAPILocationInfoIndMsg& pbMsg) {
+                pbConv.freeUpPBLocAPILocationInfoIndMsg(pbMsg);
+            },
+            results[LocAPIPbArena::BENCH_LOCATION_INFO]);
+    mismatches += roundTripIndication<PBLocAPISatelliteVehicleIndMsg>(rounds, allocCount,
+            [&](PBLocAPISatelliteVehicleIndMsg& pbMsg) {
+                pbConv.convertGnssSvNotifToPB(sv, pbMsg.mutable_gnsssvnotification());
+            },
+            [&](const PBLocAPISatelliteVehicleIndMsg& pbMsg) {
+                memset(&svOut, 0, sizeof(svOut));
+                pbConv.pbConvertToGnssSvNotif(pbMsg.gnsssvnotification(), svOut);
+                bool same = (svOut.count == sv.count);
+                for (uint32_t i = 0; same && i < sv.count; i++) {
+                    same = svOut.gnssSvs[i].svId == sv.gnssSvs[i].svId &&
+                            svOut.gnssSvs[i].cN0Dbhz == sv.gnssSvs[i].cN0Dbhz &&
+                            svOut.gnssSvs[i].elevation == sv.gnssSvs[i].elevation &&
+                            svOut.gnssSvs[i].azimuth == sv.gnssSvs[i].azimuth;
+                }
+                return same;
+            },
+            [&](PBLocAPISatelliteVehicleIndMsg& pbMsg) {
+                pbConv.freeUpPBLocAPISatelliteVehicleIndMsg(pbMsg);
+            },
+            results[LocAPIPbArena::BENCH_SV]);
+    mismatches += roundTripIndication<PBLocAPIMeasIndMsg>(rounds, allocCount,
+            [&](PBLocAPIMeasIndMsg& pbMsg) {
+                pbConv.convertGnssMeasNotifToPB(meas,
+                        pbMsg.mutable_gnssmeasurementsnotification());
+            },
+            [&](const PBLocAPIMeasIndMsg& pbMsg) {
+                memset(&measOut, 0, sizeof(measOut));
+                pbConv.pbConvertToGnssMeasNotification(pbMsg.gnssmeasurementsnotification(),
+                        measOut);
+                bool same = (measOut.count == meas.count);
+                for (uint32_t i = 0; same && i < meas.count; i++) {
+                    const GnssMeasurementsData& in = meas.measurements[i];
+                    const GnssMeasurementsData& out = measOut.measurements[i];
+                    same = out.svId == in.svId && out.receivedSvTimeNs == in.receivedSvTimeNs &&
+                            out.carrierToNoiseDbHz == in.carrierToNoiseDbHz &&
+                            out.pseudorangeRateMps == in.pseudorangeRateMps;
+                }
+                return same;
+            },
+            [&](PBLocAPIMeasIndMsg& pbMsg) {
+                pbConv.freeUpPBLocAPIMeasIndMsg(pbMsg);
+            },
+            results[LocAPIPbArena::BENCH_MEAS]);
+    return mismatches;
+}
+
+uint32_t LocAPIPbArena::checkRoundTrip(uint32_t rounds, uint64_t (*allocCount)()) {
+    BenchResult results[BENCH_COUNT];
+    uint32_t mismatches = roundTrip(rounds, allocCount, results);
+    for (const BenchResult& result : results) {
+        if (rounds > 0 && result.arenaAllocs >= result.heapAllocs) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+void LocAPIPbArena::benchmark(uint32_t rounds, uint64_t (*allocCount)(),
+                              BenchResult results[BENCH_COUNT]) {
+    roundTrip(rounds, allocCount, results);
+}
+#endif
@@ -40,6 +40,7 @@
 #include <errno.h>
 
 // Protobuf message headers
+#include <google/protobuf/arena.h>
 #include "LocationApiMsg.pb.h"
 #include "LocationApiDataTypes.pb.h"
 
@@ -48,6 +49,17 @@ Constants
 ******************************************************************************/
 #define LOCATION_REMOTE_API_MSG_VERSION (1)
 
+// IPC wire formats. v1 is a PBLocAPIMsgHeader with the typed msg serialized
+// into its payload, and is what every peer parses. v2 is a LocAPIMsgWireHeader,
+// then the NUL terminated socket name, then the serialized typed msg, so the
+// typed msg is serialized once and parsed in place. v2 is only sent to a peer
+// that has shown it parses it, see LocAPIClientRegisterReqMsg::mWireVersion.
+#define LOCAPI_MSG_WIRE_V1 (1)
+#define LOCAPI_MSG_WIRE_V2 (2)
+#define LOCAPI_MSG_WIRE_VERSION LOCAPI_MSG_WIRE_V2
+// first byte 0xff is never the first byte of a PBLocAPIMsgHeader
+#define LOCAPI_MSG_WIRE_V2_MAGIC (0x50414cff)
+
 // Maximum fully qualified path(including the file name)
 // for the location remote API service and client socket name
 #define MAX_SOCKET_PATHNAME_LENGTH (128)
@@ -245,6 +257,10 @@ enum ELocMsgID {
     E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_REQ_MSG_ID = 31,
     E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID = 32,
 
+    // SV and measurement reports as keyframes and deltas
+    E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID = 33,
+    E_LOCAPI_MEAS_DELTA_MSG_ID = 34,
+
     // ping
     E_LOCAPI_PINGTEST_MSG_ID = 99,
 
@@ -290,6 +306,7 @@ enum ELocationCallbacksOption {
     E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT  = (1<<9), /**< Register for multiple engine reports */
     E_LOC_CB_SIMPLE_LOCATION_INFO_BIT   = (1<<10), /**< Register for simple location */
     E_LOC_CB_GNSS_MEAS_BIT              = (1<<11), /**< Register for GNSS Measurements */
+    E_LOC_CB_DELTA_ENCODING_BIT         = (1<<12), /**< SV and Meas as keyframes and deltas */
 };
 
 // Mask related to all info that are tied with a position session and need to be unsubscribed
@@ -299,7 +316,8 @@ enum ELocationCallbacksOption {
                                        E_LOC_CB_GNSS_SV_BIT|E_LOC_CB_GNSS_NMEA_BIT|\
                                        E_LOC_CB_GNSS_DATA_BIT|E_LOC_CB_GNSS_MEAS_BIT|\
                                        E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT|\
-                                       E_LOC_CB_SIMPLE_LOCATION_INFO_BIT)
+                                       E_LOC_CB_SIMPLE_LOCATION_INFO_BIT|\
+                                       E_LOC_CB_DELTA_ENCODING_BIT)
 
 typedef uint32_t EngineInfoCallbacksMask;
 enum EEngineInfoCallbacksMask {
@@ -366,7 +384,97 @@ struct CollectiveResPayload {
 /******************************************************************************
 IPC message header structure
 ******************************************************************************/
+// header of a v2 wire format msg, all fields little endian
+struct LocAPIMsgWireHeader {
+    uint32_t   magic;               /**< LOCAPI_MSG_WIRE_V2_MAGIC */
+    uint32_t   msgId;               /**< PBELocMsgID */
+    uint32_t   msgVersion;          /**< Location remote API message version */
+    uint32_t   payloadSize;         /**< as in PBLocAPIMsgHeader */
+    uint32_t   sockNameLength;      /**< including the terminating NUL */
+    uint32_t   clientHandle;        /**< daemon's handle of the client, 0 if not known */
+};
+
+// Arena the protobuf msgs of one IPC msg are built on, or parsed into. Each
+// thread keeps an arena with a first block big enough for the largest
+// indication, and a LocAPIPbArena resets it when it goes out of scope, so a
+// thread converts msgs, sub msgs and repeated fields included, without going
+// to the heap. A LocAPIPbArena made while another is live on the same thread
+// gets an arena of its own.
+class LocAPIPbArena {
+    struct ThreadArena;
+    static thread_local std::unique_ptr<ThreadArena> sThreadArena;
+    ThreadArena* mThreadArena;
+    std::unique_ptr<google::protobuf::Arena> mOwnArena;
+    google::protobuf::Arena* mArena;
+public:
+    LocAPIPbArena();
+    ~LocAPIPbArena();
+    LocAPIPbArena(const LocAPIPbArena&) = delete;
+    LocAPIPbArena& operator=(const LocAPIPbArena&) = delete;
+
+    template <typename T>
+    inline T* create() {
+        return google::protobuf::Arena::CreateMessage<T>(mArena);
+    }
+
+#ifdef __LOC_UNIT_TEST__
+    enum { BENCH_LOCATION_INFO, BENCH_SV, BENCH_MEAS, BENCH_COUNT };
+    struct BenchResult {
+        uint64_t heapNs;
+        uint64_t arenaNs;
+        uint64_t heapAllocs;
+        uint64_t arenaAllocs;
+    };
+    // Converts a representative location info, SV and measurement indication
+    // to protobuf, serializes, parses and converts it back rounds times, with
+    // the protobuf msgs on the heap as before and on the thread arena.
+    // allocCount returns the number of heap allocations so far, from a
+    // counting operator new in the test program. Returns the number of round
+    // trips that changed the indication, plus one per indication the arena
+    // did not take fewer heap allocations for; 0 on success.
+    static uint32_t checkRoundTrip(uint32_t rounds, uint64_t (*allocCount)());
+    // The same round trips, returning ns and heap allocations per indication.
+    static void benchmark(uint32_t rounds, uint64_t (*allocCount)(),
+                          BenchResult results[BENCH_COUNT]);
+#endif
+};
+
+// A received msg of either wire format. The payload is not copied out of the
+// received buffer, which has to outlive the view, and the typed msg parsed
+// from it lives on the view's arena.
+class LocAPIMsgView {
+    LocAPIPbArena mArena;
+public:
+    uint32_t wireVersion;
+    PBELocMsgID msgId;
+    uint32_t msgVersion;
+    uint32_t payloadSize;
+    char sockName[MAX_SOCKET_PATHNAME_LENGTH];
+    uint32_t clientHandle;
+    const char* payload;
+    uint32_t payloadLength;
+
+    inline LocAPIMsgView() :
+        wireVersion(0), msgId(PB_E_LOCAPI_UNDEFINED_MSG_ID), msgVersion(0), payloadSize(0),
+        sockName{}, clientHandle(0), payload(nullptr), payloadLength(0) {}
+
+    /** Parse the outer msg. Return false if data is not a msg of either format.*/
+    bool parse(const char* data, uint32_t length);
+
+    /** Create a T on the arena, for the typed msg to be parsed into.*/
+    template <typename T>
+    inline T& createPbMsg() {
+        return *mArena.create<T>();
+    }
+    /** Parse the typed msg in place from the payload.*/
+    inline bool parsePayload(google::protobuf::MessageLite& pbMsg) const {
+        return pbMsg.ParseFromArray(payload, payloadLength);
+    }
+};
+
 class LocationApiPbMsgConv;
+class LocAPISvDeltaConv;
+class LocAPIMeasDeltaConv;
 struct LocAPIMsgHeader
 {
     char       mSocketName[MAX_SOCKET_PATHNAME_LENGTH]; /**< Processor string */
@@ -394,6 +502,15 @@ struct LocAPIMsgHeader
     /** Serialize message to protobuf format. Return length of serialized string.*/
     virtual int serializeToProtobuf(string& protoStr) {return 0;}
 
+    /** Serialize pbHdr and the typed msg pbPayload, if any, to protoStr in the
+        wire format of pLocApiPbMsgConv. Return length of serialized string.*/
+    int encodeToProtobuf(PBLocAPIMsgHeader& pbHdr, const google::protobuf::MessageLite* pbPayload,
+            uint32_t payloadSize, string& protoStr) const;
+
+    /** Set the client handle of protoStr, a msg serialized in the v2 wire
+        format, e.g. to 0 for a msg shared by all clients. No-op for v1.*/
+    static void setWireClientHandle(string& protoStr, uint32_t clientHandle);
+
     inline bool isValidMsg(uint32_t msgSize) {
         bool msgValid = true;
         if (msgVersion != LOCATION_REMOTE_API_MSG_VERSION) {
@@ -437,11 +554,16 @@ IPC message structure - client registration
 struct LocAPIClientRegisterReqMsg: LocAPIMsgHeader
 {
     ClientType mClientType;
+    // client takes indications over a shared memory ring, if offered
+    bool mShmCapable;
+    // newest wire format the client parses, 0 if only v1
+    uint32_t mWireVersion;
 
     inline LocAPIClientRegisterReqMsg(const char* name, ClientType clientType,
-            const LocationApiPbMsgConv *pbMsgConv) :
+            const LocationApiPbMsgConv *pbMsgConv, bool shmCapable = false,
+            uint32_t wireVersion = 0) :
         LocAPIMsgHeader(name, E_LOCAPI_CLIENT_REGISTER_MSG_ID, pbMsgConv),
-        mClientType(clientType) { }
+        mClientType(clientType), mShmCapable(shmCapable), mWireVersion(wireVersion) { }
     LocAPIClientRegisterReqMsg(const char* name,
             const PBLocAPIClientRegisterReqMsg &pbLocApiClientRegReqMsg,
             const LocationApiPbMsgConv *pbMsgConv);
@@ -941,6 +1063,40 @@ struct LocAPIMeasIndMsg : LocAPIMsgHeader
     int serializeToProtobuf(string& protoStr) override;
 };
 
+// defintion for message with msg id of E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID
+// the report is encoded by, and advances, deltaConv; received msgs are
+// decoded with LocAPISvDeltaConv::decode()
+struct LocAPISatelliteVehicleDeltaIndMsg: LocAPIMsgHeader
+{
+    const GnssSvNotification& gnssSvNotification;
+    LocAPISvDeltaConv& deltaConv;
+
+    inline LocAPISatelliteVehicleDeltaIndMsg(const char* name,
+        const GnssSvNotification& svNotification, LocAPISvDeltaConv& svDeltaConv,
+        const LocationApiPbMsgConv *pbMsgConv) :
+        LocAPIMsgHeader(name, E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID, pbMsgConv),
+        gnssSvNotification(svNotification), deltaConv(svDeltaConv) { }
+
+    int serializeToProtobuf(string& protoStr) override;
+};
+
+// defintion for message with msg id of E_LOCAPI_MEAS_DELTA_MSG_ID
+// the report is encoded by, and advances, deltaConv; received msgs are
+// decoded with LocAPIMeasDeltaConv::decode()
+struct LocAPIMeasDeltaIndMsg : LocAPIMsgHeader
+{
+    const GnssMeasurementsNotification& gnssMeasurementsNotification;
+    LocAPIMeasDeltaConv& deltaConv;
+
+    inline LocAPIMeasDeltaIndMsg(const char* name,
+        const GnssMeasurementsNotification& measurementsNotification,
+        LocAPIMeasDeltaConv& measDeltaConv, const LocationApiPbMsgConv *pbMsgConv) :
+        LocAPIMsgHeader(name, E_LOCAPI_MEAS_DELTA_MSG_ID, pbMsgConv),
+        gnssMeasurementsNotification(measurementsNotification), deltaConv(measDeltaConv) { }
+
+    int serializeToProtobuf(string& protoStr) override;
+};
+
 // defintion for message with msg id of E_LOCAPI_GET_GNSS_ENGERY_CONSUMED_MSG_ID
 struct LocAPIGnssEnergyConsumedIndMsg: LocAPIMsgHeader
 {
@@ -49,6 +49,8 @@ using std::min;
 LocationApiPbMsgConv::LocationApiPbMsgConv() {
     mPbDebugLogEnabled = false;
     mPbVerboseLogEnabled = false;
+    mWireVersion = LOCAPI_MSG_WIRE_V1;
+    mClientHandle = 0;
     // Logtag mechanism for Protobuf conv util log
     // Hidden configs to enable debug logs at runtime for printing many protobuf
     // conversion output (encode and decode). This will help for debugging. By
@@ -171,6 +173,12 @@ ELocMsgID LocationApiPbMsgConv::getEnumForPBELocMsgID(const PBELocMsgID &pbLocMs
         case PB_E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID:
             eLocMsgId = E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID;
             break;
+        case PB_E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID:
+            eLocMsgId = E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID;
+            break;
+        case PB_E_LOCAPI_MEAS_DELTA_MSG_ID:
+            eLocMsgId = E_LOCAPI_MEAS_DELTA_MSG_ID;
+            break;
         case PB_E_LOCAPI_PINGTEST_MSG_ID:
             eLocMsgId = E_LOCAPI_PINGTEST_MSG_ID;
             break;
@@ -616,6 +624,12 @@ PBELocMsgID LocationApiPbMsgConv::getPBEnumForELocMsgID(const ELocMsgID &eLocMsg
         case E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID:
             pbLocMsgId = PB_E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_RESP_MSG_ID;
             break;
+        case E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID:
+            pbLocMsgId = PB_E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID;
+            break;
+        case E_LOCAPI_MEAS_DELTA_MSG_ID:
+            pbLocMsgId = PB_E_LOCAPI_MEAS_DELTA_MSG_ID;
+            break;
         case E_LOCAPI_PINGTEST_MSG_ID:
             pbLocMsgId = PB_E_LOCAPI_PINGTEST_MSG_ID;
             break;
@@ -956,6 +970,9 @@ uint32_t LocationApiPbMsgConv::getPBMaskForLocationCallbacksMask(const uint32_t
     if (locCbMask & E_LOC_CB_GNSS_MEAS_BIT) {
         pbLocCbMask |= PB_E_LOC_CB_GNSS_MEAS_BIT;
     }
+    if (locCbMask & E_LOC_CB_DELTA_ENCODING_BIT) {
+        pbLocCbMask |= PB_E_LOC_CB_DELTA_ENCODING_BIT;
+    }
     LocApiPb_LOGv("LocApiPB: locCbMask:%x, pbLocCbMask:%x", locCbMask, pbLocCbMask);
     return pbLocCbMask;
 }
@@ -1948,6 +1965,9 @@ uint32_t LocationApiPbMsgConv::getLocationCallbacksMaskFromPB(const uint32_t &pb
     if (pbLocCbMask & PB_E_LOC_CB_GNSS_MEAS_BIT) {
         locCbMask |= E_LOC_CB_GNSS_MEAS_BIT;
     }
+    if (pbLocCbMask & PB_E_LOC_CB_DELTA_ENCODING_BIT) {
+        locCbMask |= E_LOC_CB_DELTA_ENCODING_BIT;
+    }
     LocApiPb_LOGv("LocApiPB: pbLocCbMask:%x, locCbMask:%x", pbLocCbMask, locCbMask);
     return locCbMask;
 }
@@ -2867,7 +2887,6 @@ int LocationApiPbMsgConv::convertLeverArmConfigInfoToPB(const LeverArmConfigInfo
     if (nullptr != gnssToVRP) {
         if (convertLeverArmParamsToPB(leverArmCfgInfo.gnssToVRP, gnssToVRP)) {
             LOC_LOGe("convertLeverArmParamsToPB failed");
-            free(gnssToVRP);
             return 1;
         }
     } else {
@@ -2880,7 +2899,6 @@ int LocationApiPbMsgConv::convertLeverArmConfigInfoToPB(const LeverArmConfigInfo
     if (nullptr != drImuToGnss) {
         if (convertLeverArmParamsToPB(leverArmCfgInfo.drImuToGnss, drImuToGnss)) {
             LOC_LOGe("convertLeverArmParamsToPB failed");
-            free(drImuToGnss);
             return 1;
         }
     } else {
@@ -2893,7 +2911,6 @@ int LocationApiPbMsgConv::convertLeverArmConfigInfoToPB(const LeverArmConfigInfo
     if (nullptr != veppImuToGnss) {
         if (convertLeverArmParamsToPB(leverArmCfgInfo.veppImuToGnss, veppImuToGnss)) {
             LOC_LOGe("convertLeverArmParamsToPB failed");
-            free(veppImuToGnss);
             return 1;
         }
     } else {
@@ -2944,7 +2961,6 @@ int LocationApiPbMsgConv::convertDeadReckoningEngineConfigToPB(
         if (convertBodyToSensorMountParamsToPB(drEngConfig.bodyToSensorMountParams,
                 b2SMountParams)) {
             LOC_LOGe("convertBodyToSensorMountParamsToPB failed");
-            free(b2SMountParams);
             return 1;
         }
     } else {
@@ -3013,7 +3029,6 @@ int LocationApiPbMsgConv::convertGfAddedReqPayloadToPB(
             if (nullptr != pbGfOpt) {
                 if (convertGeofenceOptionToPB(gfAddReqPayload.gfPayload[i].gfOption, pbGfOpt)) {
                     LOC_LOGe("convertGeofenceOptionToPB failed");
-                    free(pbGfOpt);
                     return 1;
                 }
             } else {
@@ -3026,7 +3041,6 @@ int LocationApiPbMsgConv::convertGfAddedReqPayloadToPB(
             if (nullptr != pbGfInfo) {
                 if (convertGeofenceInfoToPB(gfAddReqPayload.gfPayload[i].gfInfo, pbGfInfo)) {
                     LOC_LOGe("convertGeofenceInfoToPB failed");
-                    free(pbGfInfo);
                     return 1;
                 }
             } else {
@@ -3187,12 +3201,12 @@ int LocationApiPbMsgConv::convertLocAPIBatchingNotifMsgToPB(
             getPBEnumForBatchingStatus(locApiBatchNotifMsg.status));
     // repeated PBLocation location = 2;
     uint32_t count = locApiBatchNotifMsg.count;
+    pbLocApiBatchNotifMsg->mutable_location()->Reserve(count);
     for (int i=0; i < count; i++) {
         PBLocation* location = pbLocApiBatchNotifMsg->add_location();
         if (nullptr != location) {
             if (convertLocationToPB(locApiBatchNotifMsg.location[i], location)) {
                 LOC_LOGe("convertLocationToPB failed");
-                free(location);
                 return 1;
             }
         } else {
@@ -3225,7 +3239,6 @@ int LocationApiPbMsgConv::convertLocAPIGfBreachNotifToPB(
     if (nullptr != location) {
         if (convertLocationToPB(locApiGfBreachNotif.location, location)) {
             LOC_LOGe("convertLocationToPB failed");
-            free(location);
             return 1;
         }
     } else {
@@ -3252,7 +3265,6 @@ int LocationApiPbMsgConv::convertGnssLocInfoNotifToPB(
     if (nullptr != location) {
         if (convertLocationToPB(gnssLocInfoNotif.location, location)) {
             LOC_LOGe("convertLocationToPB failed");
-            free(location);
             return 1;
         }
     } else {
@@ -3320,7 +3332,6 @@ int LocationApiPbMsgConv::convertGnssLocInfoNotifToPB(
     if (nullptr != gnssLocSvUsedInPos) {
         if (convertGnssLocSvUsedInPosToPB(gnssLocInfoNotif.svUsedInPosition, gnssLocSvUsedInPos)) {
             LOC_LOGe("convertLocationToPB failed");
-            free(gnssLocSvUsedInPos);
             return 1;
         }
     } else {
@@ -3340,7 +3351,6 @@ int LocationApiPbMsgConv::convertGnssLocInfoNotifToPB(
         if (convertGnssLocationPositionDynamicsToPB(gnssLocInfoNotif.bodyFrameData,
                 gnssLocInfoNotif.bodyFrameDataExt, gnssLocPosDyn)) {
             LOC_LOGe("convertGnssLocationPositionDynamicsToPB failed");
-            free(gnssLocPosDyn);
             return 1;
         }
     } else {
@@ -3353,7 +3363,6 @@ int LocationApiPbMsgConv::convertGnssLocInfoNotifToPB(
     if (nullptr != gnssSysTime) {
         if (convertGnssSystemTimeToPB(gnssLocInfoNotif.gnssSystemTime, gnssSysTime)) {
             LOC_LOGe("convertGnssSystemTimeToPB failed");
-            free(gnssSysTime);
             return 1;
         }
     } else {
@@ -3367,13 +3376,13 @@ int LocationApiPbMsgConv::convertGnssLocInfoNotifToPB(
     // repeated PBGnssMeasUsageInfo measUsageInfo = 29; (Max array len - GNSS_SV_MAX)
     uint8_t count = gnssLocInfoNotif.numOfMeasReceived;
     LOC_LOGd("LocApiPB: gnssLocInfoNotif numOfMeasReceived : %u", count);
+    pbGnssLocInfoNotif->mutable_measusageinfo()->Reserve(count);
     for (uint8_t iter = 0; iter < count; iter++) {
         PBGnssMeasUsageInfo *gnssMeasUsageInfo = pbGnssLocInfoNotif->add_measusageinfo();
         if (nullptr != gnssMeasUsageInfo) {
             if (convertGnssMeasUsageInfoToPB(gnssLocInfoNotif.measUsageInfo[iter],
                     gnssMeasUsageInfo)) {
                 LOC_LOGe("convertGnssLocInfoNotifToPB failed");
-                free(gnssMeasUsageInfo);
                 return 1;
             }
         } else {
@@ -3411,7 +3420,6 @@ int LocationApiPbMsgConv::convertGnssLocInfoNotifToPB(
     if (nullptr != llaInfo) {
         if (convertLLAInfoToPB(gnssLocInfoNotif.llaVRPBased, llaInfo)) {
             LOC_LOGe("convertLLAInfoToPB failed");
-            free(llaInfo);
             return 1;
         }
     } else {
@@ -3420,6 +3428,7 @@ int LocationApiPbMsgConv::convertGnssLocInfoNotifToPB(
     }
 
     // repeated float enuVelocityVRPBased = 38; - Max array length 3
+    pbGnssLocInfoNotif->mutable_enuvelocityvrpbased()->Reserve(3);
     for (int i = 0; i < 3; i++) {
         LOC_LOGd("LocApiPB: gnssLocInfoNotif - jammerInd: %lf",
                 gnssLocInfoNotif.enuVelocityVRPBased[i]);
@@ -3472,7 +3481,6 @@ int LocationApiPbMsgConv::convertLocSysInfoToPB(const LocationSystemInfo &locSys
     if (nullptr != leapSecSysInfo) {
         if (convertLeapSecondSystemInfoToPB(locSysInfo.leapSecondSysInfo, leapSecSysInfo)) {
             LOC_LOGe("convertLeapSecondSystemInfoToPB failed");
-            free(leapSecSysInfo);
             return 1;
         }
     } else {
@@ -3491,14 +3499,14 @@ int LocationApiPbMsgConv::convertGnssMeasNotifToPB(
     }
 
     // repeated PBGnssMeasurementsData measurements = 1; Max array len - GNSS_MEASUREMENTS_MAX
-    uint32_t count = gnssMeasNotif.count;
+    uint32_t count = min(gnssMeasNotif.count, (uint32_t)GNSS_MEASUREMENTS_MAX);
     LOC_LOGd("LocApiPB: gnssMeasNotif - MeasNotif count:%d", count);
+    pbGnssMeasNotif->mutable_measurements()->Reserve(count);
     for (int i=0; i < count; i++) {
         PBGnssMeasurementsData* gnssMeasData = pbGnssMeasNotif->add_measurements();
         if (nullptr != gnssMeasData) {
             if (convertGnssMeasDataToPB(gnssMeasNotif.measurements[i], gnssMeasData)) {
                 LOC_LOGe("convertGnssMeasDataToPB failed");
-                free(gnssMeasData);
                 return 1;
             }
         } else {
@@ -3512,7 +3520,6 @@ int LocationApiPbMsgConv::convertGnssMeasNotifToPB(
     if (nullptr != gnssMeasClock) {
         if (convertGnssMeasClockToPB(gnssMeasNotif.clock, gnssMeasClock)) {
             LOC_LOGe("convertGnssMeasClockToPB failed");
-            free(gnssMeasClock);
             return 1;
         }
     } else {
@@ -3537,6 +3544,9 @@ int LocationApiPbMsgConv::convertGnssDataNotifToPB(const GnssDataNotification &g
     // repeated uint64  gnssDataMask = 2;
     // repeated double     jammerInd = 3;
     // repeated double     agc = 4;
+    pbGnssDataNotif->mutable_gnssdatamask()->Reserve(GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES);
+    pbGnssDataNotif->mutable_jammerind()->Reserve(GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES);
+    pbGnssDataNotif->mutable_agc()->Reserve(GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES);
     for (i = 0; i < GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES; i++) {
         LocApiPb_LOGd("LocApiPB: gnssDataNotif - jammerInd: %lf, agc: %lf, gnssDataMask: %" PRIu64,
                 gnssDataNotif.jammerInd[i], gnssDataNotif.agc[i], gnssDataNotif.gnssDataMask[i]);
@@ -3575,14 +3585,14 @@ int LocationApiPbMsgConv::convertGnssSvNotifToPB(const GnssSvNotification &gnssS
     pbGnssSvNotif->set_gnsssignaltypemaskvalid(gnssSvNotif.gnssSignalTypeMaskValid);
 
     // repeated PBLocApiGnssSv gnssSvs = 2; (max - GNSS_SV_MAX)
-    uint32_t count = gnssSvNotif.count;
+    uint32_t count = min(gnssSvNotif.count, (uint32_t)GNSS_SV_MAX);
     LOC_LOGd("LocApiPB: gnssSvNotif - SvNotif count:%d", count);
+    pbGnssSvNotif->mutable_gnsssvs()->Reserve(count);
     for (int i=0; i < count; i++) {
         PBLocApiGnssSv* gnssSv = pbGnssSvNotif->add_gnsssvs();
         if (nullptr != gnssSv) {
             if (convertGnssSvToPB(gnssSvNotif.gnssSvs[i], gnssSv)) {
                 LOC_LOGe("convertGnssSvToPB failed");
-                free(gnssSv);
                 return 1;
             }
         } else {
@@ -3634,7 +3644,6 @@ int LocationApiPbMsgConv::convertLeapSecondSystemInfoToPB(
     if (nullptr != leapSecChngInfo) {
         if (convertLeapSecChgInfoToPB(leapSecSysInfo.leapSecondChangeInfo, leapSecChngInfo)) {
             LOC_LOGe("convertLeapSecChgInfoToPB failed");
-            free(leapSecChngInfo);
             return 1;
         }
     } else {
@@ -3660,7 +3669,6 @@ int LocationApiPbMsgConv::convertLeapSecChgInfoToPB(const LeapSecondChangeInfo &
         if (convertGnssSystemTimeStructTypeToPB(leapSecChngInfo.gpsTimestampLsChange,
                 pLeapSecChngInfo)) {
             LOC_LOGe("convertGnssSystemTimeStructTypeToPB failed");
-            free(pLeapSecChngInfo);
             return 1;
         }
     } else {
@@ -4004,7 +4012,6 @@ int LocationApiPbMsgConv::convertGnssSystemTimeToPB(const GnssSystemTime &gnssSy
         if (convertSystemTimeStructUnionToPB(gnssSysTime.gnssSystemTimeSrc, gnssSysTime.u,
                 sysTimeStructUnion)) {
             LOC_LOGe("convertSystemTimeStructUnionToPB failed");
-            free(sysTimeStructUnion);
             return 1;
         }
     } else {
@@ -4137,7 +4144,6 @@ int LocationApiPbMsgConv::convertSystemTimeStructUnionToPB(
                     if (convertGnssSystemTimeStructTypeToPB(sysTimeStructUnion.gpsSystemTime,
                             gpsSysTime)) {
                         LOC_LOGe("convertGnssSystemTimeStructTypeToPB failed");
-                        free(gpsSysTime);
                         retVal = 1;
                     }
                 } else {
@@ -4155,7 +4161,6 @@ int LocationApiPbMsgConv::convertSystemTimeStructUnionToPB(
                     if (convertGnssSystemTimeStructTypeToPB(sysTimeStructUnion.galSystemTime,
                             galSysTime)) {
                         LOC_LOGe("convertGnssSystemTimeStructTypeToPB failed");
-                        free(galSysTime);
                         retVal = 1;
                     }
                 } else {
@@ -4173,7 +4178,6 @@ int LocationApiPbMsgConv::convertSystemTimeStructUnionToPB(
                     if (convertGnssSystemTimeStructTypeToPB(sysTimeStructUnion.bdsSystemTime,
                             bdsSysTime)) {
                         LOC_LOGe("convertGnssSystemTimeStructTypeToPB failed");
-                        free(bdsSysTime);
                         retVal = 1;
                     }
                 } else {
@@ -4191,7 +4195,6 @@ int LocationApiPbMsgConv::convertSystemTimeStructUnionToPB(
                     if (convertGnssSystemTimeStructTypeToPB(sysTimeStructUnion.qzssSystemTime,
                             qzssSysTime)) {
                         LOC_LOGe("convertGnssSystemTimeStructTypeToPB failed");
-                        free(qzssSysTime);
                         retVal = 1;
                     }
                 } else {
@@ -4209,7 +4212,6 @@ int LocationApiPbMsgConv::convertSystemTimeStructUnionToPB(
                     if (convertGnssGloTimeStructTypeToPB(sysTimeStructUnion.gloSystemTime,
                             gloSysTime)) {
                         LOC_LOGe("convertGnssGloTimeStructTypeToPB failed");
-                        free(gloSysTime);
                         retVal = 1;
                     }
                 } else {
@@ -4227,7 +4229,6 @@ int LocationApiPbMsgConv::convertSystemTimeStructUnionToPB(
                     if (convertGnssSystemTimeStructTypeToPB(sysTimeStructUnion.navicSystemTime,
                             navicSysTime)) {
                         LOC_LOGe("convertGnssSystemTimeStructTypeToPB failed");
-                        free(navicSysTime);
                         retVal = 1;
                     }
                 } else {
@@ -4569,53 +4570,52 @@ int LocationApiPbMsgConv::pbConvertToGnssSvNotif(const PBLocApiGnssSvNotificatio
     gnssSvNotif.count = min(pbGnssSvNotif.gnsssvs_size(), (int)GNSS_SV_MAX);
     LOC_LOGd("LocApiPB: pbGnssSvNotif- num svs %d", gnssSvNotif.count);
     for (int i=0; i < gnssSvNotif.count; i++) {
-        PBLocApiGnssSv pPbGnssSv = pbGnssSvNotif.gnsssvs(i);
-        gnssSvNotif.gnssSvs[i].size = sizeof(GnssSv);
-        // uint32 svId = 1;
-        gnssSvNotif.gnssSvs[i].svId = pPbGnssSv.svid();
-
-        // Use Gnss_LocSvSystemEnumType instead of GnssSvType
-        // PBLocApiGnss_LocSvSystemEnumType type = 2;
-        gnssSvNotif.gnssSvs[i].type =
-                getGnssSvTypeFromPBGnssLocSvSystemEnumType(pPbGnssSv.type());
-
-        // float cN0Dbhz = 3;
-        gnssSvNotif.gnssSvs[i].cN0Dbhz = pPbGnssSv.cn0dbhz();
-
-        // float elevation = 4;
-        gnssSvNotif.gnssSvs[i].elevation = pPbGnssSv.elevation();
-
-        // float azimuth = 5;
-        gnssSvNotif.gnssSvs[i].azimuth = pPbGnssSv.azimuth();
-
-        // Bitwise OR of PBLocApiGnssSvOptionsMask
-        // uint32 gnssSvOptionsMask = 6;
-        gnssSvNotif.gnssSvs[i].gnssSvOptionsMask =
-                getGnssSvOptionsMaskFromPB(pPbGnssSv.gnsssvoptionsmask());
-
-        // float carrierFrequencyHz = 7;
-        gnssSvNotif.gnssSvs[i].carrierFrequencyHz = pPbGnssSv.carrierfrequencyhz();
-
-        // uint32 gnssSignalTypeMask = 8; - PBGnssSignalTypeMask
-        gnssSvNotif.gnssSvs[i].gnssSignalTypeMask =
-                getGnssSignalTypeMaskFromPB(pPbGnssSv.gnsssignaltypemask());
-
-        // double basebandCarrierToNoiseDbHz = 9;
-        gnssSvNotif.gnssSvs[i].basebandCarrierToNoiseDbHz = pPbGnssSv.basebandcarriertonoisedbhz();
-
-        // uint32 gloFrequency = 10;
-        gnssSvNotif.gnssSvs[i].gloFrequency = pPbGnssSv.glofrequency();
-        LocApiPb_LOGd("LocApiPB: gnssSv[%d] - SvId:%d, CNo:%f, SvOptMask:%x, SignalTypeMask:%x, "\
-                "BseBandCno:%lf, gloFrequency:%d",
-                i, gnssSvNotif.gnssSvs[i].svId, gnssSvNotif.gnssSvs[i].cN0Dbhz,
-                gnssSvNotif.gnssSvs[i].gnssSvOptionsMask,
-                gnssSvNotif.gnssSvs[i].gnssSignalTypeMask,
-                gnssSvNotif.gnssSvs[i].basebandCarrierToNoiseDbHz,
-                gnssSvNotif.gnssSvs[i].gloFrequency);
+        pbConvertToGnssSv(pbGnssSvNotif.gnsssvs(i), gnssSvNotif.gnssSvs[i]);
     }
     return 0;
 }
 
+int LocationApiPbMsgConv::pbConvertToGnssSv(const PBLocApiGnssSv &pbGnssSv,
+        GnssSv &gnssSv) const {
+    gnssSv.size = sizeof(GnssSv);
+    // uint32 svId = 1;
+    gnssSv.svId = pbGnssSv.svid();
+
+    // Use Gnss_LocSvSystemEnumType instead of GnssSvType
+    // PBLocApiGnss_LocSvSystemEnumType type = 2;
+    gnssSv.type = getGnssSvTypeFromPBGnssLocSvSystemEnumType(pbGnssSv.type());
+
+    // float cN0Dbhz = 3;
+    gnssSv.cN0Dbhz = pbGnssSv.cn0dbhz();
+
+    // float elevation = 4;
+    gnssSv.elevation = pbGnssSv.elevation();
+
+    // float azimuth = 5;
+    gnssSv.azimuth = pbGnssSv.azimuth();
+
+    // Bitwise OR of PBLocApiGnssSvOptionsMask
+    // uint32 gnssSvOptionsMask = 6;
+    gnssSv.gnssSvOptionsMask = getGnssSvOptionsMaskFromPB(pbGnssSv.gnsssvoptionsmask());
+
+    // float carrierFrequencyHz = 7;
+    gnssSv.carrierFrequencyHz = pbGnssSv.carrierfrequencyhz();
+
+    // uint32 gnssSignalTypeMask = 8; - PBGnssSignalTypeMask
+    gnssSv.gnssSignalTypeMask = getGnssSignalTypeMaskFromPB(pbGnssSv.gnsssignaltypemask());
+
+    // double basebandCarrierToNoiseDbHz = 9;
+    gnssSv.basebandCarrierToNoiseDbHz = pbGnssSv.basebandcarriertonoisedbhz();
+
+    // uint32 gloFrequency = 10;
+    gnssSv.gloFrequency = pbGnssSv.glofrequency();
+    LocApiPb_LOGd("LocApiPB: gnssSv - SvId:%d, CNo:%f, SvOptMask:%x, SignalTypeMask:%x, "\
+            "BseBandCno:%lf, gloFrequency:%d",
+            gnssSv.svId, gnssSv.cN0Dbhz, gnssSv.gnssSvOptionsMask, gnssSv.gnssSignalTypeMask,
+            gnssSv.basebandCarrierToNoiseDbHz, gnssSv.gloFrequency);
+    return 0;
+}
+
 int LocationApiPbMsgConv::pbConvertToLocAPINmeaSerializedPayload(
             const PBLocAPINmeaSerializedPayload &pbLocApiNmeaSerPayload,
             LocAPINmeaSerializedPayload &locApiNmeaSerPayload) const {
@@ -4655,7 +4655,7 @@ int LocationApiPbMsgConv::pbConvertToGnssMeasNotification(
         GnssMeasurementsNotification &gnssMeasNotif) const {
     gnssMeasNotif.size = sizeof(GnssMeasurementsNotification);
     // repeated PBGnssMeasurementsData measurements = 1; - Max array len - GNSS_MEASUREMENTS_MAX
-    uint32_t count = pbGnssMeasNotif.measurements_size();
+    uint32_t count = min(pbGnssMeasNotif.measurements_size(), (int)GNSS_MEASUREMENTS_MAX);
     gnssMeasNotif.count = count;
     for (int i=0; i < count; i++) {
         pbConvertToGnssMeasurementsData(pbGnssMeasNotif.measurements(i),
@@ -4714,7 +4714,7 @@ int LocationApiPbMsgConv::pbConvertToGfAddReqPayload(
     gfAddReqPload.count = gfCount;
     LOC_LOGd("LocApiPB: pbGfAddReqPload- count %d", gfCount);
     for (int i=0; i < gfCount; i++) {
-        PBGeofencePayload pbGfPayload = pbGfAddReqPload.gfpayload(i);
+        const PBGeofencePayload& pbGfPayload = pbGfAddReqPload.gfpayload(i);
         // uint32 gfClientId = 1;
         gfAddReqPload.gfPayload[i].gfClientId = pbGfPayload.gfclientid();
         LocApiPb_LOGv("LocApiPB: gfPayload[%d] gfClientId - %u", i,
@@ -44,6 +44,18 @@ public:
     LocationApiPbMsgConv();
     virtual ~LocationApiPbMsgConv() {}
 
+    // wire format msgs converted with this are sent in, LOCAPI_MSG_WIRE_V1
+    // unless the peer is known to parse a newer one. Set from the thread
+    // that sends.
+    inline void setWireVersion(uint32_t wireVersion) { mWireVersion = wireVersion; }
+    inline uint32_t getWireVersion() const { return mWireVersion; }
+    // handle the daemon knows the client by, carried in v2 msgs so that the
+    // daemon finds the client without looking up its socket name. The daemon
+    // sets it on the converter of each client, and a client takes it from
+    // the v2 msgs sent to it alone, as shared indications carry none.
+    inline void setClientHandle(uint32_t clientHandle) { mClientHandle = clientHandle; }
+    inline uint32_t getClientHandle() const { return mClientHandle; }
+
     // STRUCTURE CONVERSION
     // ********************
     // **** helper function for structure conversion to protobuf format
@@ -515,8 +527,14 @@ public:
     PBClientType getPBEnumForClientType(const ClientType &clientTyp) const;
 
 private:
+    // delta codecs convert the SVs and measurements not sent as deltas
+    friend class LocAPISvDeltaConv;
+    friend class LocAPIMeasDeltaConv;
+
     bool mPbDebugLogEnabled;
     bool mPbVerboseLogEnabled;
+    uint32_t mWireVersion;
+    uint32_t mClientHandle;
 
     // RIGID TO PROTOBUF FORMAT
     // ************************
@@ -743,6 +761,8 @@ private:
     int pbConvertToGnssSystemTimeStructType(
             const PBLocApiGnssSystemTimeStructType &pbGnssSysTimeStrct,
             GnssSystemTimeStructType &gnssSysTimeStrct) const;
+    // PBLocApiGnssSv to GnssSv
+    int pbConvertToGnssSv(const PBLocApiGnssSv &pbGnssSv, GnssSv &gnssSv) const;
     // PBGnssMeasurementsData to GnssMeasurementsData
     int pbConvertToGnssMeasurementsData(const PBGnssMeasurementsData &pbGnssMeasData,
             GnssMeasurementsData &gnssMeasData) const;
@@ -0,0 +1,64 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_ApiMsgTest"
+
+// Runs the __LOC_UNIT_TEST__ self checks of liblocation_api_msg_proto.
+// Exits non-zero if any of them fails.
+
+#define LOC_UNIT_TEST_COUNT_ALLOCS
+#include <LocUnitTest.h>
+#include <LocationApiMsg.h>
+#include <LocationApiDeltaConv.h>
+
+using namespace loc_util;
+
+int main(int argc, char** argv) {
+    LocUnitTest test(argc, argv);
+    test.report("protobuf arena round trip",
+                LocAPIPbArena::checkRoundTrip(100, locUnitTestAllocCount));
+    test.report("SV report deltas", LocAPISvDeltaConv::check(200));
+    test.report("measurement report deltas", LocAPIMeasDeltaConv::check(200));
+
+    if (test.runBenchmarks()) {
+        static const char* const names[LocAPIPbArena::BENCH_COUNT] = {
+            "location info", "SV", "measurement"
+        };
+        LocAPIPbArena::BenchResult results[LocAPIPbArena::BENCH_COUNT];
+        LocAPIPbArena::benchmark(10000, locUnitTestAllocCount, results);
+        for (uint32_t i = 0; i < LocAPIPbArena::BENCH_COUNT; i++) {
+            printf("%s indication: %" PRIu64 " / %" PRIu64 " ns, "
+                   "%" PRIu64 " / %" PRIu64 " allocs per msg (heap / arena)\n",
+                   names[i], results[i].heapNs, results[i].arenaNs,
+                   results[i].heapAllocs, results[i].arenaAllocs);
+        }
+    }
+
+    return test.finish();
+}
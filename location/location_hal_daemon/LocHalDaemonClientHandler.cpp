@@ -37,6 +37,79 @@ shared_ptr<LocIpcSender> LocHalDaemonClientHandler::createSender(const string so
     return sockNode.createSender();
 }
 
+void LocHalDaemonClientHandler::setupShmSender() {
+    if (nullptr != mIpcSender && nullptr == mShmSender) {
+        mShmSender = LocIpc::getLocIpcShmSender(mIpcSender);
+        LOC_LOGd("client %s shm ring %s", mName.c_str(),
+                 (nullptr != mShmSender) ? "offered" : "not available");
+        if (nullptr != mShmSender && nullptr != mSendQueue) {
+            mSendQueue->setSender(mShmSender);
+        }
+    }
+}
+
+void LocHalDaemonClientHandler::startSendQueue() {
+    LocationApiService* service = mService;
+    LocHalClientHandle handle = mHandle;
+    mSendQueue = std::make_shared<LocHalDaemonSendQueue>(mName, mIpcSender,
+            mService->getSendQueueDepth(),
+            [service, handle](const LocHalDaemonSendQueue* queue) {
+        // not on the send thread, as purging takes the registry lock and
+        // stops this very thread
+        service->getMsgTask().sendMsg([service, handle]() {
+            service->purgeClient(handle);
+        });
+    });
+    if (!mSendThread.start("LocHalSendQ", mSendQueue)) {
+        LOC_LOGe("client %s send thread failed to start", mName.c_str());
+    }
+}
+
+void LocHalDaemonClientHandler::purge() {
+    // not on this thread, as purging takes the registry lock, which comes
+    // before the client lock held here
+    LocationApiService* service = mService;
+    LocHalClientHandle handle = mHandle;
+    mService->getMsgTask().sendMsg([service, handle]() {
+        service->purgeClient(handle);
+    });
+}
+
+// purges a client once it has closed its connection
+class LocHalDaemonPeerCloseListener : public ILocIpcListener {
+    LocationApiService* mService;
+    const LocHalClientHandle mHandle;
+public:
+    inline LocHalDaemonPeerCloseListener(LocationApiService* service,
+                                         LocHalClientHandle handle) :
+            mService(service), mHandle(handle) {}
+    inline virtual void onReceive(const char* data, uint32_t len,
+                                  const LocIpcRecver* recver) override {}
+    inline virtual void onPeerClosed(const LocIpcRecver* recver) override {
+        // not on the reactor thread, as purging takes the registry lock,
+        // which is held when a recver is removed from the reactor
+        LocationApiService* service = mService;
+        LocHalClientHandle handle = mHandle;
+        mService->getMsgTask().sendMsg([service, handle]() {
+            service->purgeClient(handle);
+        });
+    }
+};
+
+void LocHalDaemonClientHandler::watchPeerClose() {
+    if (nullptr == mIpcSender || nullptr != mPeerCloseRecver) {
+        return;
+    }
+    unique_ptr<LocIpcRecver> recver = mIpcSender->getPeerCloseRecver(
+            std::make_shared<LocHalDaemonPeerCloseListener>(mService, mHandle));
+    const LocIpcRecver* peerCloseRecver = recver.get();
+    if (nullptr != recver && mService->getPeerCloseReactor().add(recver)) {
+        mPeerCloseRecver = peerCloseRecver;
+    }
+    LOC_LOGd("client %s liveness by %s", mName.c_str(),
+             (nullptr != mPeerCloseRecver) ? "connection" : "ping");
+}
+
 static GeofenceBreachTypeMask parseClientGeofenceBreachType(GeofenceBreachType type);
 
 /******************************************************************************
@@ -44,6 +117,14 @@ LocHalDaemonClientHandler - updateSubscriptionMask
 ******************************************************************************/
 void LocHalDaemonClientHandler::updateSubscription(uint32_t mask) {
 
+    // a client starting on deltas needs a keyframe to decode them
+    uint32_t added = mask & ~mSubscriptionMask;
+    if ((mask & E_LOC_CB_DELTA_ENCODING_BIT) && (added & (E_LOC_CB_DELTA_ENCODING_BIT |
+            E_LOC_CB_GNSS_SV_BIT | E_LOC_CB_GNSS_MEAS_BIT))) {
+        mService->mSvDeltaConv.requestKeyframe();
+        mService->mMeasDeltaConv.requestKeyframe();
+    }
+
     // update my subscription mask
     mSubscriptionMask = mask;
 
@@ -358,13 +439,13 @@ void LocHalDaemonClientHandler::pingTest() {
 
     if (nullptr != mIpcSender) {
         string pbStr;
-        LocAPIPingTestIndMsg msg(SERVICE_NAME, &mService->mPbufMsgConv);
+        LocAPIPingTestIndMsg msg(SERVICE_NAME, &mPbufMsgConv);
         if (msg.serializeToProtobuf(pbStr)) {
             bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPIPingTestIndMsg serializeToProtobuf failed");
@@ -373,16 +454,33 @@ void LocHalDaemonClientHandler::pingTest() {
 }
 
 void LocHalDaemonClientHandler::cleanup() {
-    // please do not attempt to hold the lock, as the caller of this function
-    // already holds the lock
-
-    // set the ptr to null to prevent further sending out message to the
-    // remote client that is no longer reachable
-    mIpcSender = nullptr;
+    // the caller holds the registry for writing, so no request is using
+    // this client, but its LocationAPI callbacks may still come
+    const LocIpcRecver* peerCloseRecver = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        // set the ptr to null to prevent further sending out message to the
+        // remote client that is no longer reachable
+        mIpcSender = nullptr;
+        mShmSender = nullptr;
+        peerCloseRecver = mPeerCloseRecver;
+        mPeerCloseRecver = nullptr;
+    }
+    if (nullptr != peerCloseRecver) {
+        mService->getPeerCloseReactor().remove(peerCloseRecver);
+    }
+    // drops the msgs still queued, the I/O thread exits after any send in
+    // progress
+    mSendThread.stop();
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mSendQueue = nullptr;
+    }
 
     if (0 != remove(mName.c_str())) {
         LOC_LOGw("<-- failed to remove file %s error %s", mName.c_str(), strerror(errno));
     }
+    remove((mName + LOC_IPC_SEQPACKET_SUFFIX).c_str());
 
     if (mLocationApi) {
         mLocationApi->destroy([this]() {onLocationApiDestroyCompleteCb();});
@@ -395,12 +493,46 @@ void LocHalDaemonClientHandler::cleanup() {
     }
 }
 
+bool LocHalDaemonClientHandler::isSubscribed(uint32_t mask) {
+    std::lock_guard<std::mutex> lock(mLock);
+    return (nullptr != mIpcSender) && (mSubscriptionMask & mask);
+}
+
+bool LocHalDaemonClientHandler::isDeltaEncoded() {
+    std::lock_guard<std::mutex> lock(mLock);
+    return (mSubscriptionMask & E_LOC_CB_DELTA_ENCODING_BIT) &&
+            (LOCAPI_MSG_WIRE_V2 == mPbufMsgConv.getWireVersion());
+}
+
+void LocHalDaemonClientHandler::sendIndication(ELocMsgID msgId,
+                                               const shared_ptr<const string>& payload) {
+    if (nullptr == payload) {
+        LOC_LOGe("indication %d serializeToProtobuf failed", msgId);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    if (nullptr == mIpcSender || nullptr == mSendQueue) {
+        return;
+    }
+    // the I/O thread sends it, so that a slow client does not hold up the
+    // others, nor the service lock
+    mSendQueue->push(msgId, payload, !mService->deferIndication());
+}
+
+void LocHalDaemonClientHandler::flushIndications() {
+    // no need to hold the lock, as mSendQueue is only reset with the
+    // registry held for writing, and the caller holds it for reading
+    if (nullptr != mSendQueue) {
+        mSendQueue->kick();
+    }
+}
+
 /******************************************************************************
 LocHalDaemonClientHandler - Location API response callback functions
 ******************************************************************************/
 void LocHalDaemonClientHandler::onResponseCb(LocationError err, uint32_t id) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
 
     if (nullptr != mIpcSender) {
         LOC_LOGd("--< onResponseCb err=%u id=%u", err, id);
@@ -448,13 +580,13 @@ void LocHalDaemonClientHandler::onResponseCb(LocationError err, uint32_t id) {
             }
         }
 
-        LocAPIGenericRespMsg msg(SERVICE_NAME, eLocMsgId, err, &mService->mPbufMsgConv);
+        LocAPIGenericRespMsg msg(SERVICE_NAME, eLocMsgId, err, &mPbufMsgConv);
         if (msg.serializeToProtobuf(pbStr)) {
             rc = sendMessage(pbStr.c_str(), pbStr.size(), eLocMsgId);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPIGenericRespMsg serializeToProtobuf failed");
@@ -464,7 +596,7 @@ void LocHalDaemonClientHandler::onResponseCb(LocationError err, uint32_t id) {
 
 void LocHalDaemonClientHandler::onCollectiveResponseCallback(
         size_t count, LocationError *errs, uint32_t *ids) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onCollectiveResponseCallback");
 
     if (nullptr == mIpcSender) {
@@ -548,7 +680,7 @@ void LocHalDaemonClientHandler::onCollectiveResponseCallback(
         // purge this client if failed
         if (!rc) {
             LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-            mService->deleteClientbyName(mName);
+            purge();
         }
     } else {
         LOC_LOGe("LocAPICollectiveRespMsg serializeToProtobuf failed");
@@ -567,13 +699,13 @@ void LocHalDaemonClientHandler::onControlResponseCb(LocationError err, ELocMsgID
     if (nullptr != mIpcSender) {
         LOC_LOGi("--< onControlResponseCb err=%u msgId=%u", err, msgId);
         string pbStr;
-        LocAPIGenericRespMsg msg(SERVICE_NAME, msgId, err, &mService->mPbufMsgConv);
+        LocAPIGenericRespMsg msg(SERVICE_NAME, msgId, err, &mPbufMsgConv);
         if (msg.serializeToProtobuf(pbStr)) {
             bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPIGenericRespMsg serializeToProtobuf failed");
@@ -584,7 +716,7 @@ void LocHalDaemonClientHandler::onControlResponseCb(LocationError err, ELocMsgID
 void LocHalDaemonClientHandler::sendTerrestrialFix(LocationError error,
                                                    const Location& location) {
     LocAPIGetSingleTerrestrialPosRespMsg msg(SERVICE_NAME,
-            error, location,  &mService->mPbufMsgConv);
+            error, location,  &mPbufMsgConv);
 
     const char* msgStream = nullptr;
     size_t msgLen = 0;
@@ -605,7 +737,7 @@ void LocHalDaemonClientHandler::onGnssConfigCb(ELocMsgID configMsgId,
         if (gnssConfig.flags & GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT) {
             LocConfigGetRobustLocationConfigRespMsg msg(SERVICE_NAME,
                     gnssConfig.robustLocationConfig,
-                    &mService->mPbufMsgConv);
+                    &mPbufMsgConv);
             msg.serializeToProtobuf(pbStr);
         }
         break;
@@ -613,7 +745,7 @@ void LocHalDaemonClientHandler::onGnssConfigCb(ELocMsgID configMsgId,
         if (gnssConfig.flags & GNSS_CONFIG_FLAGS_MIN_GPS_WEEK_BIT) {
             LOC_LOGd("--< onGnssConfigCb, minGpsWeek = %d", gnssConfig.minGpsWeek);
             LocConfigGetMinGpsWeekRespMsg msg(SERVICE_NAME, gnssConfig.minGpsWeek,
-                    &mService->mPbufMsgConv);
+                    &mPbufMsgConv);
             msg.serializeToProtobuf(pbStr);
         }
         break;
@@ -621,7 +753,7 @@ void LocHalDaemonClientHandler::onGnssConfigCb(ELocMsgID configMsgId,
         if (gnssConfig.flags & GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT) {
             LOC_LOGd("--< onGnssConfigCb, minSvElevation = %d", gnssConfig.minSvElevation);
             LocConfigGetMinSvElevationRespMsg msg(SERVICE_NAME, gnssConfig.minSvElevation,
-                    &mService->mPbufMsgConv);
+                    &mPbufMsgConv);
             msg.serializeToProtobuf(pbStr);
         }
         break;
@@ -630,7 +762,7 @@ void LocHalDaemonClientHandler::onGnssConfigCb(ELocMsgID configMsgId,
         if (gnssConfig.flags & GNSS_CONFIG_FLAGS_CONSTELLATION_SECONDARY_BAND_BIT)
         {
             LocConfigGetConstellationSecondaryBandConfigRespMsg msg(SERVICE_NAME,
-                    gnssConfig.secondaryBandConfig, &mService->mPbufMsgConv);
+                    gnssConfig.secondaryBandConfig, &mPbufMsgConv);
             msg.serializeToProtobuf(pbStr);
         }
         break;
@@ -644,7 +776,7 @@ void LocHalDaemonClientHandler::onGnssConfigCb(ELocMsgID configMsgId,
         // purge this client if failed
         if (!rc) {
             LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-            mService->deleteClientbyName(mName);
+            purge();
         }
     } else {
         LOC_LOGe("mIpcSender or msgStream is null!!");
@@ -656,13 +788,13 @@ LocHalDaemonClientHandler - Location API callback functions
 ******************************************************************************/
 void LocHalDaemonClientHandler::onCapabilitiesCallback(LocationCapabilitiesMask mask) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onCapabilitiesCallback=0x%" PRIx64, mask);
 
     if ((nullptr != mIpcSender) && (mask != mCapabilityMask)) {
         // broadcast
         string pbStr;
-        LocAPICapabilitiesIndMsg msg(SERVICE_NAME, mask, &mService->mPbufMsgConv);
+        LocAPICapabilitiesIndMsg msg(SERVICE_NAME, mask, &mPbufMsgConv);
         LOC_LOGd("mask old=0x%" PRIx64" new=0x%" PRIx64, mCapabilityMask, mask);
         mCapabilityMask = mask;
         if (msg.serializeToProtobuf(pbStr)) {
@@ -670,7 +802,7 @@ void LocHalDaemonClientHandler::onCapabilitiesCallback(LocationCapabilitiesMask
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPICapabilitiesIndMsg serializeToProtobuf failed");
@@ -683,30 +815,22 @@ void LocHalDaemonClientHandler::onCapabilitiesCallback(LocationCapabilitiesMask
 
 void LocHalDaemonClientHandler::onTrackingCb(Location location) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
     LOC_LOGd("--< onTrackingCb");
-
-    if ((nullptr != mIpcSender) &&
-            (mSubscriptionMask & E_LOC_CB_DISTANCE_BASED_TRACKING_BIT)) {
+    if (isSubscribed(E_LOC_CB_DISTANCE_BASED_TRACKING_BIT)) {
         // broadcast
-        string pbStr;
-        LocAPILocationIndMsg msg(SERVICE_NAME, location, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
-            // purge this client if failed
-            if (!rc) {
-                LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
-            }
-        } else {
-            LOC_LOGe("LocAPILocationIndMsg serializeToProtobuf failed");
-        }
+        sendIndication(E_LOCAPI_LOCATION_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_LOCATION_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(), location,
+                                               [&](string& pbStr) {
+            LocAPILocationIndMsg msg(SERVICE_NAME, location, &mPbufMsgConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
     }
 }
 
 void LocHalDaemonClientHandler::onBatchingCb(size_t count, Location* location,
         BatchingOptions batchOptions) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onBatchingCb");
 
     if ((nullptr != mIpcSender) && (mSubscriptionMask & E_LOC_CB_BATCHING_BIT)) {
@@ -736,7 +860,7 @@ void LocHalDaemonClientHandler::onBatchingCb(size_t count, Location* location,
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPIBatchingIndMsg serializeToProtobuf failed");
@@ -748,7 +872,7 @@ void LocHalDaemonClientHandler::onBatchingCb(size_t count, Location* location,
 
 void LocHalDaemonClientHandler::onBatchingStatusCb(BatchingStatusInfo batchingStatus,
                 std::list<uint32_t>& listOfCompletedTrips) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onBatchingStatusCb");
     if ((nullptr != mIpcSender) && (mSubscriptionMask & E_LOC_CB_BATCHING_STATUS_BIT) &&
                 (BATCHING_MODE_TRIP == mBatchingMode) &&
@@ -757,13 +881,13 @@ void LocHalDaemonClientHandler::onBatchingStatusCb(BatchingStatusInfo batchingSt
         LocAPIBatchNotification batchNotif = {};
         batchNotif.status = BATCHING_STATUS_TRIP_COMPLETED;
         string pbStr;
-        LocAPIBatchingIndMsg msg(SERVICE_NAME, batchNotif, &mService->mPbufMsgConv);
+        LocAPIBatchingIndMsg msg(SERVICE_NAME, batchNotif, &mPbufMsgConv);
         if (msg.serializeToProtobuf(pbStr)) {
             bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPIBatchingIndMsg serializeToProtobuf failed");
@@ -774,7 +898,7 @@ void LocHalDaemonClientHandler::onBatchingStatusCb(BatchingStatusInfo batchingSt
 
 void LocHalDaemonClientHandler::onGeofenceBreachCb(GeofenceBreachNotification gfBreachNotif) {
     LOC_LOGd("--< onGeofenceBreachCallback");
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
 
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & E_LOC_CB_GEOFENCE_BREACH_BIT)) {
@@ -811,7 +935,7 @@ void LocHalDaemonClientHandler::onGeofenceBreachCb(GeofenceBreachNotification gf
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPIGeofenceBreachIndMsg serializeToProtobuf failed");
@@ -824,38 +948,24 @@ void LocHalDaemonClientHandler::onGeofenceBreachCb(GeofenceBreachNotification gf
 
 void LocHalDaemonClientHandler::onGnssLocationInfoCb(GnssLocationInfoNotification notification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
     LOC_LOGd("--< onGnssLocationInfoCb");
-
-    if ((nullptr != mIpcSender) && (mSubscriptionMask &
-            (E_LOC_CB_GNSS_LOCATION_INFO_BIT | E_LOC_CB_SIMPLE_LOCATION_INFO_BIT))) {
-        bool rc = false;
-        string pbStr;
-        if (mSubscriptionMask & E_LOC_CB_GNSS_LOCATION_INFO_BIT) {
-            LocAPILocationInfoIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-            if (msg.serializeToProtobuf(pbStr)) {
-                rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
-                // purge this client if failed
-                if (!rc) {
-                    LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                    mService->deleteClientbyName(mName);
-                }
-            } else {
-                LOC_LOGe("LocAPILocationInfoIndMsg serializeToProtobuf failed");
-            }
-        } else {
-            LocAPILocationIndMsg msg(SERVICE_NAME, notification.location, &mService->mPbufMsgConv);
-            if (msg.serializeToProtobuf(pbStr)) {
-                rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
-                // purge this client if failed
-                if (!rc) {
-                    LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                    mService->deleteClientbyName(mName);
-                }
-            } else {
-                LOC_LOGe("LocAPILocationIndMsg serializeToProtobuf failed");
-            }
-        }
+    if (isSubscribed(E_LOC_CB_GNSS_LOCATION_INFO_BIT)) {
+        sendIndication(E_LOCAPI_LOCATION_INFO_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_LOCATION_INFO_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(), notification,
+                                               [&](string& pbStr) {
+            LocAPILocationInfoIndMsg msg(SERVICE_NAME, notification, &mPbufMsgConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
+    } else if (isSubscribed(E_LOC_CB_SIMPLE_LOCATION_INFO_BIT)) {
+        Location& location = notification.location;
+        sendIndication(E_LOCAPI_LOCATION_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_LOCATION_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(), location,
+                                               [&](string& pbStr) {
+            LocAPILocationIndMsg msg(SERVICE_NAME, location, &mPbufMsgConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
     }
 }
 
@@ -864,113 +974,112 @@ void LocHalDaemonClientHandler::onEngLocationsInfoCb(
         GnssLocationInfoNotification* engLocationsInfoNotification
 ) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    uint32_t locReqEngTypeMask = 0;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        locReqEngTypeMask = mOptions.locReqEngTypeMask;
+    }
     LOC_LOGd("--< onEngLocationInfoCb count: %d, locReqEngTypeMask 0x%x",
-             count, mOptions.locReqEngTypeMask);
+             count, locReqEngTypeMask);
 
-    if ((nullptr != mIpcSender) &&
-        (mSubscriptionMask & E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT)) {
+    if (isSubscribed(E_LOC_CB_ENGINE_LOCATIONS_INFO_BIT)) {
 
         int reportCount = 0;
+        // zeroed, so that the same reports make the same cache key
         GnssLocationInfoNotification engineLocationInfoNotification[LOC_OUTPUT_ENGINE_COUNT];
+        memset(engineLocationInfoNotification, 0, sizeof(engineLocationInfoNotification));
         for (int i = 0; i < count; i++) {
             GnssLocationInfoNotification* locPtr = engLocationsInfoNotification+i;
 
             LOC_LOGv("--< onEngLocationInfoCb i %d, type %d", i, locPtr->locOutputEngType);
             if (((locPtr->locOutputEngType == LOC_OUTPUT_ENGINE_FUSED) &&
-                 (mOptions.locReqEngTypeMask & LOC_REQ_ENGINE_FUSED_BIT)) ||
+                 (locReqEngTypeMask & LOC_REQ_ENGINE_FUSED_BIT)) ||
                 ((locPtr->locOutputEngType == LOC_OUTPUT_ENGINE_SPE) &&
-                 (mOptions.locReqEngTypeMask & LOC_REQ_ENGINE_SPE_BIT)) ||
+                 (locReqEngTypeMask & LOC_REQ_ENGINE_SPE_BIT)) ||
                 ((locPtr->locOutputEngType == LOC_OUTPUT_ENGINE_PPE) &&
-                 (mOptions.locReqEngTypeMask & LOC_REQ_ENGINE_PPE_BIT )) ||
+                 (locReqEngTypeMask & LOC_REQ_ENGINE_PPE_BIT )) ||
                 ((locPtr->locOutputEngType == LOC_OUTPUT_ENGINE_VPE) &&
-                 (mOptions.locReqEngTypeMask & LOC_REQ_ENGINE_VPE_BIT))) {
+                 (locReqEngTypeMask & LOC_REQ_ENGINE_VPE_BIT))) {
                 engineLocationInfoNotification[reportCount++] = *locPtr;
             }
         }
 
         if (reportCount > 0 ) {
-            string pbStr;
-            LocAPIEngineLocationsInfoIndMsg msg(SERVICE_NAME, reportCount,
-                                                engineLocationInfoNotification,
-                                                &mService->mPbufMsgConv);
-            if (msg.serializeToProtobuf(pbStr)) {
-                bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
-                // purge this client if failed
-                if (!rc) {
-                    LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                    mService->deleteClientbyName(mName);
-                }
-            } else {
-                LOC_LOGe("LocAPIEngineLocationsInfoIndMsg serializeToProtobuf failed");
-            }
+            sendIndication(E_LOCAPI_ENGINE_LOCATIONS_INFO_MSG_ID,
+                           mService->mIndCache.get(E_LOCAPI_ENGINE_LOCATIONS_INFO_MSG_ID,
+                                   mPbufMsgConv.getWireVersion(),
+                                   engineLocationInfoNotification,
+                                   sizeof(engineLocationInfoNotification[0]) * reportCount,
+                                   [&](string& pbStr) {
+                LocAPIEngineLocationsInfoIndMsg msg(SERVICE_NAME, reportCount,
+                                                    engineLocationInfoNotification,
+                                                    &mPbufMsgConv);
+                return 0 != msg.serializeToProtobuf(pbStr);
+            }));
         }
     }
 }
 
 void LocHalDaemonClientHandler::onGnssNiCb(uint32_t id, GnssNiNotification gnssNiNotification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onGnssNiCb");
 }
 
 void LocHalDaemonClientHandler::onGnssSvCb(GnssSvNotification notification) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
     LOC_LOGd("--< onGnssSvCb");
-    if ((nullptr != mIpcSender) &&
-            (mSubscriptionMask & E_LOC_CB_GNSS_SV_BIT)) {
+    if (isSubscribed(E_LOC_CB_GNSS_SV_BIT) && isDeltaEncoded()) {
+        sendIndication(E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(), notification,
+                                               [&](string& pbStr) {
+            LocAPISatelliteVehicleDeltaIndMsg msg(SERVICE_NAME, notification,
+                                                  mService->mSvDeltaConv, &mPbufMsgConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
+    } else if (isSubscribed(E_LOC_CB_GNSS_SV_BIT)) {
         // broadcast
-        string pbStr;
-        LocAPISatelliteVehicleIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
-            // purge this client if failed
-            if (!rc) {
-                LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
-            }
-        } else {
-            LOC_LOGe("LocAPISatelliteVehicleIndMsg serializeToProtobuf failed");
-        }
+        sendIndication(E_LOCAPI_SATELLITE_VEHICLE_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_SATELLITE_VEHICLE_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(), notification,
+                                               [&](string& pbStr) {
+            LocAPISatelliteVehicleIndMsg msg(SERVICE_NAME, notification,
+                                             &mPbufMsgConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
     }
 }
 
 void LocHalDaemonClientHandler::onGnssNmeaCb(GnssNmeaNotification notification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
-    if ((nullptr != mIpcSender) && (mSubscriptionMask & E_LOC_CB_GNSS_NMEA_BIT)) {
+    if (isSubscribed(E_LOC_CB_GNSS_NMEA_BIT)) {
         LOC_LOGd("--< onGnssNmeaCb[%s] t=%" PRIu64" l=%zu nmea=%s",
                 mName.c_str(),
                 notification.timestamp,
                 notification.length,
                 notification.nmea);
-        // serialize nmea string into ipc message payload
-        string nmeaStr(notification.nmea, notification.length);
-        LocAPINmeaIndMsg msg(SERVICE_NAME, &mService->mPbufMsgConv);
-        msg.gnssNmeaNotification.timestamp = notification.timestamp;
-        msg.gnssNmeaNotification.nmea = nmeaStr;
-
-        string pbStr;
-        if (msg.serializeToProtobuf(pbStr)) {
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), E_LOCAPI_NMEA_MSG_ID);
-            // purge this client if failed
-            if (!rc) {
-                LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
-            }
-        } else {
-            LOC_LOGe("LocAPINmeaIndMsg serializeToProtobuf failed");
-        }
+        // the nmea string is not part of the notification itself
+        string key((const char*)&notification.timestamp, sizeof(notification.timestamp));
+        key.append(notification.nmea, notification.length);
+        sendIndication(E_LOCAPI_NMEA_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_NMEA_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(),
+                                               key.data(), key.size(),
+                                               [&](string& pbStr) {
+            // serialize nmea string into ipc message payload
+            LocAPINmeaIndMsg msg(SERVICE_NAME, &mPbufMsgConv);
+            msg.gnssNmeaNotification.timestamp = notification.timestamp;
+            msg.gnssNmeaNotification.nmea = string(notification.nmea, notification.length);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
     }
 }
 
 void LocHalDaemonClientHandler::onGnssDataCb(GnssDataNotification notification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
     LOC_LOGd("--< onGnssDataCb");
 
-    if ((nullptr != mIpcSender) &&
-            (mSubscriptionMask & E_LOC_CB_GNSS_DATA_BIT)) {
+    if (isSubscribed(E_LOC_CB_GNSS_DATA_BIT)) {
         for (int sig = 0; sig < GNSS_LOC_MAX_NUMBER_OF_SIGNAL_TYPES; sig++) {
             if (GNSS_LOC_DATA_JAMMER_IND_BIT ==
                 (notification.gnssDataMask[sig] & GNSS_LOC_DATA_JAMMER_IND_BIT)) {
@@ -982,58 +1091,57 @@ void LocHalDaemonClientHandler::onGnssDataCb(GnssDataNotification notification)
             }
         }
 
-        string pbStr;
-        LocAPIDataIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            LOC_LOGv("Sending data message");
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
-            // purge this client if failed
-            if (!rc) {
-                LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
-            }
-        } else {
-            LOC_LOGe("LocAPIDataIndMsg serializeToProtobuf failed");
-        }
+        LOC_LOGv("Sending data message");
+        sendIndication(E_LOCAPI_DATA_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_DATA_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(), notification,
+                                               [&](string& pbStr) {
+            LocAPIDataIndMsg msg(SERVICE_NAME, notification, &mPbufMsgConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
     }
 }
 
 void LocHalDaemonClientHandler::onGnssMeasurementsCb(GnssMeasurementsNotification notification) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
     LOC_LOGd("--< onGnssMeasurementsCb");
-    if ((nullptr != mIpcSender) && (mSubscriptionMask & E_LOC_CB_GNSS_MEAS_BIT)) {
-        string pbStr;
-        LocAPIMeasIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
-        if (msg.serializeToProtobuf(pbStr)) {
-            LOC_LOGv("Sending meas message");
-            bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
-            // purge this client if failed
-            if (!rc) {
-                LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
-            }
-        } else {
-            LOC_LOGe("LocAPIMeasIndMsg serializeToProtobuf failed");
-        }
+    if (isSubscribed(E_LOC_CB_GNSS_MEAS_BIT) && isDeltaEncoded()) {
+        LOC_LOGv("Sending meas delta message");
+        sendIndication(E_LOCAPI_MEAS_DELTA_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_MEAS_DELTA_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(), notification,
+                                               [&](string& pbStr) {
+            LocAPIMeasDeltaIndMsg msg(SERVICE_NAME, notification, mService->mMeasDeltaConv,
+                                      &mPbufMsgConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
+    } else if (isSubscribed(E_LOC_CB_GNSS_MEAS_BIT)) {
+        LOC_LOGv("Sending meas message");
+        sendIndication(E_LOCAPI_MEAS_MSG_ID,
+                       mService->mIndCache.get(E_LOCAPI_MEAS_MSG_ID,
+                                               mPbufMsgConv.getWireVersion(), notification,
+                                               [&](string& pbStr) {
+            LocAPIMeasIndMsg msg(SERVICE_NAME, notification, &mPbufMsgConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        }));
     }
 }
 
 void LocHalDaemonClientHandler::onLocationSystemInfoCb(LocationSystemInfo notification) {
 
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    std::lock_guard<std::mutex> lock(mLock);
     LOC_LOGd("--< onLocationSystemInfoCb");
 
     if ((nullptr != mIpcSender) &&
             (mSubscriptionMask & E_LOC_CB_SYSTEM_INFO_BIT)) {
         string pbStr;
-        LocAPILocationSystemInfoIndMsg msg(SERVICE_NAME, notification, &mService->mPbufMsgConv);
+        LocAPILocationSystemInfoIndMsg msg(SERVICE_NAME, notification, &mPbufMsgConv);
         LOC_LOGv("Sending location system info message");
         if (msg.serializeToProtobuf(pbStr)) {
             bool rc = sendMessage(pbStr.c_str(), pbStr.size(), msg.msgId);
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPILocationSystemInfoIndMsg serializeToProtobuf failed");
@@ -1042,7 +1150,10 @@ void LocHalDaemonClientHandler::onLocationSystemInfoCb(LocationSystemInfo notifi
 }
 
 void LocHalDaemonClientHandler::onLocationApiDestroyCompleteCb() {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+    // waits out a callback still running on another thread
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+    }
 
     LOC_LOGe("delete LocHalDaemonClientHandler");
     delete this;
@@ -1067,7 +1178,7 @@ void LocHalDaemonClientHandler::onGnssEnergyConsumedInfoAvailable(
             // purge this client if failed
             if (!rc) {
                 LOC_LOGe("failed rc=%d purging client=%s", rc, mName.c_str());
-                mService->deleteClientbyName(mName);
+                purge();
             }
         } else {
             LOC_LOGe("LocAPIGnssEnergyConsumedIndMsg serializeToProtobuf failed");
@@ -30,6 +30,7 @@
 #define LOCHAL_CLIENT_HANDLER_H
 
 #include <queue>
+#include <vector>
 #include <mutex>
 #include <log_util.h>
 #include <loc_pla.h>
@@ -43,6 +44,8 @@
 #include <LocationAPI.h>
 #include <LocIpc.h>
 #include <LocationApiPbMsgConv.h>
+#include <LocHalDaemonSendQueue.h>
+#include <LocHalDaemonClientRegistry.h>
 
 using namespace loc_util;
 
@@ -55,9 +58,13 @@ LocHalDaemonClientHandler
 class LocHalDaemonClientHandler
 {
 public:
-    inline LocHalDaemonClientHandler(LocationApiService* service, const std::string& clientname,
-                                     ClientType clientType) :
+    inline LocHalDaemonClientHandler(LocationApiService* service, LocHalClientHandle handle,
+                                     const std::string& clientname, ClientType clientType,
+                                     const LocationApiPbMsgConv& pbMsgConv,
+                                     uint32_t wireVersion = LOCAPI_MSG_WIRE_V1) :
                 mService(service),
+                mPbufMsgConv(pbMsgConv),
+                mHandle(handle),
                 mName(clientname),
                 mClientType(clientType),
                 mCapabilityMask(0),
@@ -73,8 +80,16 @@ public:
                 mSubscriptionMask(0),
                 mEngineInfoRequestMask(0),
                 mGeofenceIds(nullptr),
-                mIpcSender(createSender(clientname.c_str())) {
+                mIpcSender(createSender(clientname.c_str())),
+                mShmSender(nullptr),
+                mSendQueue(nullptr),
+                mPeerCloseRecver(nullptr) {
 
+        startSendQueue();
+        // msgs to this client are sent in the newest wire format both ends parse
+        mPbufMsgConv.setWireVersion((wireVersion >= LOCAPI_MSG_WIRE_V2) ?
+                                    LOCAPI_MSG_WIRE_V2 : LOCAPI_MSG_WIRE_V1);
+        mPbufMsgConv.setClientHandle(handle);
 
         if (mClientType == LOCATION_CLIENT_API) {
             updateSubscription(E_LOC_CB_GNSS_LOCATION_INFO_BIT);
@@ -85,7 +100,29 @@ public:
     }
 
     static shared_ptr<LocIpcSender> createSender(const string socket);
+    // sends indications over a shared memory ring from now on, if the
+    // client can map one
+    void setupShmSender();
+    // has the client purged as soon as it closes its connection, if it
+    // takes one; else it is left to the maintenance pings
+    void watchPeerClose();
+    inline bool isPeerCloseWatched() const { return nullptr != mPeerCloseRecver; }
     void cleanup();
+    // sends the indications held back so far in one batch
+    void flushIndications();
+    inline LocHalClientHandle getHandle() const { return mHandle; }
+    inline const std::string& getName() const { return mName; }
+    // held while the client's state is used, by the service for requests of
+    // the client and by the callbacks of its LocationAPI. Taken after the
+    // registry lock and the service state lock, see LocHalDaemonClientRegistry.
+    inline std::mutex& getLock() { return mLock; }
+    inline void getSendCounters(LocHalDaemonSendCounters& counters) {
+        if (nullptr != mSendQueue) {
+            mSendQueue->getCounters(counters);
+        } else {
+            counters = {};
+        }
+    }
 
     // public APIs
     void updateSubscription(uint32_t mask);
@@ -154,27 +191,48 @@ private:
     void onLocationSystemInfoCb(LocationSystemInfo);
     void onLocationApiDestroyCompleteCb();
 
-    // send ipc message to this client for serialized payload
+    // creates the queue of msgs to this client and its I/O thread
+    void startSendQueue();
+    // has the service purge this client, which failed to be sent to
+    void purge();
+
+    // queue ipc message to this client for serialized payload, along with
+    // the indications held back so far. Never blocks; a client that can't be
+    // reached is purged by the I/O thread. Returns false once purged.
     bool sendMessage(const char* msg, size_t msglen, ELocMsgID msg_id) {
-        bool retVal= LocIpc::send(*mIpcSender, reinterpret_cast<const uint8_t*>(msg), msglen);
+        bool retVal = (nullptr != mSendQueue) &&
+                mSendQueue->push(msg_id, std::make_shared<const std::string>(msg, msglen));
         if (retVal == false) {
             struct timespec ts;
             clock_gettime(CLOCK_BOOTTIME, &ts);
-            LOC_LOGe("failed: client %s, msg id: %d, msg size %d, err %s, "
+            LOC_LOGe("failed: client %s, msg id: %d, msg size %zu, client purged, "
                      "boot timestamp %" PRIu64" msec",
-                     mName.c_str(), msg_id, msglen, strerror(errno),
+                     mName.c_str(), msg_id, msglen,
                      (ts.tv_sec * 1000ULL + ts.tv_nsec/1000000));
         }
         return retVal;
     }
+    // queues a per-fix indication, serialized once for all clients it goes
+    // to, to be sent unless the service holds it back until
+    // flushIndications(). Takes mLock.
+    void sendIndication(ELocMsgID msgId, const shared_ptr<const string>& payload);
+    // takes mLock
+    bool isSubscribed(uint32_t mask);
+    // SV and measurement reports go as deltas, which the shared encoders of
+    // the service only make for the v2 wire format. Takes mLock.
+    bool isDeltaEncoded();
 
     uint32_t getSupportedTbf (uint32_t tbfMsec);
 
     // pointer to parent service
     LocationApiService* mService;
+    // converter for msgs to this client, in its wire format
+    LocationApiPbMsgConv mPbufMsgConv;
 
-    // name of this client
+    // handle and name of this client
+    const LocHalClientHandle mHandle;
     const std::string mName;
+    std::mutex mLock;
     ClientType mClientType;
 
     // LocationAPI interface
@@ -193,6 +251,14 @@ private:
 
     uint32_t* mGeofenceIds;
     shared_ptr<LocIpcSender> mIpcSender;
+    // shared memory ring to the client, with mIpcSender kept for liveness
+    // pings and msgs too big for the ring
+    shared_ptr<LocIpcSender> mShmSender;
+    // msgs to this client, sent by mSendThread
+    shared_ptr<LocHalDaemonSendQueue> mSendQueue;
+    LocThread mSendThread;
+    // on LocationApiService's peer close reactor, if the client is connected
+    const LocIpcRecver* mPeerCloseRecver;
     std::unordered_map<uint32_t, uint32_t> mGfIdsMap; //geofence ID map, clientId-->session
 };
 
@@ -0,0 +1,171 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <log_util.h>
+#include <LocHalDaemonClientRegistry.h>
+
+// slot numbers fit the low 16 bits of a handle, less the 0 of no handle
+#define LOC_HAL_CLIENT_MAX_SLOTS (0xffff)
+
+LocHalDaemonClientRegistry::LocHalDaemonClientRegistry() {
+    pthread_rwlock_init(&mLock, nullptr);
+}
+
+LocHalDaemonClientRegistry::~LocHalDaemonClientRegistry() {
+    pthread_rwlock_destroy(&mLock);
+}
+
+LocHalClientHandle LocHalDaemonClientRegistry::add(const std::string& name) {
+    if (mHandles.find(name) != mHandles.end()) {
+        return LOC_HAL_CLIENT_HANDLE_NONE;
+    }
+    size_t slot = 0;
+    if (!mFreeSlots.empty()) {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    } else if (mSlots.size() < LOC_HAL_CLIENT_MAX_SLOTS) {
+        slot = mSlots.size();
+        mSlots.push_back({0, false, nullptr, ""});
+    } else {
+        LOC_LOGe("out of client slots, client %s", name.c_str());
+        return LOC_HAL_CLIENT_HANDLE_NONE;
+    }
+    mSlots[slot].mUsed = true;
+    mSlots[slot].mClient = nullptr;
+    mSlots[slot].mName = name;
+    LocHalClientHandle handle = makeHandle(slot, mSlots[slot].mGeneration);
+    mHandles.emplace(name, handle);
+    return handle;
+}
+
+void LocHalDaemonClientRegistry::attach(LocHalClientHandle handle,
+                                        LocHalDaemonClientHandler* client) {
+    const Slot* slot = getSlot(handle);
+    if (nullptr != slot) {
+        mSlots[slot - mSlots.data()].mClient = client;
+    }
+}
+
+LocHalDaemonClientHandler* LocHalDaemonClientRegistry::remove(LocHalClientHandle handle) {
+    const Slot* used = getSlot(handle);
+    if (nullptr == used) {
+        return nullptr;
+    }
+    size_t index = used - mSlots.data();
+    Slot& slot = mSlots[index];
+    LocHalDaemonClientHandler* client = slot.mClient;
+    mHandles.erase(slot.mName);
+    slot.mUsed = false;
+    slot.mClient = nullptr;
+    slot.mName.clear();
+    // the handle just removed no longer finds this slot
+    slot.mGeneration++;
+    mFreeSlots.push_back(index);
+    return client;
+}
+
+const LocHalDaemonClientRegistry::Slot* LocHalDaemonClientRegistry::getSlot(
+        LocHalClientHandle handle) const {
+    size_t index = handle & 0xffff;
+    if (0 == index || index > mSlots.size()) {
+        return nullptr;
+    }
+    const Slot& slot = mSlots[index - 1];
+    if (!slot.mUsed || slot.mGeneration != (handle >> 16)) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+LocHalDaemonClientHandler* LocHalDaemonClientRegistry::find(LocHalClientHandle handle) const {
+    const Slot* slot = getSlot(handle);
+    return (nullptr != slot) ? slot->mClient : nullptr;
+}
+
+LocHalClientHandle LocHalDaemonClientRegistry::findHandle(const std::string& name) const {
+    auto it = mHandles.find(name);
+    return (it != mHandles.end()) ? it->second : LOC_HAL_CLIENT_HANDLE_NONE;
+}
+
+LocHalClientHandle LocHalDaemonClientRegistry::resolve(LocHalClientHandle handle,
+                                                       const char* name) const {
+    const Slot* slot = getSlot(handle);
+    if (nullptr != slot && 0 == strcmp(slot->mName.c_str(), name)) {
+        return handle;
+    }
+    return findHandle(name);
+}
+
+const std::string& LocHalDaemonClientRegistry::getName(LocHalClientHandle handle) const {
+    static const std::string sNone;
+    const Slot* slot = getSlot(handle);
+    return (nullptr != slot) ? slot->mName : sNone;
+}
+
+#ifdef __LOC_UNIT_TEST__
+uint32_t LocHalDaemonClientRegistry::checkHandles() {
+    uint32_t numBad = 0;
+    LocHalDaemonClientRegistry registry;
+    // stand-ins, the registry never dereferences its clients
+    uint32_t clients[2];
+    LocHalDaemonClientHandler* a = (LocHalDaemonClientHandler*)&clients[0];
+    LocHalDaemonClientHandler* b = (LocHalDaemonClientHandler*)&clients[1];
+    WriteLock lock(registry);
+
+    LocHalClientHandle ha = registry.add("a");
+    numBad += (LOC_HAL_CLIENT_HANDLE_NONE == ha);
+    // not found until attached, and a name is only taken once
+    numBad += (nullptr != registry.find(ha));
+    numBad += (LOC_HAL_CLIENT_HANDLE_NONE != registry.add("a"));
+    registry.attach(ha, a);
+    numBad += (a != registry.find(ha) || ha != registry.findHandle("a"));
+
+    // a handle whose name does not match, or none, is resolved by name
+    LocHalClientHandle hb = registry.add("b");
+    registry.attach(hb, b);
+    numBad += (hb != registry.resolve(hb, "b") || ha != registry.resolve(hb, "a"));
+    numBad += (hb != registry.resolve(LOC_HAL_CLIENT_HANDLE_NONE, "b"));
+
+    // the slot of a client gone is taken by the next, under a new handle
+    numBad += (a != registry.remove(ha) || nullptr != registry.remove(ha));
+    LocHalClientHandle hc = registry.add("c");
+    registry.attach(hc, a);
+    numBad += ((hc & 0xffff) != (ha & 0xffff) || hc == ha);
+    numBad += (nullptr != registry.find(ha) || a != registry.find(hc));
+    numBad += (LOC_HAL_CLIENT_HANDLE_NONE != registry.resolve(ha, "a"));
+
+    uint32_t count = 0;
+    registry.forEach([&](LocHalClientHandle handle, LocHalDaemonClientHandler* client) {
+        count++;
+        numBad += (client != registry.find(handle));
+    });
+    numBad += (2 != count || registry.getName(hc) != "c" || !registry.getName(ha).empty());
+    return numBad;
+}
+#endif
@@ -0,0 +1,144 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOCHAL_CLIENT_REGISTRY_H
+#define LOCHAL_CLIENT_REGISTRY_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#ifdef NO_UNORDERED_SET_OR_MAP
+    #include <map>
+#else
+    #include <unordered_map>
+#endif
+
+class LocHalDaemonClientHandler;
+
+// Handle the daemon knows a client by, and that the client sends in the
+// header of its v2 msgs: the slot of the client plus one in the low 16 bits,
+// the generation of the slot in the high 16 bits, so that the handle of a
+// client gone is not taken for that of the next client in its slot.
+typedef uint32_t LocHalClientHandle;
+#define LOC_HAL_CLIENT_HANDLE_NONE (0)
+
+/******************************************************************************
+LocHalDaemonClientRegistry
+
+The clients of the daemon, in an array of slots indexed by handle. Clients
+are looked up far more often than added or removed, so the registry is held
+by a reader / writer lock: msgs of different clients are looked up, and
+handled each under the lock of its own client, in parallel, and only adding
+and removing a client excludes all else. Lock order is registry, then the
+service state lock, then at most one client lock.
+******************************************************************************/
+class LocHalDaemonClientRegistry {
+public:
+    LocHalDaemonClientRegistry();
+    ~LocHalDaemonClientRegistry();
+
+    // holds the registry for looking up clients
+    class ReadLock {
+        LocHalDaemonClientRegistry& mRegistry;
+    public:
+        inline ReadLock(LocHalDaemonClientRegistry& registry) : mRegistry(registry) {
+            pthread_rwlock_rdlock(&mRegistry.mLock);
+        }
+        inline ~ReadLock() { pthread_rwlock_unlock(&mRegistry.mLock); }
+    };
+    // holds the registry for adding and removing clients
+    class WriteLock {
+        LocHalDaemonClientRegistry& mRegistry;
+    public:
+        inline WriteLock(LocHalDaemonClientRegistry& registry) : mRegistry(registry) {
+            pthread_rwlock_wrlock(&mRegistry.mLock);
+        }
+        inline ~WriteLock() { pthread_rwlock_unlock(&mRegistry.mLock); }
+    };
+
+    // with a WriteLock held. add() takes a slot for a client of the name,
+    // which is found once attach() has put the client in it. Returns
+    // LOC_HAL_CLIENT_HANDLE_NONE if the name is taken or the slots are out.
+    LocHalClientHandle add(const std::string& name);
+    void attach(LocHalClientHandle handle, LocHalDaemonClientHandler* client);
+    // frees the slot of the client, returns the client
+    LocHalDaemonClientHandler* remove(LocHalClientHandle handle);
+
+    // with either lock held. Returns nullptr if handle is no longer valid.
+    LocHalDaemonClientHandler* find(LocHalClientHandle handle) const;
+    // handle of the client of the name, LOC_HAL_CLIENT_HANDLE_NONE if none
+    LocHalClientHandle findHandle(const std::string& name) const;
+    // handle of the client a msg is from: the one it sent if that is still
+    // the handle of a client of its name, else looked up by name, e.g. for
+    // a client on the v1 wire format
+    LocHalClientHandle resolve(LocHalClientHandle handle, const char* name) const;
+    const std::string& getName(LocHalClientHandle handle) const;
+    // calls f(handle, client) for each client
+    template <typename F>
+    inline void forEach(F f) const {
+        for (size_t i = 0; i < mSlots.size(); i++) {
+            if (nullptr != mSlots[i].mClient) {
+                f(makeHandle(i, mSlots[i].mGeneration), mSlots[i].mClient);
+            }
+        }
+    }
+
+#ifdef __LOC_UNIT_TEST__
+    // adds, removes and looks up clients, and returns the number of checks
+    // that failed; 0 on success.
+    static uint32_t checkHandles();
+#endif
+
+private:
+    struct Slot {
+        uint16_t mGeneration;
+        bool mUsed;
+        LocHalDaemonClientHandler* mClient;
+        std::string mName;
+    };
+
+    static inline LocHalClientHandle makeHandle(size_t slot, uint16_t generation) {
+        return ((LocHalClientHandle)generation << 16) | (LocHalClientHandle)(slot + 1);
+    }
+    // slot of handle, or nullptr if handle is not that of a used slot
+    const Slot* getSlot(LocHalClientHandle handle) const;
+
+    pthread_rwlock_t mLock;
+    std::vector<Slot> mSlots;
+    std::vector<uint16_t> mFreeSlots;
+    // clients on the v1 wire format are found by name
+#ifdef NO_UNORDERED_SET_OR_MAP
+    std::map<std::string, LocHalClientHandle> mHandles;
+#else
+    std::unordered_map<std::string, LocHalClientHandle> mHandles;
+#endif
+};
+
+#endif //LOCHAL_CLIENT_REGISTRY_H
@@ -0,0 +1,214 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <LocHalDaemonIndCache.h>
+#ifdef __LOC_UNIT_TEST__
+#include <time.h>
+#include <LocationApiPbMsgConv.h>
+#include <vector>
+#endif
+
+std::shared_ptr<const std::string> LocHalDaemonIndCache::get(ELocMsgID msgId,
+        uint32_t wireVersion, const void* key, size_t keyLen, const Encoder& encode) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Entry& entry = mEntries[(wireVersion << 16) | msgId];
+    if (nullptr != entry.mPayload && entry.mKey.size() == keyLen &&
+            0 == memcmp(entry.mKey.data(), key, keyLen)) {
+        mHits++;
+        return entry.mPayload;
+    }
+
+    std::shared_ptr<std::string> payload = std::make_shared<std::string>();
+    mEncodes++;
+    if (!encode(*payload)) {
+        entry.mPayload = nullptr;
+        return nullptr;
+    }
+    // encoded for one client but shared by all, so it carries no handle
+    LocAPIMsgHeader::setWireClientHandle(*payload, 0);
+    entry.mKey.assign((const char*)key, keyLen);
+    entry.mPayload = payload;
+    return payload;
+}
+
+#ifdef __LOC_UNIT_TEST__
+typedef std::function<bool(LocationApiPbMsgConv&, std::string&)> ClientEncoder;
+typedef std::function<void(ELocMsgID msgId, const void* key, size_t keyLen,
+                           const ClientEncoder& encode)> ReportSender;
+
+// the reports of one fix: location info, SV, NMEA and data
+struct LocIndCacheFix {
+    GnssLocationInfoNotification locInfo = {};
+    GnssSvNotification sv = {};
+    GnssDataNotification data = {};
+
+    inline LocIndCacheFix() {
+        sv.count = 32;
+        for (uint32_t i = 0; i < sv.count; i++) {
+            sv.gnssSvs[i].svId = i + 1;
+            sv.gnssSvs[i].cN0Dbhz = 30.0f + i;
+            sv.gnssSvs[i].elevation = i;
+            sv.gnssSvs[i].azimuth = 10.0f * i;
+        }
+        data.size = sizeof(data);
+    }
+
+    // like the adapters do, each report goes to all clients in turn, as a
+    // callback per client, which sender does for each report of fix
+    void send(uint32_t fix, const ReportSender& sender) {
+        const char* nmea[] = {
+            "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n",
+            "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n",
+            "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n",
+        };
+        locInfo.location.timestamp = fix;
+        locInfo.location.latitude = 37.0 + fix * 1e-6;
+        sv.gnssSvs[0].cN0Dbhz = 30.0f + fix % 10;
+        data.agc[0] = fix;
+        sender(E_LOCAPI_LOCATION_INFO_MSG_ID, &locInfo, sizeof(locInfo),
+               [&](LocationApiPbMsgConv& pbConv, std::string& pbStr) {
+            LocAPILocationInfoIndMsg msg(SERVICE_NAME, locInfo, &pbConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        });
+        sender(E_LOCAPI_SATELLITE_VEHICLE_MSG_ID, &sv, sizeof(sv),
+               [&](LocationApiPbMsgConv& pbConv, std::string& pbStr) {
+            LocAPISatelliteVehicleIndMsg msg(SERVICE_NAME, sv, &pbConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        });
+        for (const char* sentence : nmea) {
+            std::string key((const char*)&fix, sizeof(fix));
+            key.append(sentence);
+            sender(E_LOCAPI_NMEA_MSG_ID, key.data(), key.size(),
+                   [&](LocationApiPbMsgConv& pbConv, std::string& pbStr) {
+                LocAPINmeaIndMsg msg(SERVICE_NAME, &pbConv);
+                msg.gnssNmeaNotification.timestamp = fix;
+                msg.gnssNmeaNotification.nmea = sentence;
+                return 0 != msg.serializeToProtobuf(pbStr);
+            });
+        }
+        sender(E_LOCAPI_DATA_MSG_ID, &data, sizeof(data),
+               [&](LocationApiPbMsgConv& pbConv, std::string& pbStr) {
+            LocAPIDataIndMsg msg(SERVICE_NAME, data, &pbConv);
+            return 0 != msg.serializeToProtobuf(pbStr);
+        });
+    }
+};
+
+// each client's converter, with its own handle
+static std::vector<LocationApiPbMsgConv> clientConvs(uint32_t numClients) {
+    std::vector<LocationApiPbMsgConv> pbConvs(numClients);
+    for (uint32_t client = 0; client < numClients; client++) {
+        pbConvs[client].setWireVersion(LOCAPI_MSG_WIRE_V2);
+        pbConvs[client].setClientHandle(client + 1);
+    }
+    return pbConvs;
+}
+
+uint32_t LocHalDaemonIndCache::check(uint32_t numClients, uint32_t numFixes) {
+    std::vector<LocationApiPbMsgConv> pbConvs = clientConvs(numClients);
+    LocHalDaemonIndCache cache;
+    LocIndCacheFix reports;
+    uint32_t mismatches = 0;
+    uint64_t numReports = 0;
+
+    for (uint32_t fix = 0; fix < numFixes; fix++) {
+        // every client must get what it would have encoded itself, less its
+        // handle
+        reports.send(fix, [&](ELocMsgID msgId, const void* key, size_t keyLen,
+                              const ClientEncoder& encode) {
+            numReports++;
+            for (uint32_t client = 0; client < numClients; client++) {
+                LocationApiPbMsgConv& pbConv = pbConvs[client];
+                std::shared_ptr<const std::string> payload = cache.get(msgId,
+                        LOCAPI_MSG_WIRE_V2, key, keyLen,
+                        [&](std::string& pbStr) { return encode(pbConv, pbStr); });
+                std::string own;
+                encode(pbConv, own);
+                LocAPIMsgHeader::setWireClientHandle(own, 0);
+                if (nullptr == payload || *payload != own) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+
+    // one encode per report, shared by all other clients
+    uint64_t encodes = 0;
+    uint64_t hits = 0;
+    cache.getStats(encodes, hits);
+    if (encodes != numReports || hits != numReports * (numClients - 1)) {
+        mismatches++;
+    }
+    return mismatches;
+}
+
+static inline uint64_t getThreadCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void LocHalDaemonIndCache::benchmark(uint32_t numClients, uint32_t numFixes,
+                                     uint64_t& cachedNs, uint64_t& uncachedNs) {
+    std::vector<LocationApiPbMsgConv> pbConvs = clientConvs(numClients);
+    LocHalDaemonIndCache cache;
+    LocIndCacheFix reports;
+    size_t bytes = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool useCache = (0 == pass);
+        uint64_t start = getThreadCpuNs();
+        for (uint32_t fix = 0; fix < numFixes; fix++) {
+            reports.send(fix, [&](ELocMsgID msgId, const void* key, size_t keyLen,
+                                  const ClientEncoder& encode) {
+                for (uint32_t client = 0; client < numClients; client++) {
+                    LocationApiPbMsgConv& pbConv = pbConvs[client];
+                    std::shared_ptr<const std::string> payload;
+                    if (useCache) {
+                        payload = cache.get(msgId, LOCAPI_MSG_WIRE_V2, key, keyLen,
+                                [&](std::string& pbStr) { return encode(pbConv, pbStr); });
+                    } else {
+                        std::shared_ptr<std::string> pbStr = std::make_shared<std::string>();
+                        encode(pbConv, *pbStr);
+                        payload = pbStr;
+                    }
+                    bytes += (nullptr != payload) ? payload->size() : 0;
+                }
+            });
+        }
+        uint64_t ns = (getThreadCpuNs() - start) / (numFixes > 0 ? numFixes : 1);
+        if (useCache) {
+            cachedNs = ns;
+        } else {
+            uncachedNs = ns;
+        }
+    }
+    (void)bytes;
+}
+#endif
@@ -0,0 +1,113 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOCHAL_IND_CACHE_H
+#define LOCHAL_IND_CACHE_H
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <type_traits>
+#include <LocationApiMsg.h>
+
+#ifdef NO_UNORDERED_SET_OR_MAP
+    #include <map>
+#else
+    #include <unordered_map>
+#endif
+
+/******************************************************************************
+LocHalDaemonIndCache
+
+Each client has a LocationAPI of its own, so a report reaches the daemon as
+one callback per client, each serializing the same indication again. This
+keeps the last serialized payload per indication msg id, along with the
+bytes of the report it was made from. The first client to get a report
+serializes it, and every other client getting the same msg id for the same
+report shares that payload by refcount. Clients whose subscription picks
+another msg id for the report, e.g. location vs location info, get their
+own payload, so there is one encode per kind of indication, and wire format,
+per report. Shared payloads carry no client handle; clients learn theirs from
+the msgs sent to them alone.
+******************************************************************************/
+class LocHalDaemonIndCache {
+public:
+    typedef std::function<bool(std::string& pbStr)> Encoder;
+
+    inline LocHalDaemonIndCache() : mEncodes(0), mHits(0) {}
+
+    // returns the payload of indication msgId in wire format wireVersion for
+    // the report whose bytes are key / keyLen, running encode only if that is
+    // not the last one seen. Returns nullptr if encode fails.
+    std::shared_ptr<const std::string> get(ELocMsgID msgId, uint32_t wireVersion,
+                                           const void* key, size_t keyLen,
+                                           const Encoder& encode);
+    template <typename T>
+    inline std::shared_ptr<const std::string> get(ELocMsgID msgId, uint32_t wireVersion,
+                                                  const T& report, const Encoder& encode) {
+        static_assert(std::is_trivially_copyable<T>::value, "report must be plain data");
+        return get(msgId, wireVersion, &report, sizeof(report), encode);
+    }
+
+    inline void getStats(uint64_t& encodes, uint64_t& hits) {
+        std::lock_guard<std::mutex> lock(mLock);
+        encodes = mEncodes;
+        hits = mHits;
+    }
+
+#ifdef __LOC_UNIT_TEST__
+    // serializes the indications of numFixes fixes (location info, SV, NMEA
+    // and data) for numClients clients through the cache. Returns the number
+    // of payloads not as the client would have encoded them, less its
+    // handle, plus one if a report took more than one encode; 0 on success.
+    static uint32_t check(uint32_t numClients, uint32_t numFixes);
+    // CPU time, in ns, to serialize the same indications of one fix for
+    // numClients clients, with and without the cache, averaged over numFixes
+    // fixes.
+    static void benchmark(uint32_t numClients, uint32_t numFixes,
+                          uint64_t& cachedNs, uint64_t& uncachedNs);
+#endif
+
+private:
+    struct Entry {
+        std::string mKey;
+        std::shared_ptr<const std::string> mPayload;
+    };
+    std::mutex mLock;
+#ifdef NO_UNORDERED_SET_OR_MAP
+    std::map<uint32_t, Entry> mEntries;
+#else
+    std::unordered_map<uint32_t, Entry> mEntries;
+#endif
+    uint64_t mEncodes;
+    uint64_t mHits;
+};
+
+#endif //LOCHAL_IND_CACHE_H
@@ -0,0 +1,234 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <iterator>
+#include <log_util.h>
+#include <LocHalDaemonSendQueue.h>
+
+LocHalDaemonSendQueue::LocHalDaemonSendQueue(const std::string& clientName,
+                                             const shared_ptr<LocIpcSender>& sender,
+                                             uint32_t depth, const FailureCb& onFailure) :
+        mName(clientName),
+        mDepth((depth > 0) ? depth : LOC_HAL_DAEMON_SEND_QUEUE_DEPTH),
+        mOnFailure(onFailure),
+        mSender(sender),
+        mKicked(false),
+        mStopped(false),
+        mCounters{} {
+}
+
+LocSendPolicy LocHalDaemonSendQueue::getPolicy(ELocMsgID msgId) {
+    switch (msgId) {
+        case E_LOCAPI_SATELLITE_VEHICLE_MSG_ID:
+        case E_LOCAPI_NMEA_MSG_ID:
+        case E_LOCAPI_DATA_MSG_ID:
+        case E_LOCAPI_MEAS_MSG_ID:
+        // a client missing a delta gets back in at the next keyframe
+        case E_LOCAPI_SATELLITE_VEHICLE_DELTA_MSG_ID:
+        case E_LOCAPI_MEAS_DELTA_MSG_ID:
+            return LOC_SEND_POLICY_DROP_OLDEST;
+        case E_LOCAPI_LOCATION_MSG_ID:
+        case E_LOCAPI_LOCATION_INFO_MSG_ID:
+        case E_LOCAPI_ENGINE_LOCATIONS_INFO_MSG_ID:
+            return LOC_SEND_POLICY_COALESCE;
+        default:
+            return LOC_SEND_POLICY_NEVER_DROP;
+    }
+}
+
+bool LocHalDaemonSendQueue::push(ELocMsgID msgId, const shared_ptr<const std::string>& payload,
+                                 bool kick) {
+    if (nullptr == payload) {
+        return true;
+    }
+    LocSendPolicy policy = getPolicy(msgId);
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mStopped) {
+        return false;
+    }
+
+    if (LOC_SEND_POLICY_COALESCE == policy) {
+        for (auto it = mQueue.begin(); it != mQueue.end(); ++it) {
+            if (it->mMsgId == msgId) {
+                // the newer one goes to the back, to stay in order with the rest
+                mQueue.erase(it);
+                mCounters.mCoalesced++;
+                break;
+            }
+        }
+    }
+    if (LOC_SEND_POLICY_NEVER_DROP != policy && mQueue.size() >= mDepth) {
+        // make room by dropping the oldest telemetry, else the oldest fix
+        auto victim = mQueue.end();
+        for (auto it = mQueue.begin(); it != mQueue.end(); ++it) {
+            if (LOC_SEND_POLICY_DROP_OLDEST == it->mPolicy) {
+                victim = it;
+                break;
+            }
+            if (LOC_SEND_POLICY_COALESCE == it->mPolicy && victim == mQueue.end()) {
+                victim = it;
+            }
+        }
+        mCounters.mDropped++;
+        if (victim == mQueue.end()) {
+            // all queued msgs are never to be dropped
+            return true;
+        }
+        mQueue.erase(victim);
+    }
+
+    mQueue.push_back({msgId, policy, payload});
+    if (mQueue.size() > mCounters.mMaxDepth) {
+        mCounters.mMaxDepth = mQueue.size();
+    }
+    if (kick && !mKicked) {
+        mKicked = true;
+        mCond.notify_one();
+    }
+    return true;
+}
+
+void LocHalDaemonSendQueue::kick() {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (!mKicked && !mQueue.empty()) {
+        mKicked = true;
+        mCond.notify_one();
+    }
+}
+
+void LocHalDaemonSendQueue::setSender(const shared_ptr<LocIpcSender>& sender) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mSender = sender;
+}
+
+void LocHalDaemonSendQueue::getCounters(LocHalDaemonSendCounters& counters) {
+    std::lock_guard<std::mutex> lock(mLock);
+    counters = mCounters;
+    counters.mDepth = mQueue.size();
+}
+
+bool LocHalDaemonSendQueue::run() {
+    shared_ptr<LocIpcSender> sender;
+    {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCond.wait(lock, [this] { return mStopped || (mKicked && !mQueue.empty()); });
+        if (mStopped) {
+            return false;
+        }
+        mKicked = false;
+        mBatch.assign(std::make_move_iterator(mQueue.begin()),
+                      std::make_move_iterator(mQueue.end()));
+        mQueue.clear();
+        sender = mSender;
+    }
+
+    mMsgs.resize(mBatch.size());
+    for (size_t i = 0; i < mBatch.size(); i++) {
+        mMsgs[i].mData = reinterpret_cast<const uint8_t*>(mBatch[i].mPayload->data());
+        mMsgs[i].mLength = mBatch[i].mPayload->size();
+    }
+    // may block for as long as the sender's send timeout
+    uint32_t sent = (nullptr == sender) ? 0 : LocIpc::send(*sender, mMsgs.data(), mMsgs.size());
+    int err = errno;
+    size_t numMsgs = mBatch.size();
+    ELocMsgID failedMsgId = (sent < numMsgs) ? mBatch[sent].mMsgId : E_LOCAPI_UNDEFINED_MSG_ID;
+    mBatch.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mCounters.mSent += sent;
+        if (sent == numMsgs) {
+            return true;
+        }
+        if (mStopped) {
+            return false;
+        }
+        mStopped = true;
+        mQueue.clear();
+    }
+    LOC_LOGe("failed: client %s, sent %u of %zu msgs, msg id %d, err %s",
+             mName.c_str(), sent, numMsgs, failedMsgId, strerror(err));
+    if (nullptr != mOnFailure) {
+        mOnFailure(this);
+    }
+    return false;
+}
+
+void LocHalDaemonSendQueue::interrupt() {
+    std::lock_guard<std::mutex> lock(mLock);
+    mStopped = true;
+    mQueue.clear();
+    mCond.notify_one();
+}
+
+#ifdef __LOC_UNIT_TEST__
+uint32_t LocHalDaemonSendQueue::checkPolicies() {
+    uint32_t numBad = 0;
+    auto payload = [](const char* s) { return std::make_shared<const std::string>(s); };
+    LocHalDaemonSendQueue queue("test", nullptr, 4, nullptr);
+    LocHalDaemonSendCounters counters;
+
+    // telemetry beyond the depth drops the oldest
+    const char* sv[] = {"sv0", "sv1", "sv2", "sv3", "sv4", "sv5"};
+    for (const char* s : sv) {
+        queue.push(E_LOCAPI_SATELLITE_VEHICLE_MSG_ID, payload(s), false);
+    }
+    queue.getCounters(counters);
+    numBad += (4 != counters.mDepth || 2 != counters.mDropped);
+    numBad += (*queue.mQueue.front().mPayload != "sv2");
+
+    // fixes replace the one still queued, and push out telemetry
+    queue.push(E_LOCAPI_LOCATION_INFO_MSG_ID, payload("fix0"), false);
+    queue.push(E_LOCAPI_LOCATION_INFO_MSG_ID, payload("fix1"), false);
+    queue.getCounters(counters);
+    numBad += (4 != counters.mDepth || 1 != counters.mCoalesced || 3 != counters.mDropped);
+    numBad += (*queue.mQueue.back().mPayload != "fix1");
+
+    // responses are never dropped, nor drop anything
+    queue.push(E_LOCAPI_START_TRACKING_MSG_ID, payload("resp0"));
+    queue.push(E_LOCAPI_STOP_TRACKING_MSG_ID, payload("resp1"));
+    queue.getCounters(counters);
+    numBad += (6 != counters.mDepth || 3 != counters.mDropped || !queue.mKicked);
+
+    // telemetry makes room by dropping telemetry before any fix
+    for (const char* s : sv) {
+        queue.push(E_LOCAPI_NMEA_MSG_ID, payload(s), false);
+    }
+    queue.getCounters(counters);
+    numBad += (6 != counters.mDepth || 9 != counters.mDropped);
+    numBad += (*queue.mQueue.front().mPayload != "fix1" || *queue.mQueue.back().mPayload != "sv5");
+
+    queue.interrupt();
+    numBad += queue.push(E_LOCAPI_START_TRACKING_MSG_ID, payload("resp2"));
+    queue.getCounters(counters);
+    numBad += (0 != counters.mDepth);
+    return numBad;
+}
+#endif
@@ -0,0 +1,132 @@
+/* Copyright (c) 2020, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOCHAL_SEND_QUEUE_H
+#define LOCHAL_SEND_QUEUE_H
+
+#include <stdint.h>
+#include <string>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <LocThread.h>
+#include <LocIpc.h>
+#include <LocationApiMsg.h>
+
+using namespace loc_util;
+
+// default max number of msgs queued to one client before its droppable
+// msgs are dropped, see CLIENT_SEND_QUEUE_DEPTH
+#define LOC_HAL_DAEMON_SEND_QUEUE_DEPTH 32
+
+// what a full LocHalDaemonSendQueue does about a msg
+typedef enum {
+    // responses and one off indications; queued past the depth
+    LOC_SEND_POLICY_NEVER_DROP = 0,
+    // high rate telemetry, e.g. SV and NMEA; the oldest one queued is dropped
+    LOC_SEND_POLICY_DROP_OLDEST,
+    // per-fix state; replaces the one of the same msg id still queued
+    LOC_SEND_POLICY_COALESCE,
+} LocSendPolicy;
+
+struct LocHalDaemonSendCounters {
+    // msgs queued now, and the most ever queued
+    uint32_t mDepth;
+    uint32_t mMaxDepth;
+    uint64_t mSent;
+    // msgs dropped to keep the queue within its depth
+    uint64_t mDropped;
+    // msgs replaced by a later one of the same msg id
+    uint64_t mCoalesced;
+};
+
+/******************************************************************************
+LocHalDaemonSendQueue
+
+Outbound msgs of one client. The service queues msgs without ever blocking,
+and an I/O thread of the client's own sends them, all that are queued in one
+LocIpc::send(). A client slow to read only holds up its own I/O thread, and
+the queue to it stays bounded by the LocSendPolicy of each msg id. If a send
+fails, the queue stops and onFailure is called from the I/O thread.
+******************************************************************************/
+class LocHalDaemonSendQueue : public LocRunnable {
+public:
+    typedef std::function<void(const LocHalDaemonSendQueue* queue)> FailureCb;
+
+    LocHalDaemonSendQueue(const std::string& clientName, const shared_ptr<LocIpcSender>& sender,
+                          uint32_t depth, const FailureCb& onFailure);
+
+    static LocSendPolicy getPolicy(ELocMsgID msgId);
+
+    // queues payload, and has it sent right away unless kick is false, in
+    // which case it waits for the next kick(). Returns false once stopped.
+    bool push(ELocMsgID msgId, const shared_ptr<const std::string>& payload,
+              bool kick = true);
+    // has the I/O thread send all msgs queued
+    void kick();
+    void setSender(const shared_ptr<LocIpcSender>& sender);
+    void getCounters(LocHalDaemonSendCounters& counters);
+
+    // LocRunnable, run by the I/O thread
+    bool run() override;
+    // stops the queue, discarding the msgs still in it
+    void interrupt() override;
+
+#ifdef __LOC_UNIT_TEST__
+    // pushes msgs of each policy into a queue with no I/O thread and
+    // returns the number of checks that failed; 0 on success.
+    static uint32_t checkPolicies();
+#endif
+
+private:
+    struct Entry {
+        ELocMsgID mMsgId;
+        LocSendPolicy mPolicy;
+        shared_ptr<const std::string> mPayload;
+    };
+
+    const std::string mName;
+    const uint32_t mDepth;
+    const FailureCb mOnFailure;
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::deque<Entry> mQueue;
+    shared_ptr<LocIpcSender> mSender;
+    // the queued msgs are to be sent
+    bool mKicked;
+    bool mStopped;
+    LocHalDaemonSendCounters mCounters;
+    // msgs taken off mQueue by the I/O thread, only used by it
+    std::vector<Entry> mBatch;
+    std::vector<LocIpcMsg> mMsgs;
+};
+
+#endif //LOCHAL_SEND_QUEUE_H
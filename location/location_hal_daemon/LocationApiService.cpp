@@ -54,7 +54,7 @@ typedef void* (getLocationInterface)();
 LocationApiService - static members
 ******************************************************************************/
 LocationApiService* LocationApiService::mInstance = nullptr;
-std::mutex LocationApiService::mMutex;
+thread_local bool LocationApiService::sIndicationFlushPending = false;
 
 /******************************************************************************
 LocHaldIpcListener
@@ -100,6 +100,13 @@ public:
             if ('.' == (dp->d_name[0])) {
                 continue;
             }
+            // skip the SOCK_SEQPACKET twin of each client socket
+            size_t nameLen = strlen(dp->d_name);
+            if (nameLen >= sizeof(LOC_IPC_SEQPACKET_SUFFIX) - 1 &&
+                0 == strcmp(dp->d_name + nameLen - (sizeof(LOC_IPC_SEQPACKET_SUFFIX) - 1),
+                            LOC_IPC_SEQPACKET_SUFFIX)) {
+                continue;
+            }
 
             if (0 == fname.compare(0, mClientSockPathnamePrefix.size(),
                                    mClientSockPathnamePrefix)) {
@@ -125,10 +132,13 @@ LocationApiService - constructors
 ******************************************************************************/
 LocationApiService::LocationApiService(const configParamToRead & configParamRead) :
 
+    mGnssEnergyConsumedPending(false),
     mLocationControlId(0),
     mAutoStartGnss(configParamRead.autoStartGnss),
     mPowerState(POWER_STATE_UNKNOWN),
     mPositionMode((GnssSuplMode)configParamRead.positionMode),
+    mBatchClientIndications(configParamRead.batchClientIndications),
+    mClientSendQueueDepth(configParamRead.clientSendQueueDepth),
     mMsgTask("LocHalDaemonMaintenanceMsgTask"),
     mMaintTimer(this),
     mGtpWwanSsLocationApi(nullptr),
@@ -143,6 +153,8 @@ LocationApiService::LocationApiService(const configParamToRead & configParamRead
     LOC_LOGd("DeleteAllBeforeAutoStart=%u", configParamRead.deleteAllBeforeAutoStart);
     LOC_LOGd("DeleteAllOnEnginesMask=%u", configParamRead.posEngineMask);
     LOC_LOGd("PositionMode=%u", configParamRead.positionMode);
+    LOC_LOGd("BatchClientIndications=%u", configParamRead.batchClientIndications);
+    LOC_LOGd("ClientSendQueueDepth=%u", configParamRead.clientSendQueueDepth);
 
     // create Location control API
     mControlCallabcks.size = sizeof(mControlCallabcks);
@@ -191,9 +203,13 @@ LocationApiService::LocationApiService(const configParamToRead & configParamRead
         }
 
         LOC_LOGd("--> Starting a default client...");
+        LocHalDaemonClientRegistry::WriteLock registryLock(mClients);
+        LocHalClientHandle handle = mClients.add(AUTO_START_CLIENT_NAME);
         LocHalDaemonClientHandler* pClient =
-                new LocHalDaemonClientHandler(this, AUTO_START_CLIENT_NAME, LOCATION_CLIENT_API);
-        mClients.emplace(AUTO_START_CLIENT_NAME, pClient);
+                new LocHalDaemonClientHandler(this, handle, AUTO_START_CLIENT_NAME,
+                                              LOCATION_CLIENT_API, mPbufMsgConv);
+        mClients.attach(handle, pClient);
+        std::lock_guard<std::mutex> lock(pClient->getLock());
 
         pClient->updateSubscription(
                 E_LOC_CB_GNSS_LOCATION_INFO_BIT | E_LOC_CB_GNSS_SV_BIT);
@@ -228,9 +244,12 @@ LocationApiService::~LocationApiService() {
     mIpc.stopBlockingListening(*mBlockingRecver);
 
     // free resource associated with the client
-    for (auto each : mClients) {
-        LOC_LOGd(">-- deleted client [%s]", each.first.c_str());
-        each.second->cleanup();
+    {
+        LocHalDaemonClientRegistry::WriteLock registryLock(mClients);
+        mClients.forEach([](LocHalClientHandle handle, LocHalDaemonClientHandler* pClient) {
+            LOC_LOGd(">-- deleted client [%s]", pClient->getName().c_str());
+            pClient->cleanup();
+        });
     }
 
     // delete location contorol API handle
@@ -243,372 +262,404 @@ LocationApiService - implementation - registration
 ******************************************************************************/
 void LocationApiService::processClientMsg(const char* data, uint32_t length) {
 
-    string mMsgData(data, length);
-
-    // parse received message
-    // Protobuff Encoding enabled, so we need to convert the message from proto
-    // encoded format to local structure
-    PBLocAPIMsgHeader pbLocApiMsg;
-    if (0 == pbLocApiMsg.ParseFromString(mMsgData)) {
-        LOC_LOGe("Failed to parse pbLocApiMsg from input stream!! length: %u",
-                mMsgData.length());
+    // parse received message, in either wire format. Protobuff Encoding enabled,
+    // so we need to convert the payload from proto encoded format to local structure
+    LocAPIMsgView pbLocApiMsg;
+    if (!pbLocApiMsg.parse(data, length)) {
+        LOC_LOGe("Failed to parse pbLocApiMsg from input stream!! length: %u", length);
         return;
     }
 
-    ELocMsgID eLocMsgid = mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgid());
-    string sockName = pbLocApiMsg.msocketname();
-    uint32_t msgVer = pbLocApiMsg.msgversion();
-    uint32_t payloadSize = pbLocApiMsg.payloadsize();
-    // pbLocApiMsg.payload() contains the payload data.
+    ELocMsgID eLocMsgid = mPbufMsgConv.getEnumForPBELocMsgID(pbLocApiMsg.msgId);
+    const char* sockName = pbLocApiMsg.sockName;
+    uint32_t msgVer = pbLocApiMsg.msgVersion;
+    uint32_t payloadSize = pbLocApiMsg.payloadSize;
+    // pbLocApiMsg.payload points to the payload data.
 
     LOC_LOGi(">-- onReceive Rcvd msg id: %d, remote client: %s, payload size: %d", eLocMsgid,
-            sockName.c_str(), payloadSize);
-    LocAPIMsgHeader locApiMsg(sockName.c_str(), eLocMsgid);
+            sockName, payloadSize);
+    LocAPIMsgHeader locApiMsg(sockName, eLocMsgid);
 
     // throw away msg that does not come from location hal daemon client, e.g. LCA/LIA
     if (false == locApiMsg.isValidClientMsg(payloadSize)) {
         return;
     }
 
+    // the client is found by the handle it sent, if it is on the v2 wire
+    // format, else by its name
+    LocHalClientHandle handle = LOC_HAL_CLIENT_HANDLE_NONE;
+    if (E_LOCAPI_CLIENT_REGISTER_MSG_ID != eLocMsgid) {
+        LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+        handle = mClients.resolve(pbLocApiMsg.clientHandle, sockName);
+    }
+
     switch (eLocMsgid) {
         case E_LOCAPI_CLIENT_REGISTER_MSG_ID: {
             // new client
-            PBLocAPIClientRegisterReqMsg pbLocApiClientRegReqMsg;
-            if (0 == pbLocApiClientRegReqMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIClientRegisterReqMsg& pbLocApiClientRegReqMsg =
+                    pbLocApiMsg.createPbMsg<PBLocAPIClientRegisterReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiClientRegReqMsg)) {
                 LOC_LOGe("Failed to parse pbLocApiClientRegReqMsg from payload!!");
                 return;
             }
-            LocAPIClientRegisterReqMsg msg(pbLocApiMsg.msocketname().c_str(),
+            LocAPIClientRegisterReqMsg msg(sockName,
                     pbLocApiClientRegReqMsg, &mPbufMsgConv);
             newClient(reinterpret_cast<LocAPIClientRegisterReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_CLIENT_DEREGISTER_MSG_ID: {
             // delete client
-            LocAPIClientDeregisterReqMsg msg(sockName.c_str(), &mPbufMsgConv);
-            deleteClient(reinterpret_cast<LocAPIClientDeregisterReqMsg*>(&msg));
+            deleteClient(handle);
             break;
         }
 
         case E_LOCAPI_START_TRACKING_MSG_ID: {
             // start
-            PBLocAPIStartTrackingReqMsg pbLocApiStartTrackMsg;
-            if (0 == pbLocApiStartTrackMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIStartTrackingReqMsg& pbLocApiStartTrackMsg =
+                    pbLocApiMsg.createPbMsg<PBLocAPIStartTrackingReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiStartTrackMsg)) {
                 LOC_LOGe("Failed to parse pbLocApiStartTrackMsg from payload!!");
                 return;
             }
-            LocAPIStartTrackingReqMsg msg(sockName.c_str(), pbLocApiStartTrackMsg, &mPbufMsgConv);
-            startTracking(reinterpret_cast<LocAPIStartTrackingReqMsg*>(&msg));
+            LocAPIStartTrackingReqMsg msg(sockName, pbLocApiStartTrackMsg, &mPbufMsgConv);
+            startTracking(handle, reinterpret_cast<LocAPIStartTrackingReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_STOP_TRACKING_MSG_ID: {
             // stop
-            LocAPIStopTrackingReqMsg msg(sockName.c_str(), &mPbufMsgConv);
-            stopTracking(reinterpret_cast<LocAPIStopTrackingReqMsg*>(&msg));
+            LocAPIStopTrackingReqMsg msg(sockName, &mPbufMsgConv);
+            stopTracking(handle, reinterpret_cast<LocAPIStopTrackingReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_UPDATE_CALLBACKS_MSG_ID: {
             // update subscription
-            PBLocAPIUpdateCallbacksReqMsg pbLocApiUpdateCbsReqMsg;
-            if (0 == pbLocApiUpdateCbsReqMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIUpdateCallbacksReqMsg& pbLocApiUpdateCbsReqMsg =
+                    pbLocApiMsg.createPbMsg<PBLocAPIUpdateCallbacksReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiUpdateCbsReqMsg)) {
                 LOC_LOGe("Failed to parse pbLocApiUpdateCbsReqMsg from payload!!");
                 return;
             }
-            LocAPIUpdateCallbacksReqMsg msg(sockName.c_str(), pbLocApiUpdateCbsReqMsg,
+            LocAPIUpdateCallbacksReqMsg msg(sockName, pbLocApiUpdateCbsReqMsg,
                     &mPbufMsgConv);
-            updateSubscription(reinterpret_cast<LocAPIUpdateCallbacksReqMsg*>(&msg));
+            updateSubscription(handle, reinterpret_cast<LocAPIUpdateCallbacksReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_UPDATE_TRACKING_OPTIONS_MSG_ID: {
-            PBLocAPIUpdateTrackingOptionsReqMsg pbLocApiUpdateTrackOptMsg;
-            if (0 == pbLocApiUpdateTrackOptMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIUpdateTrackingOptionsReqMsg& pbLocApiUpdateTrackOptMsg =
+                    pbLocApiMsg.createPbMsg<PBLocAPIUpdateTrackingOptionsReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiUpdateTrackOptMsg)) {
                 LOC_LOGe("Failed to parse pbLocApiUpdateTrackOptMsg from payload!!");
                 return;
             }
-            LocAPIUpdateTrackingOptionsReqMsg msg(sockName.c_str(), pbLocApiUpdateTrackOptMsg,
+            LocAPIUpdateTrackingOptionsReqMsg msg(sockName, pbLocApiUpdateTrackOptMsg,
                     &mPbufMsgConv);
-            updateTrackingOptions(reinterpret_cast <LocAPIUpdateTrackingOptionsReqMsg*>(&msg));
+            updateTrackingOptions(handle,
+                    reinterpret_cast <LocAPIUpdateTrackingOptionsReqMsg*>(&msg));
             break;
         }
 
         case E_LOCAPI_START_BATCHING_MSG_ID: {
             // start
-            PBLocAPIStartBatchingReqMsg pbLocApiStartBatchReq;
-            if (0 == pbLocApiStartBatchReq.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIStartBatchingReqMsg& pbLocApiStartBatchReq =
+                    pbLocApiMsg.createPbMsg<PBLocAPIStartBatchingReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiStartBatchReq)) {
                 LOC_LOGe("Failed to parse pbLocApiStartBatchReq from payload!!");
                 return;
             }
-            LocAPIStartBatchingReqMsg msg(sockName.c_str(), pbLocApiStartBatchReq, &mPbufMsgConv);
-            startBatching(reinterpret_cast<LocAPIStartBatchingReqMsg*>(&msg));
+            LocAPIStartBatchingReqMsg msg(sockName, pbLocApiStartBatchReq, &mPbufMsgConv);
+            startBatching(handle, reinterpret_cast<LocAPIStartBatchingReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_STOP_BATCHING_MSG_ID: {
             // stop
-            LocAPIStopBatchingReqMsg msg(sockName.c_str(), &mPbufMsgConv);
-            stopBatching(reinterpret_cast<LocAPIStopBatchingReqMsg*>(&msg));
+            LocAPIStopBatchingReqMsg msg(sockName, &mPbufMsgConv);
+            stopBatching(handle, reinterpret_cast<LocAPIStopBatchingReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID: {
-            PBLocAPIUpdateBatchingOptionsReqMsg pbLocApiUpdateBatch;
-            if (0 == pbLocApiUpdateBatch.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIUpdateBatchingOptionsReqMsg& pbLocApiUpdateBatch =
+                    pbLocApiMsg.createPbMsg<PBLocAPIUpdateBatchingOptionsReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiUpdateBatch)) {
                 LOC_LOGe("Failed to parse pbLocApiUpdateBatch from payload!!");
                 return;
             }
-            LocAPIUpdateBatchingOptionsReqMsg msg(sockName.c_str(), pbLocApiUpdateBatch,
+            LocAPIUpdateBatchingOptionsReqMsg msg(sockName, pbLocApiUpdateBatch,
                     &mPbufMsgConv);
-            updateBatchingOptions(reinterpret_cast <LocAPIUpdateBatchingOptionsReqMsg*>(&msg));
+            updateBatchingOptions(handle,
+                    reinterpret_cast <LocAPIUpdateBatchingOptionsReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_ADD_GEOFENCES_MSG_ID: {
-            PBLocAPIAddGeofencesReqMsg pbLocApiAddGf;
-            if (0 == pbLocApiAddGf.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIAddGeofencesReqMsg& pbLocApiAddGf =
+                    pbLocApiMsg.createPbMsg<PBLocAPIAddGeofencesReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiAddGf)) {
                 LOC_LOGe("Failed to parse pbLocApiAddGf from payload!!");
                 return;
             }
-            LocAPIAddGeofencesReqMsg msg(sockName.c_str(), pbLocApiAddGf, &mPbufMsgConv);
-            addGeofences(reinterpret_cast<LocAPIAddGeofencesReqMsg*>(&msg));
+            LocAPIAddGeofencesReqMsg msg(sockName, pbLocApiAddGf, &mPbufMsgConv);
+            addGeofences(handle, reinterpret_cast<LocAPIAddGeofencesReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_REMOVE_GEOFENCES_MSG_ID: {
-            PBLocAPIRemoveGeofencesReqMsg pbLocApiRnGfReq;
-            if (0 == pbLocApiRnGfReq.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIRemoveGeofencesReqMsg& pbLocApiRnGfReq =
+                    pbLocApiMsg.createPbMsg<PBLocAPIRemoveGeofencesReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiRnGfReq)) {
                 LOC_LOGe("Failed to parse pbLocApiRnGfReq from payload!!");
                 return;
             }
-            LocAPIRemoveGeofencesReqMsg msg(sockName.c_str(), pbLocApiRnGfReq, &mPbufMsgConv);
-            removeGeofences(reinterpret_cast<LocAPIRemoveGeofencesReqMsg*>(&msg));
+            LocAPIRemoveGeofencesReqMsg msg(sockName, pbLocApiRnGfReq, &mPbufMsgConv);
+            removeGeofences(handle, reinterpret_cast<LocAPIRemoveGeofencesReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_MODIFY_GEOFENCES_MSG_ID: {
-            PBLocAPIModifyGeofencesReqMsg pbLocApiModGf;
-            if (0 == pbLocApiModGf.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIModifyGeofencesReqMsg& pbLocApiModGf =
+                    pbLocApiMsg.createPbMsg<PBLocAPIModifyGeofencesReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiModGf)) {
                 LOC_LOGe("Failed to parse pbLocApiModGf from payload!!");
                 return;
             }
-            LocAPIModifyGeofencesReqMsg msg(sockName.c_str(), pbLocApiModGf, &mPbufMsgConv);
-            modifyGeofences(reinterpret_cast<LocAPIModifyGeofencesReqMsg*>(&msg));
+            LocAPIModifyGeofencesReqMsg msg(sockName, pbLocApiModGf, &mPbufMsgConv);
+            modifyGeofences(handle, reinterpret_cast<LocAPIModifyGeofencesReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_PAUSE_GEOFENCES_MSG_ID: {
-            PBLocAPIPauseGeofencesReqMsg pbLocApiPauseGf;
-            if (0 == pbLocApiPauseGf.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIPauseGeofencesReqMsg& pbLocApiPauseGf =
+                    pbLocApiMsg.createPbMsg<PBLocAPIPauseGeofencesReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiPauseGf)) {
                 LOC_LOGe("Failed to parse pbLocApiPauseGf from payload!!");
                 return;
             }
-            LocAPIPauseGeofencesReqMsg msg(sockName.c_str(), pbLocApiPauseGf, &mPbufMsgConv);
-            pauseGeofences(reinterpret_cast<LocAPIPauseGeofencesReqMsg*>(&msg));
+            LocAPIPauseGeofencesReqMsg msg(sockName, pbLocApiPauseGf, &mPbufMsgConv);
+            pauseGeofences(handle, reinterpret_cast<LocAPIPauseGeofencesReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_RESUME_GEOFENCES_MSG_ID: {
-            PBLocAPIResumeGeofencesReqMsg pbLocApiResumeGf;
-            if (0 == pbLocApiResumeGf.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIResumeGeofencesReqMsg& pbLocApiResumeGf =
+                    pbLocApiMsg.createPbMsg<PBLocAPIResumeGeofencesReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiResumeGf)) {
                 LOC_LOGe("Failed to parse pbLocApiResumeGf from payload!!");
                 return;
             }
-            LocAPIResumeGeofencesReqMsg msg(sockName.c_str(), pbLocApiResumeGf, &mPbufMsgConv);
-            resumeGeofences(reinterpret_cast<LocAPIResumeGeofencesReqMsg*>(&msg));
+            LocAPIResumeGeofencesReqMsg msg(sockName, pbLocApiResumeGf, &mPbufMsgConv);
+            resumeGeofences(handle, reinterpret_cast<LocAPIResumeGeofencesReqMsg*>(&msg));
             break;
         }
         case E_LOCAPI_CONTROL_UPDATE_NETWORK_AVAILABILITY_MSG_ID: {
-            PBLocAPIUpdateNetworkAvailabilityReqMsg pbLocApiUpdateNetwAvail;
-            if (0 == pbLocApiUpdateNetwAvail.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIUpdateNetworkAvailabilityReqMsg& pbLocApiUpdateNetwAvail =
+                    pbLocApiMsg.createPbMsg<PBLocAPIUpdateNetworkAvailabilityReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiUpdateNetwAvail)) {
                 LOC_LOGe("Failed to parse pbLocApiUpdateNetwAvail from payload!!");
                 return;
             }
-            LocAPIUpdateNetworkAvailabilityReqMsg msg(sockName.c_str(), pbLocApiUpdateNetwAvail,
+            LocAPIUpdateNetworkAvailabilityReqMsg msg(sockName, pbLocApiUpdateNetwAvail,
                     &mPbufMsgConv);
             updateNetworkAvailability(msg.mAvailability);
             break;
         }
         case E_LOCAPI_GET_GNSS_ENGERY_CONSUMED_MSG_ID: {
-            getGnssEnergyConsumed(sockName.c_str());
+            getGnssEnergyConsumed(handle);
             break;
         }
         case E_LOCAPI_GET_SINGLE_TERRESTRIAL_POS_REQ_MSG_ID: {
-            PBLocAPIGetSingleTerrestrialPosReqMsg pbMsg;
-            if (0 == pbMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIGetSingleTerrestrialPosReqMsg& pbMsg =
+                    pbLocApiMsg.createPbMsg<PBLocAPIGetSingleTerrestrialPosReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbMsg)) {
                 LOC_LOGe("Failed to parse PBLocAPIGetSingleTerrestrialPosReqMsg from payload!!");
                 return;
             }
-            LocAPIGetSingleTerrestrialPosReqMsg msg(sockName.c_str(), pbMsg, &mPbufMsgConv);
-            getSingleTerrestrialPos(&msg);
+            LocAPIGetSingleTerrestrialPosReqMsg msg(sockName, pbMsg, &mPbufMsgConv);
+            getSingleTerrestrialPos(handle, &msg);
             break;
         }
         case E_LOCAPI_PINGTEST_MSG_ID: {
-            PBLocAPIPingTestReqMsg pbLocApiPingTestMsg;
-            if (0 == pbLocApiPingTestMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocAPIPingTestReqMsg& pbLocApiPingTestMsg =
+                    pbLocApiMsg.createPbMsg<PBLocAPIPingTestReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiPingTestMsg)) {
                 LOC_LOGe("Failed to parse pbLocApiPingTestMsg from payload!!");
                 return;
             }
-            LocAPIPingTestReqMsg msg(sockName.c_str(), pbLocApiPingTestMsg, &mPbufMsgConv);
-            pingTest(reinterpret_cast<LocAPIPingTestReqMsg*>(&msg));
+            LocAPIPingTestReqMsg msg(sockName, pbLocApiPingTestMsg, &mPbufMsgConv);
+            pingTest(handle, reinterpret_cast<LocAPIPingTestReqMsg*>(&msg));
             break;
         }
 
         // location configuration API
         case E_INTAPI_CONFIG_CONSTRAINTED_TUNC_MSG_ID: {
-            PBLocConfigConstrainedTuncReqMsg pbLocApiConfConstrTunc;
-            if (0 == pbLocApiConfConstrTunc.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigConstrainedTuncReqMsg& pbLocApiConfConstrTunc =
+                    pbLocApiMsg.createPbMsg<PBLocConfigConstrainedTuncReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiConfConstrTunc)) {
                 LOC_LOGe("Failed to parse pbLocApiConfConstrTunc from payload!!");
                 return;
             }
-            LocConfigConstrainedTuncReqMsg msg(sockName.c_str(), pbLocApiConfConstrTunc,
+            LocConfigConstrainedTuncReqMsg msg(sockName, pbLocApiConfConstrTunc,
                     &mPbufMsgConv);
-            configConstrainedTunc(reinterpret_cast<LocConfigConstrainedTuncReqMsg*>(&msg));
+            configConstrainedTunc(handle, reinterpret_cast<LocConfigConstrainedTuncReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_POSITION_ASSISTED_CLOCK_ESTIMATOR_MSG_ID: {
-            PBLocConfigPositionAssistedClockEstimatorReqMsg pbLocApiConfPosAsstdClockEst;
-            if (0 == pbLocApiConfPosAsstdClockEst.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigPositionAssistedClockEstimatorReqMsg& pbLocApiConfPosAsstdClockEst =
+                    pbLocApiMsg.createPbMsg<PBLocConfigPositionAssistedClockEstimatorReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiConfPosAsstdClockEst)) {
                 LOC_LOGe("Failed to parse pbLocApiConfPosAsstdClockEst from payload!!");
                 return;
             }
-            LocConfigPositionAssistedClockEstimatorReqMsg msg(sockName.c_str(),
+            LocConfigPositionAssistedClockEstimatorReqMsg msg(sockName,
                     pbLocApiConfPosAsstdClockEst, &mPbufMsgConv);
-            configPositionAssistedClockEstimator(reinterpret_cast
+            configPositionAssistedClockEstimator(handle, reinterpret_cast
                         <LocConfigPositionAssistedClockEstimatorReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_SV_CONSTELLATION_MSG_ID: {
-            PBLocConfigSvConstellationReqMsg pbLocApiConfSvConstReqMsg;
-            if (0 == pbLocApiConfSvConstReqMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigSvConstellationReqMsg& pbLocApiConfSvConstReqMsg =
+                    pbLocApiMsg.createPbMsg<PBLocConfigSvConstellationReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocApiConfSvConstReqMsg)) {
                 LOC_LOGe("Failed to parse pbLocApiConfSvConstReqMsg from payload!!");
                 return;
             }
-            LocConfigSvConstellationReqMsg msg(sockName.c_str(), pbLocApiConfSvConstReqMsg,
+            LocConfigSvConstellationReqMsg msg(sockName, pbLocApiConfSvConstReqMsg,
                     &mPbufMsgConv);
-            configConstellations(reinterpret_cast<LocConfigSvConstellationReqMsg*>(&msg));
+            configConstellations(handle, reinterpret_cast<LocConfigSvConstellationReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_CONSTELLATION_SECONDARY_BAND_MSG_ID: {
-            PBLocConfigConstellationSecondaryBandReqMsg pbLocCfgConstlSecBandReqMsg;
-            if (0 == pbLocCfgConstlSecBandReqMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigConstellationSecondaryBandReqMsg& pbLocCfgConstlSecBandReqMsg =
+                    pbLocApiMsg.createPbMsg<PBLocConfigConstellationSecondaryBandReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocCfgConstlSecBandReqMsg)) {
                 LOC_LOGe("Failed to parse pbLocCfgConstlSecBandReqMsg from payload!!");
                 return;
             }
-            LocConfigConstellationSecondaryBandReqMsg msg(sockName.c_str(),
+            LocConfigConstellationSecondaryBandReqMsg msg(sockName,
                     pbLocCfgConstlSecBandReqMsg, &mPbufMsgConv);
-            configConstellationSecondaryBand(reinterpret_cast
+            configConstellationSecondaryBand(handle, reinterpret_cast
                     <LocConfigConstellationSecondaryBandReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_AIDING_DATA_DELETION_MSG_ID: {
-            PBLocConfigAidingDataDeletionReqMsg pbLocConfAidDataDelMsg;
-            if (0 == pbLocConfAidDataDelMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigAidingDataDeletionReqMsg& pbLocConfAidDataDelMsg =
+                    pbLocApiMsg.createPbMsg<PBLocConfigAidingDataDeletionReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocConfAidDataDelMsg)) {
                 LOC_LOGe("Failed to parse pbLocConfAidDataDelMsg from payload!!");
                 return;
             }
-            LocConfigAidingDataDeletionReqMsg msg(sockName.c_str(), pbLocConfAidDataDelMsg,
+            LocConfigAidingDataDeletionReqMsg msg(sockName, pbLocConfAidDataDelMsg,
                     &mPbufMsgConv);
-            configAidingDataDeletion(reinterpret_cast<LocConfigAidingDataDeletionReqMsg*>(&msg));
+            configAidingDataDeletion(handle,
+                    reinterpret_cast<LocConfigAidingDataDeletionReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_LEVER_ARM_MSG_ID: {
-            PBLocConfigLeverArmReqMsg pbLocConfLeverArmMsg;
-            if (0 == pbLocConfLeverArmMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigLeverArmReqMsg& pbLocConfLeverArmMsg =
+                    pbLocApiMsg.createPbMsg<PBLocConfigLeverArmReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocConfLeverArmMsg)) {
                 LOC_LOGe("Failed to parse pbLocConfLeverArmMsg from payload!!");
                 return;
             }
-            LocConfigLeverArmReqMsg msg(sockName.c_str(), pbLocConfLeverArmMsg, &mPbufMsgConv);
-            configLeverArm(reinterpret_cast<LocConfigLeverArmReqMsg*>(&msg));
+            LocConfigLeverArmReqMsg msg(sockName, pbLocConfLeverArmMsg, &mPbufMsgConv);
+            configLeverArm(handle, reinterpret_cast<LocConfigLeverArmReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_ROBUST_LOCATION_MSG_ID: {
-            PBLocConfigRobustLocationReqMsg pbLocConfRobustLocMsg;
-            if (0 == pbLocConfRobustLocMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigRobustLocationReqMsg& pbLocConfRobustLocMsg =
+                    pbLocApiMsg.createPbMsg<PBLocConfigRobustLocationReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocConfRobustLocMsg)) {
                 LOC_LOGe("Failed to parse pbLocConfRobustLocMsg from payload!!");
                 return;
             }
-            LocConfigRobustLocationReqMsg msg(sockName.c_str(), pbLocConfRobustLocMsg,
+            LocConfigRobustLocationReqMsg msg(sockName, pbLocConfRobustLocMsg,
                     &mPbufMsgConv);
-            configRobustLocation(reinterpret_cast<LocConfigRobustLocationReqMsg*>(&msg));
+            configRobustLocation(handle, reinterpret_cast<LocConfigRobustLocationReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_MIN_GPS_WEEK_MSG_ID: {
-            PBLocConfigMinGpsWeekReqMsg pbLocConfMinGpsWeek;
-            if (0 == pbLocConfMinGpsWeek.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigMinGpsWeekReqMsg& pbLocConfMinGpsWeek =
+                    pbLocApiMsg.createPbMsg<PBLocConfigMinGpsWeekReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocConfMinGpsWeek)) {
                 LOC_LOGe("Failed to parse pbLocConfMinGpsWeek from payload!!");
                 return;
             }
-            LocConfigMinGpsWeekReqMsg msg(sockName.c_str(), pbLocConfMinGpsWeek, &mPbufMsgConv);
-            configMinGpsWeek(reinterpret_cast<LocConfigMinGpsWeekReqMsg*>(&msg));
+            LocConfigMinGpsWeekReqMsg msg(sockName, pbLocConfMinGpsWeek, &mPbufMsgConv);
+            configMinGpsWeek(handle, reinterpret_cast<LocConfigMinGpsWeekReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_DEAD_RECKONING_ENGINE_MSG_ID: {
-            PBLocConfigDrEngineParamsReqMsg pbLocCfgDrEngParamReq;
-            if (0 == pbLocCfgDrEngParamReq.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigDrEngineParamsReqMsg& pbLocCfgDrEngParamReq =
+                    pbLocApiMsg.createPbMsg<PBLocConfigDrEngineParamsReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocCfgDrEngParamReq)) {
                 LOC_LOGe("Failed to parse pbLocCfgDrEngParamReq from payload!!");
                 return;
             }
-            LocConfigDrEngineParamsReqMsg msg(sockName.c_str(), pbLocCfgDrEngParamReq,
+            LocConfigDrEngineParamsReqMsg msg(sockName, pbLocCfgDrEngParamReq,
                     &mPbufMsgConv);
-            configDeadReckoningEngineParams(
+            configDeadReckoningEngineParams(handle,
                     reinterpret_cast<LocConfigDrEngineParamsReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_MIN_SV_ELEVATION_MSG_ID: {
-            PBLocConfigMinSvElevationReqMsg pbLocConfMinSvElev;
-            if (0 == pbLocConfMinSvElev.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigMinSvElevationReqMsg& pbLocConfMinSvElev =
+                    pbLocApiMsg.createPbMsg<PBLocConfigMinSvElevationReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocConfMinSvElev)) {
                 LOC_LOGe("Failed to parse pbLocConfMinSvElev from payload!!");
                 return;
             }
-            LocConfigMinSvElevationReqMsg msg(sockName.c_str(), pbLocConfMinSvElev, &mPbufMsgConv);
-            configMinSvElevation(reinterpret_cast<LocConfigMinSvElevationReqMsg*>(&msg));
+            LocConfigMinSvElevationReqMsg msg(sockName, pbLocConfMinSvElev, &mPbufMsgConv);
+            configMinSvElevation(handle, reinterpret_cast<LocConfigMinSvElevationReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_ENGINE_RUN_STATE_MSG_ID: {
-            PBLocConfigEngineRunStateReqMsg pbLocConfEngineRunState;
-            if (0 == pbLocConfEngineRunState.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigEngineRunStateReqMsg& pbLocConfEngineRunState =
+                    pbLocApiMsg.createPbMsg<PBLocConfigEngineRunStateReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbLocConfEngineRunState)) {
                 LOC_LOGe("Failed to parse pbLocConfEngineRunState from payload!!");
                 return;
             }
-            LocConfigEngineRunStateReqMsg msg(sockName.c_str(),
+            LocConfigEngineRunStateReqMsg msg(sockName,
                                               pbLocConfEngineRunState,
                                               &mPbufMsgConv);
-            configEngineRunState(reinterpret_cast<LocConfigEngineRunStateReqMsg*>(&msg));
+            configEngineRunState(handle, reinterpret_cast<LocConfigEngineRunStateReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_CONFIG_USER_CONSENT_TERRESTRIAL_POSITIONING_MSG_ID: {
-            PBLocConfigUserConsentTerrestrialPositioningReqMsg pbMsg;
-            if (0 == pbMsg.ParseFromString(pbLocApiMsg.payload())) {
+            PBLocConfigUserConsentTerrestrialPositioningReqMsg& pbMsg =
+                    pbLocApiMsg.createPbMsg<PBLocConfigUserConsentTerrestrialPositioningReqMsg>();
+            if (!pbLocApiMsg.parsePayload(pbMsg)) {
                 LOC_LOGe("Failed to parse PBLocConfigUserConsentTerrestrialPositioningReqMsg!!");
                 return;
             }
             LocConfigUserConsentTerrestrialPositioningReqMsg msg(
-                    sockName.c_str(), pbMsg, &mPbufMsgConv);
-            configUserConsentTerrestrialPositioning(reinterpret_cast
+                    sockName, pbMsg, &mPbufMsgConv);
+            configUserConsentTerrestrialPositioning(handle, reinterpret_cast
                     <LocConfigUserConsentTerrestrialPositioningReqMsg*>(&msg));
             break;
         }
 
         case E_INTAPI_GET_ROBUST_LOCATION_CONFIG_REQ_MSG_ID: {
-            getGnssConfig(&locApiMsg, GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT);
+            getGnssConfig(handle, &locApiMsg, GNSS_CONFIG_FLAGS_ROBUST_LOCATION_BIT);
             break;
         }
 
         case E_INTAPI_GET_MIN_GPS_WEEK_REQ_MSG_ID: {
-            getGnssConfig(&locApiMsg, GNSS_CONFIG_FLAGS_MIN_GPS_WEEK_BIT);
+            getGnssConfig(handle, &locApiMsg, GNSS_CONFIG_FLAGS_MIN_GPS_WEEK_BIT);
             break;
         }
 
         case E_INTAPI_GET_MIN_SV_ELEVATION_REQ_MSG_ID: {
-            getGnssConfig(&locApiMsg, GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT);
+            getGnssConfig(handle, &locApiMsg, GNSS_CONFIG_FLAGS_MIN_SV_ELEVATION_BIT);
             break;
         }
 
         case E_INTAPI_GET_CONSTELLATION_SECONDARY_BAND_CONFIG_REQ_MSG_ID: {
-            getConstellationSecondaryBandConfig(
+            getConstellationSecondaryBandConfig(handle,
                     (const LocConfigGetConstellationSecondaryBandConfigReqMsg*) &locApiMsg);
             break;
         }
@@ -625,59 +676,99 @@ LocationApiService - implementation - registration
 ******************************************************************************/
 void LocationApiService::newClient(LocAPIClientRegisterReqMsg *pMsg) {
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::WriteLock registryLock(mClients);
     std::string clientname(pMsg->mSocketName);
 
     // if this name is already used return error
-    if (mClients.find(clientname) != mClients.end()) {
+    LocHalClientHandle handle = mClients.add(clientname);
+    if (LOC_HAL_CLIENT_HANDLE_NONE == handle) {
         LOC_LOGe("invalid client=%s already existing", clientname.c_str());
         return;
     }
 
     // store it in client property database
     LocHalDaemonClientHandler *pClient =
-            new LocHalDaemonClientHandler(this, clientname, pMsg->mClientType);
+            new LocHalDaemonClientHandler(this, handle, clientname, pMsg->mClientType,
+                                          mPbufMsgConv, pMsg->mWireVersion);
     if (!pClient) {
         LOC_LOGe("failed to register client=%s", clientname.c_str());
+        mClients.remove(handle);
         return;
     }
 
-    mClients.emplace(clientname, pClient);
-    LOC_LOGi(">-- registered new client=%s", clientname.c_str());
+    mClients.attach(handle, pClient);
+    if (pMsg->mShmCapable) {
+        pClient->setupShmSender();
+    }
+    pClient->watchPeerClose();
+    LOC_LOGi(">-- registered new client=%s handle=%x", clientname.c_str(), handle);
 }
 
-void LocationApiService::deleteClient(LocAPIClientDeregisterReqMsg *pMsg) {
+void LocationApiService::deleteClient(LocHalClientHandle handle) {
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    std::string clientname(pMsg->mSocketName);
-    deleteClientbyName(clientname);
+    LocHalDaemonClientRegistry::WriteLock registryLock(mClients);
+    deleteClientByHandle(handle);
 }
 
-void LocationApiService::deleteClientbyName(const std::string clientname) {
-    LOC_LOGi(">-- deleteClient client=%s", clientname.c_str());
+void LocationApiService::deleteClientByHandle(LocHalClientHandle handle) {
+    LOC_LOGi(">-- deleteClient client=%s", mClients.getName(handle).c_str());
 
     // delete this client from property db
-    LocHalDaemonClientHandler* pClient = getClient(clientname);
+    LocHalDaemonClientHandler* pClient = mClients.remove(handle);
 
     if (!pClient) {
-        LOC_LOGe(">-- deleteClient invlalid client=%s", clientname.c_str());
+        LOC_LOGe(">-- deleteClient invlalid client=%x", handle);
         return;
     }
-    mClients.erase(clientname);
-    mTerrestrialFixReqs.erase(clientname);
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mTerrestrialFixReqs.erase(handle);
+    }
     pClient->cleanup();
 }
+bool LocationApiService::deferIndication() {
+    if (0 == mBatchClientIndications) {
+        return false;
+    }
+    if (!sIndicationFlushPending) {
+        sIndicationFlushPending = MsgTask::runWhenIdle([this]() { flushIndications(); });
+    }
+    return sIndicationFlushPending;
+}
+
+void LocationApiService::flushIndications() {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    sIndicationFlushPending = false;
+    mClients.forEach([](LocHalClientHandle handle, LocHalDaemonClientHandler* pClient) {
+        pClient->flushIndications();
+    });
+}
+
+void LocationApiService::purgeClient(LocHalClientHandle handle) {
+    LocHalDaemonClientRegistry::WriteLock registryLock(mClients);
+    // unless it has been purged meanwhile; a new client in its slot has
+    // another handle
+    if (nullptr != mClients.find(handle)) {
+        LOC_LOGi("purging client=%s handle=%x", mClients.getName(handle).c_str(), handle);
+        deleteClientByHandle(handle);
+    } else {
+        LOC_LOGe("failed purging client handle=%x, not found", handle);
+    }
+}
+
 /******************************************************************************
 LocationApiService - implementation - tracking
 ******************************************************************************/
-void LocationApiService::startTracking(LocAPIStartTrackingReqMsg *pMsg) {
+void LocationApiService::startTracking(LocHalClientHandle handle,
+                                       LocAPIStartTrackingReqMsg *pMsg) {
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (!pClient) {
         LOC_LOGe(">-- start invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
 
     LocationOptions locationOption = pMsg->locOptions;
     // set the mode according to the master position mode
@@ -695,14 +786,16 @@ void LocationApiService::startTracking(LocAPIStartTrackingReqMsg *pMsg) {
     return;
 }
 
-void LocationApiService::stopTracking(LocAPIStopTrackingReqMsg *pMsg) {
+void LocationApiService::stopTracking(LocHalClientHandle handle,
+                                      LocAPIStopTrackingReqMsg *pMsg) {
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (!pClient) {
         LOC_LOGe(">-- stop invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
 
     pClient->mTracking = false;
     pClient->unsubscribeLocationSessionCb();
@@ -711,44 +804,52 @@ void LocationApiService::stopTracking(LocAPIStopTrackingReqMsg *pMsg) {
     LOC_LOGi(">-- stopping session");
 }
 
-// no need to hold the lock as lock has been held on calling functions
+// no need to hold the registry lock as it has been held on calling functions,
+// the clients are locked one at a time
 void LocationApiService::suspendAllTrackingSessions() {
-    for (auto client : mClients) {
+    mClients.forEach([](LocHalClientHandle handle, LocHalDaemonClientHandler* pClient) {
+        std::lock_guard<std::mutex> lock(pClient->getLock());
         // stop session if running
-        if (client.second && client.second->mTracking) {
-            client.second->stopTracking();
-            client.second->mPendingMessages.push(E_LOCAPI_STOP_TRACKING_MSG_ID);
+        if (pClient->mTracking) {
+            pClient->stopTracking();
+            pClient->mPendingMessages.push(E_LOCAPI_STOP_TRACKING_MSG_ID);
             LOC_LOGi("--> suspended");
         }
-    }
+    });
 }
 
-// no need to hold the lock as lock has been held on calling functions
+// no need to hold the registry lock as it has been held on calling functions,
+// the clients are locked one at a time
 void LocationApiService::resumeAllTrackingSessions() {
-    for (auto client : mClients) {
+    bool failed = false;
+    mClients.forEach([&failed](LocHalClientHandle handle, LocHalDaemonClientHandler* pClient) {
+        std::lock_guard<std::mutex> lock(pClient->getLock());
         // start session if not running
-        if (client.second && client.second->mTracking) {
+        if (!failed && pClient->mTracking) {
 
             // resume session with preserved options
-            if (!client.second->startTracking()) {
+            if (!pClient->startTracking()) {
                 LOC_LOGe("Failed to start session");
+                failed = true;
                 return;
             }
             // success
-            client.second->mPendingMessages.push(E_LOCAPI_START_TRACKING_MSG_ID);
+            pClient->mPendingMessages.push(E_LOCAPI_START_TRACKING_MSG_ID);
             LOC_LOGi("--> resumed");
         }
-    }
+    });
 }
 
-void LocationApiService::updateSubscription(LocAPIUpdateCallbacksReqMsg *pMsg) {
+void LocationApiService::updateSubscription(LocHalClientHandle handle,
+                                            LocAPIUpdateCallbacksReqMsg *pMsg) {
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (!pClient) {
         LOC_LOGe(">-- updateSubscription invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
 
     pClient->updateSubscription(pMsg->locationCallbacks);
 
@@ -756,12 +857,14 @@ void LocationApiService::updateSubscription(LocAPIUpdateCallbacksReqMsg *pMsg) {
             pMsg->mSocketName, pMsg->locationCallbacks);
 }
 
-void LocationApiService::updateTrackingOptions(LocAPIUpdateTrackingOptionsReqMsg *pMsg) {
+void LocationApiService::updateTrackingOptions(LocHalClientHandle handle,
+                                               LocAPIUpdateTrackingOptionsReqMsg *pMsg) {
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
 
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (pClient) {
+        std::lock_guard<std::mutex> lock(pClient->getLock());
         LocationOptions locationOption = pMsg->locOptions;
         // set the mode according to the master position mode
         locationOption.mode = mPositionMode;
@@ -786,9 +889,10 @@ void LocationApiService::updateNetworkAvailability(bool availability) {
     }
 }
 
-void LocationApiService::getGnssEnergyConsumed(const char* clientSocketName) {
+void LocationApiService::getGnssEnergyConsumed(LocHalClientHandle handle) {
 
-    LOC_LOGi(">-- getGnssEnergyConsumed by=%s", clientSocketName);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LOC_LOGi(">-- getGnssEnergyConsumed by=%s", mClients.getName(handle).c_str());
 
     GnssInterface* gnssInterface = getGnssInterface();
     if (!gnssInterface) {
@@ -796,20 +900,18 @@ void LocationApiService::getGnssEnergyConsumed(const char* clientSocketName) {
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    bool requestAlreadyPending = false;
-    for (auto each : mClients) {
-        if ((each.second != nullptr) &&
-            (each.second->hasPendingEngineInfoRequest(E_ENGINE_INFO_CB_GNSS_ENERGY_CONSUMED_BIT))) {
-            requestAlreadyPending = true;
-            break;
-        }
-    }
-
-    std::string clientname(clientSocketName);
-    LocHalDaemonClientHandler* pClient = getClient(clientname);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (pClient) {
-        pClient->addEngineInfoRequst(E_ENGINE_INFO_CB_GNSS_ENERGY_CONSUMED_BIT);
+        bool requestAlreadyPending = false;
+        {
+            std::lock_guard<std::mutex> lock(mStateMutex);
+            requestAlreadyPending = mGnssEnergyConsumedPending;
+            mGnssEnergyConsumedPending = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(pClient->getLock());
+            pClient->addEngineInfoRequst(E_ENGINE_INFO_CB_GNSS_ENERGY_CONSUMED_BIT);
+        }
 
         // this is first client coming to request GNSS energy consumed
         if (requestAlreadyPending == false) {
@@ -826,7 +928,7 @@ void LocationApiService::getGnssEnergyConsumed(const char* clientSocketName) {
     }
 }
 
-void LocationApiService::getConstellationSecondaryBandConfig(
+void LocationApiService::getConstellationSecondaryBandConfig(LocHalClientHandle handle,
         const LocConfigGetConstellationSecondaryBandConfigReqMsg* pReqMsg) {
 
     LOC_LOGi(">--getConstellationConfig");
@@ -836,27 +938,30 @@ void LocationApiService::getConstellationSecondaryBandConfig(
         return;
     }
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     // retrieve the constellation enablement/disablement config
     // blacklisted SV info and secondary band config
     uint32_t sessionId = gnssInterface-> gnssGetSecondaryBandConfig();
 
     // if sessionId is 0, e.g.: error callback will be delivered
     // by addConfigRequestToMap
-    addConfigRequestToMap(sessionId, pReqMsg);
+    addConfigRequestToMap(sessionId, handle, pReqMsg);
 }
 
 /******************************************************************************
 LocationApiService - implementation - batching
 ******************************************************************************/
-void LocationApiService::startBatching(LocAPIStartBatchingReqMsg *pMsg) {
+void LocationApiService::startBatching(LocHalClientHandle handle,
+                                       LocAPIStartBatchingReqMsg *pMsg) {
 
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (!pClient) {
         LOC_LOGe(">-- start invalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
 
     if (!pClient->startBatching(pMsg->intervalInMs, pMsg->distanceInMeters,
                 pMsg->batchingMode)) {
@@ -872,13 +977,15 @@ void LocationApiService::startBatching(LocAPIStartBatchingReqMsg *pMsg) {
     return;
 }
 
-void LocationApiService::stopBatching(LocAPIStopBatchingReqMsg *pMsg) {
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+void LocationApiService::stopBatching(LocHalClientHandle handle,
+                                      LocAPIStopBatchingReqMsg *pMsg) {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (!pClient) {
         LOC_LOGe(">-- stop invalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
 
     pClient->mBatching = false;
     pClient->mBatchingMode = BATCHING_MODE_NO_AUTO_REPORT;
@@ -888,10 +995,12 @@ void LocationApiService::stopBatching(LocAPIStopBatchingReqMsg *pMsg) {
     LOC_LOGi(">-- stopping batching session");
 }
 
-void LocationApiService::updateBatchingOptions(LocAPIUpdateBatchingOptionsReqMsg *pMsg) {
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+void LocationApiService::updateBatchingOptions(LocHalClientHandle handle,
+                                               LocAPIUpdateBatchingOptionsReqMsg *pMsg) {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (pClient) {
+        std::lock_guard<std::mutex> lock(pClient->getLock());
         pClient->updateBatchingOptions(pMsg->intervalInMs, pMsg->distanceInMeters,
                 pMsg->batchingMode);
         pClient->mPendingMessages.push(E_LOCAPI_UPDATE_BATCHING_OPTIONS_MSG_ID);
@@ -903,13 +1012,14 @@ void LocationApiService::updateBatchingOptions(LocAPIUpdateBatchingOptionsReqMsg
 /******************************************************************************
 LocationApiService - implementation - geofence
 ******************************************************************************/
-void LocationApiService::addGeofences(LocAPIAddGeofencesReqMsg* pMsg) {
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+void LocationApiService::addGeofences(LocHalClientHandle handle, LocAPIAddGeofencesReqMsg* pMsg) {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (!pClient) {
         LOC_LOGe(">-- start invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
     if (pMsg->geofences.count > MAX_GEOFENCE_COUNT) {
         LOC_LOGe(">-- geofence count greater than MAX =%d", pMsg->geofences.count);
         return;
@@ -956,13 +1066,15 @@ void LocationApiService::addGeofences(LocAPIAddGeofencesReqMsg* pMsg) {
     free(gfOptions);
 }
 
-void LocationApiService::removeGeofences(LocAPIRemoveGeofencesReqMsg* pMsg) {
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+void LocationApiService::removeGeofences(LocHalClientHandle handle,
+        LocAPIRemoveGeofencesReqMsg* pMsg) {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (nullptr == pClient) {
         LOC_LOGe("removeGeofences - Null client!");
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
     uint32_t* sessions = pClient->getSessionIds(pMsg->gfClientIds.count, pMsg->gfClientIds.gfIds);
     if (pClient && sessions) {
         pClient->removeGeofences(pMsg->gfClientIds.count, sessions);
@@ -972,13 +1084,15 @@ void LocationApiService::removeGeofences(LocAPIRemoveGeofencesReqMsg* pMsg) {
     LOC_LOGi(">-- remove geofences");
     free(sessions);
 }
-void LocationApiService::modifyGeofences(LocAPIModifyGeofencesReqMsg* pMsg) {
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+void LocationApiService::modifyGeofences(LocHalClientHandle handle,
+        LocAPIModifyGeofencesReqMsg* pMsg) {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (nullptr == pClient) {
         LOC_LOGe("modifyGeofences - Null client!");
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
     if (pMsg->geofences.count > MAX_GEOFENCE_COUNT) {
         LOC_LOGe("modifyGeofences - geofence count greater than MAX =%d", pMsg->geofences.count);
         return;
@@ -1012,13 +1126,15 @@ void LocationApiService::modifyGeofences(LocAPIModifyGeofencesReqMsg* pMsg) {
     free(clientIds);
     free(gfOptions);
 }
-void LocationApiService::pauseGeofences(LocAPIPauseGeofencesReqMsg* pMsg) {
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+void LocationApiService::pauseGeofences(LocHalClientHandle handle,
+        LocAPIPauseGeofencesReqMsg* pMsg) {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (nullptr == pClient) {
         LOC_LOGe("pauseGeofences - Null client!");
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
     uint32_t* sessions = pClient->getSessionIds(pMsg->gfClientIds.count, pMsg->gfClientIds.gfIds);
     if (pClient && sessions) {
         pClient->pauseGeofences(pMsg->gfClientIds.count, sessions);
@@ -1028,13 +1144,15 @@ void LocationApiService::pauseGeofences(LocAPIPauseGeofencesReqMsg* pMsg) {
     LOC_LOGi(">-- pause geofences");
     free(sessions);
 }
-void LocationApiService::resumeGeofences(LocAPIResumeGeofencesReqMsg* pMsg) {
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+void LocationApiService::resumeGeofences(LocHalClientHandle handle,
+        LocAPIResumeGeofencesReqMsg* pMsg) {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (nullptr == pClient) {
         LOC_LOGe("resumeGeofences - Null client!");
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
     uint32_t* sessions = pClient->getSessionIds(pMsg->gfClientIds.count, pMsg->gfClientIds.gfIds);
     if (pClient && sessions) {
         pClient->resumeGeofences(pMsg->gfClientIds.count, sessions);
@@ -1045,38 +1163,41 @@ void LocationApiService::resumeGeofences(LocAPIResumeGeofencesReqMsg* pMsg) {
     free(sessions);
 }
 
-void LocationApiService::pingTest(LocAPIPingTestReqMsg* pMsg) {
+void LocationApiService::pingTest(LocHalClientHandle handle, LocAPIPingTestReqMsg* pMsg) {
 
     // test only - ignore this request when config is not enabled
-    std::lock_guard<std::mutex> lock(mMutex);
-    LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
     if (!pClient) {
         LOC_LOGe(">-- pingTest invlalid client=%s", pMsg->mSocketName);
         return;
     }
+    std::lock_guard<std::mutex> lock(pClient->getLock());
     pClient->pingTest();
     LOC_LOGd(">-- pingTest");
 }
 
-void LocationApiService::configConstrainedTunc(
+void LocationApiService::configConstrainedTunc(LocHalClientHandle handle,
         const LocConfigConstrainedTuncReqMsg* pMsg){
 
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     uint32_t sessionId = mLocationControlApi->configConstrainedTimeUncertainty(
             pMsg->mEnable, pMsg->mTuncConstraint, pMsg->mEnergyBudget);
     LOC_LOGi(">-- enable: %d, tunc constraint %f, energy budget %d, session ID = %d",
              pMsg->mEnable, pMsg->mTuncConstraint, pMsg->mEnergyBudget,
              sessionId);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configPositionAssistedClockEstimator(
+void LocationApiService::configPositionAssistedClockEstimator(LocHalClientHandle handle,
         const LocConfigPositionAssistedClockEstimatorReqMsg* pMsg)
 {
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     if (!pMsg || !mLocationControlApi) {
         return;
     }
@@ -1085,15 +1206,17 @@ void LocationApiService::configPositionAssistedClockEstimator(
             configPositionAssistedClockEstimator(pMsg->mEnable);
     LOC_LOGi(">-- enable: %d, session ID = %d", pMsg->mEnable,  sessionId);
 
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configConstellations(const LocConfigSvConstellationReqMsg* pMsg) {
+void LocationApiService::configConstellations(LocHalClientHandle handle,
+        const LocConfigSvConstellationReqMsg* pMsg) {
 
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
     uint32_t sessionId = mLocationControlApi->configConstellations(
             pMsg->mConstellationEnablementConfig, pMsg->mBlacklistSvConfig);
@@ -1103,16 +1226,17 @@ void LocationApiService::configConstellations(const LocConfigSvConstellationReqM
              (pMsg->mConstellationEnablementConfig.size == 0),
              pMsg->mConstellationEnablementConfig.enabledSvTypesMask,
              pMsg->mConstellationEnablementConfig.blacklistedSvTypesMask);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configConstellationSecondaryBand(
+void LocationApiService::configConstellationSecondaryBand(LocHalClientHandle handle,
         const LocConfigConstellationSecondaryBandReqMsg* pMsg) {
 
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
     uint32_t sessionId = mLocationControlApi->configConstellationSecondaryBand(
             pMsg->mSecondaryBandConfig);
@@ -1122,15 +1246,17 @@ void LocationApiService::configConstellationSecondaryBand(
              pMsg->mSecondaryBandConfig.size,
              pMsg->mSecondaryBandConfig.enabledSvTypesMask,
              pMsg->mSecondaryBandConfig.blacklistedSvTypesMask);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configAidingDataDeletion(LocConfigAidingDataDeletionReqMsg* pMsg) {
+void LocationApiService::configAidingDataDeletion(LocHalClientHandle handle,
+        LocConfigAidingDataDeletionReqMsg* pMsg) {
 
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
     LOC_LOGi(">-- client %s, deleteAll %d",
              pMsg->mSocketName, pMsg->mAidingData.deleteAll);
@@ -1139,7 +1265,7 @@ void LocationApiService::configAidingDataDeletion(LocConfigAidingDataDeletionReq
     suspendAllTrackingSessions();
 
     uint32_t sessionId = mLocationControlApi->gnssDeleteAidingData(pMsg->mAidingData);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 
 #ifdef POWERMANAGER_ENABLED
     // We do not need to resume the session if device is suspend/shutdown state
@@ -1154,53 +1280,61 @@ void LocationApiService::configAidingDataDeletion(LocConfigAidingDataDeletionReq
     resumeAllTrackingSessions();
 }
 
-void LocationApiService::configLeverArm(const LocConfigLeverArmReqMsg* pMsg){
+void LocationApiService::configLeverArm(LocHalClientHandle handle,
+        const LocConfigLeverArmReqMsg* pMsg){
 
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
     uint32_t sessionId = mLocationControlApi->configLeverArm(pMsg->mLeverArmConfigInfo);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configRobustLocation(const LocConfigRobustLocationReqMsg* pMsg){
+void LocationApiService::configRobustLocation(LocHalClientHandle handle,
+        const LocConfigRobustLocationReqMsg* pMsg){
 
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
     LOC_LOGi(">-- client %s, enable %d, enableForE911 %d",
              pMsg->mSocketName, pMsg->mEnable, pMsg->mEnableForE911);
 
     uint32_t sessionId = mLocationControlApi->configRobustLocation(
             pMsg->mEnable, pMsg->mEnableForE911);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configMinGpsWeek(const LocConfigMinGpsWeekReqMsg* pMsg){
+void LocationApiService::configMinGpsWeek(LocHalClientHandle handle,
+        const LocConfigMinGpsWeekReqMsg* pMsg){
 
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
     LOC_LOGi(">-- client %s, minGpsWeek %u",
              pMsg->mSocketName, pMsg->mMinGpsWeek);
 
     uint32_t sessionId =
             mLocationControlApi->configMinGpsWeek(pMsg->mMinGpsWeek);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configMinSvElevation(const LocConfigMinSvElevationReqMsg* pMsg){
+void LocationApiService::configMinSvElevation(LocHalClientHandle handle,
+        const LocConfigMinSvElevationReqMsg* pMsg){
 
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     LOC_LOGi(">-- client %s, minSvElevation %u", pMsg->mSocketName, pMsg->mMinSvElevation);
 
     GnssConfig gnssConfig = {};
@@ -1208,28 +1342,31 @@ void LocationApiService::configMinSvElevation(const LocConfigMinSvElevationReqMs
     gnssConfig.minSvElevation = pMsg->mMinSvElevation;
     uint32_t sessionId = gnssUpdateConfig(gnssConfig);
 
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configEngineRunState(const LocConfigEngineRunStateReqMsg* pMsg) {
+void LocationApiService::configEngineRunState(LocHalClientHandle handle,
+        const LocConfigEngineRunStateReqMsg* pMsg) {
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
     LOC_LOGi(">-- client %s, eng type 0x%x, eng state %d",
              pMsg->mSocketName, pMsg->mEngType, pMsg->mEngState);
     uint32_t sessionId =
             mLocationControlApi->configEngineRunState(pMsg->mEngType, pMsg->mEngState);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::configUserConsentTerrestrialPositioning(
+void LocationApiService::configUserConsentTerrestrialPositioning(LocHalClientHandle handle,
         LocConfigUserConsentTerrestrialPositioningReqMsg* pMsg) {
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
     LOC_LOGi(">-- client %s, current user consent %d, new usr consent %d",
              pMsg->mSocketName, mOptInTerrestrialService, pMsg->mUserConsent);
@@ -1262,13 +1399,14 @@ void LocationApiService::configUserConsentTerrestrialPositioning(
     }
 
     uint32_t sessionId = mLocationControlApi->setOptInStatus(pMsg->mUserConsent);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
-void LocationApiService::getGnssConfig(const LocAPIMsgHeader* pReqMsg,
+void LocationApiService::getGnssConfig(LocHalClientHandle handle, const LocAPIMsgHeader* pReqMsg,
                                        GnssConfigFlagsBits configFlag) {
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     if (!pReqMsg) {
         return;
     }
@@ -1284,35 +1422,47 @@ void LocationApiService::getGnssConfig(const LocAPIMsgHeader* pReqMsg,
     }
     // if sessionId is 0, e.g.: error callback will be delivered
     // by addConfigRequestToMap
-    addConfigRequestToMap(sessionId, pReqMsg);
+    addConfigRequestToMap(sessionId, handle, pReqMsg);
 }
 
-void LocationApiService::configDeadReckoningEngineParams(const LocConfigDrEngineParamsReqMsg* pMsg){
+void LocationApiService::configDeadReckoningEngineParams(LocHalClientHandle handle,
+        const LocConfigDrEngineParamsReqMsg* pMsg){
     if (!pMsg) {
         return;
     }
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     uint32_t sessionId = mLocationControlApi->configDeadReckoningEngineParams(
             pMsg->mDreConfig);
-    addConfigRequestToMap(sessionId, pMsg);
+    addConfigRequestToMap(sessionId, handle, pMsg);
 }
 
 void LocationApiService::addConfigRequestToMap(
-        uint32_t sessionId, const LocAPIMsgHeader* pMsg){
+        uint32_t sessionId, LocHalClientHandle handle, const LocAPIMsgHeader* pMsg){
     // for config request that is invoked from location integration API
     // if session id is valid, we need to add it to the map so when response
     // comes back, we can deliver the response to the integration api client
+    ConfigReqClientData configClientData;
+    configClientData.configMsgId = pMsg->msgId;
+    configClientData.clientHandle = handle;
     if (sessionId != 0) {
-        ConfigReqClientData configClientData;
-        configClientData.configMsgId = pMsg->msgId;
-        configClientData.clientName  = pMsg->mSocketName;
         mConfigReqs.emplace(sessionId, configClientData);
     } else {
         // if session id is 0, we need to deliver failed response back to the
         // client
-        LocHalDaemonClientHandler* pClient = getClient(pMsg->mSocketName);
-        if (pClient) {
-            pClient->onControlResponseCb(LOCATION_ERROR_GENERAL_FAILURE, pMsg->msgId);
+        sendControlResponse(configClientData, LOCATION_ERROR_GENERAL_FAILURE, nullptr);
+    }
+}
+
+void LocationApiService::sendControlResponse(const ConfigReqClientData& configReq,
+                                             LocationError err, const GnssConfig* config) {
+    LocHalDaemonClientHandler* pClient = getClient(configReq.clientHandle);
+    if (pClient) {
+        std::lock_guard<std::mutex> lock(pClient->getLock());
+        pClient->onControlResponseCb(err, configReq.configMsgId);
+        if (nullptr != config) {
+            // invoke the configCb to deliver the config
+            pClient->onGnssConfigCb(configReq.configMsgId, *config);
         }
     }
 }
@@ -1321,15 +1471,13 @@ void LocationApiService::addConfigRequestToMap(
 LocationApiService - Location Control API callback functions
 ******************************************************************************/
 void LocationApiService::onControlResponseCallback(LocationError err, uint32_t sessionId) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     LOC_LOGd("--< onControlResponseCallback err=%u id=%u", err, sessionId);
 
     auto configReqData = mConfigReqs.find(sessionId);
     if (configReqData != std::end(mConfigReqs)) {
-        LocHalDaemonClientHandler* pClient = getClient(configReqData->second.clientName);
-        if (pClient) {
-            pClient->onControlResponseCb(err, configReqData->second.configMsgId);
-        }
+        sendControlResponse(configReqData->second, err, nullptr);
         mConfigReqs.erase(configReqData);
         LOC_LOGd("--< map size %d", mConfigReqs.size());
     } else {
@@ -1339,7 +1487,8 @@ void LocationApiService::onControlResponseCallback(LocationError err, uint32_t s
 
 void LocationApiService::onControlCollectiveResponseCallback(
     size_t count, LocationError *errs, uint32_t *ids) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     if (count != 1) {
         LOC_LOGe("--< onControlCollectiveResponseCallback, count is %d, expecting 1", count);
         return;
@@ -1353,10 +1502,7 @@ void LocationApiService::onControlCollectiveResponseCallback(
     // the first id
     auto configReqData = mConfigReqs.find(sessionId);
     if (configReqData != std::end(mConfigReqs)) {
-        LocHalDaemonClientHandler* pClient = getClient(configReqData->second.clientName.c_str());
-        if (pClient) {
-            pClient->onControlResponseCb(err, configReqData->second.configMsgId);
-        }
+        sendControlResponse(configReqData->second, err, nullptr);
         mConfigReqs.erase(configReqData);
         LOC_LOGd("--< map size %d", mConfigReqs.size());
     } else {
@@ -1366,18 +1512,14 @@ void LocationApiService::onControlCollectiveResponseCallback(
 
 void LocationApiService::onGnssConfigCallback(uint32_t sessionId,
                                               const GnssConfig& config) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     LOC_LOGd("--< onGnssConfigCallback, req cnt %d", mConfigReqs.size());
 
     auto configReqData = mConfigReqs.find(sessionId);
     if (configReqData != std::end(mConfigReqs)) {
-        LocHalDaemonClientHandler* pClient = getClient(configReqData->second.clientName);
-        if (pClient) {
-            // invoke the respCb to deliver success status
-            pClient->onControlResponseCb(LOCATION_ERROR_SUCCESS, configReqData->second.configMsgId);
-            // invoke the configCb to deliver the config
-            pClient->onGnssConfigCb(configReqData->second.configMsgId, config);
-        }
+        // invoke the respCb to deliver success status, and the configCb
+        sendControlResponse(configReqData->second, LOCATION_ERROR_SUCCESS, &config);
         mConfigReqs.erase(configReqData);
         LOC_LOGd("--< map size %d", mConfigReqs.size());
     } else {
@@ -1398,7 +1540,8 @@ void LocationApiService::onCollectiveResponseCallback(
 }
 
 void LocationApiService::onGtpWwanTrackingCallback(Location location) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     LOC_LOGd("--< onGtpWwanTrackingCallback optIn=%u loc flags=0x%x", mOptInTerrestrialService,
             location.flags);
 
@@ -1407,7 +1550,10 @@ void LocationApiService::onGtpWwanTrackingCallback(Location location) {
 
         for (auto it = mTerrestrialFixReqs.begin(); it != mTerrestrialFixReqs.end();) {
             LocHalDaemonClientHandler* pClient = getClient(it->first);
-            pClient->sendTerrestrialFix(LOCATION_ERROR_SUCCESS, location);
+            if (pClient) {
+                std::lock_guard<std::mutex> clientLock(pClient->getLock());
+                pClient->sendTerrestrialFix(LOCATION_ERROR_SUCCESS, location);
+            }
             ++it;
         }
         mTerrestrialFixReqs.clear();
@@ -1420,7 +1566,8 @@ LocationApiService - power event handlers
 ******************************************************************************/
 #ifdef POWERMANAGER_ENABLED
 void LocationApiService::onPowerEvent(PowerStateType powerState) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
     LOC_LOGd("--< onPowerEvent %d", powerState);
 
     mPowerState = powerState;
@@ -1444,15 +1591,20 @@ void LocationApiService::onPowerEvent(PowerStateType powerState) {
 LocationApiService - on query callback from location engines
 ******************************************************************************/
 void LocationApiService::onGnssEnergyConsumedCb(uint64_t totalGnssEnergyConsumedSinceFirstBoot) {
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
     LOC_LOGd("--< onGnssEnergyConsumedCb");
+    {
+        std::lock_guard<std::mutex> lock(mStateMutex);
+        mGnssEnergyConsumedPending = false;
+    }
 
     LocAPIGnssEnergyConsumedIndMsg msg(SERVICE_NAME, totalGnssEnergyConsumedSinceFirstBoot,
             &mPbufMsgConv);
-    for (auto each : mClients) {
+    mClients.forEach([&msg](LocHalClientHandle handle, LocHalDaemonClientHandler* pClient) {
         // deliver the engergy info to registered client
-        each.second->onGnssEnergyConsumedInfoAvailable(msg);
-    }
+        std::lock_guard<std::mutex> lock(pClient->getLock());
+        pClient->onGnssEnergyConsumedInfoAvailable(msg);
+    });
 }
 
 /******************************************************************************
@@ -1478,22 +1630,27 @@ GnssInterface* LocationApiService::getGnssInterface() {
 }
 
 void LocationApiService::performMaintenance() {
-    ClientNameIpcSenderMap   clientsToCheck;
+    ClientIpcSenderMap   clientsToCheck;
 
     // Hold the lock when we access global variable of mClients
-    // copy out the client name and shared_ptr of ipc sender for the clients.
+    // copy out the client handle and shared_ptr of ipc sender for the clients.
     // We do not use mClients directly or making a copy of mClients, as the
     // client handler object can become invalid when the client gets
     // deleted by the thread of LocationApiService.
     {
-        std::lock_guard<std::mutex> lock(mMutex);
-        for (auto client : mClients) {
-            if (client.first.compare(AUTO_START_CLIENT_NAME) != 0) {
-                clientsToCheck.emplace(client.first, client.second->getIpcSender());
+        LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+        mClients.forEach([&](LocHalClientHandle handle, LocHalDaemonClientHandler* pClient) {
+            std::lock_guard<std::mutex> lock(pClient->getLock());
+            // a connected client is purged as soon as it closes the connection
+            if (pClient->getName().compare(AUTO_START_CLIENT_NAME) != 0 &&
+                !pClient->isPeerCloseWatched()) {
+                clientsToCheck.emplace(handle, pClient->getIpcSender());
             }
-        }
+        });
     }
 
+    reportSendCounters();
+
     for (auto client : clientsToCheck) {
         string pbStr;
         bool messageSent = false;
@@ -1504,10 +1661,10 @@ void LocationApiService::performMaintenance() {
         } else {
             LOC_LOGe("LocAPIPingTestReqMsg serializeToProtobuf failed");
         }
-        LOC_LOGd("send ping message returned %d for client %s", messageSent, client.first.c_str());
+        LOC_LOGd("send ping message returned %d for client %x", messageSent, client.first);
         if (messageSent == false) {
-            LOC_LOGe("--< ping failed for client %s", client.first.c_str());
-            deleteClientbyName(client.first);
+            LOC_LOGe("--< ping failed for client %x", client.first);
+            purgeClient(client.first);
         }
     }
 
@@ -1515,6 +1672,19 @@ void LocationApiService::performMaintenance() {
     mMaintTimer.start(MAINT_TIMER_INTERVAL_MSEC, false);
 }
 
+void LocationApiService::reportSendCounters() {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    mClients.forEach([](LocHalClientHandle handle, LocHalDaemonClientHandler* pClient) {
+        LocHalDaemonSendCounters counters;
+        {
+            std::lock_guard<std::mutex> lock(pClient->getLock());
+            pClient->getSendCounters(counters);
+        }
+        LOC_LOGi("client %s send queue depth %u max %u, sent %" PRIu64 " dropped %" PRIu64
+                 " coalesced %" PRIu64, pClient->getName().c_str(), counters.mDepth,
+                 counters.mMaxDepth, counters.mSent, counters.mDropped, counters.mCoalesced);
+    });
+}
 
 // Maintenance timer to clean up resources when client exists without sending
 // out de-registration message
@@ -1536,29 +1706,30 @@ void MaintTimer::timeOutCallback() {
 /******************************************************************************
 LocationApiService - GTP WWAN functionality
 ******************************************************************************/
-void LocationApiService::getSingleTerrestrialPos(
+void LocationApiService::getSingleTerrestrialPos(LocHalClientHandle handle,
         LocAPIGetSingleTerrestrialPosReqMsg* pReqMsg) {
 
-    std::string clientName(pReqMsg->mSocketName);
-
     LOC_LOGd(">--getSingleTerrestrialPos, timeout msec %d, tech mask 0x%x, horQoS %f",
              pReqMsg->mTimeoutMsec, pReqMsg->mTechMask, pReqMsg->mHorQoS);
 
-    std::lock_guard<std::mutex> lock(mMutex);
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    LocHalDaemonClientHandler* pClient = getClient(handle);
+    if (!pClient) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mStateMutex);
     // Make sure client has opt-in for the service
     if (mOptInTerrestrialService != 1) {
-        LocHalDaemonClientHandler* pClient = getClient(clientName);
-        if (pClient) {
-            // inform client that GTP service is not supported
-            Location location = {};
-            pClient->sendTerrestrialFix(LOCATION_ERROR_NOT_SUPPORTED, location);
-        }
+        // inform client that GTP service is not supported
+        std::lock_guard<std::mutex> clientLock(pClient->getLock());
+        Location location = {};
+        pClient->sendTerrestrialFix(LOCATION_ERROR_NOT_SUPPORTED, location);
     } else {
         mTerrestrialFixReqs.emplace(std::piecewise_construct,
-                                    std::forward_as_tuple(clientName),
-                                    std::forward_as_tuple(this, clientName));
+                                    std::forward_as_tuple(handle),
+                                    std::forward_as_tuple(this, handle));
 
-        auto it = mTerrestrialFixReqs.find(clientName);
+        auto it = mTerrestrialFixReqs.find(handle);
         if (it != mTerrestrialFixReqs.end()) {
             it->second.start(pReqMsg->mTimeoutMsec, false);
         }
@@ -1569,19 +1740,21 @@ void LocationApiService::getSingleTerrestrialPos(
     }
 }
 
-void LocationApiService::gtpFixRequestTimeout(const std::string& clientName) {
-    std::lock_guard<std::mutex> lock(LocationApiService::mMutex);
+void LocationApiService::gtpFixRequestTimeout(LocHalClientHandle clientHandle) {
+    LocHalDaemonClientRegistry::ReadLock registryLock(mClients);
+    std::lock_guard<std::mutex> lock(mStateMutex);
 
-    LOC_LOGd("timer out processing for client %s", clientName.c_str());
-    auto it = mTerrestrialFixReqs.find(clientName);
+    LOC_LOGd("timer out processing for client %s", mClients.getName(clientHandle).c_str());
+    auto it = mTerrestrialFixReqs.find(clientHandle);
     if (it != mTerrestrialFixReqs.end()) {
-        LocHalDaemonClientHandler* pClient = getClient(clientName);
+        LocHalDaemonClientHandler* pClient = getClient(clientHandle);
         if (pClient) {
             // inform client of timeout
+            std::lock_guard<std::mutex> clientLock(pClient->getLock());
             Location location = {};
             pClient->sendTerrestrialFix(LOCATION_ERROR_TIMEOUT, location);
         }
-        mTerrestrialFixReqs.erase(clientName);
+        mTerrestrialFixReqs.erase(clientHandle);
         // stop tracking if there is no more request
         if (mTerrestrialFixReqs.size() == 1) {
             mGtpWwanSsLocationApi->stopNetworkLocation(&mGtpWwanPosCallback);
@@ -1594,17 +1767,17 @@ void SingleTerrestrialFixTimer::timeOutCallback() {
 
     struct SingleTerrestrialFixTimeoutReq : public LocMsg {
         SingleTerrestrialFixTimeoutReq(LocationApiService* locationApiService,
-                                       const std::string &clientName) :
+                                       LocHalClientHandle clientHandle) :
                 mLocationApiService(locationApiService),
-                mClientName(clientName) {}
+                mClientHandle(clientHandle) {}
         virtual ~SingleTerrestrialFixTimeoutReq() {}
         void proc() const {
-            mLocationApiService->gtpFixRequestTimeout(mClientName);
+            mLocationApiService->gtpFixRequestTimeout(mClientHandle);
         }
         LocationApiService* mLocationApiService;
-        std::string         mClientName;
+        LocHalClientHandle  mClientHandle;
     };
 
     mLocationApiService->getMsgTask().sendMsg(new SingleTerrestrialFixTimeoutReq(
-                mLocationApiService, mClientName));
+                mLocationApiService, mClientHandle));
 }
@@ -42,8 +42,11 @@
 #include <location_interface.h>
 #include <LocationAPI.h>
 #include <LocationApiMsg.h>
+#include <LocationApiDeltaConv.h>
 
 #include <LocHalDaemonClientHandler.h>
+#include <LocHalDaemonIndCache.h>
+#include <LocHalDaemonClientRegistry.h>
 
 #ifdef NO_UNORDERED_SET_OR_MAP
     #include <map>
@@ -60,6 +63,8 @@ typedef struct {
     uint32_t deleteAllBeforeAutoStart;
     uint32_t posEngineMask;
     uint32_t positionMode;
+    uint32_t batchClientIndications;
+    uint32_t clientSendQueueDepth;
 } configParamToRead;
 
 
@@ -68,15 +73,15 @@ LocationApiService
 ******************************************************************************/
 
 typedef struct {
-    // this stores the client name and the command type that client requests
+    // this stores the client handle and the command type that client requests
     // the info will be used to send back command response
-    std::string clientName;
+    LocHalClientHandle clientHandle;
     ELocMsgID   configMsgId;
 } ConfigReqClientData;
 
 // periodic timer to perform maintenance work, e.g.: resource cleanup
 // for location hal daemon
-typedef std::unordered_map<std::string, shared_ptr<LocIpcSender>> ClientNameIpcSenderMap;
+typedef std::unordered_map<LocHalClientHandle, shared_ptr<LocIpcSender>> ClientIpcSenderMap;
 class MaintTimer : public LocTimer {
 public:
     MaintTimer(LocationApiService* locationApiService) :
@@ -96,9 +101,9 @@ class SingleTerrestrialFixTimer : public LocTimer {
 public:
 
     SingleTerrestrialFixTimer(LocationApiService* locationApiService,
-                              std::string& clientName) :
+                              LocHalClientHandle clientHandle) :
             mLocationApiService(locationApiService),
-            mClientName(clientName) {
+            mClientHandle(clientHandle) {
     }
 
     ~SingleTerrestrialFixTimer() {
@@ -109,12 +114,12 @@ public:
 
 private:
     LocationApiService* mLocationApiService;
-    const std::string mClientName;
+    const LocHalClientHandle mClientHandle;
 };
 
 // This keeps track of the client that requests single fix terrestrial position
 // and the timer that will fire when the timeout value has reached
-typedef std::unordered_map<std::string, SingleTerrestrialFixTimer>
+typedef std::unordered_map<LocHalClientHandle, SingleTerrestrialFixTimer>
         SingleTerrestrialFixClientMap;
 
 class LocationApiService
@@ -151,49 +156,78 @@ public:
 #endif
 
     // other APIs
-    void deleteClientbyName(const std::string name);
+    // removes the client and frees its resources, with the registry held
+    // for writing
+    void deleteClientByHandle(LocHalClientHandle handle);
 
     // protobuf conversion util class
     LocationApiPbMsgConv mPbufMsgConv;
-
-    static std::mutex mMutex;
+    // indications serialized once for all clients
+    LocHalDaemonIndCache mIndCache;
+    // SV and measurement reports as deltas, encoded once, through mIndCache,
+    // for all clients subscribing E_LOC_CB_DELTA_ENCODING_BIT
+    LocAPISvDeltaConv mSvDeltaConv;
+    LocAPIMeasDeltaConv mMeasDeltaConv;
 
     // Utility routine used by maintenance timer
     void performMaintenance();
 
     // Utility routine used by gtp fix timeout timer
-    void gtpFixRequestTimeout(const std::string& clientName);
+    void gtpFixRequestTimeout(LocHalClientHandle clientHandle);
 
     inline const MsgTask& getMsgTask() const {return mMsgTask;};
 
+    // With BATCH_CLIENT_INDICATIONS set, per-fix indications reported on a
+    // MsgTask thread are held back by the client handlers until that thread
+    // has worked through its pending msgs, and then flushIndications() sends
+    // each client its indications in one batch. Returns true if the caller
+    // is to hold its indication back. Called with the client lock held.
+    bool deferIndication();
+    void flushIndications();
+
+    // max number of msgs queued to a client before some are dropped,
+    // see LocHalDaemonSendQueue
+    inline uint32_t getSendQueueDepth() const { return mClientSendQueueDepth; }
+    // purges the client, when its I/O thread failed to send or it closed its
+    // connection, unless it is gone already. Takes the registry for writing.
+    void purgeClient(LocHalClientHandle handle);
+    // watches the connections of clients for being closed
+    inline LocIpcReactor& getPeerCloseReactor() { return mPeerCloseReactor; }
+
 private:
     // APIs can be invoked to process client's IPC messgage
+    // the requests of a registered client take the handle of the client,
+    // LOC_HAL_CLIENT_HANDLE_NONE if it is not registered
     void newClient(LocAPIClientRegisterReqMsg*);
-    void deleteClient(LocAPIClientDeregisterReqMsg*);
+    void deleteClient(LocHalClientHandle handle);
 
-    void startTracking(LocAPIStartTrackingReqMsg*);
-    void stopTracking(LocAPIStopTrackingReqMsg*);
+    void startTracking(LocHalClientHandle handle, LocAPIStartTrackingReqMsg*);
+    void stopTracking(LocHalClientHandle handle, LocAPIStopTrackingReqMsg*);
 
+    // with the registry held and the service state lock taken
     void suspendAllTrackingSessions();
     void resumeAllTrackingSessions();
 
-    void updateSubscription(LocAPIUpdateCallbacksReqMsg*);
-    void updateTrackingOptions(LocAPIUpdateTrackingOptionsReqMsg*);
+    void updateSubscription(LocHalClientHandle handle, LocAPIUpdateCallbacksReqMsg*);
+    void updateTrackingOptions(LocHalClientHandle handle, LocAPIUpdateTrackingOptionsReqMsg*);
     void updateNetworkAvailability(bool availability);
-    void getGnssEnergyConsumed(const char* clientSocketName);
-    void getSingleTerrestrialPos(LocAPIGetSingleTerrestrialPosReqMsg*);
+    void getGnssEnergyConsumed(LocHalClientHandle handle);
+    void getSingleTerrestrialPos(LocHalClientHandle handle,
+                                 LocAPIGetSingleTerrestrialPosReqMsg*);
 
-    void startBatching(LocAPIStartBatchingReqMsg*);
-    void stopBatching(LocAPIStopBatchingReqMsg*);
-    void updateBatchingOptions(LocAPIUpdateBatchingOptionsReqMsg*);
+    void startBatching(LocHalClientHandle handle, LocAPIStartBatchingReqMsg*);
+    void stopBatching(LocHalClientHandle handle, LocAPIStopBatchingReqMsg*);
+    void updateBatchingOptions(LocHalClientHandle handle, LocAPIUpdateBatchingOptionsReqMsg*);
 
-    void addGeofences(LocAPIAddGeofencesReqMsg*);
-    void removeGeofences(LocAPIRemoveGeofencesReqMsg*);
-    void modifyGeofences(LocAPIModifyGeofencesReqMsg*);
-    void pauseGeofences(LocAPIPauseGeofencesReqMsg*);
-    void resumeGeofences(LocAPIResumeGeofencesReqMsg*);
+    void addGeofences(LocHalClientHandle handle, LocAPIAddGeofencesReqMsg*);
+    void removeGeofences(LocHalClientHandle handle, LocAPIRemoveGeofencesReqMsg*);
+    void modifyGeofences(LocHalClientHandle handle, LocAPIModifyGeofencesReqMsg*);
+    void pauseGeofences(LocHalClientHandle handle, LocAPIPauseGeofencesReqMsg*);
+    void resumeGeofences(LocHalClientHandle handle, LocAPIResumeGeofencesReqMsg*);
 
-    void pingTest(LocAPIPingTestReqMsg*);
+    void pingTest(LocHalClientHandle handle, LocAPIPingTestReqMsg*);
+    // logs the send queue counters of every client
+    void reportSendCounters();
 
     inline uint32_t gnssUpdateConfig(const GnssConfig& config) {
         uint32_t* sessionIds =  mLocationControlApi->gnssUpdateConfig(config);
@@ -219,53 +253,54 @@ private:
     void onCollectiveResponseCallback(size_t count, LocationError *errs, uint32_t *ids);
     void onGtpWwanTrackingCallback(Location location);
 
-    // Location configuration API requests
-    void configConstrainedTunc(
+    // Location configuration API requests, from the client of handle
+    void configConstrainedTunc(LocHalClientHandle handle,
             const LocConfigConstrainedTuncReqMsg* pMsg);
-    void configPositionAssistedClockEstimator(
+    void configPositionAssistedClockEstimator(LocHalClientHandle handle,
             const LocConfigPositionAssistedClockEstimatorReqMsg* pMsg);
-    void configConstellations(
+    void configConstellations(LocHalClientHandle handle,
             const LocConfigSvConstellationReqMsg* pMsg);
-    void configConstellationSecondaryBand(
+    void configConstellationSecondaryBand(LocHalClientHandle handle,
             const LocConfigConstellationSecondaryBandReqMsg* pMsg);
-    void configAidingDataDeletion(
+    void configAidingDataDeletion(LocHalClientHandle handle,
             LocConfigAidingDataDeletionReqMsg* pMsg);
-    void configLeverArm(const LocConfigLeverArmReqMsg* pMsg);
-    void configRobustLocation(const LocConfigRobustLocationReqMsg* pMsg);
-    void configMinGpsWeek(const LocConfigMinGpsWeekReqMsg* pMsg);
-    void configDeadReckoningEngineParams(const LocConfigDrEngineParamsReqMsg* pMsg);
-    void configMinSvElevation(const LocConfigMinSvElevationReqMsg* pMsg);
-    void configEngineRunState(const LocConfigEngineRunStateReqMsg* pMsg);
-    void configUserConsentTerrestrialPositioning(
+    void configLeverArm(LocHalClientHandle handle, const LocConfigLeverArmReqMsg* pMsg);
+    void configRobustLocation(LocHalClientHandle handle,
+            const LocConfigRobustLocationReqMsg* pMsg);
+    void configMinGpsWeek(LocHalClientHandle handle, const LocConfigMinGpsWeekReqMsg* pMsg);
+    void configDeadReckoningEngineParams(LocHalClientHandle handle,
+            const LocConfigDrEngineParamsReqMsg* pMsg);
+    void configMinSvElevation(LocHalClientHandle handle,
+            const LocConfigMinSvElevationReqMsg* pMsg);
+    void configEngineRunState(LocHalClientHandle handle,
+            const LocConfigEngineRunStateReqMsg* pMsg);
+    void configUserConsentTerrestrialPositioning(LocHalClientHandle handle,
             LocConfigUserConsentTerrestrialPositioningReqMsg* pMsg);
 
     // Location configuration API get/read requests
-    void getGnssConfig(const LocAPIMsgHeader* pReqMsg,
+    void getGnssConfig(LocHalClientHandle handle, const LocAPIMsgHeader* pReqMsg,
                        GnssConfigFlagsBits configFlag);
-    void getConstellationSecondaryBandConfig(
+    void getConstellationSecondaryBandConfig(LocHalClientHandle handle,
             const LocConfigGetConstellationSecondaryBandConfigReqMsg* pReqMsg);
 
-    // Location configuration API util routines
-    void addConfigRequestToMap(uint32_t sessionId,
+    // Location configuration API util routines, with mStateMutex held
+    void addConfigRequestToMap(uint32_t sessionId, LocHalClientHandle handle,
                                const LocAPIMsgHeader* pMsg);
+    // delivers the response to a config request, with the registry held
+    void sendControlResponse(const ConfigReqClientData& configReq, LocationError err,
+                             const GnssConfig* config);
 
     LocationApiService(const configParamToRead & configParamRead);
     virtual ~LocationApiService();
 
     // private utilities
-    inline LocHalDaemonClientHandler* getClient(const std::string& clientname) {
-        // find client from property db
-        auto client = mClients.find(clientname);
-        if (client == std::end(mClients)) {
-            LOC_LOGe("Failed to find client %s", clientname.c_str());
-            return nullptr;
+    // with the registry held, the client of handle, or nullptr if it is gone
+    inline LocHalDaemonClientHandler* getClient(LocHalClientHandle handle) {
+        LocHalDaemonClientHandler* client = mClients.find(handle);
+        if (nullptr == client) {
+            LOC_LOGe("Failed to find client %x", handle);
         }
-        return client->second;
-    }
-
-    inline LocHalDaemonClientHandler* getClient(const char* socketName) {
-        std::string clientname(socketName);
-        return getClient(clientname);
+        return client;
     }
 
     GnssInterface* getGnssInterface();
@@ -283,8 +318,14 @@ private:
     unique_ptr<LocIpcRecver> mBlockingRecver;
 
     // Client propery database
-    std::unordered_map<std::string, LocHalDaemonClientHandler*> mClients;
+    LocHalDaemonClientRegistry mClients;
+    // service wide state, i.e. mConfigReqs, mTerrestrialFixReqs, the
+    // terrestrial service and the power state; taken after the registry lock
+    // and before any client lock
+    std::mutex mStateMutex;
     std::unordered_map<uint32_t, ConfigReqClientData> mConfigReqs;
+    // a GNSS energy consumed request is out to the engine
+    bool mGnssEnergyConsumedPending;
 
     // Location Control API interface
     uint32_t mLocationControlId;
@@ -294,11 +335,16 @@ private:
     // Configration
     const uint32_t mAutoStartGnss;
     GnssSuplMode   mPositionMode;
+    const uint32_t mBatchClientIndications;
+    const uint32_t mClientSendQueueDepth;
+    // a flushIndications() is due on this thread
+    static thread_local bool sIndicationFlushPending;
 
     PowerStateType  mPowerState;
 
-    // maintenance timer
+    // maintenance timer, pinging the clients whose connection isn't watched
     MaintTimer mMaintTimer;
+    LocIpcReactor mPeerCloseReactor;
 
    // msg task used by timers
     const MsgTask   mMsgTask;
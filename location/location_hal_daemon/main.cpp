@@ -75,6 +75,8 @@ int main(int argc, char *argv[])
         {"DELETE_ALL_BEFORE_AUTO_START", &configParamRead.deleteAllBeforeAutoStart, NULL, 'n'},
         {"DELETE_ALL_ON_ENGINE_MASK", &configParamRead.posEngineMask, NULL, 'n'},
         {"POSITION_MODE", &configParamRead.positionMode, NULL, 'n'},
+        {"BATCH_CLIENT_INDICATIONS", &configParamRead.batchClientIndications, NULL, 'n'},
+        {"CLIENT_SEND_QUEUE_DEPTH", &configParamRead.clientSendQueueDepth, NULL, 'n'},
     };
 
     // read configuration file
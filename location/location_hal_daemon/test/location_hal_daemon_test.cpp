@@ -0,0 +1,59 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_HalDaemonTest"
+
+// Runs the __LOC_UNIT_TEST__ self checks of location_hal_daemon. Exits
+// non-zero if any of them fails.
+
+#include <LocUnitTest.h>
+#include <LocHalDaemonClientRegistry.h>
+#include <LocHalDaemonIndCache.h>
+#include <LocHalDaemonSendQueue.h>
+
+using namespace loc_util;
+
+int main(int argc, char** argv) {
+    LocUnitTest test(argc, argv);
+    test.report("client handles", LocHalDaemonClientRegistry::checkHandles());
+    test.report("indication cache", LocHalDaemonIndCache::check(8, 100));
+    test.report("send queue policies", LocHalDaemonSendQueue::checkPolicies());
+
+    if (test.runBenchmarks()) {
+        static const uint32_t clientCounts[] = {1, 2, 4, 8, 16};
+        for (uint32_t numClients : clientCounts) {
+            uint64_t cachedNs = 0, uncachedNs = 0;
+            LocHalDaemonIndCache::benchmark(numClients, 1000, cachedNs, uncachedNs);
+            printf("indications of a fix for %u clients: %" PRIu64 " / %" PRIu64
+                   " ns CPU (cached / uncached)\n", numClients, cachedNs, uncachedNs);
+        }
+    }
+
+    return test.finish();
+}